@@ -53,7 +53,15 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         return -1;
     }
 
-    // Load Blue material shader
+    // Load Blue material shaders; the blue triangles get their world matrices as root constants
+    std::unique_ptr<ByteBuffer> constantsVertexShaderBytecode;
+    if (!ByteBuffer::Create(materialDir / "WorldConstants.vertx.cso",
+                            constantsVertexShaderBytecode)) {
+        LOG_ERROR(L"Failed to load Blue vertex shader.");
+        MainWindow::ShowErrorMessageBox();
+        return -1;
+    }
+
     std::unique_ptr<ByteBuffer> bluePixelShaderBytecode;
     if (!ByteBuffer::Create(materialDir / "ColorBlue.pixel.cso", bluePixelShaderBytecode)) {
         LOG_ERROR(L"Failed to load Blue pixel shader.");
@@ -82,6 +90,19 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         return -1;
     }
 
+    std::unique_ptr<ByteBuffer> constantsRootSignBytecode;
+    if (!ByteBuffer::Create(materialDir / "WorldConstants.rsign.cso", constantsRootSignBytecode)) {
+        LOG_ERROR(L"Failed to load Blue root signature.");
+        MainWindow::ShowErrorMessageBox();
+        return -1;
+    }
+
+    std::unique_ptr<RootSignature> constantsRootSignature;
+    if (!device->CreateRootSignature(*constantsRootSignBytecode, constantsRootSignature)) {
+        LOG_ERROR(L"Failed to create Blue root signature.");
+        return -1;
+    }
+
     // The Renderer (use Red root signature)
     std::unique_ptr<Renderer> renderer;
     if (!Renderer::Create(*rootSignature, renderer)) {
@@ -105,9 +126,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     // Create Blue Material
     MaterialBuilder blueMaterialBuilder;
     std::shared_ptr<Material> blueMaterial;
-    if (!blueMaterialBuilder.SetVertexShaderBytecode(*vertexShaderBytecode)
+    if (!blueMaterialBuilder.SetVertexShaderBytecode(*constantsVertexShaderBytecode)
              .SetPixelShaderBytecode(*bluePixelShaderBytecode)
-             .CreateMaterial(*device, *rootSignature, blueMaterial)) {
+             .SetInstanceBinding(InstanceBinding::kRootConstants)
+             .CreateMaterial(*device, *constantsRootSignature, blueMaterial)) {
         LOG_ERROR(L"Failed to create Blue Material.\n");
         MainWindow::ShowErrorMessageBox();
         return -1;
@@ -147,7 +169,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         }
 
         // Position triangle randomly (from -1.0f to 1.0f)
-        node->GetTransform().Translate(Vector3(posDist(gen), posDist(gen), 0));
+        node->SetTransform(Matrix4().Translate(Vector3(posDist(gen), posDist(gen), 0)));
 
         rootNode->AddChild(std::move(node));
     }
@@ -0,0 +1,4 @@
+#define ROOTSIGN \
+    "RootFlags(ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT), " \
+    "RootConstants(num32BitConstants = 16, b0, visibility = SHADER_VISIBILITY_VERTEX), " /* Per-draw world matrix */ \
+    "CBV(b1, visibility = SHADER_VISIBILITY_VERTEX)" // Per-view view-projection matrix
@@ -0,0 +1,24 @@
+#include "WorldConstants.rsign.hlsl"
+
+struct MeshConstants
+{
+    float4x4 World;   // Object to world
+};
+
+struct ViewConstants
+{
+    float4x4 ViewProjection;   // World to clip space
+};
+
+// Set per view
+ConstantBuffer<ViewConstants> View : register(b1);
+
+// Set per draw as root constants
+ConstantBuffer<MeshConstants> Mesh : register(b0);
+
+[RootSignature(ROOTSIGN)]
+float4 main(float3 pos: POSITION) : SV_POSITION
+{
+    float4 worldPos = mul(Mesh.World, float4(pos, 1.0f));
+    return mul(View.ViewProjection, worldPos);
+}
@@ -1,5 +1,6 @@
 #define ROOTSIGN \
     "RootFlags(ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT), " \
-    "CBV(b0, visibility = SHADER_VISIBILITY_VERTEX)" // World matrix constant buffer
+    "SRV(t0, visibility = SHADER_VISIBILITY_VERTEX), " /* Per-instance world matrices */ \
+    "CBV(b1, visibility = SHADER_VISIBILITY_VERTEX)" // Per-view view-projection matrix
 
 
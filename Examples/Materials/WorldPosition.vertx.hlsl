@@ -1,13 +1,24 @@
 #include "WorldPosition.rsign.hlsl"
 
-cbuffer MeshConstants : register(b0)
+struct MeshConstants
 {
     float4x4 World;   // Object to world
 };
 
+struct ViewConstants
+{
+    float4x4 ViewProjection;   // World to clip space
+};
+
+// Set per view
+ConstantBuffer<ViewConstants> View : register(b1);
+
+// One element per instance of the draw
+StructuredBuffer<MeshConstants> Instances : register(t0);
+
 [RootSignature(ROOTSIGN)]
-float4 main(float3 pos: POSITION) : SV_POSITION
+float4 main(float3 pos: POSITION, uint instanceId : SV_InstanceID) : SV_POSITION
 {
-    float4 worldPos = mul(World, float4(pos, 1.0f));
-    return worldPos;
+    float4 worldPos = mul(Instances[instanceId].World, float4(pos, 1.0f));
+    return mul(View.ViewProjection, worldPos);
 }
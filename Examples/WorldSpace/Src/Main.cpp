@@ -102,8 +102,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         MainWindow::ShowErrorMessageBox();
         return -1;
     }
-    rotatedTwo->GetTransform().Translate(Vector3(0.3, 0., 0.));
-    rotatedTwo->GetTransform().RotateZ(90);
+    rotatedTwo->SetTransform(Matrix4().Translate(Vector3(0.3, 0., 0.)).RotateZ(90));
     
     // Tri node One
     std::unique_ptr<Node> rotatedOne;
@@ -112,8 +111,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         MainWindow::ShowErrorMessageBox();
         return -1;
     }
-    rotatedOne->GetTransform().Translate(Vector3(0.3, 0., 0.));
-    rotatedOne->GetTransform().RotateZ(90);
+    rotatedOne->SetTransform(Matrix4().Translate(Vector3(0.3, 0., 0.)).RotateZ(90));
     rotatedOne->AddChild(std::move(rotatedTwo));
     
     // Straight node
@@ -138,6 +136,22 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 
     renderer->SetScene(*scene);
 
+    // Split the screen: the left half keeps the identity camera, the right half looks at the same
+    // scene through a perspective camera placed in front of it
+    renderer->GetView(Renderer::kMainViewIndex).SetRect(0.f, 0.f, 0.5f, 1.f);
+
+    Camera perspectiveCamera;
+    perspectiveCamera.SetLookAt(Vector3(0.f, 0.f, -1.f), Vector3(0.f, 0.f, 0.f),
+                                Vector3(0.f, 1.f, 0.f));
+    perspectiveCamera.SetPerspective(60.f, 1.f, 0.1f, 10.f);
+
+    uint32_t perspectiveViewIndex;
+    if (!renderer->AddView(View(perspectiveCamera, 0.5f, 0.f, 0.5f, 1.f), perspectiveViewIndex)) {
+        LOG_ERROR(L"Failed to add the perspective view.\n");
+        MainWindow::ShowErrorMessageBox();
+        return -1;
+    }
+
     // The main window.
     std::unique_ptr<MainWindow> mainWindow;
     if (!MainWindow::Create(*device, *renderer, mainWindow)) {
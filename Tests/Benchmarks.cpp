@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "Graphics/Command/CommandStream.h"
+#include "Graphics/Command/NullCommandBackend.h"
+#include "Graphics/DeferredReleaseQueue.h"
+#include "Graphics/OcclusionBuffer.h"
+#include "Graphics/RadixSort.h"
+#include "Graphics/Resource/NullUploadBackend.h"
+#include "Graphics/Resource/UploadBatcher.h"
+#include "Memory/TlsfAllocator.h"
+#include "Threading/WorkerPool.h"
+
+#ifdef HAS_DIRECTXMATH
+#include "Scene/Bvh.h"
+#include "Scene/TransformStore.h"
+#endif
+
+/**
+ * Runs the function Repeats times and prints the average time per run.
+ */
+template <typename Function>
+static void Measure(const char* Name, uint32_t Repeats, Function&& Run) {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < Repeats; ++i) {
+        Run();
+    }
+    const std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::printf("%-40s %12.1f us\n", Name, elapsed.count() / Repeats);
+}
+
+/**
+ * Walks the keys in order the way the renderer does, into a hash of the order.
+ */
+template <typename Container>
+static uint64_t WalkKeys(const Container& Keys) {
+    uint64_t hash = 0;
+    for (const RenderingKey& key : Keys) {
+        hash = hash * 31 + key.value;
+    }
+    return hash;
+}
+
+/**
+ * Builds, sorts and walks a frame's render queue. The std::set one is the queue the flat vector
+ * replaced: a tree node allocation per key on the insertion.
+ */
+static void BenchmarkRadixSort(WorkerPool& Pool, size_t KeyCount, uint32_t Repeats) {
+    std::mt19937_64 random(1);
+    std::vector<RenderingKey> source(KeyCount);
+    for (RenderingKey& key : source) {
+        key.value = random() >> 4;
+    }
+
+    std::printf("Render queue of %zu keys\n", KeyCount);
+
+    std::set<RenderingKey> orderedQueue;
+    uint64_t orderedHash = 0;
+    Measure("  std::set", Repeats, [&]() {
+        orderedQueue.clear();
+        for (const RenderingKey& key : source) {
+            orderedQueue.insert(key);
+        }
+        orderedHash = WalkKeys(orderedQueue);
+    });
+
+    std::vector<RenderingKey> keys;
+    std::vector<RenderingKey> scratch;
+    uint64_t hash = 0;
+    Measure("  RadixSort", Repeats, [&]() {
+        keys = source;
+        RadixSort(keys, scratch);
+        hash = WalkKeys(keys);
+    });
+    Measure("  RadixSort on the pool", Repeats, [&]() {
+        keys = source;
+        RadixSort(keys, scratch, Pool);
+        hash = WalkKeys(keys);
+    });
+    Measure("  std::sort", Repeats, [&]() {
+        keys = source;
+        std::sort(keys.begin(), keys.end());
+        hash = WalkKeys(keys);
+    });
+    if (hash != orderedHash) {
+        std::printf("The render queues walk the keys in different orders\n");
+    }
+}
+
+static void BenchmarkTlsf(uint32_t OperationCount, uint32_t Repeats) {
+    Measure("TlsfAllocator churn", Repeats, [OperationCount]() {
+        TlsfAllocator allocator(uint64_t{1} << 28);
+        std::mt19937 random(2);
+        std::vector<TlsfAllocation> allocations;
+        for (uint32_t i = 0; i < OperationCount; ++i) {
+            if (!allocations.empty() && random() % 2 == 0) {
+                const size_t index = random() % allocations.size();
+                allocator.Free(allocations[index]);
+                allocations[index] = allocations.back();
+                allocations.pop_back();
+                continue;
+            }
+
+            TlsfAllocation allocation;
+            if (allocator.Allocate(256 + random() % 65536, 256, allocation)) {
+                allocations.push_back(allocation);
+            }
+        }
+    });
+}
+
+static void BenchmarkOcclusion(uint32_t OccluderCount, uint32_t BoxCount, uint32_t Repeats) {
+    static const float kIdentity[16] = {1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f,
+                                        0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f};
+
+    std::unique_ptr<OcclusionBuffer> buffer;
+    if (!OcclusionBuffer::Create(256, 144, buffer)) {
+        return;
+    }
+
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> position(-1.f, 1.f);
+    std::uniform_real_distribution<float> depth(0.1f, 0.9f);
+    std::vector<float> triangles;
+    for (uint32_t i = 0; i < OccluderCount * 3; ++i) {
+        triangles.insert(triangles.end(), {position(random), position(random), depth(random)});
+    }
+    std::vector<float> boxes;
+    for (uint32_t i = 0; i < BoxCount; ++i) {
+        const float x = position(random);
+        const float y = position(random);
+        const float z = depth(random);
+        boxes.insert(boxes.end(), {x, y, z, x + 0.05f, y + 0.05f, z + 0.05f});
+    }
+
+    Measure("OcclusionBuffer rasterize", Repeats, [&]() {
+        buffer->Clear(kIdentity);
+        buffer->RasterizeOccluder(kIdentity, triangles.data(), OccluderCount * 3,
+                                  3 * sizeof(float));
+        buffer->BuildHierarchy();
+    });
+    Measure("OcclusionBuffer test", Repeats, [&]() {
+        for (size_t i = 0; i < boxes.size(); i += 6) {
+            buffer->IsVisible(&boxes[i], &boxes[i + 3]);
+        }
+    });
+}
+
+#ifdef HAS_DIRECTXMATH
+static void BenchmarkBvh(uint32_t ItemCount, uint32_t Repeats) {
+    std::mt19937 random(4);
+    std::uniform_real_distribution<float> position(-500.f, 500.f);
+    std::vector<AABB> boxes(ItemCount);
+    for (AABB& box : boxes) {
+        const float x = position(random);
+        const float y = position(random);
+        const float z = position(random);
+        box = AABB(Vector3(x, y, z), Vector3(x + 2.f, y + 2.f, z + 2.f));
+    }
+
+    Bvh index;
+    Measure("Bvh build", Repeats, [&]() {
+        index = Bvh();
+        for (uint32_t id = 0; id < ItemCount; ++id) {
+            index.SetBounds(id, boxes[id]);
+        }
+        index.Update();
+    });
+
+    float offset = 0.f;
+    Measure("Bvh refit", Repeats, [&]() {
+        offset = offset == 0.f ? 0.5f : 0.f;
+        for (uint32_t id = 0; id < ItemCount; id += 10) {
+            index.SetBounds(id, boxes[id].Transform(Matrix4(
+                                    DirectX::XMMatrixTranslation(offset, 0.f, 0.f))));
+        }
+        index.Update();
+    });
+
+    std::vector<uint32_t> ids;
+    Measure("Bvh query", Repeats, [&]() {
+        for (uint32_t query = 0; query < 100; ++query) {
+            ids.clear();
+            index.Query(AABB(Vector3(query * 5.f - 250.f, -50.f, -50.f),
+                             Vector3(query * 5.f - 200.f, 50.f, 50.f)),
+                        ids);
+        }
+    });
+}
+
+/**
+ * Moves every root of a scene of trees of up to 1000 slots, so the whole scene gets recomputed, on
+ * 1 to all the hardware threads.
+ */
+static void BenchmarkTransformStore(uint32_t SlotCount, uint32_t Repeats) {
+    constexpr uint32_t kTreeSize = 1000;
+
+    // The store never dereferences the owners
+    std::vector<uint32_t> slots(SlotCount);
+    TransformStore store;
+    std::mt19937 random(5);
+    for (uint32_t id = 0; id < SlotCount; ++id) {
+        slots[id] = store.Allocate(reinterpret_cast<Node*>(16), &slots[id]);
+        if (id % kTreeSize != 0) {
+            store.SetParent(slots[id], slots[id - 1 - random() % (id % kTreeSize)]);
+        }
+    }
+    store.UpdateWorldTransforms();
+
+    const uint32_t maxThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t threadCount = 1;; threadCount = std::min(threadCount * 2, maxThreadCount)) {
+        std::unique_ptr<WorkerPool> pool;
+        if (!WorkerPool::Create(threadCount - 1, pool)) {
+            return;
+        }
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "TransformStore update, %u thread(s)", threadCount);
+        Measure(name, Repeats, [&]() {
+            for (uint32_t id = 0; id < SlotCount; id += kTreeSize) {
+                store.SetLocalTransform(slots[id], store.GetLocalTransform(slots[id]));
+            }
+            store.UpdateWorldTransforms(*pool);
+        });
+
+        if (threadCount == maxThreadCount) {
+            break;
+        }
+    }
+}
+#endif
+
+static void BenchmarkReleaseQueue(uint32_t ItemCount, uint32_t Repeats) {
+    DeferredReleaseQueue<std::unique_ptr<int>> queue;
+    Measure("DeferredReleaseQueue", Repeats, [&]() {
+        for (uint32_t i = 0; i < ItemCount; ++i) {
+            queue.Enqueue(i / 64, std::make_unique<int>(static_cast<int>(i)));
+            if (i % 64 == 0) {
+                queue.Release(i / 64);
+            }
+        }
+        queue.ReleaseAll();
+    });
+}
+
+/**
+ * Records draws the way the renderer does, a pipeline switch every 64 draws and the constants of 8
+ * instances per draw, and replays them into the null backend.
+ */
+static void BenchmarkCommandStream(uint32_t DrawCount, uint32_t Repeats) {
+    constexpr uint32_t kInstanceCount = 8;
+    constexpr size_t kInstanceSize = 64;
+
+    CommandStream stream;
+    auto record = [&]() {
+        stream.Reset();
+        stream.SetPrimitiveTopology(PrimitiveTopology::kTriangleList);
+        stream.SetRootSignature(reinterpret_cast<ID3D12RootSignature*>(16));
+        stream.SetViewport(Viewport{0.f, 0.f, 1920.f, 1080.f, 0.f, 1.f});
+        stream.SetScissorRect(ScissorRect{0, 0, 1920, 1080});
+        for (uint32_t draw = 0; draw < DrawCount; ++draw) {
+            if (draw % 64 == 0) {
+                stream.SetPipelineState(reinterpret_cast<ID3D12PipelineState*>(32 + draw));
+            }
+            stream.SetVertexBuffer(0, 0x10000 + draw * 4096, 4096, 32);
+
+            uint32_t dataOffset = 0;
+            void* instances = stream.AllocateData(kInstanceCount * kInstanceSize, 16, dataOffset);
+            memset(instances, 0, kInstanceCount * kInstanceSize);
+            stream.SetRootShaderResourceData(1, dataOffset);
+            stream.DrawInstanced(36, kInstanceCount, 0, 0);
+        }
+    };
+
+    Measure("CommandStream record", Repeats, record);
+
+    NullCommandBackend backend;
+    Measure("CommandStream replay (null backend)", Repeats, [&]() {
+        backend.Reset();
+        backend.Submit(stream);
+    });
+    if (backend.GetErrorCount() != 0 || backend.GetDrawCount() != DrawCount) {
+        std::printf("CommandStream replay found %zu errors\n", backend.GetErrorCount());
+    }
+}
+
+/**
+ * Uploads the meshes of a scene through the null copy queue, one submission per mesh the way the
+ * meshes used to be created, against one batch the way Device::CreateMeshes records them. Counts
+ * the submissions, the staging allocations and the copies.
+ */
+static void BenchmarkUploads(uint32_t MeshCount, uint32_t Repeats) {
+    using Batcher = UploadBatcher<NullUploadBackend>;
+
+    // A vertex and an index buffer per mesh, of a few kilobytes each
+    std::mt19937 random(9);
+    std::vector<NullUploadBuffer> buffers;
+    for (uint32_t i = 0; i < 2 * MeshCount; ++i) {
+        buffers.emplace_back(1024 + random() % (16 * 1024));
+    }
+    const std::vector<std::byte> data(17 * 1024, std::byte{1});
+    std::vector<Batcher::Request> requests;
+    for (NullUploadBuffer& buffer : buffers) {
+        requests.push_back({&buffer, data.data(), buffer.Data.size()});
+    }
+
+    auto report = [](const char* Name, const Batcher& Batcher, const NullUploadBackend& Backend,
+                     uint32_t Repeats) {
+        std::printf("  %s: %llu submits, %llu staging pages, %zu copies a run\n", Name,
+                    static_cast<unsigned long long>(Batcher.GetSubmitCount() / Repeats),
+                    static_cast<unsigned long long>(Batcher.GetStagingPageCount() / Repeats),
+                    Backend.GetCopyCount() / Repeats);
+    };
+
+    std::printf("Upload of %u meshes\n", MeshCount);
+    {
+        NullUploadBackend backend;
+        Batcher batcher(backend);
+        Measure("  Per mesh", Repeats, [&]() {
+            for (uint32_t mesh = 0; mesh < MeshCount; ++mesh) {
+                UploadTicket ticket = 0;
+                batcher.UploadBatch({&requests[2 * mesh], 2}, ticket);
+                batcher.Submit(ticket);
+                backend.Complete(ticket);
+                batcher.Collect();
+            }
+        });
+        report("Per mesh", batcher, backend, Repeats);
+    }
+    {
+        NullUploadBackend backend;
+        Batcher batcher(backend);
+        Measure("  Batched", Repeats, [&]() {
+            UploadTicket ticket = 0;
+            batcher.UploadBatch(requests, ticket);
+            batcher.Submit(ticket);
+            backend.Complete(ticket);
+            batcher.Collect();
+        });
+        report("Batched", batcher, backend, Repeats);
+    }
+}
+
+/**
+ * Times the D3D-free building blocks of the renderer. --quick runs every benchmark once on small
+ * inputs, e.g. as a smoke test.
+ */
+int main(int argc, char** argv) {
+    const bool isQuick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+    const uint32_t repeats = isQuick ? 1 : 20;
+    const uint32_t scale = isQuick ? 1 : 100;
+
+    std::unique_ptr<WorkerPool> pool;
+    if (!WorkerPool::Create(pool)) {
+        return 1;
+    }
+
+    // The drawable counts of a small, a large and a huge scene
+    for (size_t keyCount : {1000, 100000, 1000000}) {
+        if (!isQuick || keyCount <= 100000) {
+            BenchmarkRadixSort(*pool, keyCount, repeats);
+        }
+    }
+    BenchmarkTlsf(1000 * scale, repeats);
+    BenchmarkOcclusion(10 * scale, 100 * scale, repeats);
+#ifdef HAS_DIRECTXMATH
+    BenchmarkBvh(1000 * scale, repeats);
+    BenchmarkTransformStore(5000 * scale, repeats);
+#endif
+    BenchmarkReleaseQueue(1000 * scale, repeats);
+    BenchmarkCommandStream(100 * scale, repeats);
+    BenchmarkUploads(10 * scale, repeats);
+    return 0;
+}
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Scene/Bvh.h"
+#include "Test.h"
+
+/**
+ * Returns the unit box with the min corner at (X, Y, Z).
+ */
+static AABB MakeBox(float X, float Y, float Z) {
+    return AABB(Vector3(X, Y, Z), Vector3(X + 1.f, Y + 1.f, Z + 1.f));
+}
+
+/**
+ * Returns the ids the query finds, sorted.
+ */
+static std::vector<uint32_t> QuerySorted(const Bvh& Index, const AABB& Bounds) {
+    std::vector<uint32_t> ids;
+    Index.Query(Bounds, ids);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+/**
+ * Fills the index with a grid of Size^3 unit boxes, two units apart; the id is the grid position.
+ */
+static void FillGrid(Bvh& Index, uint32_t Size) {
+    for (uint32_t z = 0; z < Size; ++z) {
+        for (uint32_t y = 0; y < Size; ++y) {
+            for (uint32_t x = 0; x < Size; ++x) {
+                Index.SetBounds((z * Size + y) * Size + x,
+                                MakeBox(2.f * x, 2.f * y, 2.f * z));
+            }
+        }
+    }
+}
+
+TEST(Bvh_BuildsAndQueries) {
+    Bvh index;
+    FillGrid(index, 10);
+    index.Update();
+    CHECK(index.GetItemCount() == 1000);
+    CHECK(index.GetBuildCount() == 1);
+
+    // The boxes at x, y, z in {1, 2} of the grid
+    const AABB bounds(Vector3(2.5f, 2.5f, 2.5f), Vector3(4.5f, 4.5f, 4.5f));
+    const std::vector<uint32_t> expected = {111, 112, 121, 122, 211, 212, 221, 222};
+    CHECK(QuerySorted(index, bounds) == expected);
+
+    const AABB empty(Vector3(1.25f, 1.25f, 1.25f), Vector3(1.75f, 1.75f, 1.75f));
+    CHECK(QuerySorted(index, empty).empty());
+}
+
+TEST(Bvh_QueriesFrustum) {
+    Bvh index;
+    index.SetBounds(0, AABB(Vector3(-0.5f, -0.5f, 0.2f), Vector3(0.5f, 0.5f, 0.4f)));
+    index.SetBounds(1, AABB(Vector3(2.f, 2.f, 0.2f), Vector3(3.f, 3.f, 0.4f)));
+    index.SetBounds(2, AABB(Vector3(0.9f, 0.9f, 0.9f), Vector3(1.5f, 1.5f, 1.5f)));
+    index.Update();
+
+    // The clip volume
+    std::vector<uint32_t> ids;
+    index.Query(Frustum(), ids);
+    std::sort(ids.begin(), ids.end());
+    CHECK((ids == std::vector<uint32_t>{0, 2}));
+}
+
+TEST(Bvh_RefitsMovedItems) {
+    Bvh index;
+    FillGrid(index, 8);
+    index.Update();
+
+    // A small move keeps the hierarchy and refits it
+    index.SetBounds(0, MakeBox(0.5f, 0.f, 0.f));
+    index.Update();
+    CHECK(index.GetBuildCount() == 1);
+    CHECK(index.GetRefitCount() == 1);
+
+    const AABB bounds(Vector3(1.25f, 0.25f, 0.25f), Vector3(1.3f, 0.75f, 0.75f));
+    CHECK((QuerySorted(index, bounds) == std::vector<uint32_t>{0}));
+
+    // An item moved far across the scene gets its degraded subtree rebuilt
+    index.SetBounds(0, MakeBox(100.f, 100.f, 100.f));
+    index.Update();
+    CHECK(index.GetBuildCount() == 1);
+    CHECK(index.GetSubtreeRebuildCount() > 0);
+
+    const AABB farBounds(Vector3(100.5f, 100.5f, 100.5f), Vector3(101.f, 101.f, 101.f));
+    CHECK((QuerySorted(index, farBounds) == std::vector<uint32_t>{0}));
+    CHECK(QuerySorted(index, bounds).empty());
+}
+
+TEST(Bvh_RemovesItems) {
+    Bvh index;
+    FillGrid(index, 4);
+    index.Update();
+
+    index.Remove(5);
+    CHECK(!index.Contains(5));
+
+    // Queries see the removal before the Update too
+    const AABB all(Vector3(-1.f, -1.f, -1.f), Vector3(10.f, 10.f, 10.f));
+    CHECK(QuerySorted(index, all).size() == 63);
+
+    index.Update();
+    CHECK(index.GetItemCount() == 63);
+    std::vector<uint32_t> ids = QuerySorted(index, all);
+    CHECK(ids.size() == 63);
+    CHECK(!std::binary_search(ids.begin(), ids.end(), 5u));
+
+    // Empty bounds remove the item too
+    index.SetBounds(6, AABB());
+    index.Update();
+    CHECK(!index.Contains(6));
+    CHECK(QuerySorted(index, all).size() == 62);
+}
+
+TEST(Bvh_MatchesBruteForce) {
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> position(-50.f, 50.f);
+    std::uniform_real_distribution<float> size(0.1f, 4.f);
+
+    Bvh index;
+    std::vector<AABB> boxes(2000);
+    for (uint32_t id = 0; id < boxes.size(); ++id) {
+        const float x = position(random);
+        const float y = position(random);
+        const float z = position(random);
+        boxes[id] = AABB(Vector3(x, y, z), Vector3(x + size(random), y + size(random),
+                                                   z + size(random)));
+        index.SetBounds(id, boxes[id]);
+    }
+    index.Update();
+
+    for (uint32_t query = 0; query < 50; ++query) {
+        const float x = position(random);
+        const float y = position(random);
+        const float z = position(random);
+        const AABB bounds(Vector3(x, y, z), Vector3(x + 10.f, y + 10.f, z + 10.f));
+
+        std::vector<uint32_t> expected;
+        for (uint32_t id = 0; id < boxes.size(); ++id) {
+            const AABB& box = boxes[id];
+            if (DirectX::XMVector3LessOrEqual(box.GetMin(), bounds.GetMax()) &&
+                DirectX::XMVector3LessOrEqual(bounds.GetMin(), box.GetMax())) {
+                expected.push_back(id);
+            }
+        }
+        CHECK(QuerySorted(index, bounds) == expected);
+    }
+}
+
+TEST(Bvh_InsertsAndRemovesLocally) {
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> position(-50.f, 50.f);
+    std::uniform_int_distribution<uint32_t> pick(0, 999);
+
+    Bvh index;
+    std::vector<AABB> boxes(1000);
+    std::vector<bool> isAlive(boxes.size(), true);
+    for (uint32_t id = 0; id < boxes.size(); ++id) {
+        boxes[id] = MakeBox(position(random), position(random), position(random));
+        index.SetBounds(id, boxes[id]);
+    }
+    index.Update();
+
+    // A few insertions and removals per frame get patched into the tree without a full build
+    const AABB all(Vector3(-60.f, -60.f, -60.f), Vector3(60.f, 60.f, 60.f));
+    for (uint32_t frame = 0; frame < 100; ++frame) {
+        for (uint32_t change = 0; change < 8; ++change) {
+            const uint32_t id = pick(random);
+            if (isAlive[id]) {
+                index.Remove(id);
+            } else {
+                boxes[id] = MakeBox(position(random), position(random), position(random));
+                index.SetBounds(id, boxes[id]);
+            }
+            isAlive[id] = !isAlive[id];
+        }
+        index.Update();
+
+        std::vector<uint32_t> expected;
+        for (uint32_t id = 0; id < boxes.size(); ++id) {
+            if (isAlive[id]) {
+                expected.push_back(id);
+            }
+        }
+        CHECK(index.GetItemCount() == expected.size());
+        CHECK(QuerySorted(index, all) == expected);
+
+        const float x = position(random);
+        const float y = position(random);
+        const float z = position(random);
+        const AABB bounds(Vector3(x, y, z), Vector3(x + 20.f, y + 20.f, z + 20.f));
+        expected.clear();
+        for (uint32_t id = 0; id < boxes.size(); ++id) {
+            if (isAlive[id] && DirectX::XMVector3LessOrEqual(boxes[id].GetMin(), bounds.GetMax()) &&
+                DirectX::XMVector3LessOrEqual(bounds.GetMin(), boxes[id].GetMax())) {
+                expected.push_back(id);
+            }
+        }
+        CHECK(QuerySorted(index, bounds) == expected);
+    }
+    CHECK(index.GetBuildCount() == 1);
+}
+
+TEST(Bvh_Raycasts) {
+    Bvh index;
+    index.SetBounds(0, MakeBox(5.f, 0.f, 0.f));
+    index.SetBounds(1, MakeBox(10.f, 0.f, 0.f));
+    index.SetBounds(2, MakeBox(5.f, 5.f, 0.f));
+    index.Update();
+
+    uint32_t id = Bvh::kInvalidIndex;
+    float distance = 0.f;
+    CHECK(index.Raycast(Vector3(0.f, 0.5f, 0.5f), Vector3(1.f, 0.f, 0.f), 100.f, id, distance));
+    CHECK(id == 0);
+    CHECK(distance == 5.f);
+
+    CHECK(index.Raycast(Vector3(20.f, 0.5f, 0.5f), Vector3(-1.f, 0.f, 0.f), 100.f, id, distance));
+    CHECK(id == 1);
+
+    id = Bvh::kInvalidIndex;
+    CHECK(!index.Raycast(Vector3(0.f, 0.5f, 0.5f), Vector3(1.f, 0.f, 0.f), 4.f, id, distance));
+    CHECK(!index.Raycast(Vector3(0.f, 3.f, 0.5f), Vector3(1.f, 0.f, 0.f), 100.f, id, distance));
+    CHECK(id == Bvh::kInvalidIndex);
+}
@@ -0,0 +1,165 @@
+#include <cstdint>
+#include <cstring>
+
+#include "Graphics/Command/CommandStream.h"
+#include "Graphics/Command/NullCommandBackend.h"
+#include "Test.h"
+
+// The null backend only checks the pointers for null, so any other address stands in for them
+static ID3D12RootSignature* const kRootSignature = reinterpret_cast<ID3D12RootSignature*>(16);
+static ID3D12PipelineState* const kPipelineState = reinterpret_cast<ID3D12PipelineState*>(32);
+
+/**
+ * Records the state every draw needs, the way the renderer starts a view.
+ */
+static void RecordDrawState(CommandStream& Stream) {
+    Stream.SetPrimitiveTopology(PrimitiveTopology::kTriangleList);
+    Stream.SetRootSignature(kRootSignature);
+    Stream.SetViewport(Viewport{0.f, 0.f, 640.f, 480.f, 0.f, 1.f});
+    Stream.SetScissorRect(ScissorRect{0, 0, 640, 480});
+    Stream.SetPipelineState(kPipelineState);
+    Stream.SetVertexBuffer(0, 0x10000, 36 * 32, 32);
+}
+
+TEST(CommandStream_ReplaysInOrder) {
+    CommandStream stream;
+    RecordDrawState(stream);
+
+    uint32_t dataOffset = 0;
+    float* constants = static_cast<float*>(
+        stream.AllocateData(64, CommandStream::kDataPlacementAlignment, dataOffset));
+    constants[0] = 1.f;
+    stream.SetRootShaderResourceData(1, dataOffset);
+    stream.DrawInstanced(36, 4, 0, 0);
+
+    const uint32_t rootConstants[] = {7, 8, 9};
+    stream.SetRoot32BitConstants(1, 3, rootConstants);
+    stream.DrawInstanced(36, 1, 0, 0);
+
+    CHECK(stream.GetCommandCount() == 10);
+    CHECK(stream.GetDataSize() == 64);
+    CHECK(dataOffset == 0);
+
+    NullCommandBackend backend;
+    CHECK(backend.Submit(stream));
+    CHECK(backend.GetErrorCount() == 0);
+    CHECK(backend.GetDrawCount() == 2);
+    CHECK(backend.GetCommandCount(CommandType::kSetRootShaderResourceData) == 1);
+    CHECK(backend.GetCommandCount(CommandType::kSetRoot32BitConstants) == 1);
+    CHECK(backend.GetInstanceCount() == 5);
+    CHECK(backend.GetVertexCount() == 36 * 5);
+
+    // The counters accumulate over the submissions until reset
+    CHECK(backend.Submit(stream));
+    CHECK(backend.GetDrawCount() == 4);
+    backend.Reset();
+    CHECK(backend.GetDrawCount() == 0);
+    CHECK(backend.GetInstanceCount() == 0);
+}
+
+TEST(CommandStream_AlignsData) {
+    CommandStream stream;
+    uint32_t first = 0;
+    uint32_t second = 0;
+    uint32_t third = 0;
+    stream.AllocateData(3, 1, first);
+    stream.AllocateData(16, 16, second);
+    void* data = stream.AllocateData(64, CommandStream::kDataPlacementAlignment, third);
+    CHECK(first == 0);
+    CHECK(second == 16);
+    CHECK(third == CommandStream::kDataPlacementAlignment);
+    CHECK(stream.GetDataSize() == CommandStream::kDataPlacementAlignment + 64);
+
+    // The earlier ranges survive the blob growing
+    memset(data, 0xAB, 64);
+    uint32_t grown = 0;
+    stream.AllocateData(1 << 16, 16, grown);
+    CHECK(static_cast<uint8_t>(stream.GetData()[third + 63]) == 0xAB);
+}
+
+TEST(CommandStream_ReusesMemoryAfterReset) {
+    CommandStream stream;
+    RecordDrawState(stream);
+    stream.DrawInstanced(3, 1, 0, 0);
+    const size_t commandsSize = stream.GetCommandsSize();
+
+    stream.Reset();
+    CHECK(stream.GetCommandCount() == 0);
+    CHECK(stream.GetCommandsSize() == 0);
+    CHECK(stream.GetDataSize() == 0);
+
+    RecordDrawState(stream);
+    stream.DrawInstanced(3, 1, 0, 0);
+    CHECK(stream.GetCommandsSize() == commandsSize);
+}
+
+TEST(NullCommandBackend_RejectsDrawWithoutState) {
+    CommandStream stream;
+    stream.SetPrimitiveTopology(PrimitiveTopology::kTriangleList);
+    stream.SetRootSignature(kRootSignature);
+    stream.SetViewport(Viewport{0.f, 0.f, 640.f, 480.f, 0.f, 1.f});
+    stream.SetScissorRect(ScissorRect{0, 0, 640, 480});
+    stream.SetVertexBuffer(0, 0x10000, 36 * 32, 32);
+    // No pipeline state
+    stream.DrawInstanced(36, 2, 0, 0);
+
+    NullCommandBackend backend;
+    CHECK(!backend.Submit(stream));
+    CHECK(backend.GetErrorCount() == 1);
+    CHECK(backend.GetDrawCount() == 1);
+    CHECK(backend.GetInstanceCount() == 0);
+
+    // The state doesn't carry over into the next stream
+    CommandStream complete;
+    RecordDrawState(complete);
+    complete.DrawInstanced(36, 2, 0, 0);
+    CHECK(backend.Submit(complete));
+    CHECK(!backend.Submit(stream));
+    CHECK(backend.GetErrorCount() == 2);
+    CHECK(backend.GetInstanceCount() == 2);
+}
+
+TEST(NullCommandBackend_RejectsInvalidState) {
+    NullCommandBackend backend;
+
+    CommandStream nullPipeline;
+    RecordDrawState(nullPipeline);
+    nullPipeline.SetPipelineState(nullptr);
+    CHECK(!backend.Submit(nullPipeline));
+
+    CommandStream emptyViewport;
+    emptyViewport.SetViewport(Viewport{0.f, 0.f, 0.f, 480.f, 0.f, 1.f});
+    CHECK(!backend.Submit(emptyViewport));
+
+    CommandStream zeroStride;
+    zeroStride.SetVertexBuffer(0, 0x10000, 1024, 0);
+    CHECK(!backend.Submit(zeroStride));
+
+    CommandStream noConstants;
+    noConstants.SetRoot32BitConstants(1, 0, nullptr);
+    CHECK(!backend.Submit(noConstants));
+
+    CHECK(backend.GetErrorCount() == 4);
+}
+
+TEST(NullCommandBackend_RejectsBadDataOffsets) {
+    CommandStream stream;
+    RecordDrawState(stream);
+    uint32_t dataOffset = 0;
+    stream.AllocateData(64, CommandStream::kDataPlacementAlignment, dataOffset);
+
+    // Past the end of the data blob
+    stream.SetRootShaderResourceData(1, 64);
+    // Within the blob but not at the constant buffer placement alignment
+    stream.SetRootConstantBufferData(0, 16);
+    stream.SetRootConstantBufferData(0, dataOffset);
+    stream.DrawInstanced(36, 1, 0, 0);
+
+    NullCommandBackend backend;
+    CHECK(!backend.Submit(stream));
+    CHECK(backend.GetErrorCount() == 2);
+    CHECK(backend.GetCommandCount(CommandType::kSetRootConstantBufferData) == 2);
+
+    // The draw itself has all its state, so it still counts
+    CHECK(backend.GetInstanceCount() == 1);
+}
@@ -0,0 +1,101 @@
+#include <memory>
+#include <vector>
+
+#include "Graphics/DeferredReleaseQueue.h"
+#include "Test.h"
+
+/**
+ * Counts its own destruction, standing in for a GPU resource.
+ */
+class ReleaseCounter {
+   public:
+    explicit ReleaseCounter(int& ReleaseCount) : mReleaseCount(&ReleaseCount) {}
+
+    ~ReleaseCounter() {
+        if (mReleaseCount) {
+            ++*mReleaseCount;
+        }
+    }
+
+    // Prohibit copying
+    ReleaseCounter(const ReleaseCounter&) = delete;
+    ReleaseCounter& operator=(const ReleaseCounter&) = delete;
+
+    // Allow moving
+    ReleaseCounter(ReleaseCounter&& Other) noexcept
+        : mReleaseCount(std::exchange(Other.mReleaseCount, nullptr)) {}
+
+    ReleaseCounter& operator=(ReleaseCounter&& Other) noexcept {
+        if (this != &Other) {
+            mReleaseCount = std::exchange(Other.mReleaseCount, nullptr);
+        }
+        return *this;
+    }
+
+   private:
+    int* mReleaseCount;
+};
+
+TEST(DeferredReleaseQueue_ReleasesCompletedFences) {
+    int releaseCount = 0;
+    DeferredReleaseQueue<ReleaseCounter> queue;
+    queue.Enqueue(5, ReleaseCounter(releaseCount));
+    queue.Enqueue(6, ReleaseCounter(releaseCount));
+    queue.Enqueue(6, ReleaseCounter(releaseCount));
+    CHECK(releaseCount == 0);
+
+    CHECK(queue.Release(4) == 0);
+    CHECK(queue.Release(5) == 1);
+    CHECK(releaseCount == 1);
+    CHECK(queue.Release(7) == 2);
+    CHECK(releaseCount == 3);
+    CHECK(queue.GetSize() == 0);
+}
+
+TEST(DeferredReleaseQueue_KeepsFenceOrder) {
+    int releaseCount = 0;
+    DeferredReleaseQueue<ReleaseCounter> queue;
+
+    // A lower fence value racing in after a higher one waits for the higher one
+    queue.Enqueue(9, ReleaseCounter(releaseCount));
+    queue.Enqueue(3, ReleaseCounter(releaseCount));
+    CHECK(queue.Release(3) == 0);
+    CHECK(queue.Release(9) == 2);
+    CHECK(releaseCount == 2);
+}
+
+TEST(DeferredReleaseQueue_TakesWithoutReleasing) {
+    int releaseCount = 0;
+    DeferredReleaseQueue<ReleaseCounter> queue;
+    queue.Enqueue(1, ReleaseCounter(releaseCount));
+    queue.Enqueue(2, ReleaseCounter(releaseCount));
+
+    std::vector<ReleaseCounter> taken;
+    CHECK(queue.Take(1, taken) == 1);
+    CHECK(taken.size() == 1);
+    CHECK(releaseCount == 0);
+    CHECK(queue.GetSize() == 1);
+
+    // Parked on another fence, the way the releaser moves them from the copy queue on
+    DeferredReleaseQueue<ReleaseCounter> nextStage;
+    nextStage.Enqueue(10, std::move(taken.back()));
+    taken.clear();
+    CHECK(releaseCount == 0);
+    CHECK(nextStage.Release(10) == 1);
+    CHECK(releaseCount == 1);
+}
+
+TEST(DeferredReleaseQueue_ReleasesAllOnDestruction) {
+    int releaseCount = 0;
+    {
+        DeferredReleaseQueue<ReleaseCounter> queue;
+        queue.Enqueue(100, ReleaseCounter(releaseCount));
+        queue.Enqueue(200, ReleaseCounter(releaseCount));
+    }
+    CHECK(releaseCount == 2);
+
+    DeferredReleaseQueue<ReleaseCounter> queue;
+    queue.Enqueue(100, ReleaseCounter(releaseCount));
+    CHECK(queue.ReleaseAll() == 1);
+    CHECK(releaseCount == 3);
+}
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <vector>
+
+#include "Memory/DescriptorAllocator.h"
+#include "Test.h"
+
+constexpr uint32_t kCount = 1024;
+constexpr uint32_t kTransientCountPerFrame = 128;
+constexpr uint32_t kFrameCount = 3;
+constexpr uint32_t kPersistentCount = kCount - kTransientCountPerFrame * kFrameCount;
+
+TEST(DescriptorAllocator_KeepsRangesInBounds) {
+    DescriptorAllocator allocator(kCount, kTransientCountPerFrame, kFrameCount);
+    CHECK(allocator.GetCount() == kCount);
+    CHECK(allocator.GetPersistentCount() == kPersistentCount);
+
+    // Ranges of 1 to 8 descriptors until the persistent part is full
+    std::vector<bool> isUsed(kCount, false);
+    std::vector<uint32_t> indices;
+    uint32_t usedCount = 0;
+    for (uint32_t count = 1; usedCount + count <= kPersistentCount; count = count % 8 + 1) {
+        uint32_t index = 0;
+        CHECK(allocator.Allocate(count, index));
+        CHECK(index + count <= kPersistentCount);
+        for (uint32_t i = index; i < index + count && i < kCount; ++i) {
+            CHECK(!isUsed[i]);
+            isUsed[i] = true;
+        }
+        indices.push_back(index);
+        usedCount += count;
+    }
+    CHECK(allocator.GetPersistentUsedCount() == usedCount);
+
+    // The transient slices stay clear of the persistent ranges
+    for (uint32_t frame = 0; frame < kFrameCount; ++frame) {
+        allocator.BeginFrame(frame);
+        uint32_t index = 0;
+        CHECK(allocator.AllocateTransient(kTransientCountPerFrame, index));
+        CHECK(index == kPersistentCount + frame * kTransientCountPerFrame);
+        CHECK(std::none_of(isUsed.begin() + index,
+                           isUsed.begin() + index + kTransientCountPerFrame,
+                           [](bool IsUsed) { return IsUsed; }));
+    }
+
+    // A freed range gets reused
+    allocator.Free(indices[3]);
+    CHECK(allocator.GetPersistentUsedCount() == usedCount - 4);
+    uint32_t index = 0;
+    CHECK(allocator.Allocate(4, index));
+    CHECK(index == indices[3]);
+}
+
+TEST(DescriptorAllocator_RecyclesTransientSlices) {
+    DescriptorAllocator allocator(kCount, kTransientCountPerFrame, kFrameCount);
+
+    allocator.BeginFrame(1);
+    uint32_t first = 0;
+    uint32_t second = 0;
+    CHECK(allocator.AllocateTransient(10, first));
+    CHECK(allocator.AllocateTransient(20, second));
+    CHECK(first == kPersistentCount + kTransientCountPerFrame);
+    CHECK(second == first + 10);
+    CHECK(allocator.GetTransientUsedCount() == 30);
+
+    // The next frame bumps out of its own slice
+    allocator.BeginFrame(2);
+    CHECK(allocator.GetTransientUsedCount() == 0);
+    uint32_t next = 0;
+    CHECK(allocator.AllocateTransient(10, next));
+    CHECK(next == kPersistentCount + 2 * kTransientCountPerFrame);
+
+    // Back in the slot, the slice starts over
+    allocator.BeginFrame(1);
+    uint32_t again = 0;
+    CHECK(allocator.AllocateTransient(10, again));
+    CHECK(again == first);
+
+    // The transient descriptors never touch the persistent part
+    CHECK(allocator.GetPersistentUsedCount() == 0);
+}
+
+TEST(DescriptorAllocator_FailsWhenExhausted) {
+    DescriptorAllocator allocator(kCount, kTransientCountPerFrame, kFrameCount);
+
+    uint32_t index = 7;
+    CHECK(!allocator.Allocate(kPersistentCount + 1, index));
+    CHECK(index == 7);
+    CHECK(allocator.Allocate(kPersistentCount, index));
+    CHECK(index == 0);
+    uint32_t overflow = 7;
+    CHECK(!allocator.Allocate(1, overflow));
+    CHECK(overflow == 7);
+
+    allocator.Free(index);
+    CHECK(allocator.GetPersistentUsedCount() == 0);
+    CHECK(allocator.Allocate(1, overflow));
+
+    // The transient slice runs out without spilling into the next one
+    allocator.BeginFrame(0);
+    uint32_t transient = 7;
+    CHECK(allocator.AllocateTransient(kTransientCountPerFrame - 1, transient));
+    CHECK(allocator.AllocateTransient(1, transient));
+    CHECK(transient == kPersistentCount + kTransientCountPerFrame - 1);
+    transient = 7;
+    CHECK(!allocator.AllocateTransient(1, transient));
+    CHECK(transient == 7);
+    CHECK(allocator.GetTransientUsedCount() == kTransientCountPerFrame);
+
+    allocator.BeginFrame(0);
+    CHECK(allocator.AllocateTransient(1, transient));
+}
@@ -0,0 +1,108 @@
+#include <vector>
+
+#include "Graphics/FrameRing.h"
+#include "Test.h"
+
+/**
+ * A queue whose fence completes when the test says so, the way the GPU catches up. A wait on a
+ * value the fence hasn't reached blocks until the GPU gets there, like CommandQueue's.
+ */
+class FakeFenceQueue {
+   public:
+    bool WaitForFenceValue(uint64_t FenceValue) {
+        WaitedValues.push_back(FenceValue);
+        if (FailWaits) {
+            return false;
+        }
+        if (FenceValue > CompletedValue) {
+            ++BlockedCount;
+            CompletedValue = FenceValue;
+        }
+        return true;
+    }
+
+    /**
+     * Submits a frame's work, returning the fence value it signals.
+     */
+    uint64_t Submit() {
+        return ++SignaledValue;
+    }
+
+    std::vector<uint64_t> WaitedValues;
+    uint64_t SignaledValue{0};
+    uint64_t CompletedValue{0};
+    uint32_t BlockedCount{0};
+    bool FailWaits{false};
+};
+
+TEST(FrameRing_WaitsOnlyForSlotsInFlight) {
+    FakeFenceQueue queue;
+    FrameRing<FakeFenceQueue> ring(queue, 3);
+
+    // The first frames find their slots unused
+    for (uint32_t frame = 0; frame < 3; ++frame) {
+        CHECK(ring.GetFrameIndex() == frame);
+        CHECK(ring.BeginFrame());
+        ring.EndFrame(queue.Submit());
+    }
+    CHECK(queue.BlockedCount == 0);
+    CHECK(ring.GetFrameFenceValue(2) == 3);
+
+    // The GPU finished frame 0 in the meantime, so its slot is free right away
+    queue.CompletedValue = 1;
+    CHECK(ring.BeginFrame());
+    CHECK(queue.WaitedValues.back() == 1);
+    CHECK(queue.BlockedCount == 0);
+    ring.EndFrame(queue.Submit());
+
+    // Frame 1 is still in flight: the CPU waits for exactly its fence value, not the latest one
+    CHECK(ring.BeginFrame());
+    CHECK(queue.WaitedValues.back() == 2);
+    CHECK(queue.BlockedCount == 1);
+    CHECK(queue.CompletedValue == 2);
+    ring.EndFrame(queue.Submit());
+}
+
+TEST(FrameRing_ReusesSlotsInOrder) {
+    constexpr uint32_t kFrameCount = 2;
+    constexpr uint32_t kFrames = 7;
+
+    FakeFenceQueue queue;
+    FrameRing<FakeFenceQueue> ring(queue, kFrameCount);
+
+    for (uint32_t frame = 0; frame < kFrames; ++frame) {
+        CHECK(ring.GetFrameIndex() == frame % kFrameCount);
+        CHECK(ring.BeginFrame());
+        ring.EndFrame(queue.Submit());
+        CHECK(ring.GetFrameNumber() == frame + 1);
+    }
+
+    // Every frame waited for the one FrameCount frames before it, wrapping around the slots
+    CHECK(queue.WaitedValues.size() == kFrames);
+    for (uint32_t frame = 0; frame < kFrames; ++frame) {
+        const uint64_t expected = frame < kFrameCount ? 0 : frame - kFrameCount + 1;
+        CHECK(queue.WaitedValues[frame] == expected);
+    }
+    CHECK(ring.GetFrameIndex() == kFrames % kFrameCount);
+    CHECK(ring.GetFrameFenceValue(0) == kFrames);
+    CHECK(ring.GetFrameFenceValue(1) == kFrames - 1);
+}
+
+TEST(FrameRing_KeepsSlotOnFailedWait) {
+    FakeFenceQueue queue;
+    FrameRing<FakeFenceQueue> ring(queue, 2);
+    CHECK(ring.BeginFrame());
+    ring.EndFrame(queue.Submit());
+    CHECK(ring.BeginFrame());
+    ring.EndFrame(queue.Submit());
+
+    queue.FailWaits = true;
+    CHECK(!ring.BeginFrame());
+    CHECK(ring.GetFrameIndex() == 0);
+    CHECK(ring.GetFrameNumber() == 2);
+
+    // The slot is still waiting for the same frame
+    queue.FailWaits = false;
+    CHECK(ring.BeginFrame());
+    CHECK(queue.WaitedValues.back() == 1);
+}
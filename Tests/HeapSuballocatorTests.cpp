@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Memory/HeapSuballocator.h"
+#include "Test.h"
+
+/**
+ * Records the blocks and pages the suballocator asks for, the way the HeapAllocator creates the
+ * heaps and the page buffers.
+ */
+class FakeHeapBackend {
+   public:
+    bool CreateBlock(uint32_t BlockIndex) {
+        ++CreateBlockCount;
+        if (FailBlocks) {
+            return false;
+        }
+        if (BlockIndex == Blocks.size()) {
+            Blocks.push_back(false);
+        }
+        CHECK(!Blocks[BlockIndex]);
+        Blocks[BlockIndex] = true;
+        return true;
+    }
+
+    void ReleaseBlock(uint32_t BlockIndex) {
+        CHECK(Blocks[BlockIndex]);
+        Blocks[BlockIndex] = false;
+    }
+
+    bool CreatePage(uint32_t PageIndex, uint32_t BlockIndex, uint64_t Offset) {
+        ++CreatePageCount;
+        if (FailPages) {
+            return false;
+        }
+        CHECK(Blocks[BlockIndex]);
+        if (PageIndex == Pages.size()) {
+            Pages.emplace_back();
+        }
+        CHECK(!Pages[PageIndex].IsLive);
+        Pages[PageIndex] = Page{true, BlockIndex, Offset};
+        return true;
+    }
+
+    void ReleasePage(uint32_t PageIndex) {
+        CHECK(Pages[PageIndex].IsLive);
+        Pages[PageIndex].IsLive = false;
+    }
+
+    uint32_t GetLiveBlockCount() const {
+        return static_cast<uint32_t>(std::count(Blocks.begin(), Blocks.end(), true));
+    }
+
+    uint32_t GetLivePageCount() const {
+        return static_cast<uint32_t>(std::count_if(
+            Pages.begin(), Pages.end(), [](const Page& Page) { return Page.IsLive; }));
+    }
+
+    struct Page {
+        bool IsLive{false};
+        uint32_t BlockIndex{0};
+        uint64_t Offset{0};
+    };
+
+    std::vector<bool> Blocks;
+    std::vector<Page> Pages;
+    uint32_t CreateBlockCount{0};
+    uint32_t CreatePageCount{0};
+    bool FailBlocks{false};
+    bool FailPages{false};
+};
+
+using Suballocator = HeapSuballocator<FakeHeapBackend>;
+
+constexpr uint64_t kKilobyte = 1024;
+
+/**
+ * Checks that the buffers don't overlap within their heap blocks, the packed ones included.
+ */
+static bool AreDisjoint(const FakeHeapBackend& Backend, const std::vector<HeapRange>& Ranges) {
+    struct Extent {
+        uint32_t BlockIndex;
+        uint64_t Offset;
+        uint64_t Size;
+    };
+    std::vector<Extent> extents;
+    for (const HeapRange& range : Ranges) {
+        uint64_t offset = range.Range.Offset;
+        if (range.IsPacked()) {
+            const FakeHeapBackend::Page& page = Backend.Pages[range.PageIndex];
+            if (!page.IsLive || page.BlockIndex != range.BlockIndex ||
+                range.Range.Offset + range.Range.Size > Suballocator::kPageSize) {
+                return false;
+            }
+            offset += page.Offset;
+        }
+        extents.push_back({range.BlockIndex, offset, range.Range.Size});
+    }
+
+    std::sort(extents.begin(), extents.end(), [](const Extent& A, const Extent& B) {
+        return A.BlockIndex != B.BlockIndex ? A.BlockIndex < B.BlockIndex : A.Offset < B.Offset;
+    });
+    for (size_t i = 0; i < extents.size(); ++i) {
+        const uint64_t end = extents[i].Offset + extents[i].Size;
+        if (end > Suballocator::kBlockSize ||
+            (i + 1 < extents.size() && extents[i].BlockIndex == extents[i + 1].BlockIndex &&
+             end > extents[i + 1].Offset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(HeapSuballocator_ReportsPlacementWaste) {
+    FakeHeapBackend backend;
+    Suballocator suballocator(backend);
+
+    HeapRange range;
+    CHECK(suballocator.Allocate(100 * kKilobyte, false, range));
+    CHECK(!range.IsPacked());
+    CHECK(range.Range.Offset % Suballocator::kPlacementAlignment == 0);
+    CHECK(range.Size == 100 * kKilobyte);
+
+    HeapStats stats;
+    suballocator.GetStats(stats);
+    CHECK(stats.HeapCount == 1);
+    CHECK(stats.AllocationCount == 1);
+    CHECK(stats.ReservedSize == Suballocator::kBlockSize);
+    CHECK(stats.UsedSize == 128 * kKilobyte);
+    CHECK(stats.RequestedSize == 100 * kKilobyte);
+    CHECK(stats.WastedSize == 28 * kKilobyte);
+
+    // Too large to pack, so it gets placed all the same
+    HeapRange large;
+    CHECK(suballocator.Allocate(Suballocator::kMaxPackedSize + 1, true, large));
+    CHECK(!large.IsPacked());
+    CHECK(backend.CreatePageCount == 0);
+}
+
+TEST(HeapSuballocator_PacksSmallBuffers) {
+    constexpr uint32_t kBufferCount = 64;
+    constexpr uint64_t kBufferSize = 1000;
+
+    FakeHeapBackend backend;
+    Suballocator packing(backend);
+    FakeHeapBackend placedBackend;
+    Suballocator placing(placedBackend);
+
+    std::vector<HeapRange> ranges(kBufferCount);
+    for (HeapRange& range : ranges) {
+        CHECK(packing.Allocate(kBufferSize, true, range));
+        CHECK(range.IsPacked());
+        CHECK(range.PageIndex == 0);
+        CHECK(range.Range.Offset % Suballocator::kPackedAlignment == 0);
+
+        HeapRange placed;
+        CHECK(placing.Allocate(kBufferSize, false, placed));
+    }
+    CHECK(AreDisjoint(backend, ranges));
+
+    HeapStats packed;
+    packing.GetStats(packed);
+    CHECK(packed.PageCount == 1);
+    CHECK(packed.PackedCount == kBufferCount);
+    CHECK(packed.AllocationCount == kBufferCount);
+    CHECK(packed.UsedSize == Suballocator::kPageSize);
+    CHECK(packed.PageFreeSize == Suballocator::kPageSize - kBufferCount * 1024);
+    CHECK(packed.WastedSize == kBufferCount * (1024 - kBufferSize));
+
+    HeapStats placed;
+    placing.GetStats(placed);
+    CHECK(placed.PageCount == 0);
+    CHECK(placed.AllocationCount == kBufferCount);
+    CHECK(placed.UsedSize == kBufferCount * Suballocator::kPlacementAlignment);
+    CHECK(placed.WastedSize == kBufferCount * (Suballocator::kPlacementAlignment - kBufferSize));
+}
+
+TEST(HeapSuballocator_ReleasesEmptyPagesAndBlocks) {
+    constexpr uint32_t kPerPage = Suballocator::kPageSize / Suballocator::kMaxPackedSize;
+
+    FakeHeapBackend backend;
+    Suballocator suballocator(backend);
+
+    std::vector<HeapRange> ranges(kPerPage);
+    for (HeapRange& range : ranges) {
+        CHECK(suballocator.Allocate(Suballocator::kMaxPackedSize, true, range));
+        CHECK(range.PageIndex == 0);
+    }
+    HeapRange overflow;
+    CHECK(suballocator.Allocate(Suballocator::kMaxPackedSize, true, overflow));
+    CHECK(overflow.PageIndex == 1);
+    CHECK(backend.GetLivePageCount() == 2);
+
+    // The full block doesn't fit next to the pages
+    HeapRange whole;
+    CHECK(suballocator.Allocate(Suballocator::kBlockSize, false, whole));
+    CHECK(whole.BlockIndex == 1);
+    CHECK(backend.GetLiveBlockCount() == 2);
+
+    suballocator.Free(overflow);
+    CHECK(backend.GetLivePageCount() == 1);
+    suballocator.Free(whole);
+    CHECK(backend.GetLiveBlockCount() == 1);
+
+    // The last page and block stay for the next buffers
+    for (const HeapRange& range : ranges) {
+        suballocator.Free(range);
+    }
+    CHECK(backend.GetLivePageCount() == 1);
+    CHECK(backend.GetLiveBlockCount() == 1);
+
+    HeapStats stats;
+    suballocator.GetStats(stats);
+    CHECK(stats.AllocationCount == 0);
+    CHECK(stats.RequestedSize == 0);
+    CHECK(stats.UsedSize == Suballocator::kPageSize);
+    CHECK(stats.PageFreeSize == Suballocator::kPageSize);
+    CHECK(stats.WastedSize == 0);
+
+    HeapRange again;
+    CHECK(suballocator.Allocate(1, true, again));
+    CHECK(backend.CreatePageCount == 2);
+    CHECK(backend.CreateBlockCount == 2);
+}
+
+TEST(HeapSuballocator_ReusesReleasedIndices) {
+    FakeHeapBackend backend;
+    Suballocator suballocator(backend);
+
+    HeapRange first;
+    HeapRange second;
+    CHECK(suballocator.Allocate(Suballocator::kBlockSize, false, first));
+    CHECK(suballocator.Allocate(Suballocator::kBlockSize, false, second));
+    suballocator.Free(first);
+
+    HeapRange third;
+    CHECK(suballocator.Allocate(Suballocator::kBlockSize, false, third));
+    CHECK(third.BlockIndex == first.BlockIndex);
+    CHECK(backend.Blocks.size() == 2);
+}
+
+TEST(HeapSuballocator_LeavesRangeOnFailure) {
+    FakeHeapBackend backend;
+    Suballocator suballocator(backend);
+
+    HeapRange range;
+    range.BlockIndex = 7;
+    CHECK(!suballocator.Allocate(Suballocator::kBlockSize + 1, false, range));
+    CHECK(backend.CreateBlockCount == 0);
+
+    backend.FailBlocks = true;
+    CHECK(!suballocator.Allocate(1024, false, range));
+    CHECK(!suballocator.Allocate(1024, true, range));
+    CHECK(range.BlockIndex == 7);
+
+    // The block of the failed page gets its range back
+    backend.FailBlocks = false;
+    backend.FailPages = true;
+    CHECK(!suballocator.Allocate(1024, true, range));
+    CHECK(range.BlockIndex == 7);
+    CHECK(backend.CreatePageCount == 1);
+
+    HeapStats stats;
+    suballocator.GetStats(stats);
+    CHECK(stats.HeapCount == 1);
+    CHECK(stats.PageCount == 0);
+    CHECK(stats.AllocationCount == 0);
+    CHECK(stats.UsedSize == 0);
+    CHECK(stats.RequestedSize == 0);
+
+    backend.FailPages = false;
+    CHECK(suballocator.Allocate(1024, true, range));
+    CHECK(range.IsPacked());
+    CHECK(backend.Blocks.size() == 1);
+}
+
+TEST(HeapSuballocator_SurvivesChurn) {
+    FakeHeapBackend backend;
+    Suballocator suballocator(backend);
+
+    std::mt19937 random(42);
+    std::vector<HeapRange> ranges;
+    uint64_t requestedSize = 0;
+    uint32_t packedCount = 0;
+    for (uint32_t step = 0; step < 20000; ++step) {
+        if (!ranges.empty() && random() % 3 == 0) {
+            const size_t index = random() % ranges.size();
+            requestedSize -= ranges[index].Size;
+            packedCount -= ranges[index].IsPacked();
+            suballocator.Free(ranges[index]);
+            ranges[index] = ranges.back();
+            ranges.pop_back();
+            continue;
+        }
+
+        // Mostly small buffers, the way the meshes and the constants come
+        const uint64_t size = 1 + random() % (random() % 4 == 0 ? 1024 * kKilobyte : kKilobyte);
+        HeapRange range;
+        CHECK(suballocator.Allocate(size, random() % 2 == 0, range));
+        requestedSize += size;
+        packedCount += range.IsPacked();
+        ranges.push_back(range);
+    }
+
+    CHECK(AreDisjoint(backend, ranges));
+
+    HeapStats stats;
+    suballocator.GetStats(stats);
+    CHECK(stats.AllocationCount == ranges.size());
+    CHECK(stats.PackedCount == packedCount);
+    CHECK(stats.RequestedSize == requestedSize);
+    CHECK(stats.HeapCount == backend.GetLiveBlockCount());
+    CHECK(stats.PageCount == backend.GetLivePageCount());
+    CHECK(stats.UsedSize == stats.RequestedSize + stats.PageFreeSize + stats.WastedSize);
+
+    for (const HeapRange& range : ranges) {
+        suballocator.Free(range);
+    }
+    suballocator.GetStats(stats);
+    CHECK(stats.HeapCount == 1);
+    CHECK(stats.PageCount == 1);
+    CHECK(stats.AllocationCount == 0);
+    CHECK(stats.WastedSize == 0);
+}
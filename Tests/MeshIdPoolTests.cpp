@@ -0,0 +1,73 @@
+#include <thread>
+#include <vector>
+
+#include "Graphics/Mesh/MeshIdPool.h"
+#include "Test.h"
+
+TEST(MeshIdPool_RecyclesIds) {
+    MeshIdPool pool;
+    const MeshId a = pool.Acquire();
+    const MeshId b = pool.Acquire();
+    const MeshId c = pool.Acquire();
+    CHECK(a == 0 && b == 1 && c == 2);
+
+    // The freed ids come back before the range grows
+    pool.Release(b);
+    pool.Release(a);
+    CHECK(pool.GetLiveCount() == 1);
+    CHECK(pool.Acquire() == a);
+    CHECK(pool.Acquire() == b);
+    CHECK(pool.Acquire() == 3);
+    CHECK(pool.GetIdRange() == 4);
+}
+
+TEST(MeshIdPool_StaysWithinTheLiveCount) {
+    // Far more meshes created over time than the 16 bits of the rendering key hold, a few hundred
+    // at a time the way the levels stream in and out
+    constexpr uint32_t kLiveCount = 300;
+    MeshIdPool pool;
+    std::vector<MeshId> live;
+    for (uint32_t i = 0; i < 100000; ++i) {
+        if (live.size() == kLiveCount) {
+            pool.Release(live[i % kLiveCount]);
+            live[i % kLiveCount] = pool.Acquire();
+        } else {
+            live.push_back(pool.Acquire());
+        }
+    }
+    CHECK(pool.GetLiveCount() == kLiveCount);
+    CHECK(pool.GetIdRange() == kLiveCount);
+}
+
+TEST(MeshIdPool_HandsOutUniqueIdsAcrossThreads) {
+    constexpr uint32_t kThreadCount = 4;
+    constexpr uint32_t kIdsPerThread = 1000;
+    MeshIdPool pool;
+
+    std::vector<std::vector<MeshId>> ids(kThreadCount);
+    std::vector<std::thread> threads;
+    for (uint32_t thread = 0; thread < kThreadCount; ++thread) {
+        threads.emplace_back([&pool, &Ids = ids[thread]]() {
+            for (uint32_t i = 0; i < kIdsPerThread; ++i) {
+                Ids.push_back(pool.Acquire());
+                if (i % 2 == 1) {
+                    pool.Release(Ids.back());
+                    Ids.pop_back();
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<bool> isTaken(pool.GetIdRange(), false);
+    for (const std::vector<MeshId>& threadIds : ids) {
+        for (MeshId id : threadIds) {
+            CHECK(!isTaken[id]);
+            isTaken[id] = true;
+        }
+    }
+    CHECK(pool.GetLiveCount() == kThreadCount * kIdsPerThread / 2);
+    CHECK(pool.GetIdRange() <= kThreadCount * kIdsPerThread / 2 + kThreadCount);
+}
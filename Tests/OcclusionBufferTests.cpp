@@ -0,0 +1,159 @@
+#include <cmath>
+#include <memory>
+
+#include "Graphics/OcclusionBuffer.h"
+#include "Test.h"
+
+// Maps the world onto the clip space as is: x and y in [-1, 1], the depth in [0, 1]
+static const float kIdentity[16] = {1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f,
+                                    0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f};
+
+/**
+ * Rasterizes a quad over the given part of the screen at the given depth.
+ */
+static void RasterizeQuad(OcclusionBuffer& Buffer,
+                          float MinX,
+                          float MinY,
+                          float MaxX,
+                          float MaxY,
+                          float Depth) {
+    const float positions[] = {MinX, MinY, Depth, MaxX, MinY, Depth, MaxX, MaxY, Depth,
+                               MinX, MinY, Depth, MaxX, MaxY, Depth, MinX, MaxY, Depth};
+    Buffer.RasterizeOccluder(kIdentity, positions, 6, 3 * sizeof(float));
+}
+
+TEST(OcclusionBuffer_RejectsInvalidSize) {
+    std::unique_ptr<OcclusionBuffer> buffer;
+    CHECK(!OcclusionBuffer::Create(0, 64, buffer));
+    CHECK(!OcclusionBuffer::Create(100, 64, buffer));
+    CHECK(OcclusionBuffer::Create(64, 32, buffer));
+    CHECK(buffer && buffer->GetWidth() == 64 && buffer->GetHeight() == 32);
+}
+
+TEST(OcclusionBuffer_RasterizesOccluders) {
+    std::unique_ptr<OcclusionBuffer> buffer;
+    CHECK(OcclusionBuffer::Create(64, 64, buffer));
+
+    buffer->Clear(kIdentity);
+    RasterizeQuad(*buffer, -1.f, -1.f, 0.f, 0.f, 0.25f);
+    CHECK(buffer->GetRasterizedTriangleCount() == 2);
+
+    // The lower left quarter; y goes down in pixels
+    CHECK(buffer->GetDepth(10, 50) == 0.25f);
+    CHECK(buffer->GetDepth(31, 32) == 0.25f);
+    CHECK(buffer->GetDepth(32, 50) == 1.f);
+    CHECK(buffer->GetDepth(10, 31) == 1.f);
+
+    // The nearest depth wins
+    RasterizeQuad(*buffer, -1.f, -1.f, 1.f, 1.f, 0.5f);
+    CHECK(buffer->GetDepth(10, 50) == 0.25f);
+    CHECK(buffer->GetDepth(50, 10) == 0.5f);
+}
+
+TEST(OcclusionBuffer_SkipsTrianglesCrossingNearPlane) {
+    std::unique_ptr<OcclusionBuffer> buffer;
+    CHECK(OcclusionBuffer::Create(32, 32, buffer));
+
+    buffer->Clear(kIdentity);
+    const float positions[] = {-1.f, -1.f, -0.5f, 1.f, -1.f, 0.5f, 1.f, 1.f, 0.5f};
+    buffer->RasterizeOccluder(kIdentity, positions, 3, 3 * sizeof(float));
+    CHECK(buffer->GetRasterizedTriangleCount() == 0);
+    CHECK(buffer->GetDepth(16, 16) == 1.f);
+}
+
+TEST(OcclusionBuffer_CullsHiddenBoxes) {
+    std::unique_ptr<OcclusionBuffer> buffer;
+    CHECK(OcclusionBuffer::Create(64, 64, buffer));
+
+    buffer->Clear(kIdentity);
+    RasterizeQuad(*buffer, -1.f, -1.f, 1.f, 1.f, 0.5f);
+    buffer->BuildHierarchy();
+
+    const float behindMin[] = {-0.5f, -0.5f, 0.7f};
+    const float behindMax[] = {0.5f, 0.5f, 0.8f};
+    CHECK(!buffer->IsVisible(behindMin, behindMax));
+
+    const float frontMin[] = {-0.5f, -0.5f, 0.1f};
+    const float frontMax[] = {0.5f, 0.5f, 0.2f};
+    CHECK(buffer->IsVisible(frontMin, frontMax));
+
+    // Partially in front of the occluder
+    const float crossingMin[] = {-0.5f, -0.5f, 0.4f};
+    const float crossingMax[] = {0.5f, 0.5f, 0.9f};
+    CHECK(buffer->IsVisible(crossingMin, crossingMax));
+
+    // Crossing the near plane
+    const float nearMin[] = {-0.5f, -0.5f, -1.f};
+    const float nearMax[] = {0.5f, 0.5f, 0.9f};
+    CHECK(buffer->IsVisible(nearMin, nearMax));
+
+    CHECK(buffer->GetTestedCount() == 4);
+    CHECK(buffer->GetCulledCount() == 1);
+}
+
+TEST(OcclusionBuffer_CullsOffScreenBoxes) {
+    std::unique_ptr<OcclusionBuffer> buffer;
+    CHECK(OcclusionBuffer::Create(64, 64, buffer));
+
+    buffer->Clear(kIdentity);
+    buffer->BuildHierarchy();
+
+    const float min[] = {2.f, -0.5f, 0.5f};
+    const float max[] = {3.f, 0.5f, 0.6f};
+    CHECK(!buffer->IsVisible(min, max));
+
+    // Nothing got rasterized, so anything on the screen is visible
+    const float onScreenMin[] = {0.5f, -0.5f, 0.9f};
+    const float onScreenMax[] = {3.f, 0.5f, 0.95f};
+    CHECK(buffer->IsVisible(onScreenMin, onScreenMax));
+}
+
+TEST(OcclusionBuffer_SeesThroughGaps) {
+    std::unique_ptr<OcclusionBuffer> buffer;
+    CHECK(OcclusionBuffer::Create(64, 64, buffer));
+
+    // Two walls with a gap between them
+    buffer->Clear(kIdentity);
+    RasterizeQuad(*buffer, -1.f, -1.f, -0.25f, 1.f, 0.3f);
+    RasterizeQuad(*buffer, 0.25f, -1.f, 1.f, 1.f, 0.3f);
+    buffer->BuildHierarchy();
+
+    const float behindWallMin[] = {-0.9f, -0.5f, 0.6f};
+    const float behindWallMax[] = {-0.5f, 0.5f, 0.7f};
+    CHECK(!buffer->IsVisible(behindWallMin, behindWallMax));
+
+    const float inGapMin[] = {-0.1f, -0.5f, 0.6f};
+    const float inGapMax[] = {0.1f, 0.5f, 0.7f};
+    CHECK(buffer->IsVisible(inGapMin, inGapMax));
+}
+
+TEST(OcclusionBuffer_ClampsHugeCoordinates) {
+    std::unique_ptr<OcclusionBuffer> buffer;
+    CHECK(OcclusionBuffer::Create(64, 64, buffer));
+
+    // A vertex far off the screen still covers the pixels on it
+    buffer->Clear(kIdentity);
+    const float huge[] = {-1.f, -1.f, 0.5f, 1e12f, -1.f, 0.5f, -1.f, 1.f, 0.5f};
+    buffer->RasterizeOccluder(kIdentity, huge, 3, 3 * sizeof(float));
+    CHECK(buffer->GetRasterizedTriangleCount() == 1);
+    CHECK(buffer->GetDepth(63, 62) == 0.5f);
+
+    // An infinite vertex leaves nothing to rasterize
+    const float infinite[] = {-1.f, -1.f, 0.25f, INFINITY, -1.f, 0.25f, -1.f, 1.f, 0.25f};
+    buffer->RasterizeOccluder(kIdentity, infinite, 3, 3 * sizeof(float));
+    CHECK(buffer->GetRasterizedTriangleCount() == 1);
+    buffer->BuildHierarchy();
+
+    // The boxes reaching far off the screen get tested against the pixels they cover on it
+    const float spanningMin[] = {-1e30f, -0.5f, 0.1f};
+    const float spanningMax[] = {1e30f, 0.5f, 0.2f};
+    CHECK(buffer->IsVisible(spanningMin, spanningMax));
+
+    const float hiddenMin[] = {-1e30f, -0.5f, 0.7f};
+    const float hiddenMax[] = {0.5f, 0.5f, 0.8f};
+    CHECK(!buffer->IsVisible(hiddenMin, hiddenMax));
+
+    const float offScreenMin[] = {1e30f, -0.5f, 0.1f};
+    const float offScreenMax[] = {INFINITY, 0.5f, 0.2f};
+    CHECK(!buffer->IsVisible(offScreenMin, offScreenMax));
+}
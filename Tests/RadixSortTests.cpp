@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Graphics/RadixSort.h"
+#include "Test.h"
+#include "Threading/WorkerPool.h"
+
+/**
+ * Returns keys with random object ids under a few hundred batches, the way a scene keys them.
+ */
+static std::vector<RenderingKey> MakeKeys(size_t Count, uint32_t Seed) {
+    std::mt19937 random(Seed);
+    std::vector<RenderingKey> keys(Count);
+    for (RenderingKey& key : keys) {
+        key.value = random() & ((1u << 24) - 1);
+        key.mMeshId = random() % 64;
+        key.mMaterialId = random() % 8;
+        key.mPass = 0;
+    }
+    return keys;
+}
+
+TEST(RadixSort_SortsSerially) {
+    for (size_t count : {0, 1, 100, 300, 50000}) {
+        std::vector<RenderingKey> keys = MakeKeys(count, 1);
+        std::vector<RenderingKey> expected = keys;
+        std::sort(expected.begin(), expected.end());
+
+        std::vector<RenderingKey> scratch;
+        RadixSort(keys, scratch);
+        CHECK(keys == expected);
+    }
+}
+
+TEST(RadixSort_SortsAllKeyBits) {
+    std::mt19937_64 random(2);
+    std::vector<RenderingKey> keys(10000);
+    for (RenderingKey& key : keys) {
+        key.value = random();
+    }
+    std::vector<RenderingKey> expected = keys;
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<RenderingKey> scratch;
+    RadixSort(keys, scratch);
+    CHECK(keys == expected);
+}
+
+TEST(RadixSort_SortsOnPool) {
+    std::unique_ptr<WorkerPool> pool;
+    CHECK(WorkerPool::Create(3, pool));
+
+    // Below, at and well above the size a task sorts
+    const size_t grainSize = kRadixSortGrainSize;
+    for (size_t count : {size_t{1000}, grainSize, grainSize * 7 + 5}) {
+        std::vector<RenderingKey> keys = MakeKeys(count, 3);
+        std::vector<RenderingKey> expected = keys;
+        std::sort(expected.begin(), expected.end());
+
+        std::vector<RenderingKey> scratch;
+        RadixSort(keys, scratch, *pool);
+        CHECK(keys == expected);
+    }
+}
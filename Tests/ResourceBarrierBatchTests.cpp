@@ -0,0 +1,117 @@
+#include <vector>
+
+#include "Graphics/ResourceBarrierBatch.h"
+#include "Test.h"
+
+// The D3D12_RESOURCE_STATES values the tests use
+constexpr uint32_t kPresent = 0x0;
+constexpr uint32_t kRenderTarget = 0x4;
+constexpr uint32_t kPixelShaderResource = 0x80;
+constexpr uint32_t kCopyDest = 0x400;
+constexpr uint32_t kCopySource = 0x800;
+
+// The batch only passes the resources through, so any address stands in for them
+static ID3D12Resource* const kResourceA = reinterpret_cast<ID3D12Resource*>(16);
+static ID3D12Resource* const kResourceB = reinterpret_cast<ID3D12Resource*>(32);
+static ID3D12Resource* const kResourceC = reinterpret_cast<ID3D12Resource*>(48);
+
+/**
+ * Records the ResourceBarrier calls the way a command list would submit them.
+ */
+struct BarrierRecorder {
+    void ResourceBarriers(const BarrierTransition* Transitions, uint32_t Count) {
+        Calls.emplace_back(Transitions, Transitions + Count);
+    }
+
+    std::vector<std::vector<BarrierTransition>> Calls;
+};
+
+static bool IsTransition(const BarrierTransition& Barrier,
+                         ID3D12Resource* Resource,
+                         uint32_t StateBefore,
+                         uint32_t StateAfter) {
+    return Barrier.Resource == Resource && Barrier.StateBefore == StateBefore &&
+           Barrier.StateAfter == StateAfter;
+}
+
+TEST(ResourceBarrierBatch_FlushesInOneCall) {
+    ResourceBarrierBatch batch;
+    BarrierRecorder recorder;
+
+    batch.Transition(kResourceA, kPresent, kRenderTarget);
+    batch.Transition(kResourceB, kCopyDest, kPixelShaderResource);
+    batch.Transition(kResourceC, kCopyDest, kCopySource);
+    CHECK(batch.GetPendingCount() == 3);
+    CHECK(recorder.Calls.empty());
+
+    batch.Flush(recorder);
+    CHECK(recorder.Calls.size() == 1);
+    CHECK(recorder.Calls[0].size() == 3);
+    CHECK(IsTransition(recorder.Calls[0][0], kResourceA, kPresent, kRenderTarget));
+    CHECK(IsTransition(recorder.Calls[0][1], kResourceB, kCopyDest, kPixelShaderResource));
+    CHECK(IsTransition(recorder.Calls[0][2], kResourceC, kCopyDest, kCopySource));
+    CHECK(batch.IsEmpty());
+    CHECK(batch.GetFlushCount() == 1);
+    CHECK(batch.GetFlushedCount() == 3);
+
+    // Nothing pending, so no call at all
+    batch.Flush(recorder);
+    CHECK(recorder.Calls.size() == 1);
+    CHECK(batch.GetFlushCount() == 1);
+
+    batch.Transition(kResourceA, kRenderTarget, kPresent);
+    batch.Flush(recorder);
+    CHECK(recorder.Calls.size() == 2);
+    CHECK(recorder.Calls[1].size() == 1);
+    CHECK(batch.GetFlushCount() == 2);
+    CHECK(batch.GetFlushedCount() == 4);
+    CHECK(batch.GetRequestedCount() == 4);
+}
+
+TEST(ResourceBarrierBatch_CollapsesPendingTransitions) {
+    ResourceBarrierBatch batch;
+    BarrierRecorder recorder;
+
+    // Chained transitions fold into one
+    batch.Transition(kResourceB, kPresent, kRenderTarget);
+    batch.Transition(kResourceB, kRenderTarget, kCopySource);
+    CHECK(batch.GetPendingCount() == 1);
+    CHECK(batch.GetRemovedCount() == 1);
+
+    // A round trip cancels out
+    batch.Transition(kResourceA, kCopyDest, kPixelShaderResource);
+    batch.Transition(kResourceA, kPixelShaderResource, kCopyDest);
+    CHECK(batch.GetPendingCount() == 1);
+    CHECK(batch.GetRemovedCount() == 3);
+
+    batch.Flush(recorder);
+    CHECK(recorder.Calls.size() == 1);
+    CHECK(recorder.Calls[0].size() == 1);
+    CHECK(IsTransition(recorder.Calls[0][0], kResourceB, kPresent, kCopySource));
+    CHECK(batch.GetRequestedCount() == 4);
+    CHECK(batch.GetFlushedCount() + batch.GetRemovedCount() == batch.GetRequestedCount());
+
+    // A flushed transition is no longer pending, so the next one stands on its own
+    batch.Transition(kResourceB, kCopySource, kPresent);
+    batch.Flush(recorder);
+    CHECK(recorder.Calls.size() == 2);
+    CHECK(IsTransition(recorder.Calls[1][0], kResourceB, kCopySource, kPresent));
+}
+
+TEST(ResourceBarrierBatch_DropsEmptyBatches) {
+    ResourceBarrierBatch batch;
+    BarrierRecorder recorder;
+
+    // Everything cancels out between two flushes
+    batch.Transition(kResourceA, kPresent, kRenderTarget);
+    batch.Transition(kResourceB, kCopyDest, kCopySource);
+    batch.Transition(kResourceA, kRenderTarget, kPresent);
+    batch.Transition(kResourceB, kCopySource, kCopyDest);
+    CHECK(batch.IsEmpty());
+
+    batch.Flush(recorder);
+    CHECK(recorder.Calls.empty());
+    CHECK(batch.GetFlushCount() == 0);
+    CHECK(batch.GetFlushedCount() == 0);
+    CHECK(batch.GetRemovedCount() == 4);
+}
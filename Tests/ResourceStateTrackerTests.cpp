@@ -0,0 +1,132 @@
+#include <vector>
+
+#include "Graphics/ResourceBarrierBatch.h"
+#include "Graphics/ResourceStateTracker.h"
+#include "Test.h"
+
+// The D3D12_RESOURCE_STATES values the tests use
+constexpr uint32_t kCommon = 0x0;
+constexpr uint32_t kRenderTarget = 0x4;
+constexpr uint32_t kPixelShaderResource = 0x80;
+constexpr uint32_t kCopyDest = 0x400;
+constexpr uint32_t kCopySource = 0x800;
+
+// The tracker never dereferences the resources, so any address stands in for them
+static ID3D12Resource* const kResourceA = reinterpret_cast<ID3D12Resource*>(16);
+static ID3D12Resource* const kResourceB = reinterpret_cast<ID3D12Resource*>(32);
+
+/**
+ * A command list as far as the states go: the tracker of the list and the barriers it records.
+ */
+struct TrackedList {
+    void Transition(ResourceState& State, uint32_t StateAfter) {
+        Tracker.Transition(State, StateAfter, Barriers);
+    }
+
+    void ResourceBarriers(const BarrierTransition* Transitions, uint32_t Count) {
+        Recorded.insert(Recorded.end(), Transitions, Transitions + Count);
+    }
+
+    /**
+     * Resolves the list the way the queue submits it, returning the fix-up barriers.
+     */
+    std::vector<BarrierTransition> Submit() {
+        Barriers.Flush(*this);
+        std::vector<BarrierTransition> fixups;
+        Tracker.Resolve(fixups);
+        return fixups;
+    }
+
+    ResourceStateTracker Tracker;
+    ResourceBarrierBatch Barriers;
+    std::vector<BarrierTransition> Recorded;
+};
+
+static bool IsTransition(const BarrierTransition& Barrier,
+                         ID3D12Resource* Resource,
+                         uint32_t StateBefore,
+                         uint32_t StateAfter) {
+    return Barrier.Resource == Resource && Barrier.StateBefore == StateBefore &&
+           Barrier.StateAfter == StateAfter;
+}
+
+TEST(ResourceStateTracker_FixesUpFirstUse) {
+    ResourceState stateA{kResourceA, kCommon};
+
+    // The lists record in any order, before either gets submitted
+    TrackedList second;
+    second.Transition(stateA, kCopySource);
+    TrackedList first;
+    first.Transition(stateA, kRenderTarget);
+    first.Transition(stateA, kPixelShaderResource);
+
+    // Only the transitions after the first use get recorded into the lists
+    CHECK(first.Tracker.GetResourceCount() == 1);
+    CHECK(first.Barriers.GetPendingCount() == 1);
+    CHECK(second.Barriers.IsEmpty());
+    CHECK(stateA.State == kCommon);
+
+    const std::vector<BarrierTransition> firstFixups = first.Submit();
+    CHECK(firstFixups.size() == 1);
+    CHECK(IsTransition(firstFixups[0], kResourceA, kCommon, kRenderTarget));
+    CHECK(first.Recorded.size() == 1);
+    CHECK(IsTransition(first.Recorded[0], kResourceA, kRenderTarget, kPixelShaderResource));
+
+    // The second list starts from the state the first one left
+    const std::vector<BarrierTransition> secondFixups = second.Submit();
+    CHECK(secondFixups.size() == 1);
+    CHECK(IsTransition(secondFixups[0], kResourceA, kPixelShaderResource, kCopySource));
+    CHECK(second.Recorded.empty());
+    CHECK(stateA.State == kCopySource);
+}
+
+TEST(ResourceStateTracker_PublishesFinalStates) {
+    ResourceState stateA{kResourceA, kCommon};
+    ResourceState stateB{kResourceB, kCopyDest};
+
+    TrackedList list;
+    list.Transition(stateA, kCopyDest);
+    list.Transition(stateB, kCopyDest);
+    list.Transition(stateA, kCopySource);
+    list.Transition(stateB, kPixelShaderResource);
+    list.Transition(stateA, kRenderTarget);
+    CHECK(list.Tracker.GetResourceCount() == 2);
+
+    const std::vector<BarrierTransition> fixups = list.Submit();
+    CHECK(fixups.size() == 1);
+    CHECK(IsTransition(fixups[0], kResourceA, kCommon, kCopyDest));
+    CHECK(stateA.State == kRenderTarget);
+    CHECK(stateB.State == kPixelShaderResource);
+
+    // Resolving clears the tracker for the next recording
+    CHECK(list.Tracker.IsEmpty());
+    list.Transition(stateA, kRenderTarget);
+    CHECK(list.Submit().empty());
+    CHECK(stateA.State == kRenderTarget);
+}
+
+TEST(ResourceStateTracker_SkipsNoOpTransitions) {
+    ResourceState stateA{kResourceA, kRenderTarget};
+
+    // Already in the state the list needs, and transitioned to the state it's in
+    TrackedList list;
+    list.Transition(stateA, kRenderTarget);
+    list.Transition(stateA, kRenderTarget);
+    CHECK(list.Barriers.IsEmpty());
+    CHECK(list.Barriers.GetRequestedCount() == 0);
+
+    // A round trip within the list cancels out
+    list.Transition(stateA, kCopySource);
+    list.Transition(stateA, kRenderTarget);
+    CHECK(list.Barriers.IsEmpty());
+
+    CHECK(list.Submit().empty());
+    CHECK(list.Recorded.empty());
+    CHECK(list.Barriers.GetFlushCount() == 0);
+    CHECK(stateA.State == kRenderTarget);
+
+    // A list that never touches the resource leaves it alone
+    TrackedList other;
+    CHECK(other.Submit().empty());
+    CHECK(stateA.State == kRenderTarget);
+}
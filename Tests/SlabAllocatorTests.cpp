@@ -0,0 +1,51 @@
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "Memory/SlabAllocator.h"
+#include "Test.h"
+
+struct alignas(32) SlabItem {
+    float Values[12];
+};
+
+TEST(SlabAllocator_AlignsBlocks) {
+    SlabAllocator<SlabItem, 16> allocator;
+    std::set<void*> blocks;
+    for (int i = 0; i < 40; ++i) {
+        void* block = allocator.Allocate();
+        CHECK(reinterpret_cast<uintptr_t>(block) % alignof(SlabItem) == 0);
+        blocks.insert(block);
+    }
+
+    CHECK(blocks.size() == 40);
+    CHECK(allocator.GetBlockCount() == 40);
+    CHECK(allocator.GetCapacity() == 48);
+
+    for (void* block : blocks) {
+        allocator.Free(block);
+    }
+    CHECK(allocator.GetBlockCount() == 0);
+}
+
+TEST(SlabAllocator_ReusesFreedBlocks) {
+    SlabAllocator<SlabItem, 64> allocator;
+    std::vector<void*> blocks;
+    for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < 100; ++i) {
+            blocks.push_back(allocator.Allocate());
+        }
+        for (void* block : blocks) {
+            allocator.Free(block);
+        }
+        blocks.clear();
+    }
+
+    // The slabs follow the peak number of the live blocks
+    CHECK(allocator.GetCapacity() == 128);
+
+    // The last freed block is handed out first
+    void* block = allocator.Allocate();
+    allocator.Free(block);
+    CHECK(allocator.Allocate() == block);
+}
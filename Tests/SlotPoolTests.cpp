@@ -0,0 +1,137 @@
+#include <vector>
+
+#include "Memory/SlotPool.h"
+#include "Test.h"
+
+/**
+ * An item that counts the live instances, to catch leaked or doubly destroyed items.
+ */
+struct CountedItem {
+    explicit CountedItem(int Value) : Value(Value) {
+        ++LiveCount;
+    }
+
+    ~CountedItem() {
+        --LiveCount;
+    }
+
+    // Prohibit copying
+    CountedItem(const CountedItem&) = delete;
+    CountedItem& operator=(const CountedItem&) = delete;
+
+    static inline int LiveCount = 0;
+    int Value;
+};
+
+// Small slabs so the tests cross them
+using Pool = SlotPool<CountedItem, 4>;
+
+static uint32_t GetGeneration(SlotHandle Handle) {
+    return Handle >> Pool::kIndexBits;
+}
+
+TEST(SlotPool_ResolvesGenerationalHandles) {
+    {
+        Pool pool;
+        const SlotHandle a = pool.Create(1);
+        const SlotHandle b = pool.Create(2);
+        CHECK(a != Pool::kInvalidHandle);
+        CHECK(pool.Get(a)->Value == 1);
+        CHECK(pool.Get(b)->Value == 2);
+        CHECK(pool.GetCount() == 2);
+        const CountedItem* itemB = pool.Get(b);
+
+        // The freed slot gets reused under the next generation
+        CHECK(pool.Destroy(a));
+        const SlotHandle c = pool.Create(3);
+        CHECK((c & Pool::kIndexMask) == (a & Pool::kIndexMask));
+        CHECK(GetGeneration(c) == GetGeneration(a) + 1);
+        CHECK(pool.Get(c)->Value == 3);
+
+        // The items keep their addresses while the slabs grow
+        for (int i = 0; i < 20; ++i) {
+            pool.Create(i);
+        }
+        CHECK(pool.Get(b) == itemB);
+        CHECK(pool.GetCount() == 22);
+        CHECK(CountedItem::LiveCount == 22);
+    }
+    CHECK(CountedItem::LiveCount == 0);
+}
+
+TEST(SlotPool_RejectsStaleHandles) {
+    Pool pool;
+    const SlotHandle a = pool.Create(1);
+    CHECK(pool.Destroy(a));
+    CHECK(!pool.IsValid(a));
+    CHECK(pool.Get(a) == nullptr);
+    CHECK(!pool.Destroy(a));
+    CHECK(pool.GetCount() == 0);
+
+    // The stale handle doesn't resolve to the item in its slot now
+    const SlotHandle b = pool.Create(2);
+    CHECK(!pool.IsValid(a));
+    CHECK(pool.Get(a) == nullptr);
+    CHECK(!pool.Destroy(a));
+    CHECK(pool.Get(b)->Value == 2);
+
+    // Nor do the handles of slots never used
+    CHECK(!pool.IsValid(Pool::kInvalidHandle));
+    CHECK(!pool.IsValid(b + 1));
+    CHECK(CountedItem::LiveCount == 1);
+}
+
+TEST(SlotPool_RetiresWrappedSlots) {
+    Pool pool;
+    const SlotHandle first = pool.Create(0);
+    const uint32_t index = first & Pool::kIndexMask;
+
+    // Cycle the slot through all its generations
+    SlotHandle handle = first;
+    for (uint32_t generation = 0; generation < Pool::kGenerationMask; ++generation) {
+        CHECK(pool.Destroy(handle));
+        handle = pool.Create(0);
+        CHECK((handle & Pool::kIndexMask) == index);
+    }
+    CHECK(GetGeneration(handle) == Pool::kGenerationMask);
+
+    // Wrapping back to the first generation would revive the first handle, so the slot retires
+    CHECK(pool.Destroy(handle));
+    const SlotHandle next = pool.Create(0);
+    CHECK((next & Pool::kIndexMask) != index);
+    CHECK(!pool.IsValid(first));
+    CHECK(!pool.IsValid(handle));
+    CHECK(pool.GetSlotCount() == 2);
+    pool.Destroy(next);
+}
+
+TEST(SlotPool_IteratesInSlotOrder) {
+    Pool pool;
+    std::vector<SlotHandle> handles;
+    for (int i = 0; i < 10; ++i) {
+        handles.push_back(pool.Create(i));
+    }
+
+    // Destroying and creating other items leaves the order of the rest as it is
+    pool.Destroy(handles[2]);
+    pool.Destroy(handles[7]);
+    pool.Create(100);
+
+    std::vector<int> values;
+    std::vector<SlotHandle> visited;
+    pool.ForEach([&](SlotHandle Handle, CountedItem& Item) {
+        visited.push_back(Handle);
+        values.push_back(Item.Value);
+    });
+    CHECK((values == std::vector<int>{0, 1, 3, 4, 5, 6, 100, 8, 9}));
+    for (size_t i = 0; i < visited.size(); ++i) {
+        CHECK(pool.Get(visited[i])->Value == values[i]);
+    }
+
+    // Moving the pool keeps the items and the handles
+    Pool moved(std::move(pool));
+    CHECK(moved.GetCount() == 9);
+    CHECK(moved.Get(handles[9])->Value == 9);
+    CHECK(pool.GetCount() == 0);
+    CHECK(CountedItem::LiveCount == 9);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+/**
+ * A minimal test harness for the parts of the framework that don't need a GPU. TEST defines a test
+ * case that registers itself before main runs; CHECK reports a failed condition and carries on, so
+ * a single run lists all the failures:
+ *
+ *   TEST(TlsfAllocator_AlignsOffsets) {
+ *       CHECK(allocation.Offset % 256 == 0);
+ *   }
+ */
+class TestRegistry {
+   public:
+    using TestFunction = void (*)();
+
+    // Using the function-local static pattern the same way TransformStore::Get does, so the tests
+    // can register from any translation unit in any order
+    static TestRegistry& Get() {
+        static TestRegistry registry;
+        return registry;
+    }
+
+    bool Register(const char* Name, TestFunction Function) {
+        mTests.push_back({Name, Function});
+        return true;
+    }
+
+    void Fail(const char* File, int Line, const char* Condition) {
+        std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", File, Line, Condition);
+        ++mFailureCount;
+    }
+
+    /**
+     * Runs the tests whose names contain the filter.
+     * @param Filter The substring to match, or nullptr to run all the tests.
+     * @return The number of the tests that failed.
+     */
+    int Run(const char* Filter);
+
+   private:
+    struct TestCase {
+        const char* Name;
+        TestFunction Function;
+    };
+
+    std::vector<TestCase> mTests;
+
+    // The failed checks so far
+    int mFailureCount{0};
+};
+
+#define TEST(Name)                                                                  \
+    static void Name();                                                             \
+    static const bool Name##Registered = TestRegistry::Get().Register(#Name, Name); \
+    static void Name()
+
+#define CHECK(Condition)                                              \
+    do {                                                              \
+        if (!(Condition)) {                                           \
+            TestRegistry::Get().Fail(__FILE__, __LINE__, #Condition); \
+        }                                                             \
+    } while (0)
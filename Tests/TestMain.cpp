@@ -0,0 +1,31 @@
+#include <cstring>
+
+#include "Test.h"
+
+int TestRegistry::Run(const char* Filter) {
+    int failedCount = 0;
+    int runCount = 0;
+    for (const TestCase& test : mTests) {
+        if (Filter && !std::strstr(test.Name, Filter)) {
+            continue;
+        }
+
+        const int failureCount = mFailureCount;
+        test.Function();
+        ++runCount;
+
+        const bool isPassed = mFailureCount == failureCount;
+        std::printf("[%s] %s\n", isPassed ? "PASS" : "FAIL", test.Name);
+        failedCount += isPassed ? 0 : 1;
+    }
+
+    std::printf("%d of %d tests passed.\n", runCount - failedCount, runCount);
+    return failedCount;
+}
+
+/**
+ * Runs all the tests, or the ones whose names contain the first argument.
+ */
+int main(int argc, char** argv) {
+    return TestRegistry::Get().Run(argc > 1 ? argv[1] : nullptr) == 0 ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Memory/TlsfAllocator.h"
+#include "Test.h"
+
+/**
+ * Checks that the allocations don't overlap and lie within the capacity.
+ */
+static bool AreDisjoint(std::vector<TlsfAllocation> Allocations, uint64_t Capacity) {
+    std::sort(Allocations.begin(), Allocations.end(),
+              [](const TlsfAllocation& A, const TlsfAllocation& B) { return A.Offset < B.Offset; });
+    for (size_t i = 0; i < Allocations.size(); ++i) {
+        const uint64_t end = Allocations[i].Offset + Allocations[i].Size;
+        if (end > Capacity || (i + 1 < Allocations.size() && end > Allocations[i + 1].Offset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(TlsfAllocator_AlignsOffsets) {
+    TlsfAllocator allocator(1 << 20);
+
+    TlsfAllocation unaligned;
+    CHECK(allocator.Allocate(3, 1, unaligned));
+
+    for (uint64_t alignment : {16, 256, 4096, 65536}) {
+        TlsfAllocation allocation;
+        CHECK(allocator.Allocate(100, alignment, allocation));
+        CHECK(allocation.Offset % alignment == 0);
+        CHECK(allocation.Size >= 100);
+    }
+}
+
+TEST(TlsfAllocator_MergesFreedNeighbors) {
+    constexpr uint64_t kCapacity = 1 << 16;
+    TlsfAllocator allocator(kCapacity);
+
+    std::vector<TlsfAllocation> allocations(64);
+    for (TlsfAllocation& allocation : allocations) {
+        CHECK(allocator.Allocate(kCapacity / 64, 1, allocation));
+    }
+    CHECK(allocator.GetFreeSize() == 0);
+
+    // Free every other one first, so the rest merges both ways
+    for (size_t i = 0; i < allocations.size(); i += 2) {
+        allocator.Free(allocations[i]);
+    }
+    CHECK(allocator.GetFreeBlockCount() == 32);
+    CHECK(allocator.GetLargestFreeSize() == kCapacity / 64);
+
+    for (size_t i = 1; i < allocations.size(); i += 2) {
+        allocator.Free(allocations[i]);
+    }
+    CHECK(allocator.IsEmpty());
+    CHECK(allocator.GetFreeBlockCount() == 1);
+    CHECK(allocator.GetLargestFreeSize() == kCapacity);
+    CHECK(allocator.GetFragmentation() == 0.f);
+}
+
+TEST(TlsfAllocator_FailsWhenFull) {
+    TlsfAllocator allocator(1024);
+
+    TlsfAllocation allocation;
+    CHECK(allocator.Allocate(1024, 1, allocation));
+
+    TlsfAllocation failed{7, 7, 7};
+    CHECK(!allocator.Allocate(1, 1, failed));
+    CHECK(!allocator.Allocate(0, 1, failed));
+    CHECK(failed.Offset == 7 && failed.Size == 7 && failed.BlockIndex == 7);
+}
+
+TEST(TlsfAllocator_SurvivesChurn) {
+    constexpr uint64_t kCapacity = 1 << 24;
+    TlsfAllocator allocator(kCapacity);
+
+    std::mt19937 random(42);
+    std::vector<TlsfAllocation> allocations;
+    uint64_t usedSize = 0;
+    for (uint32_t step = 0; step < 20000; ++step) {
+        if (!allocations.empty() && random() % 3 == 0) {
+            const size_t index = random() % allocations.size();
+            usedSize -= allocations[index].Size;
+            allocator.Free(allocations[index]);
+            allocations[index] = allocations.back();
+            allocations.pop_back();
+            continue;
+        }
+
+        const uint64_t alignment = uint64_t{1} << (random() % 13);
+        TlsfAllocation allocation;
+        if (allocator.Allocate(1 + random() % 65536, alignment, allocation)) {
+            CHECK(allocation.Offset % alignment == 0);
+            usedSize += allocation.Size;
+            allocations.push_back(allocation);
+        }
+    }
+
+    CHECK(AreDisjoint(allocations, kCapacity));
+    CHECK(allocator.GetUsedSize() == usedSize);
+    CHECK(allocator.GetAllocationCount() == allocations.size());
+
+    for (const TlsfAllocation& allocation : allocations) {
+        allocator.Free(allocation);
+    }
+    CHECK(allocator.IsEmpty());
+    CHECK(allocator.GetLargestFreeSize() == kCapacity);
+}
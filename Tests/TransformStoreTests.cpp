@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Scene/TransformStore.h"
+#include "Test.h"
+#include "Threading/WorkerPool.h"
+
+// The store never dereferences the owners, so any address stands in for the nodes
+static Node* const kOwner = reinterpret_cast<Node*>(16);
+
+constexpr uint32_t kNoParent = TransformStore::kInvalidIndex;
+
+/**
+ * A scene of slots registered the way the nodes do, with a copy of the hierarchy by node id. A
+ * parent always has a lower id than its children.
+ */
+struct SlotScene {
+    explicit SlotScene(uint32_t NodeCount) : Slots(NodeCount), Parents(NodeCount, kNoParent) {
+        for (uint32_t& slot : Slots) {
+            slot = Store.Allocate(kOwner, &slot);
+        }
+    }
+
+    void SetParent(uint32_t Id, uint32_t ParentId) {
+        Parents[Id] = ParentId;
+        Store.SetParent(Slots[Id], ParentId == kNoParent ? kNoParent : Slots[ParentId]);
+    }
+
+    void Release(uint32_t Id) {
+        Store.Release(Slots[Id]);
+        Slots[Id] = TransformStore::kInvalidIndex;
+    }
+
+    bool IsLive(uint32_t Id) const {
+        return Slots[Id] != TransformStore::kInvalidIndex;
+    }
+
+    TransformStore Store;
+    // The slot per node id, kept up to date by the store
+    std::vector<uint32_t> Slots;
+    std::vector<uint32_t> Parents;
+};
+
+static bool IsEqual(const Matrix4& A, const Matrix4& B) {
+    return std::memcmp(&A, &B, sizeof(Matrix4)) == 0;
+}
+
+static bool IsEqual(const AABB& A, const AABB& B) {
+    const DirectX::XMVECTOR corners[] = {A.GetMin(), A.GetMax(), B.GetMin(), B.GetMax()};
+    return std::memcmp(&corners[0], &corners[2], 2 * sizeof(DirectX::XMVECTOR)) == 0;
+}
+
+/**
+ * Builds a random tree of TreeSize nodes, large enough to be split over the parallel tasks, and
+ * small trees of SmallTreeSize nodes after it.
+ */
+static void BuildScene(SlotScene& Scene, uint32_t TreeSize, uint32_t SmallTreeSize) {
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> position(-10.f, 10.f);
+    for (uint32_t id = 0; id < Scene.Slots.size(); ++id) {
+        if (id < TreeSize) {
+            Scene.SetParent(id, id == 0 ? kNoParent : random() % id);
+        } else if ((id - TreeSize) % SmallTreeSize != 0) {
+            Scene.SetParent(id, id - 1 - random() % ((id - TreeSize) % SmallTreeSize));
+        }
+
+        Matrix4 local(DirectX::XMMatrixTranslation(position(random), position(random), 0.f));
+        Scene.Store.SetLocalTransform(Scene.Slots[id], local.RotateY(Degrees(position(random))));
+        const float size = 1.f + random() % 4;
+        Scene.Store.SetLocalBounds(Scene.Slots[id],
+                                   AABB(Vector3(-size, -size, -size), Vector3(size, size, size)));
+    }
+}
+
+/**
+ * Checks that the world transforms are the local ones applied to the parents' world transforms.
+ */
+static bool IsPropagated(const SlotScene& Scene) {
+    const TransformStore& store = Scene.Store;
+    for (uint32_t id = 0; id < Scene.Slots.size(); ++id) {
+        if (!Scene.IsLive(id)) {
+            continue;
+        }
+        const uint32_t slot = Scene.Slots[id];
+        const uint32_t parent = Scene.Parents[id];
+        const Matrix4 expected =
+            parent == kNoParent
+                ? store.GetLocalTransform(slot)
+                : store.GetWorldTransform(Scene.Slots[parent]) * store.GetLocalTransform(slot);
+        if (!IsEqual(store.GetWorldTransform(slot), expected)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks that every subtree occupies a contiguous range of slots starting at its root.
+ */
+static bool IsDepthFirst(const SlotScene& Scene) {
+    const size_t count = Scene.Slots.size();
+    std::vector<uint32_t> sizes(count, 1);
+    std::vector<uint32_t> firstSlots(Scene.Slots);
+    std::vector<uint32_t> lastSlots(Scene.Slots);
+    for (size_t id = count; id-- > 0;) {
+        const uint32_t parent = Scene.Parents[id];
+        if (!Scene.IsLive(id) || parent == kNoParent) {
+            continue;
+        }
+        sizes[parent] += sizes[id];
+        firstSlots[parent] = std::min(firstSlots[parent], firstSlots[id]);
+        lastSlots[parent] = std::max(lastSlots[parent], lastSlots[id]);
+    }
+
+    for (size_t id = 0; id < count; ++id) {
+        const bool isContiguous = firstSlots[id] == Scene.Slots[id] &&
+                                  lastSlots[id] - firstSlots[id] + 1 == sizes[id];
+        if (Scene.IsLive(id) && !isContiguous) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks that both stores hold the same slots and computed the same transforms and bounds.
+ */
+static bool IsSame(const SlotScene& A, const SlotScene& B) {
+    if (A.Slots != B.Slots || A.Store.GetSize() != B.Store.GetSize() ||
+        A.Store.GetUpdatedCount() != B.Store.GetUpdatedCount() ||
+        !std::equal(A.Store.GetUpdatedSlots().begin(), A.Store.GetUpdatedSlots().end(),
+                    B.Store.GetUpdatedSlots().begin())) {
+        return false;
+    }
+
+    for (uint32_t slot = 0; slot < A.Store.GetSize(); ++slot) {
+        if (!IsEqual(A.Store.GetWorldTransform(slot), B.Store.GetWorldTransform(slot)) ||
+            !IsEqual(A.Store.GetWorldBounds(slot), B.Store.GetWorldBounds(slot)) ||
+            !IsEqual(A.Store.GetSubtreeBounds(slot), B.Store.GetSubtreeBounds(slot))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(TransformStore_KeepsSubtreesContiguous) {
+    SlotScene scene(40);
+    BuildScene(scene, 10, 10);
+    scene.Store.UpdateWorldTransforms();
+    CHECK(scene.Store.GetUpdatedCount() == 40);
+    CHECK(IsDepthFirst(scene));
+    CHECK(IsPropagated(scene));
+
+    // Move a small tree under the large one and drop another one
+    scene.SetParent(20, 3);
+    for (uint32_t id = 30; id < 40; ++id) {
+        scene.Release(id);
+    }
+    scene.Store.UpdateWorldTransforms();
+    CHECK(scene.Store.GetSize() == 30);
+    CHECK(scene.Store.GetUpdatedCount() == 10);
+    CHECK(IsDepthFirst(scene));
+    CHECK(IsPropagated(scene));
+
+    scene.Store.UpdateWorldTransforms();
+    CHECK(scene.Store.GetUpdatedCount() == 0);
+}
+
+TEST(TransformStore_ParallelMatchesSerial) {
+    constexpr uint32_t kTreeSize = 3 * TransformStore::kParallelGrainSize;
+    constexpr uint32_t kSmallTreeSize = 50;
+    constexpr uint32_t kNodeCount = kTreeSize + 200 * kSmallTreeSize;
+
+    std::unique_ptr<WorkerPool> pool;
+    CHECK(WorkerPool::Create(3, pool));
+
+    SlotScene serial(kNodeCount);
+    SlotScene parallel(kNodeCount);
+    BuildScene(serial, kTreeSize, kSmallTreeSize);
+    BuildScene(parallel, kTreeSize, kSmallTreeSize);
+    auto update = [&]() {
+        serial.Store.UpdateWorldTransforms();
+        parallel.Store.UpdateWorldTransforms(*pool);
+        CHECK(IsSame(serial, parallel));
+        CHECK(IsPropagated(parallel));
+        CHECK(IsDepthFirst(parallel));
+    };
+    update();
+    CHECK(parallel.Store.GetUpdatedCount() == kNodeCount);
+
+    // Move a few nodes of every tree
+    for (SlotScene* scene : {&serial, &parallel}) {
+        std::mt19937 random(6);
+        for (uint32_t i = 0; i < kNodeCount / 100; ++i) {
+            const uint32_t slot = scene->Slots[random() % kNodeCount];
+            Matrix4 local = scene->Store.GetLocalTransform(slot);
+            scene->Store.SetLocalTransform(slot, local.Translate(Vector3(0.f, 1.f, 0.f)));
+        }
+    }
+    update();
+    CHECK(parallel.Store.GetUpdatedCount() < kNodeCount);
+
+    // Re-parent some small trees under the large one and drop others
+    for (SlotScene* scene : {&serial, &parallel}) {
+        std::mt19937 random(7);
+        for (uint32_t id = kTreeSize; id < kNodeCount; id += 4 * kSmallTreeSize) {
+            scene->SetParent(id, random() % kTreeSize);
+            for (uint32_t dropped = id + kSmallTreeSize; dropped < id + 2 * kSmallTreeSize;
+                 ++dropped) {
+                scene->Release(dropped);
+            }
+        }
+    }
+    update();
+    CHECK(parallel.Store.GetSize() == kNodeCount - 50 * kSmallTreeSize);
+
+    update();
+    CHECK(parallel.Store.GetUpdatedCount() == 0);
+}
+
+TEST(TransformStore_ListsVisibleSlots) {
+    SlotScene scene(400);
+    BuildScene(scene, 100, 20);
+    scene.Store.UpdateWorldTransforms();
+
+    // The clip volume around the origin and one shifted along x
+    const Frustum frustums[] = {
+        Frustum(), Frustum(Matrix4(DirectX::XMMatrixTranslation(-5.f, 0.f, 0.f)))};
+    std::vector<uint32_t> visibility;
+    std::vector<uint32_t> visibleSlots;
+    scene.Store.Cull(frustums, visibility, visibleSlots);
+
+    std::vector<uint32_t> expected;
+    for (uint32_t slot = 0; slot < visibility.size(); ++slot) {
+        if (visibility[slot] != 0) {
+            expected.push_back(slot);
+        }
+    }
+    CHECK(visibleSlots == expected);
+    CHECK(!visibleSlots.empty());
+    CHECK(visibleSlots.size() < scene.Store.GetSize());
+
+    // Nothing to test against, nothing visible
+    scene.Store.Cull({}, visibility, visibleSlots);
+    CHECK(visibleSlots.empty());
+}
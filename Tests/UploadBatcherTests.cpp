@@ -0,0 +1,196 @@
+#include <cstring>
+#include <vector>
+
+#include "Graphics/Resource/NullUploadBackend.h"
+#include "Graphics/Resource/UploadBatcher.h"
+#include "Test.h"
+
+using Batcher = UploadBatcher<NullUploadBackend>;
+
+/**
+ * The data of an upload: its bytes count up from the seed.
+ */
+static std::vector<std::byte> MakeData(size_t Size, uint8_t Seed) {
+    std::vector<std::byte> data(Size);
+    for (size_t i = 0; i < Size; ++i) {
+        data[i] = static_cast<std::byte>(Seed + i);
+    }
+    return data;
+}
+
+static bool IsUploaded(const NullUploadBuffer& Buffer, const std::vector<std::byte>& Data) {
+    return Buffer.Data.size() >= Data.size() &&
+           std::memcmp(Buffer.Data.data(), Data.data(), Data.size()) == 0;
+}
+
+TEST(UploadBatcher_BatchesUploadsUnderOneTicket) {
+    NullUploadBackend backend;
+    Batcher batcher(backend);
+
+    // Sizes off the staging alignment, so the packed copies would overlap if misplaced
+    std::vector<NullUploadBuffer> buffers;
+    std::vector<std::vector<std::byte>> data;
+    std::vector<Batcher::Request> requests;
+    for (size_t i = 0; i < 8; ++i) {
+        data.push_back(MakeData(100 + 7 * i, static_cast<uint8_t>(i)));
+        buffers.emplace_back(data.back().size());
+    }
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        requests.push_back({&buffers[i], data[i].data(), data[i].size()});
+    }
+
+    UploadTicket ticket = 0;
+    CHECK(batcher.UploadBatch(requests, ticket));
+    CHECK(ticket == 1);
+    CHECK(backend.GetBatchCount() == 0);
+    CHECK(backend.GetStagingBufferCount() == 1);
+    for (const NullUploadBuffer& buffer : buffers) {
+        CHECK(buffer.Ticket == ticket);
+    }
+
+    // Later uploads join the open batch and its staging page
+    NullUploadBuffer extra(64);
+    const std::vector<std::byte> extraData = MakeData(64, 99);
+    const Batcher::Request extraRequest{&extra, extraData.data(), extraData.size()};
+    UploadTicket extraTicket = 0;
+    CHECK(batcher.UploadBatch({&extraRequest, 1}, extraTicket));
+    CHECK(extraTicket == ticket);
+    CHECK(backend.GetStagingBufferCount() == 1);
+
+    CHECK(batcher.Submit());
+    CHECK(batcher.GetSubmitCount() == 1);
+    CHECK(backend.GetBatchCount() == 1);
+    CHECK(backend.GetCopyCount() == buffers.size() + 1);
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        CHECK(IsUploaded(buffers[i], data[i]));
+    }
+    CHECK(IsUploaded(extra, extraData));
+
+    // Nothing left to submit
+    CHECK(batcher.Submit());
+    CHECK(backend.GetBatchCount() == 1);
+
+    CHECK(batcher.UploadBatch({&extraRequest, 1}, extraTicket));
+    CHECK(extraTicket == ticket + 1);
+}
+
+TEST(UploadBatcher_SubmitsTicketOnlyWhileOpen) {
+    NullUploadBackend backend;
+    Batcher batcher(backend);
+
+    NullUploadBuffer buffer(32);
+    const std::vector<std::byte> data = MakeData(32, 1);
+    const Batcher::Request request{&buffer, data.data(), data.size()};
+
+    UploadTicket first = 0;
+    CHECK(batcher.UploadBatch({&request, 1}, first));
+    CHECK(batcher.Submit(first));
+    CHECK(backend.GetBatchCount() == 1);
+
+    // The ticket of a submitted batch doesn't submit the open one
+    UploadTicket second = 0;
+    CHECK(batcher.UploadBatch({&request, 1}, second));
+    CHECK(second == first + 1);
+    CHECK(batcher.Submit(first));
+    CHECK(backend.GetBatchCount() == 1);
+    CHECK(batcher.Submit(second));
+    CHECK(backend.GetBatchCount() == 2);
+}
+
+TEST(UploadBatcher_SizesStagingPages) {
+    NullUploadBackend backend;
+    Batcher batcher(backend);
+
+    // Larger than a page, so it gets one of its own
+    constexpr size_t kLargeSize = Batcher::kStagingPageSize + 1000;
+    NullUploadBuffer large(kLargeSize);
+    const std::vector<std::byte> largeData = MakeData(kLargeSize, 3);
+    const Batcher::Request largeRequest{&large, largeData.data(), largeData.size()};
+    UploadTicket ticket = 0;
+    CHECK(batcher.UploadBatch({&largeRequest, 1}, ticket));
+    CHECK(batcher.GetStagingPageCount() == 1);
+
+    NullUploadBuffer small(16);
+    const std::vector<std::byte> smallData = MakeData(16, 4);
+    const Batcher::Request smallRequest{&small, smallData.data(), smallData.size()};
+    CHECK(batcher.UploadBatch({&smallRequest, 1}, ticket));
+    CHECK(batcher.UploadBatch({&smallRequest, 1}, ticket));
+    CHECK(batcher.GetStagingPageCount() == 2);
+
+    // Half the batch limit twice submits the batch without waiting for Submit
+    constexpr size_t kHalfBatchSize = Batcher::kMaxBatchSize / 2;
+    NullUploadBuffer half(kHalfBatchSize);
+    const std::vector<std::byte> halfData(kHalfBatchSize, std::byte{5});
+    const Batcher::Request halfRequest{&half, halfData.data(), halfData.size()};
+    CHECK(batcher.UploadBatch({&halfRequest, 1}, ticket));
+    CHECK(backend.GetBatchCount() == 0);
+    CHECK(batcher.UploadBatch({&halfRequest, 1}, ticket));
+    CHECK(backend.GetBatchCount() == 1);
+    CHECK(IsUploaded(large, largeData));
+    CHECK(IsUploaded(half, halfData));
+}
+
+TEST(UploadBatcher_RetiresPagesUntilComplete) {
+    NullUploadBackend backend;
+    Batcher batcher(backend);
+
+    NullUploadBuffer buffer(256);
+    const std::vector<std::byte> data = MakeData(256, 6);
+    const Batcher::Request request{&buffer, data.data(), data.size()};
+
+    UploadTicket first = 0;
+    CHECK(batcher.UploadBatch({&request, 1}, first));
+    CHECK(batcher.Submit());
+    UploadTicket second = 0;
+    CHECK(batcher.UploadBatch({&request, 1}, second));
+    CHECK(batcher.Submit());
+    CHECK(backend.GetStagingBufferCount() == 2);
+
+    // The queue may still be reading the pages
+    batcher.Collect();
+    CHECK(backend.GetLiveStagingBufferCount() == 2);
+
+    backend.Complete(first);
+    batcher.Collect();
+    CHECK(backend.GetLiveStagingBufferCount() == 1);
+
+    backend.Complete(second);
+    batcher.Collect();
+    CHECK(backend.GetLiveStagingBufferCount() == 0);
+
+    CHECK(batcher.UploadBatch({&request, 1}, first));
+    CHECK(batcher.Submit());
+    batcher.ReleaseAll();
+    CHECK(backend.GetLiveStagingBufferCount() == 0);
+}
+
+TEST(UploadBatcher_LeavesTicketOnFailure) {
+    NullUploadBackend backend;
+    Batcher batcher(backend);
+
+    NullUploadBuffer buffer(64);
+    const std::vector<std::byte> data = MakeData(64, 7);
+    const Batcher::Request request{&buffer, data.data(), data.size()};
+
+    // Nothing to upload, nothing to wait for
+    const Batcher::Request empty{&buffer, data.data(), 0};
+    UploadTicket ticket = 42;
+    CHECK(batcher.UploadBatch({&empty, 1}, ticket));
+    CHECK(ticket == 0);
+    CHECK(backend.GetStagingBufferCount() == 0);
+
+    ticket = 42;
+    backend.SetFailures(true, false);
+    CHECK(!batcher.UploadBatch({&request, 1}, ticket));
+    backend.SetFailures(false, true);
+    CHECK(!batcher.UploadBatch({&request, 1}, ticket));
+    CHECK(ticket == 42);
+    CHECK(buffer.Ticket == 0);
+
+    backend.SetFailures(false, false);
+    CHECK(batcher.UploadBatch({&request, 1}, ticket));
+    CHECK(ticket == 1);
+    CHECK(batcher.Submit());
+    CHECK(IsUploaded(buffer, data));
+    CHECK(backend.GetCopyCount() == 1);
+}
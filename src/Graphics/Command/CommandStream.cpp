@@ -0,0 +1,24 @@
+#include "CommandStream.h"
+
+#include <algorithm>
+#include <cstring>
+
+void* CommandStream::AllocateData(size_t Size, size_t Alignment, uint32_t& OutOffset) {
+    const size_t offset = (mDataSize + Alignment - 1) & ~(Alignment - 1);
+    const size_t end = offset + Size;
+
+    if (end > mDataCapacity) {
+        // Grow geometrically so the stream settles at the size of a frame
+        const size_t capacity = std::max(end, mDataCapacity * 2);
+        std::unique_ptr<std::byte[]> data(new std::byte[capacity]);
+        if (mDataSize > 0) {
+            memcpy(data.get(), mData.get(), mDataSize);
+        }
+        mData = std::move(data);
+        mDataCapacity = capacity;
+    }
+
+    mDataSize = end;
+    OutOffset = static_cast<uint32_t>(offset);
+    return mData.get() + offset;
+}
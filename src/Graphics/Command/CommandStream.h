@@ -0,0 +1,363 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// The stream only carries the pointers; the D3D12 backend is the one dereferencing them
+struct ID3D12PipelineState;
+struct ID3D12RootSignature;
+
+enum class CommandType : uint8_t {
+    kSetRootSignature,
+    kSetPipelineState,
+    kSetPrimitiveTopology,
+    kSetViewport,
+    kSetScissorRect,
+    kClearRenderTarget,
+    kSetVertexBuffer,
+    kSetRootConstantBufferData,
+    kSetRootShaderResourceData,
+    kSetRoot32BitConstants,
+    kDrawInstanced,
+    kCount
+};
+
+enum class PrimitiveTopology : uint8_t {
+    kTriangleList,
+};
+
+struct Viewport {
+    float TopLeftX{0.f};
+    float TopLeftY{0.f};
+    float Width{0.f};
+    float Height{0.f};
+    float MinDepth{0.f};
+    float MaxDepth{1.f};
+};
+
+struct ScissorRect {
+    int32_t Left{0};
+    int32_t Top{0};
+    int32_t Right{0};
+    int32_t Bottom{0};
+};
+
+// Commands; every one of them is a plain struct tagged with its CommandType
+
+struct SetRootSignatureCommand {
+    static constexpr CommandType kType = CommandType::kSetRootSignature;
+    ID3D12RootSignature* RootSignature;
+};
+
+struct SetPipelineStateCommand {
+    static constexpr CommandType kType = CommandType::kSetPipelineState;
+    ID3D12PipelineState* PipelineState;
+};
+
+struct SetPrimitiveTopologyCommand {
+    static constexpr CommandType kType = CommandType::kSetPrimitiveTopology;
+    PrimitiveTopology Topology;
+};
+
+struct SetViewportCommand {
+    static constexpr CommandType kType = CommandType::kSetViewport;
+    Viewport View;
+};
+
+struct SetScissorRectCommand {
+    static constexpr CommandType kType = CommandType::kSetScissorRect;
+    ScissorRect Rect;
+};
+
+struct ClearRenderTargetCommand {
+    static constexpr CommandType kType = CommandType::kClearRenderTarget;
+    float ColorRGBA[4];
+};
+
+struct SetVertexBufferCommand {
+    static constexpr CommandType kType = CommandType::kSetVertexBuffer;
+    uint64_t BufferLocation;
+    uint32_t SizeInBytes;
+    uint32_t StrideInBytes;
+    uint32_t Slot;
+};
+
+/**
+ * Binds a range of the stream data as a root CBV or SRV; the backend resolves the offset into a
+ * GPU address.
+ */
+struct SetRootDataCommand {
+    uint32_t RootParameterIndex;
+    uint32_t DataOffset;
+};
+
+struct SetRootConstantBufferDataCommand : SetRootDataCommand {
+    static constexpr CommandType kType = CommandType::kSetRootConstantBufferData;
+};
+
+struct SetRootShaderResourceDataCommand : SetRootDataCommand {
+    static constexpr CommandType kType = CommandType::kSetRootShaderResourceData;
+};
+
+/**
+ * Sets root constants right from the command, e.g. the constants of a single draw, with no data to
+ * upload.
+ */
+struct SetRoot32BitConstantsCommand {
+    static constexpr CommandType kType = CommandType::kSetRoot32BitConstants;
+
+    // Enough for a 4x4 float matrix
+    static constexpr uint32_t kMaxConstantCount = 16;
+
+    uint32_t RootParameterIndex;
+    uint32_t ConstantCount;
+    uint32_t Constants[kMaxConstantCount];
+};
+
+struct DrawInstancedCommand {
+    static constexpr CommandType kType = CommandType::kDrawInstanced;
+    uint32_t VertexCountPerInstance;
+    uint32_t InstanceCount;
+    uint32_t StartVertexLocation;
+    uint32_t StartInstanceLocation;
+};
+
+/**
+ * Backend-agnostic recording of the rendering commands. The renderer records a frame into the
+ * stream without touching any graphics API, and a backend replays it: the D3D12 backend translates
+ * it into a command list, the null backend only counts and validates it, so the renderer's CPU
+ * cost can be measured without a GPU.
+ *
+ * The commands are packed back to back into one flat array of 8-byte words, a tag word followed
+ * by the command struct:
+ *
+ *   | tag | SetPipelineState | tag | SetVertexBuffer ... | tag | DrawInstanced ... | ...
+ *
+ * The transient data the commands bind, e.g. the per-instance constants, goes into a separate
+ * data blob the backend uploads in one go and the commands refer to by offset.
+ *
+ * The stream keeps its memory between the frames, so recording doesn't allocate once it has grown
+ * to the size of a frame.
+ */
+class CommandStream {
+   public:
+    // The data blob starts at this alignment on the GPU, so the data offsets aligned to it can be
+    // bound as constant buffers (D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT)
+    static constexpr size_t kDataPlacementAlignment = 256;
+
+    CommandStream() = default;
+    ~CommandStream() = default;
+
+    // Prohibit copying
+    CommandStream(const CommandStream&) = delete;
+    CommandStream& operator=(const CommandStream&) = delete;
+
+    // Allow moving
+    CommandStream(CommandStream&&) noexcept = default;
+    CommandStream& operator=(CommandStream&&) noexcept = default;
+
+    /**
+     * Drops the recorded commands and data, keeping the memory.
+     */
+    void Reset() {
+        mWords.clear();
+        mDataSize = 0;
+        mCommandCount = 0;
+    }
+
+    void SetRootSignature(ID3D12RootSignature* RootSignature) {
+        Push(SetRootSignatureCommand{RootSignature});
+    }
+
+    void SetPipelineState(ID3D12PipelineState* PipelineState) {
+        Push(SetPipelineStateCommand{PipelineState});
+    }
+
+    void SetPrimitiveTopology(PrimitiveTopology Topology) {
+        Push(SetPrimitiveTopologyCommand{Topology});
+    }
+
+    void SetViewport(const Viewport& Viewport) {
+        Push(SetViewportCommand{Viewport});
+    }
+
+    void SetScissorRect(const ScissorRect& Rect) {
+        Push(SetScissorRectCommand{Rect});
+    }
+
+    void ClearRenderTarget(const float* ClearColorRGBA) {
+        Push(ClearRenderTargetCommand{
+            {ClearColorRGBA[0], ClearColorRGBA[1], ClearColorRGBA[2], ClearColorRGBA[3]}});
+    }
+
+    void SetVertexBuffer(uint32_t Slot,
+                         uint64_t BufferLocation,
+                         uint32_t SizeInBytes,
+                         uint32_t StrideInBytes) {
+        Push(SetVertexBufferCommand{BufferLocation, SizeInBytes, StrideInBytes, Slot});
+    }
+
+    void SetRootConstantBufferData(uint32_t RootParameterIndex, uint32_t DataOffset) {
+        SetRootConstantBufferDataCommand command;
+        command.RootParameterIndex = RootParameterIndex;
+        command.DataOffset = DataOffset;
+        Push(command);
+    }
+
+    void SetRootShaderResourceData(uint32_t RootParameterIndex, uint32_t DataOffset) {
+        SetRootShaderResourceDataCommand command;
+        command.RootParameterIndex = RootParameterIndex;
+        command.DataOffset = DataOffset;
+        Push(command);
+    }
+
+    /**
+     * @param ConstantCount The number of 32-bit constants; the ones past
+     * SetRoot32BitConstantsCommand::kMaxConstantCount get dropped.
+     * @param Constants The constants; copied into the stream. May be nullptr without constants.
+     */
+    void SetRoot32BitConstants(uint32_t RootParameterIndex,
+                               uint32_t ConstantCount,
+                               const void* Constants) {
+        SetRoot32BitConstantsCommand command;
+        command.RootParameterIndex = RootParameterIndex;
+        command.ConstantCount =
+            std::min(ConstantCount, SetRoot32BitConstantsCommand::kMaxConstantCount);
+        if (command.ConstantCount != 0) {
+            memcpy(command.Constants, Constants, command.ConstantCount * sizeof(uint32_t));
+        }
+        Push(command);
+    }
+
+    void DrawInstanced(uint32_t VertexCountPerInstance,
+                       uint32_t InstanceCount,
+                       uint32_t StartVertexLocation,
+                       uint32_t StartInstanceLocation) {
+        Push(DrawInstancedCommand{VertexCountPerInstance, InstanceCount, StartVertexLocation,
+                                  StartInstanceLocation});
+    }
+
+    /**
+     * Allocates a range of the data blob for the caller to fill in.
+     *
+     * @param Size The size of the range in bytes.
+     * @param Alignment The alignment of the range offset; a power of two up to
+     * kDataPlacementAlignment.
+     * @param OutOffset Output parameter that will be populated with the offset of the range, to be
+     * passed to the SetRoot*Data commands.
+     * @return The CPU pointer to the range; valid until the next AllocateData or Reset call. The
+     * pointer itself is aligned to at most __STDCPP_DEFAULT_NEW_ALIGNMENT__.
+     */
+    void* AllocateData(size_t Size, size_t Alignment, uint32_t& OutOffset);
+
+    /**
+     * Replays the commands in the recorded order into the backend. The backend has to provide an
+     *   void Execute(const T& Command);
+     * overload for every command struct. Dispatching over a template parameter rather than a
+     * virtual interface lets the compiler inline the backend's handlers into the replay loop.
+     */
+    template <typename T>
+    void Replay(T& Backend) const;
+
+    const std::byte* GetData() const {
+        return mData.get();
+    }
+
+    size_t GetDataSize() const {
+        return mDataSize;
+    }
+
+    size_t GetCommandCount() const {
+        return mCommandCount;
+    }
+
+    /**
+     * Returns the size of the recorded commands in bytes, not including the data blob.
+     */
+    size_t GetCommandsSize() const {
+        return mWords.size() * sizeof(uint64_t);
+    }
+
+   private:
+    template <typename T>
+    static constexpr size_t kWordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    template <typename T>
+    void Push(const T& Command) {
+        static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= alignof(uint64_t));
+
+        const size_t at = mWords.size();
+        mWords.resize(at + 1 + kWordCount<T>);
+        mWords[at] = static_cast<uint64_t>(T::kType);
+        new (&mWords[at + 1]) T(Command);
+        ++mCommandCount;
+    }
+
+    template <typename T, typename B>
+    static void Dispatch(B& Backend, const uint64_t* Words, size_t& At) {
+        Backend.Execute(*std::launder(reinterpret_cast<const T*>(Words + At)));
+        At += kWordCount<T>;
+    }
+
+    std::vector<uint64_t> mWords;
+    size_t mCommandCount{0};
+
+    // Not value-initialized on growth, unlike a std::vector, as it gets overwritten anyway
+    std::unique_ptr<std::byte[]> mData;
+    size_t mDataSize{0};
+    size_t mDataCapacity{0};
+};
+
+template <typename T>
+void CommandStream::Replay(T& Backend) const {
+    const uint64_t* words = mWords.data();
+    const size_t wordCount = mWords.size();
+
+    for (size_t at = 0; at < wordCount;) {
+        const CommandType type = static_cast<CommandType>(words[at++]);
+        switch (type) {
+            case CommandType::kSetRootSignature:
+                Dispatch<SetRootSignatureCommand>(Backend, words, at);
+                break;
+            case CommandType::kSetPipelineState:
+                Dispatch<SetPipelineStateCommand>(Backend, words, at);
+                break;
+            case CommandType::kSetPrimitiveTopology:
+                Dispatch<SetPrimitiveTopologyCommand>(Backend, words, at);
+                break;
+            case CommandType::kSetViewport:
+                Dispatch<SetViewportCommand>(Backend, words, at);
+                break;
+            case CommandType::kSetScissorRect:
+                Dispatch<SetScissorRectCommand>(Backend, words, at);
+                break;
+            case CommandType::kClearRenderTarget:
+                Dispatch<ClearRenderTargetCommand>(Backend, words, at);
+                break;
+            case CommandType::kSetVertexBuffer:
+                Dispatch<SetVertexBufferCommand>(Backend, words, at);
+                break;
+            case CommandType::kSetRootConstantBufferData:
+                Dispatch<SetRootConstantBufferDataCommand>(Backend, words, at);
+                break;
+            case CommandType::kSetRootShaderResourceData:
+                Dispatch<SetRootShaderResourceDataCommand>(Backend, words, at);
+                break;
+            case CommandType::kSetRoot32BitConstants:
+                Dispatch<SetRoot32BitConstantsCommand>(Backend, words, at);
+                break;
+            case CommandType::kDrawInstanced:
+                Dispatch<DrawInstancedCommand>(Backend, words, at);
+                break;
+            case CommandType::kCount:
+                // Never recorded
+                return;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#include "D3D12CommandBackend.h"
+
+#include "Logging/Logging.h"
+#include "Memory/StreamingCopy.h"
+
+bool D3D12CommandBackend::Submit(const CommandStream& Stream) {
+    if (Stream.GetDataSize() > 0) {
+        UploadAllocation allocation;
+        if (!mCmdl->AllocateUpload(Stream.GetDataSize(), CommandStream::kDataPlacementAlignment,
+                                   allocation)) {
+            LOG_ERROR(L"Failed to upload %zu bytes of command stream data.\n",
+                      Stream.GetDataSize());
+            return false;
+        }
+
+        // One sequential streaming copy into the write-combined ring memory
+        StreamingCopy(allocation.CpuPtr, Stream.GetData(), Stream.GetDataSize());
+        mDataAddress = allocation.GpuAddress;
+    }
+
+    Stream.Replay(*this);
+    return true;
+}
+
+void D3D12CommandBackend::Execute(const SetPrimitiveTopologyCommand& Command) {
+    D3D_PRIMITIVE_TOPOLOGY topology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+    switch (Command.Topology) {
+        case PrimitiveTopology::kTriangleList:
+            topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+            break;
+    }
+    (*mCmdl)->IASetPrimitiveTopology(topology);
+}
+
+void D3D12CommandBackend::Execute(const SetViewportCommand& Command) {
+    D3D12_VIEWPORT viewport;
+    viewport.TopLeftX = Command.View.TopLeftX;
+    viewport.TopLeftY = Command.View.TopLeftY;
+    viewport.Width = Command.View.Width;
+    viewport.Height = Command.View.Height;
+    viewport.MinDepth = Command.View.MinDepth;
+    viewport.MaxDepth = Command.View.MaxDepth;
+    (*mCmdl)->RSSetViewports(1, &viewport);
+}
+
+void D3D12CommandBackend::Execute(const SetScissorRectCommand& Command) {
+    D3D12_RECT rect;
+    rect.left = Command.Rect.Left;
+    rect.top = Command.Rect.Top;
+    rect.right = Command.Rect.Right;
+    rect.bottom = Command.Rect.Bottom;
+    (*mCmdl)->RSSetScissorRects(1, &rect);
+}
+
+void D3D12CommandBackend::Execute(const SetVertexBufferCommand& Command) {
+    D3D12_VERTEX_BUFFER_VIEW vbv;
+    vbv.BufferLocation = Command.BufferLocation;
+    vbv.SizeInBytes = Command.SizeInBytes;
+    vbv.StrideInBytes = Command.StrideInBytes;
+    (*mCmdl)->IASetVertexBuffers(Command.Slot, 1, &vbv);
+}
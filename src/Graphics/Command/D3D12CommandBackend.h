@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CommandStream.h"
+#include "Graphics/CommandList10.h"
+#include "Includes/GraphicsIncl.h"
+
+/**
+ * Translates a CommandStream into a command list. The data blob of the stream gets copied into the
+ * list's upload ring with a single allocation, and the SetRoot*Data commands get bound at their
+ * offsets into it.
+ */
+class D3D12CommandBackend {
+   public:
+    /**
+     * @param Cmdl The command list to record into.
+     * @param RenderTarget The render target the clear commands clear.
+     */
+    D3D12CommandBackend(const CommandList10& Cmdl, const ColorBuffer& RenderTarget)
+        : mCmdl(&Cmdl), mRenderTarget(&RenderTarget) {}
+
+    explicit D3D12CommandBackend(const FrameCommandList10& Cmdl)
+        : D3D12CommandBackend(Cmdl, Cmdl.GetRenderTarget()) {}
+
+    // Prohibit copying
+    D3D12CommandBackend(const D3D12CommandBackend&) = delete;
+    D3D12CommandBackend& operator=(const D3D12CommandBackend&) = delete;
+
+    /**
+     * Uploads the stream data and records the commands into the command list.
+     * @return true if the stream was recorded, false if its data didn't fit into the upload ring.
+     */
+    bool Submit(const CommandStream& Stream);
+
+    void Execute(const SetRootSignatureCommand& Command) {
+        (*mCmdl)->SetGraphicsRootSignature(Command.RootSignature);
+    }
+
+    void Execute(const SetPipelineStateCommand& Command) {
+        (*mCmdl)->SetPipelineState(Command.PipelineState);
+    }
+
+    void Execute(const SetPrimitiveTopologyCommand& Command);
+
+    void Execute(const SetViewportCommand& Command);
+
+    void Execute(const SetScissorRectCommand& Command);
+
+    void Execute(const ClearRenderTargetCommand& Command) {
+        mCmdl->ClearRenderTarget(*mRenderTarget, Command.ColorRGBA);
+    }
+
+    void Execute(const SetVertexBufferCommand& Command);
+
+    void Execute(const SetRootConstantBufferDataCommand& Command) {
+        (*mCmdl)->SetGraphicsRootConstantBufferView(Command.RootParameterIndex,
+                                                   mDataAddress + Command.DataOffset);
+    }
+
+    void Execute(const SetRootShaderResourceDataCommand& Command) {
+        (*mCmdl)->SetGraphicsRootShaderResourceView(Command.RootParameterIndex,
+                                                   mDataAddress + Command.DataOffset);
+    }
+
+    void Execute(const SetRoot32BitConstantsCommand& Command) {
+        (*mCmdl)->SetGraphicsRoot32BitConstants(Command.RootParameterIndex, Command.ConstantCount,
+                                                Command.Constants, 0);
+    }
+
+    void Execute(const DrawInstancedCommand& Command) {
+        mCmdl->DrawInstanced(Command.VertexCountPerInstance, Command.InstanceCount,
+                             Command.StartVertexLocation, Command.StartInstanceLocation);
+    }
+
+   private:
+    // Not-owning
+    const CommandList10* mCmdl;
+    const ColorBuffer* mRenderTarget;
+
+    // GPU address of the stream data in the upload ring
+    D3D12_GPU_VIRTUAL_ADDRESS mDataAddress{0};
+};
@@ -0,0 +1,126 @@
+#include "NullCommandBackend.h"
+
+#include "Logging/Logging.h"
+
+bool NullCommandBackend::Submit(const CommandStream& Stream) {
+    mStream = &Stream;
+    mStreamErrorCount = 0;
+
+    mHasRootSignature = false;
+    mHasPipelineState = false;
+    mHasTopology = false;
+    mHasViewport = false;
+    mHasScissorRect = false;
+    mHasVertexBuffer = false;
+
+    Stream.Replay(*this);
+
+    mStream = nullptr;
+    mErrorCount += mStreamErrorCount;
+    return mStreamErrorCount == 0;
+}
+
+void NullCommandBackend::Reset() {
+    mCommandCounts.fill(0);
+    mInstanceCount = 0;
+    mVertexCount = 0;
+    mErrorCount = 0;
+}
+
+void NullCommandBackend::Execute(const SetRootSignatureCommand& Command) {
+    ++mCommandCounts[static_cast<size_t>(Command.kType)];
+    if (!Command.RootSignature) {
+        LOG_ERROR(L"Null root signature set.\n");
+        ++mStreamErrorCount;
+        return;
+    }
+    mHasRootSignature = true;
+}
+
+void NullCommandBackend::Execute(const SetPipelineStateCommand& Command) {
+    ++mCommandCounts[static_cast<size_t>(Command.kType)];
+    if (!Command.PipelineState) {
+        LOG_ERROR(L"Null pipeline state set.\n");
+        ++mStreamErrorCount;
+        return;
+    }
+    mHasPipelineState = true;
+}
+
+void NullCommandBackend::Execute(const SetPrimitiveTopologyCommand& Command) {
+    ++mCommandCounts[static_cast<size_t>(Command.kType)];
+    mHasTopology = true;
+}
+
+void NullCommandBackend::Execute(const SetViewportCommand& Command) {
+    ++mCommandCounts[static_cast<size_t>(Command.kType)];
+    if (Command.View.Width <= 0.f || Command.View.Height <= 0.f) {
+        LOG_ERROR(L"Empty viewport of %.1fx%.1f set.\n", Command.View.Width, Command.View.Height);
+        ++mStreamErrorCount;
+        return;
+    }
+    mHasViewport = true;
+}
+
+void NullCommandBackend::Execute(const SetScissorRectCommand& Command) {
+    ++mCommandCounts[static_cast<size_t>(Command.kType)];
+    mHasScissorRect = true;
+}
+
+void NullCommandBackend::Execute(const ClearRenderTargetCommand& Command) {
+    ++mCommandCounts[static_cast<size_t>(Command.kType)];
+}
+
+void NullCommandBackend::Execute(const SetVertexBufferCommand& Command) {
+    ++mCommandCounts[static_cast<size_t>(Command.kType)];
+    if (Command.StrideInBytes == 0 || Command.SizeInBytes < Command.StrideInBytes) {
+        LOG_ERROR(L"Invalid vertex buffer of %u bytes with a stride of %u set to slot %u.\n",
+                  Command.SizeInBytes, Command.StrideInBytes, Command.Slot);
+        ++mStreamErrorCount;
+        return;
+    }
+    if (Command.Slot == 0) {
+        mHasVertexBuffer = true;
+    }
+}
+
+void NullCommandBackend::Execute(const SetRootConstantBufferDataCommand& Command) {
+    ++mCommandCounts[static_cast<size_t>(Command.kType)];
+    if (Command.DataOffset % CommandStream::kDataPlacementAlignment != 0 ||
+        Command.DataOffset >= mStream->GetDataSize()) {
+        LOG_ERROR(L"Invalid constant buffer data offset %u bound to root parameter %u.\n",
+                  Command.DataOffset, Command.RootParameterIndex);
+        ++mStreamErrorCount;
+    }
+}
+
+void NullCommandBackend::Execute(const SetRootShaderResourceDataCommand& Command) {
+    ++mCommandCounts[static_cast<size_t>(Command.kType)];
+    if (Command.DataOffset >= mStream->GetDataSize()) {
+        LOG_ERROR(L"Invalid shader resource data offset %u bound to root parameter %u.\n",
+                  Command.DataOffset, Command.RootParameterIndex);
+        ++mStreamErrorCount;
+    }
+}
+
+void NullCommandBackend::Execute(const SetRoot32BitConstantsCommand& Command) {
+    ++mCommandCounts[static_cast<size_t>(Command.kType)];
+    if (Command.ConstantCount == 0) {
+        LOG_ERROR(L"No root constants set to root parameter %u.\n", Command.RootParameterIndex);
+        ++mStreamErrorCount;
+    }
+}
+
+void NullCommandBackend::Execute(const DrawInstancedCommand& Command) {
+    ++mCommandCounts[static_cast<size_t>(Command.kType)];
+    if (!mHasRootSignature || !mHasPipelineState || !mHasTopology || !mHasViewport ||
+        !mHasScissorRect || !mHasVertexBuffer) {
+        LOG_ERROR(L"Draw of %u instances recorded without the required state bound.\n",
+                  Command.InstanceCount);
+        ++mStreamErrorCount;
+        return;
+    }
+
+    mInstanceCount += Command.InstanceCount;
+    mVertexCount += static_cast<uint64_t>(Command.VertexCountPerInstance) * Command.InstanceCount;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "CommandStream.h"
+
+/**
+ * Replays a CommandStream without a GPU. Counts the commands, draws, instances and vertices, and
+ * validates the state every draw relies on, so the renderer's recording can be profiled and checked
+ * on a headless machine.
+ *
+ * A draw is valid when the root signature, the pipeline state, the primitive topology, the
+ * viewport, the scissor rect and vertex buffer slot 0 have been set, and the root data ranges lie
+ * within the stream's data blob.
+ */
+class NullCommandBackend {
+   public:
+    NullCommandBackend() = default;
+
+    // Prohibit copying
+    NullCommandBackend(const NullCommandBackend&) = delete;
+    NullCommandBackend& operator=(const NullCommandBackend&) = delete;
+
+    /**
+     * Replays the stream. The counters accumulate over the submitted streams; the bound state
+     * doesn't carry over from one stream to the next, the same way it doesn't between D3D12 command
+     * lists.
+     * @return true if all the commands of the stream are valid.
+     */
+    bool Submit(const CommandStream& Stream);
+
+    /**
+     * Zeroes the counters.
+     */
+    void Reset();
+
+    void Execute(const SetRootSignatureCommand& Command);
+    void Execute(const SetPipelineStateCommand& Command);
+    void Execute(const SetPrimitiveTopologyCommand& Command);
+    void Execute(const SetViewportCommand& Command);
+    void Execute(const SetScissorRectCommand& Command);
+    void Execute(const ClearRenderTargetCommand& Command);
+    void Execute(const SetVertexBufferCommand& Command);
+    void Execute(const SetRootConstantBufferDataCommand& Command);
+    void Execute(const SetRootShaderResourceDataCommand& Command);
+    void Execute(const SetRoot32BitConstantsCommand& Command);
+    void Execute(const DrawInstancedCommand& Command);
+
+    size_t GetCommandCount(CommandType Type) const {
+        return mCommandCounts[static_cast<size_t>(Type)];
+    }
+
+    size_t GetDrawCount() const {
+        return GetCommandCount(CommandType::kDrawInstanced);
+    }
+
+    uint64_t GetInstanceCount() const {
+        return mInstanceCount;
+    }
+
+    uint64_t GetVertexCount() const {
+        return mVertexCount;
+    }
+
+    size_t GetErrorCount() const {
+        return mErrorCount;
+    }
+
+   private:
+    // The commands of the stream being replayed
+    const CommandStream* mStream{nullptr};
+    size_t mStreamErrorCount{0};
+
+    // State bound by the stream being replayed
+    bool mHasRootSignature{false};
+    bool mHasPipelineState{false};
+    bool mHasTopology{false};
+    bool mHasViewport{false};
+    bool mHasScissorRect{false};
+    bool mHasVertexBuffer{false};
+
+    std::array<size_t, static_cast<size_t>(CommandType::kCount)> mCommandCounts{};
+    uint64_t mInstanceCount{0};
+    uint64_t mVertexCount{0};
+    size_t mErrorCount{0};
+};
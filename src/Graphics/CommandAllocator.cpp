@@ -2,12 +2,15 @@
 
 #include "Logging/Logging.h"
 
-bool CommandAllocator::GetID3D12CommandList(ID3D12GraphicsCommandList10*& OutCommandList) const {
+bool CommandAllocator::Reset() const {
     if (FAILED(mD3D12CommandAllocator->Reset())) {
         LOG_ERROR(L"Failed to reset ID3D12CommandAllocator\n");
         return false;
     }
+    return true;
+}
 
+bool CommandAllocator::GetID3D12CommandList(ID3D12GraphicsCommandList10*& OutCommandList) const {
     if (FAILED(mD3D12GraphicsCommandList->Reset(mD3D12CommandAllocator.Get(), nullptr))) {
         LOG_ERROR(L"Failed to reset ID3D12GraphicsCommandList\n");
         return false;
@@ -15,4 +18,14 @@ bool CommandAllocator::GetID3D12CommandList(ID3D12GraphicsCommandList10*& OutCom
 
     OutCommandList = mD3D12GraphicsCommandList.Get();
     return true;
-}
\ No newline at end of file
+}
+
+bool CommandAllocator::GetFixupCommandList(ID3D12GraphicsCommandList10*& OutCommandList) const {
+    if (FAILED(mD3D12FixupCommandList->Reset(mD3D12CommandAllocator.Get(), nullptr))) {
+        LOG_ERROR(L"Failed to reset the fix-up ID3D12GraphicsCommandList\n");
+        return false;
+    }
+
+    OutCommandList = mD3D12FixupCommandList.Get();
+    return true;
+}
@@ -12,10 +12,12 @@ class CommandAllocator {
    public:
     CommandAllocator(D3D12_COMMAND_LIST_TYPE Type,
                      ComPtr<ID3D12CommandAllocator>&& pD3D12CommandAllocator,
-                     ComPtr<ID3D12GraphicsCommandList10>&& pGraphicsCommandList)
+                     ComPtr<ID3D12GraphicsCommandList10>&& pGraphicsCommandList,
+                     ComPtr<ID3D12GraphicsCommandList10>&& pFixupCommandList)
         : mType{Type},
           mD3D12CommandAllocator{std::move(pD3D12CommandAllocator)},
-          mD3D12GraphicsCommandList{std::move(pGraphicsCommandList)} {}
+          mD3D12GraphicsCommandList{std::move(pGraphicsCommandList)},
+          mD3D12FixupCommandList{std::move(pFixupCommandList)} {}
 
     ~CommandAllocator() {
         LOG_INFO(L"Freeing CommandAllocator of type %d\n", mType);
@@ -25,11 +27,26 @@ class CommandAllocator {
     CommandAllocator(const CommandAllocator& copy) = delete;
     CommandAllocator& operator=(const CommandAllocator& copy) = delete;
 
-    // Get a fresh command list
+    /**
+     * Frees the memory of the recorded commands. The GPU must be done executing them.
+     */
+    bool Reset() const;
+
+    /**
+     * Gets the command list reset for recording into the allocator. The list can be reset again
+     * once it has been submitted, so several lists per frame can share the allocator.
+     */
     bool GetID3D12CommandList(ID3D12GraphicsCommandList10*& OutCommandList) const;
 
+    /**
+     * Gets the list for the fix-up barriers resolved at submission, reset for recording into the
+     * allocator. The command list has to be closed already.
+     */
+    bool GetFixupCommandList(ID3D12GraphicsCommandList10*& OutCommandList) const;
+
    private:
     D3D12_COMMAND_LIST_TYPE mType;
     ComPtr<ID3D12CommandAllocator> mD3D12CommandAllocator;
     ComPtr<ID3D12GraphicsCommandList10> mD3D12GraphicsCommandList;
+    ComPtr<ID3D12GraphicsCommandList10> mD3D12FixupCommandList;
 };
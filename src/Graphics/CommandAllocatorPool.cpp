@@ -0,0 +1,58 @@
+#include "CommandAllocatorPool.h"
+
+#include "Device.h"
+#include "Logging/Logging.h"
+
+bool CommandAllocatorPool::Acquire(CommandAllocator*& OutAllocator) {
+    CommandAllocator* allocator = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // Recycle the allocators of the completed submissions
+        const uint64_t completedFenceValue = mCommandQueue->GetCompletedFenceValue();
+        while (!mPending.empty() && mPending.front().FenceValue <= completedFenceValue) {
+            mFree.push_back(mPending.front().Allocator);
+            mPending.pop_front();
+        }
+
+        if (!mFree.empty()) {
+            allocator = mFree.back();
+            mFree.pop_back();
+        }
+    }
+
+    if (allocator) {
+        // The GPU is done with the commands recorded the last time
+        if (!allocator->Reset()) {
+            LOG_ERROR(L"Failed to reset a pooled command allocator.\n");
+            Release(allocator, 0);
+            return false;
+        }
+        OutAllocator = allocator;
+        return true;
+    }
+
+    // Create outside the lock, so the other threads keep recycling meanwhile
+    std::unique_ptr<CommandAllocator> newAllocator;
+    if (!Device::CreateCommandAllocator(mD3DDevice, mType, D3D12_COMMAND_LIST_FLAG_NONE,
+                                        newAllocator)) {
+        LOG_ERROR(L"Failed to create a pooled command allocator.\n");
+        return false;
+    }
+
+    OutAllocator = newAllocator.get();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mAllocators.push_back(std::move(newAllocator));
+    return true;
+}
+
+void CommandAllocatorPool::Release(CommandAllocator* Allocator, uint64_t FenceValue) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // A fence value racing in lower than the last one only delays the recycling
+    if (!mPending.empty() && FenceValue < mPending.back().FenceValue) {
+        FenceValue = mPending.back().FenceValue;
+    }
+    mPending.push_back({FenceValue, Allocator});
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "CommandAllocator.h"
+#include "CommandQueue.h"
+#include "Includes/ComIncl.h"
+#include "Includes/GraphicsIncl.h"
+
+/**
+ * A thread-safe pool of allocator/list pairs, so several threads can record command lists at once.
+ *
+ * An allocator gets handed out for recording one list, and released back with the fence value
+ * signaled after the list's submission. It's reset and handed out again once the fence value
+ * completes, so the pool grows to the number of lists recorded over the frames in flight and
+ * stays there.
+ */
+class CommandAllocatorPool {
+    // Alias for Microsoft::WRL::ComPtr
+    template <typename T>
+    using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+   public:
+    CommandAllocatorPool(ComPtr<ID3D12Device14> D3DDevice,
+                         CommandQueue& CommandQueue,
+                         D3D12_COMMAND_LIST_TYPE Type)
+        : mD3DDevice(std::move(D3DDevice)), mCommandQueue(&CommandQueue), mType(Type) {}
+
+    // Prohibit copying and moving as the command lists hold a pointer to the pool
+    CommandAllocatorPool(const CommandAllocatorPool&) = delete;
+    CommandAllocatorPool& operator=(const CommandAllocatorPool&) = delete;
+    CommandAllocatorPool(CommandAllocatorPool&&) = delete;
+    CommandAllocatorPool& operator=(CommandAllocatorPool&&) = delete;
+
+    /**
+     * Hands out an allocator the GPU is done with, reset for recording, creating one if there's
+     * none.
+     * @param OutAllocator Output parameter that will be populated with the allocator on success.
+     * Unchanged on failure.
+     * @return true if the allocator was acquired, false otherwise.
+     */
+    bool Acquire(CommandAllocator*& OutAllocator);
+
+    /**
+     * Takes the allocator back; it gets recycled once the fence value completes.
+     * @param Allocator The allocator handed out by Acquire.
+     * @param FenceValue The fence value signaled after the submission of the list recorded into
+     * the allocator.
+     */
+    void Release(CommandAllocator* Allocator, uint64_t FenceValue);
+
+    uint32_t GetAllocatorCount() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return static_cast<uint32_t>(mAllocators.size());
+    }
+
+   private:
+    struct PendingAllocator {
+        uint64_t FenceValue;
+        CommandAllocator* Allocator;
+    };
+
+    ComPtr<ID3D12Device14> mD3DDevice;
+
+    // Not-owning
+    CommandQueue* mCommandQueue;
+
+    D3D12_COMMAND_LIST_TYPE mType;
+
+    mutable std::mutex mMutex;
+    std::vector<std::unique_ptr<CommandAllocator>> mAllocators;
+    // Ordered by the fence value
+    std::deque<PendingAllocator> mPending;
+    std::vector<CommandAllocator*> mFree;
+};
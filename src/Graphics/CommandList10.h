@@ -1,38 +1,50 @@
 #pragma once
 
+#include <algorithm>
 #include <utility>
 
+#include "CommandAllocator.h"
+#include "CommandAllocatorPool.h"
 #include "CommandQueue.h"
 #include "Includes/ComIncl.h"
 #include "Includes/GraphicsIncl.h"
 #include "Logging/Logging.h"
 #include "Mesh/Mesh.h"
+#include "ResourceBarrierBatch.h"
+#include "ResourceStateTracker.h"
 #include "Resource/DeviceBuffer.h"
 #include "Resource/Resource.h"
+#include "Resource/UploadRing.h"
 #include "SwapChain.h"
 
 /**
  * CommandList is a RAII wrapper for any ID3D12GraphicsCommandList version.
- * It ensures that the command list is executed and the command queue is waited on when it goes
- * out of scope.
+ * It ensures that the command list is executed when it goes out of scope. A blocking command list
+ * also waits on the command queue; a frame command list doesn't, as the frame slot it belongs to
+ * gets waited on only when it's reused. A pooled command list gives its allocator back to the pool
+ * once executed.
  */
 class CommandList10 {
    public:
     CommandList10() = default;
 
-    CommandList10(CommandQueue* CommandQueue, ID3D12GraphicsCommandList10* CommandList)
-        : mCommandQueue{CommandQueue}, mD3DCommandList{CommandList} {}
+    CommandList10(CommandQueue* CommandQueue,
+                  CommandAllocator* CommandAllocator,
+                  ID3D12GraphicsCommandList10* CommandList,
+                  UploadRing* UploadRing = nullptr,
+                  uint32_t FrameIndex = 0,
+                  bool IsBlocking = true,
+                  CommandAllocatorPool* AllocatorPool = nullptr)
+        : mCommandQueue{CommandQueue},
+          mCommandAllocator{CommandAllocator},
+          mAllocatorPool{AllocatorPool},
+          mD3DCommandList{CommandList},
+          mUploadRing{UploadRing},
+          mFrameIndex{FrameIndex},
+          mIsBlocking{IsBlocking} {}
 
     virtual ~CommandList10() {
-        // Execute and wait on current command list if valid
-        if (mCommandQueue && mD3DCommandList) {
-            if (!mCommandQueue->ExecuteCommandList(mD3DCommandList)) {
-                LOG_ERROR(L"Failed to execute command list.\n");
-            }
-            if (!mCommandQueue->WaitForIdle()) {
-                LOG_ERROR(L"Failed to wait on command queue.\n");
-            }
-        }
+        Submit();
     }
 
     // Prohibit copying
@@ -42,29 +54,109 @@ class CommandList10 {
     // Move constructor
     CommandList10(CommandList10&& Other) noexcept
         : mCommandQueue{std::exchange(Other.mCommandQueue, nullptr)},
-          mD3DCommandList{std::exchange(Other.mD3DCommandList, nullptr)} {}
+          mCommandAllocator{std::exchange(Other.mCommandAllocator, nullptr)},
+          mAllocatorPool{std::exchange(Other.mAllocatorPool, nullptr)},
+          mD3DCommandList{std::exchange(Other.mD3DCommandList, nullptr)},
+          mUploadRing{std::exchange(Other.mUploadRing, nullptr)},
+          mFrameIndex{std::exchange(Other.mFrameIndex, 0)},
+          mIsBlocking{std::exchange(Other.mIsBlocking, true)},
+          mBarriers{std::move(Other.mBarriers)},
+          mStates{std::move(Other.mStates)} {}
 
     // Move assignment operator
     CommandList10& operator=(CommandList10&& Other) noexcept {
         if (this != &Other) {
             // The command list doesn't own these resources, so just move the pointers
             mCommandQueue = std::exchange(Other.mCommandQueue, nullptr);
+            mCommandAllocator = std::exchange(Other.mCommandAllocator, nullptr);
+            mAllocatorPool = std::exchange(Other.mAllocatorPool, nullptr);
             mD3DCommandList = std::exchange(Other.mD3DCommandList, nullptr);
+            mUploadRing = std::exchange(Other.mUploadRing, nullptr);
+            mFrameIndex = std::exchange(Other.mFrameIndex, 0);
+            mIsBlocking = std::exchange(Other.mIsBlocking, true);
+            mBarriers = std::move(Other.mBarriers);
+            mStates = std::move(Other.mStates);
         }
         return *this;
     }
 
     // Instance members
-    void CopyBufferRegion(const Resource& From,
+
+    /**
+     * Executes the command list right away rather than when it goes out of scope, e.g. to submit
+     * the lists recorded in parallel in order. Does nothing if the list has been submitted.
+     * @return true if the list was executed (and waited on if blocking), false otherwise.
+     */
+    bool Submit() {
+        if (!mCommandQueue || !mD3DCommandList) {
+            return true;
+        }
+
+        bool isSubmitted = true;
+        FlushResourceBarriers();
+        if (!mCommandQueue->ExecuteCommandList(mD3DCommandList, mStates, *mCommandAllocator)) {
+            LOG_ERROR(L"Failed to execute command list.\n");
+            isSubmitted = false;
+        }
+
+        // The allocator gets recycled once the GPU is done with the list
+        if (mAllocatorPool) {
+            mAllocatorPool->Release(mCommandAllocator, mCommandQueue->GetLastSignaledFenceValue());
+        }
+
+        if (mIsBlocking && !mCommandQueue->WaitForIdle()) {
+            LOG_ERROR(L"Failed to wait on command queue.\n");
+            isSubmitted = false;
+        }
+
+        mCommandQueue = nullptr;
+        mD3DCommandList = nullptr;
+        return isSubmitted;
+    }
+
+    /**
+     * Returns the frame slot the command list records for. Per-frame CPU-written resources are
+     * indexed by it so that frames in flight don't overwrite each other's data.
+     */
+    uint32_t GetFrameIndex() const {
+        return mFrameIndex;
+    }
+
+    /**
+     * Copies NumBytes from FromOffset into the start of To. The offsets are relative to the
+     * buffers, which may be ranges of a shared page buffer.
+     */
+    void CopyBufferRegion(const DeviceBuffer& From,
                           size_t FromOffset,
-                          const Resource& To,
+                          const DeviceBuffer& To,
                           size_t NumBytes) const {
-        mD3DCommandList->CopyBufferRegion(To.GetResource(), 0, From.GetResource(), FromOffset,
-                                          NumBytes);
+        FlushResourceBarriers();
+        mD3DCommandList->CopyBufferRegion(To.GetResource(), To.GetResourceOffset(),
+                                          From.GetResource(),
+                                          From.GetResourceOffset() + FromOffset, NumBytes);
+    }
+
+    /**
+     * Allocates a range of the frame's upload ring for the caller to fill in. The range stays
+     * valid on the GPU until the frame completes.
+     *
+     * @param Size The size of the range in bytes.
+     * @param Alignment The alignment of the range; a power of two.
+     * @param OutAllocation Output parameter that will be populated with the CPU and GPU addresses
+     * of the range.
+     * @return true if the range was allocated, false if the list has no upload ring or it's full.
+     */
+    bool AllocateUpload(size_t Size, size_t Alignment, UploadAllocation& OutAllocation) const {
+        if (!mUploadRing || !mUploadRing->Allocate(Size, Alignment, OutAllocation)) {
+            LOG_ERROR(L"Failed to allocate %zu bytes of upload data.\n", Size);
+            return false;
+        }
+        return true;
     }
 
-    void SetConstantBuffer(uint32_t Index, DeviceBuffer& View) const {
-        mD3DCommandList->SetGraphicsRootConstantBufferView(Index, View.GetDeviceVirtualAddress());
+    void ClearRenderTarget(const ColorBuffer& RTV, const float* ClearColorRGBA) const {
+        FlushResourceBarriers();
+        mD3DCommandList->ClearRenderTargetView(RTV.GetRTV(), ClearColorRGBA, 0, nullptr);
     }
 
     void SetRenderTarget(ColorBuffer& RTV) const {
@@ -89,52 +181,110 @@ class CommandList10 {
                        uint32_t NumInstance,
                        uint32_t StartVertexOffset,
                        uint32_t StartInstanceOffset) const {
+        FlushResourceBarriers();
         mD3DCommandList->DrawInstanced(NumVertexPerInstance, NumInstance, StartVertexOffset,
                                        StartInstanceOffset);
     }
 
     /** Transition a resource from one state to another.
      *  This is a template method that accepts any type derived from Resource.
+     *  The state is tracked by the list alone, so lists may record on several threads. The first
+     *  transition of a resource gets resolved against its shared state at submission; the
+     *  following ones are batched and submitted before the next draw, clear or copy.
      */
     template <typename T>
     void TransitionResource(T& Rsrc, D3D12_RESOURCE_STATES After)
         requires std::is_base_of_v<Resource, T>
     {
-        D3D12_RESOURCE_STATES Before = Rsrc.GetCurrentState();
-
-        if (Before != After) {
-            // Prepare a transition barrier desc.
-            D3D12_RESOURCE_BARRIER desc{};
-            desc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-            desc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-            // The resource to transition.
-            desc.Transition.pResource = Rsrc.GetResource();
-            // Transition all subresources
-            desc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-            desc.Transition.StateBefore = Before;
-            desc.Transition.StateAfter = After;
-
-            Rsrc.SetCurrentState(After);
-
-            mD3DCommandList->ResourceBarrier(1, &desc);
-        }
+        mStates.Transition(Rsrc.GetState(), After, mBarriers);
 
         // TODO: Implement state management with D3D12 Enhanced Barriers API
     }
 
+    /**
+     * Submits the batched transition barriers in one ResourceBarrier call.
+     */
+    void FlushResourceBarriers() const {
+        mBarriers.Flush(*this);
+    }
+
+    /**
+     * Records the transitions as barriers; the target of the barrier batch flush.
+     */
+    void ResourceBarriers(const BarrierTransition* Transitions, uint32_t Count) const {
+        RecordResourceBarriers(mD3DCommandList, Transitions, Count);
+    }
+
+    /**
+     * Records the transitions as barriers into the D3D12 command list.
+     */
+    static void RecordResourceBarriers(ID3D12GraphicsCommandList10* CommandList,
+                                       const BarrierTransition* Transitions,
+                                       uint32_t Count) {
+        // Convert in chunks on the stack, a batch rarely exceeds one
+        constexpr uint32_t kChunkSize = 16;
+        D3D12_RESOURCE_BARRIER descs[kChunkSize];
+
+        for (uint32_t first = 0; first < Count; first += kChunkSize) {
+            const uint32_t chunkSize = std::min(Count - first, kChunkSize);
+            for (uint32_t i = 0; i < chunkSize; ++i) {
+                const BarrierTransition& transition = Transitions[first + i];
+
+                D3D12_RESOURCE_BARRIER& desc = descs[i];
+                desc = {};
+                desc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+                desc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+                desc.Transition.pResource = transition.Resource;
+                // Transition all subresources
+                desc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+                desc.Transition.StateBefore =
+                    static_cast<D3D12_RESOURCE_STATES>(transition.StateBefore);
+                desc.Transition.StateAfter =
+                    static_cast<D3D12_RESOURCE_STATES>(transition.StateAfter);
+            }
+            CommandList->ResourceBarrier(chunkSize, descs);
+        }
+    }
+
+    /**
+     * Returns the barrier batch, e.g. to report how many barriers got collapsed.
+     */
+    const ResourceBarrierBatch& GetResourceBarriers() const {
+        return mBarriers;
+    }
+
+    /**
+     * The raw command list. Flushes the batched barriers first, as whatever gets recorded through
+     * it may depend on them.
+     */
     ID3D12GraphicsCommandList10* operator->() const {
+        FlushResourceBarriers();
         return mD3DCommandList;
     }
 
    protected:
     CommandQueue* mCommandQueue{nullptr};
+    // Not-owning; records the fix-up barriers at submission
+    CommandAllocator* mCommandAllocator{nullptr};
+    // Not-owning; nullptr unless the allocator is pooled
+    CommandAllocatorPool* mAllocatorPool{nullptr};
     ID3D12GraphicsCommandList10* mD3DCommandList{nullptr};
+
+    // Not-owning; transient per-frame data
+    UploadRing* mUploadRing{nullptr};
+
+    uint32_t mFrameIndex{0};
+    bool mIsBlocking{true};
+
+    // Mutable, as the const recording methods flush it
+    mutable ResourceBarrierBatch mBarriers;
+    ResourceStateTracker mStates;
 };
 
 /**
  * FrameCommandList is a RAII wrapper for any ID3D12GraphicsCommandList version that is used for
  * rendering a frame. It ensures that the frame is begun and ended on the swap chain, and that the
- * command list is executed and the command queue is waited on when it goes out of scope.
+ * command list is executed when it goes out of scope.
  */
 class FrameCommandList10 : public CommandList10 {
    public:
@@ -142,19 +292,23 @@ class FrameCommandList10 : public CommandList10 {
 
     FrameCommandList10(SwapChain* SwapChain,
                        CommandQueue* CommandQueue,
-                       ID3D12GraphicsCommandList10* CommandList)
-        : CommandList10(CommandQueue, CommandList), mSwapChain{SwapChain} {
+                       CommandAllocator* CommandAllocator,
+                       ID3D12GraphicsCommandList10* CommandList,
+                       UploadRing* UploadRing,
+                       uint32_t FrameIndex)
+        : CommandList10(CommandQueue, CommandAllocator, CommandList, UploadRing, FrameIndex, false),
+          mSwapChain{SwapChain} {
         // Begin the frame on the swap chain
         mSwapChain->BeginFrame(*this);
     }
 
     ~FrameCommandList10() {
-        // End the frame on the swap chain
-        if (mSwapChain) {
+        // End the frame on the swap chain, unless the list has been submitted already
+        if (mSwapChain && mD3DCommandList) {
             mSwapChain->EndFrame(*this);
         }
 
-        // Let the base class handle executing and waiting on the command list
+        // Let the base class handle executing the command list
         // CommandList10::~CommandList10(); is implicitly called
     }
 
@@ -182,8 +336,14 @@ class FrameCommandList10 : public CommandList10 {
             LOG_ERROR(L"ClearRenderTarget: mSwapChain is nullptr.");
             return;
         }
-        D3D12_CPU_DESCRIPTOR_HANDLE RenderTarget = mSwapChain->GetCurrentBackBuffer().GetRTV();
-        mD3DCommandList->ClearRenderTargetView(RenderTarget, ClearColorRGBA, 0, nullptr);
+        CommandList10::ClearRenderTarget(mSwapChain->GetCurrentBackBuffer(), ClearColorRGBA);
+    }
+
+    /**
+     * Returns the back buffer the frame renders to.
+     */
+    ColorBuffer& GetRenderTarget() const {
+        return mSwapChain->GetCurrentBackBuffer();
     }
 
    private:
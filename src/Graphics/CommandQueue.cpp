@@ -1,8 +1,11 @@
 #include "CommandQueue.h"
 
+#include "CommandList10.h"
 #include "Logging/Logging.h"
 
-bool CommandQueue::ExecuteCommandList(ID3D12GraphicsCommandList10* CommandList) {
+bool CommandQueue::ExecuteCommandList(ID3D12GraphicsCommandList10* CommandList,
+                                      ResourceStateTracker& States,
+                                      const CommandAllocator& Allocator) {
     if (CommandList == nullptr) {
         LOG_ERROR(L"CommandList is null.\n");
         return false;
@@ -13,8 +16,31 @@ bool CommandQueue::ExecuteCommandList(ID3D12GraphicsCommandList10* CommandList)
         return false;
     }
 
-    ID3D12CommandList* Lists[1] = {CommandList};
-    mD3D12CommandQueue->ExecuteCommandLists(1, Lists);
+    std::lock_guard<std::mutex> LockGuard(mSubmitMutex);
+
+    // The shared states are as the previously submitted lists leave them
+    mFixups.clear();
+    States.Resolve(mFixups);
+
+    ID3D12CommandList* Lists[2];
+    uint32_t ListCount = 0;
+    if (!mFixups.empty()) {
+        ID3D12GraphicsCommandList10* FixupList;
+        if (!Allocator.GetFixupCommandList(FixupList)) {
+            LOG_ERROR(L"Failed to get the fix-up command list.\n");
+            return false;
+        }
+
+        CommandList10::RecordResourceBarriers(FixupList, mFixups.data(),
+                                              static_cast<uint32_t>(mFixups.size()));
+        if (FAILED(FixupList->Close())) {
+            LOG_ERROR(L"Failed to close the fix-up command list.\n");
+            return false;
+        }
+        Lists[ListCount++] = FixupList;
+    }
+    Lists[ListCount++] = CommandList;
+    mD3D12CommandQueue->ExecuteCommandLists(ListCount, Lists);
 
     NextFenceValue();
     return true;
@@ -30,6 +56,14 @@ uint64_t CommandQueue::NextFenceValue() {
     return mNextFenceValue++;
 }
 
+bool CommandQueue::WaitForQueue(const CommandQueue& Queue, uint64_t FenceValue) {
+    if (FAILED(mD3D12CommandQueue->Wait(Queue.mD3D12Fence.Get(), FenceValue))) {
+        LOG_ERROR(L"Failed to make the queue wait on the fence value %llu.\n", FenceValue);
+        return false;
+    }
+    return true;
+}
+
 bool CommandQueue::WaitForFenceValue(uint64_t FenceValueToWait) {
     // Check the fence has already been crossed first
     if (FenceValueToWait > mD3D12Fence->GetCompletedValue()) {
@@ -1,10 +1,13 @@
 #pragma once
 
 #include <mutex>
+#include <vector>
 
+#include "CommandAllocator.h"
 #include "Includes/ComIncl.h"
 #include "Includes/GraphicsIncl.h"
 #include "Logging/Logging.h"
+#include "ResourceStateTracker.h"
 
 class CommandQueue {
     // Alias for Microsoft::WRL::ComPtr
@@ -18,7 +21,8 @@ class CommandQueue {
                  ComPtr<ID3D12Fence1>&& D3D12Fence,
                  ComPtr<ID3D12CommandQueue>&& D3D12CommandQueue)
         : mType{Type},
-          mNextFenceValue{InitFenceValue},
+          // The fence starts completed at InitFenceValue, so the first signal has to go above it
+          mNextFenceValue{InitFenceValue + 1},
           mFenceEventHandle{FenceEventHandle},
           mD3D12Fence{std::move(D3D12Fence)},
           mD3D12CommandQueue{std::move(D3D12CommandQueue)} {}
@@ -31,12 +35,53 @@ class CommandQueue {
     }
 
     // Class members
-    bool ExecuteCommandList(ID3D12GraphicsCommandList10* CommandList);
+
+    /**
+     * Closes and executes the command list. The resource states the list tracked get resolved
+     * against the shared ones in the submission order; the fix-up barriers are recorded into the
+     * allocator's fix-up list executed right before the command list.
+     *
+     * @param CommandList The command list to execute.
+     * @param States The resource states tracked by the command list; cleared.
+     * @param Allocator The allocator the command list records into.
+     * @return true if the command list was executed, false otherwise.
+     */
+    bool ExecuteCommandList(ID3D12GraphicsCommandList10* CommandList,
+                            ResourceStateTracker& States,
+                            const CommandAllocator& Allocator);
     bool WaitForFenceValue(uint64_t FenceValueToWait);
+
+    /**
+     * Makes this queue wait on the GPU until the other queue's fence reaches the value; the CPU
+     * doesn't block.
+     */
+    bool WaitForQueue(const CommandQueue& Queue, uint64_t FenceValue);
     bool WaitForIdle() {
         return WaitForFenceValue(NextFenceValue());
     }
 
+    /**
+     * Returns the fence value signaled after the last submission. Waiting for it waits for all the
+     * work submitted so far.
+     */
+    uint64_t GetLastSignaledFenceValue() {
+        std::lock_guard<std::mutex> LockGuard(mFenceValueMutex);
+        return mNextFenceValue - 1;
+    }
+
+    /**
+     * Returns the fence value the next submission signals. Waiting for it also covers the command
+     * list being recorded, provided it's the next one to be executed.
+     */
+    uint64_t GetNextFenceValue() {
+        std::lock_guard<std::mutex> LockGuard(mFenceValueMutex);
+        return mNextFenceValue;
+    }
+
+    uint64_t GetCompletedFenceValue() const {
+        return mD3D12Fence->GetCompletedValue();
+    }
+
     // Prohibit copying
     CommandQueue(const CommandQueue& copy) = delete;
     CommandQueue& operator=(const CommandQueue& copy) = delete;
@@ -53,6 +98,10 @@ class CommandQueue {
     uint64_t mNextFenceValue;
     std::mutex mFenceValueMutex;
 
+    // Keeps the resource state resolution in the execution order
+    std::mutex mSubmitMutex;
+    std::vector<BarrierTransition> mFixups;
+
     HANDLE mFenceEventHandle;
     std::mutex mFenceEventMutex;
 
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * Parks the objects the GPU may still be using until the fence value signaled after their last
+ * use completes. Releasing an object is destroying it, so the item type decides what releasing
+ * means, e.g. dropping a ComPtr and freeing its heap range.
+ *
+ *   Enqueue(5, A)  Enqueue(6, B)  Enqueue(6, C)  Release(5) -> A   Release(7) -> B, C
+ *
+ * The queue knows nothing about the GPU: the fence values come from the caller, so it can be
+ * driven by a simulated fence as well. Items may get enqueued from any thread.
+ *
+ * @tparam T The parked item type; movable.
+ */
+template <typename T>
+class DeferredReleaseQueue {
+   public:
+    DeferredReleaseQueue() = default;
+
+    ~DeferredReleaseQueue() {
+        ReleaseAll();
+    }
+
+    // Prohibit copying
+    DeferredReleaseQueue(const DeferredReleaseQueue&) = delete;
+    DeferredReleaseQueue& operator=(const DeferredReleaseQueue&) = delete;
+
+    /**
+     * Parks the item until the fence value completes.
+     * @param FenceValue The fence value signaled after the last GPU use of the item.
+     * @param Item The item to release.
+     */
+    void Enqueue(uint64_t FenceValue, T&& Item) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // Keep the entries ordered by the fence value, so Release stops at the first pending
+        // one. A fence value racing in lower than the last one only delays the release.
+        if (!mEntries.empty() && FenceValue < mEntries.back().FenceValue) {
+            FenceValue = mEntries.back().FenceValue;
+        }
+        mEntries.push_back({FenceValue, std::move(Item)});
+    }
+
+    /**
+     * Releases the items whose fence values have completed.
+     * @return The number of items released.
+     */
+    size_t Release(uint64_t CompletedFenceValue) {
+        // Destroy the items outside the lock, so releasing them may enqueue other items
+        std::deque<Entry> released;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            while (!mEntries.empty() && mEntries.front().FenceValue <= CompletedFenceValue) {
+                released.push_back(std::move(mEntries.front()));
+                mEntries.pop_front();
+            }
+        }
+        return released.size();
+    }
+
+    /**
+     * Hands the items whose fence values have completed over to the caller instead of releasing
+     * them, e.g. to park them on the fence of another queue.
+     * @param OutItems Output parameter the items get appended to.
+     * @return The number of items taken.
+     */
+    size_t Take(uint64_t CompletedFenceValue, std::vector<T>& OutItems) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        size_t count = 0;
+        while (!mEntries.empty() && mEntries.front().FenceValue <= CompletedFenceValue) {
+            OutItems.push_back(std::move(mEntries.front().Item));
+            mEntries.pop_front();
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * Releases all the items regardless of their fence values, e.g. once the GPU is idle.
+     * @return The number of items released.
+     */
+    size_t ReleaseAll() {
+        std::deque<Entry> released;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            released.swap(mEntries);
+        }
+        return released.size();
+    }
+
+    size_t GetSize() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mEntries.size();
+    }
+
+   private:
+    struct Entry {
+        uint64_t FenceValue;
+        T Item;
+    };
+
+    mutable std::mutex mMutex;
+    std::deque<Entry> mEntries;
+};
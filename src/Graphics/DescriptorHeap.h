@@ -3,18 +3,26 @@
 #include "Includes/ComIncl.h"
 #include "Includes/GraphicsIncl.h"
 #include "Logging/Logging.h"
+#include "Memory/DescriptorAllocator.h"
 
+/**
+ * A CPU descriptor heap. The descriptors get recycled: the persistent ones are freed by their
+ * handle, the transient ones are recycled all at once when their frame slot comes around again.
+ * The index bookkeeping lives in the DescriptorAllocator, this class only maps the indices to
+ * handles.
+ */
 class DescriptorHeap {
    public:
     DescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE Type,
                    uint32_t Size,
                    uint32_t Count,
+                   uint32_t TransientCountPerFrame,
+                   uint32_t FrameCount,
                    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>&& DescriptorHeap)
-        : mType{Type},
-          mSize{Size},
-          mFreeDescriptorCount{Count},
+        : mSize{Size},
+          mAllocator{Count, TransientCountPerFrame, FrameCount},
+          mType{Type},
           mFirstHandle{DescriptorHeap->GetCPUDescriptorHandleForHeapStart()},
-          mCurrentHandle{mFirstHandle},
           mD3D12Heap{std::move(DescriptorHeap)} {}
 
     // Prohibit copying
@@ -22,31 +30,75 @@ class DescriptorHeap {
     DescriptorHeap& operator=(const DescriptorHeap& other) = delete;
 
     // Instance members
+
+    /**
+     * Allocates a contiguous range of descriptors living until FreeHandles.
+     * @param Count The number of descriptors.
+     * @param OutHandle Output parameter that will be populated with the handle of the first
+     * descriptor on success. Unchanged on failure.
+     * @return true if the descriptors were allocated, false otherwise.
+     */
     bool AllocateHandles(uint32_t Count, D3D12_CPU_DESCRIPTOR_HANDLE& OutHandle) {
-        // Overflow check
-        if (Count > mFreeDescriptorCount) {
+        uint32_t index;
+        if (!mAllocator.Allocate(Count, index)) {
             LOG_ERROR(
                 L"\t\tNot enough free descriptors in the heap of type %d. Requested: %u, "
-                L"Available: %u\n",
-                mType, Count, mFreeDescriptorCount);
+                L"Used: %u of %u\n",
+                mType, Count, mAllocator.GetPersistentUsedCount(),
+                mAllocator.GetPersistentCount());
             return false;
         }
 
-        // Return the current handle
-        OutHandle = mCurrentHandle;
+        OutHandle = GetHandle(index);
+        return true;
+    }
+
+    /**
+     * Frees the range of descriptors allocated by AllocateHandles; the GPU has to be done with
+     * them.
+     * @param Handle The handle of the first descriptor of the range.
+     */
+    void FreeHandles(D3D12_CPU_DESCRIPTOR_HANDLE Handle) {
+        mAllocator.Free(GetIndex(Handle));
+    }
 
-        // Incrementing to the next handle
-        mCurrentHandle.ptr += Count * mSize;
-        mFreeDescriptorCount -= Count;
+    /**
+     * Allocates a contiguous range of descriptors valid for the current frame only.
+     */
+    bool AllocateTransientHandles(uint32_t Count, D3D12_CPU_DESCRIPTOR_HANDLE& OutHandle) {
+        uint32_t index;
+        if (!mAllocator.AllocateTransient(Count, index)) {
+            LOG_ERROR(
+                L"\t\tNot enough transient descriptors in the heap of type %d. Requested: %u, "
+                L"Used: %u\n",
+                mType, Count, mAllocator.GetTransientUsedCount());
+            return false;
+        }
+
+        OutHandle = GetHandle(index);
         return true;
     }
 
+    /**
+     * Recycles the transient descriptors of the frame slot being started.
+     */
+    void BeginFrame(uint32_t FrameIndex) {
+        mAllocator.BeginFrame(FrameIndex);
+    }
+
    private:
+    D3D12_CPU_DESCRIPTOR_HANDLE GetHandle(uint32_t Index) const {
+        return {mFirstHandle.ptr + static_cast<SIZE_T>(Index) * mSize};
+    }
+
+    uint32_t GetIndex(D3D12_CPU_DESCRIPTOR_HANDLE Handle) const {
+        return static_cast<uint32_t>((Handle.ptr - mFirstHandle.ptr) / mSize);
+    }
+
     uint32_t mSize;
-    uint32_t mFreeDescriptorCount;
+    DescriptorAllocator mAllocator;
 
     D3D12_DESCRIPTOR_HEAP_TYPE mType;
     D3D12_CPU_DESCRIPTOR_HANDLE mFirstHandle;
-    D3D12_CPU_DESCRIPTOR_HANDLE mCurrentHandle;
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mD3D12Heap;
-};
\ No newline at end of file
+};
@@ -1,5 +1,9 @@
 #include "Device.h"
 
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
 #include "CommandList10.h"
 #include "IO/ByteBuffer.h"
 #include "Logging/Logging.h"
@@ -10,6 +14,12 @@
 
 using Microsoft::WRL::ComPtr;
 
+// The vertices start with a float3 position the mesh bounds get computed from
+constexpr uint32_t kMinVertexStrideInBytes = 3 * sizeof(float);
+
+// The vertex buffer views address the vertex buffers with 32-bit sizes
+constexpr size_t kMaxVertexBufferSizeInBytes = std::numeric_limits<uint32_t>::max();
+
 bool Device::Create(D3D_FEATURE_LEVEL FeatureLevel,
                     bool IsHardwareDevice,
                     bool HasMaxVideoMemory,
@@ -49,16 +59,57 @@ bool Device::Create(D3D_FEATURE_LEVEL FeatureLevel,
         return false;
     }
 
+    std::vector<std::unique_ptr<CommandAllocator>> frameAllocators(FRAMES_IN_FLIGHT);
+    for (std::unique_ptr<CommandAllocator>& frameAllocator : frameAllocators) {
+        if (!CreateCommandAllocator(d3dDevice, commandListType, D3D12_COMMAND_LIST_FLAG_NONE,
+                                    frameAllocator)) {
+            LOG_ERROR(L"Failed to create a frame Command Allocator.\n");
+            return false;
+        }
+    }
+
     std::unique_ptr<DescriptorHeap> rtvHeap;
     if (!CreateDescriptorHeap(d3dDevice, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, RTV_DESCRIPTOR_COUNT,
-                              rtvHeap)) {
+                              RTV_TRANSIENT_DESCRIPTOR_COUNT, rtvHeap)) {
         LOG_ERROR(L"Failed to create the RTV Descriptor Heap.\n");
         return false;
     }
 
-    OutDevice = std::make_unique<Device>(std::move(debugLayer), std::move(rtvHeap),
-                                         std::move(commandQueue), std::move(commandAllocator),
-                                         std::move(dxgiFactory), std::move(d3dDevice));
+    std::unique_ptr<Device> device = std::make_unique<Device>(
+        std::move(debugLayer), std::move(rtvHeap), std::move(commandQueue),
+        std::move(frameAllocators), std::move(commandAllocator), std::move(dxgiFactory),
+        std::move(d3dDevice));
+
+    device->mDefaultHeapAllocator =
+        std::make_unique<HeapAllocator>(device->mD3DDevice.Get(), D3D12_HEAP_TYPE_DEFAULT);
+    device->mUploadHeapAllocator =
+        std::make_unique<HeapAllocator>(device->mD3DDevice.Get(), D3D12_HEAP_TYPE_UPLOAD);
+    device->mResourceReleaser = std::make_unique<ResourceReleaser>(*device->mCommandQueue);
+    device->mCommandAllocatorPool = std::make_unique<CommandAllocatorPool>(
+        device->mD3DDevice, *device->mCommandQueue, commandListType);
+
+    if (!UploadManager::Create(*device, device->mD3DDevice, device->mUploadManager)) {
+        LOG_ERROR(L"Failed to create the upload manager.\n");
+        return false;
+    }
+    device->mResourceReleaser->SetUploadManager(device->mUploadManager.get());
+
+    // One persistently mapped buffer for the per-frame data of all the frames in flight
+    std::unique_ptr<UploadBuffer> uploadRingBuffer;
+    if (!device->CreateBuffer(L"UploadRingBuffer", D3D12_HEAP_TYPE_UPLOAD,
+                              D3D12_RESOURCE_STATE_GENERIC_READ, UPLOAD_RING_SIZE,
+                              uploadRingBuffer)) {
+        LOG_ERROR(L"Failed to create the upload ring buffer.\n");
+        return false;
+    }
+
+    if (!uploadRingBuffer->MapPersistent()) {
+        LOG_ERROR(L"Failed to map the upload ring buffer.\n");
+        return false;
+    }
+    device->mUploadRing = std::make_unique<UploadRing>(std::move(uploadRingBuffer));
+
+    OutDevice = std::move(device);
     return true;
 }
 
@@ -145,8 +196,16 @@ bool Device::CreateCommandAllocator(ComPtr<ID3D12Device14>& D3DDevice,
         return false;
     }
 
+    // Records the barriers bringing the resources into the states the command list expects
+    ComPtr<ID3D12GraphicsCommandList10> fixupCommandList;
+    if (FAILED(D3DDevice->CreateCommandList1(0, Type, Flags, IID_PPV_ARGS(&fixupCommandList)))) {
+        LOG_ERROR(L"Failed to create D3D12 fix-up command list.\n");
+        return false;
+    }
+
     OutAllocator = std::make_unique<CommandAllocator>(Type, std::move(commandAllocator),
-                                                      std::move(graphicsCommandList));
+                                                      std::move(graphicsCommandList),
+                                                      std::move(fixupCommandList));
     return true;
 }
 
@@ -194,6 +253,7 @@ bool Device::CreateCommandQueue(ComPtr<ID3D12Device14>& D3DDevice,
 bool Device::CreateDescriptorHeap(ComPtr<ID3D12Device14>& D3DDevice,
                                   D3D12_DESCRIPTOR_HEAP_TYPE Type,
                                   uint32_t Count,
+                                  uint32_t TransientCountPerFrame,
                                   std::unique_ptr<DescriptorHeap>& OutHeap) {
     D3D12_DESCRIPTOR_HEAP_DESC desc{};
     desc.Type = Type;
@@ -209,99 +269,116 @@ bool Device::CreateDescriptorHeap(ComPtr<ID3D12Device14>& D3DDevice,
 
     uint32_t descriptorSize = D3DDevice->GetDescriptorHandleIncrementSize(Type);
 
-    OutHeap =
-        std::make_unique<DescriptorHeap>(Type, descriptorSize, Count, std::move(descriptorHeap));
+    OutHeap = std::make_unique<DescriptorHeap>(Type, descriptorSize, Count, TransientCountPerFrame,
+                                               FRAMES_IN_FLIGHT, std::move(descriptorHeap));
     return true;
 }
 
 // Instance members
 
-void Device::CreateRenderTargetView(ID3D12Resource2* Resource,
+bool Device::CreateRenderTargetView(ID3D12Resource2* Resource,
                                     D3D12_RENDER_TARGET_VIEW_DESC& Desc,
                                     D3D12_CPU_DESCRIPTOR_HANDLE& OutCpuHandle) const {
     // Allocate a descriptor from the heap
-    mRTVHeap->AllocateHandles(1, OutCpuHandle);
+    if (!mRTVHeap->AllocateHandles(1, OutCpuHandle)) {
+        LOG_ERROR(L"Failed to allocate a render target view descriptor.\n");
+        return false;
+    }
     // Create the RTV
     mD3DDevice->CreateRenderTargetView(Resource, &Desc, OutCpuHandle);
+    return true;
+}
+
+void Device::FreeRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE CpuHandle) const {
+    mRTVHeap->FreeHandles(CpuHandle);
 }
 
 bool Device::CreateMesh(uint32_t VertexCount,
                         uint32_t VertexStrideInBytes,
                         const void* VertexData,
                         std::unique_ptr<Mesh>& OutMesh) {
-    size_t dataSizeInBytes = VertexCount * VertexStrideInBytes;
-
-    // Create a temporary upload buffer in state D3D12_RESOURCE_STATE_GENERIC_READ
-    std::unique_ptr<UploadBuffer> meshGeometryUploadBuffer;
-    if (!CreateBuffer(L"MeshGeometryUploadBuffer", D3D12_HEAP_TYPE_UPLOAD,
-                      D3D12_RESOURCE_STATE_GENERIC_READ, dataSizeInBytes,
-                      meshGeometryUploadBuffer)) {
-        LOG_ERROR(L"Failed to create geometry upload buffer.\n");
+    const MeshData meshData{VertexCount, VertexStrideInBytes, VertexData};
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    if (!CreateMeshes({&meshData, 1}, meshes)) {
         return false;
     }
 
-    // Upload bytes to the CPU buffer
-    if (!meshGeometryUploadBuffer->UploadBytes(dataSizeInBytes, VertexData)) {
-        LOG_ERROR(L"Failed to upload bytes to the geometry upload buffer.\n");
-        return false;
-    }
-
-    // Create the GPU vertex buffer in the state COMMON
-    std::unique_ptr<DeviceBuffer> meshVertexBuffer;
-    if (!CreateBuffer(L"MeshVertexBuffer", D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COMMON,
-                      dataSizeInBytes, meshVertexBuffer)) {
-        LOG_ERROR(L"Failed to create vertex buffer.\n");
-        return false;
-    }
-
-    // Get a command list
-    CommandList10 cmdl;
-    if (!this->GetCommandList(cmdl)) {
-        LOG_ERROR(L"Failed to get command list.\n");
-        return false;
-    }
-
-    // Transition device buffer to COPY_DEST for receiving the copy
-    cmdl.TransitionResource(*meshVertexBuffer, D3D12_RESOURCE_STATE_COPY_DEST);
+    OutMesh = std::move(meshes.front());
+    return true;
+}
 
-    // Copy from upload buffer to device buffer
-    cmdl.CopyBufferRegion(*meshGeometryUploadBuffer, 0, *meshVertexBuffer,
-                          meshGeometryUploadBuffer->GetBufferSize());
+bool Device::CreateMeshes(std::span<const MeshData> Meshes,
+                          std::vector<std::unique_ptr<Mesh>>& OutMeshes) {
+    // Create the GPU vertex buffers in the state COMMON; the copy queue promotes them to
+    // COPY_DEST and they decay back once the copies complete, so the direct queue reads them as is
+    std::vector<std::unique_ptr<DeviceBuffer>> vertexBuffers(Meshes.size());
+    std::vector<UploadRequest> uploads(Meshes.size());
+    for (size_t i = 0; i < Meshes.size(); ++i) {
+        const MeshData& meshData = Meshes[i];
+        if (meshData.VertexStrideInBytes < kMinVertexStrideInBytes) {
+            LOG_ERROR(L"The vertex stride %u is too small to hold a position.\n",
+                      meshData.VertexStrideInBytes);
+            return false;
+        }
 
-    // Transition device buffer to GENERIC_READ for shader access
-    cmdl.TransitionResource(*meshVertexBuffer, D3D12_RESOURCE_STATE_GENERIC_READ);
+        if (meshData.VertexCount == 0) {
+            LOG_ERROR(L"Failed to create a mesh without vertices.\n");
+            return false;
+        }
 
-    OutMesh =
-        std::make_unique<Mesh>(VertexCount, VertexStrideInBytes, std::move(*meshVertexBuffer));
+        // Multiplied in 64 bits, so a large mesh can't wrap around to a small buffer
+        const size_t dataSizeInBytes =
+            static_cast<size_t>(meshData.VertexCount) * meshData.VertexStrideInBytes;
+        if (dataSizeInBytes > kMaxVertexBufferSizeInBytes) {
+            LOG_ERROR(L"Failed to create a mesh as its %u vertices exceed 4 GB.\n",
+                      meshData.VertexCount);
+            return false;
+        }
 
-    // Cmdl gets executed when exiting the scope
-    return true;
-}
+        if (!CreateBuffer(L"MeshVertexBuffer", D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COMMON,
+                          dataSizeInBytes, vertexBuffers[i])) {
+            LOG_ERROR(L"Failed to create vertex buffer.\n");
+            return false;
+        }
 
-bool Device::CreateMeshInstance(Mesh& Model, std::unique_ptr<MeshInstance>& Mesh) {
-    // Each MeshInstance represents a couple of constant buffers holding transformation data about
-    // the mesh
-    size_t transformDataSize = sizeof(Matrix4);
+        uploads[i] = {vertexBuffers[i].get(), meshData.VertexData, dataSizeInBytes};
+    }
 
-    // Create an upload buffer in state D3D12_RESOURCE_STATE_GENERIC_READ (we'll never transition
-    // from that)
-    std::unique_ptr<UploadBuffer> uploadConstantBuffer;
-    if (!CreateBuffer(L"MeshConstUploadBuffer", D3D12_HEAP_TYPE_UPLOAD,
-                      D3D12_RESOURCE_STATE_GENERIC_READ, transformDataSize, uploadConstantBuffer)) {
-        LOG_ERROR(L"Failed to create upload buffer.\n");
+    // Stage the vertex data of all the meshes at once and record the copies into the open batch
+    UploadTicket uploadTicket;
+    if (!mUploadManager->UploadBatch(uploads, uploadTicket)) {
+        LOG_ERROR(L"Failed to upload the vertex data.\n");
         return false;
     }
 
-    // The buffer that holds Model's matrices
-    std::unique_ptr<DeviceBuffer> meshConstantBuffer;
-    if (!CreateBuffer(L"MeshConstDeviceBuffer", D3D12_HEAP_TYPE_DEFAULT,
-                      D3D12_RESOURCE_STATE_COMMON, transformDataSize, meshConstantBuffer)) {
-        LOG_ERROR(L"Failed to create default buffer.\n");
-        return false;
+    OutMeshes.reserve(OutMeshes.size() + Meshes.size());
+    for (size_t i = 0; i < Meshes.size(); ++i) {
+        const MeshData& meshData = Meshes[i];
+        const AABB bounds = AABB::FromPoints(meshData.VertexData, meshData.VertexCount,
+                                             meshData.VertexStrideInBytes);
+
+        // The occluders keep their positions packed, the rest of the vertex is of no use to them
+        std::vector<float> occluderPositions;
+        if (meshData.IsOccluder) {
+            occluderPositions.resize(static_cast<size_t>(meshData.VertexCount) * 3);
+            const std::byte* vertex = static_cast<const std::byte*>(meshData.VertexData);
+            for (uint32_t v = 0; v < meshData.VertexCount; ++v) {
+                std::memcpy(&occluderPositions[static_cast<size_t>(v) * 3],
+                            vertex + static_cast<size_t>(v) * meshData.VertexStrideInBytes,
+                            3 * sizeof(float));
+            }
+        }
+
+        OutMeshes.push_back(std::make_unique<Mesh>(
+            meshData.VertexCount, meshData.VertexStrideInBytes, std::move(*vertexBuffers[i]),
+            bounds, uploadTicket, std::move(occluderPositions)));
     }
+    return true;
+}
 
-    Mesh = std::make_unique<MeshInstance>(Model, std::move(uploadConstantBuffer),
-                                          std::move(meshConstantBuffer));
+bool Device::CreateMeshInstance(Mesh& Model, std::unique_ptr<MeshInstance>& Mesh) {
+    // The transformation data about the mesh lives on the CPU and gets bound from the upload ring
+    Mesh = std::make_unique<MeshInstance>(Model);
     return true;
 }
 
@@ -314,7 +391,10 @@ bool Device::CreateMeshNode(MaterialId MaterialId, Mesh& Model, std::unique_ptr<
     }
 
     // Combine both the mesh and the materialId into a scene node
-    OutNode = std::make_unique<Node>(MaterialId, std::move(MeshInstance));
+    if (!Node::Create(MaterialId, std::move(MeshInstance), OutNode)) {
+        LOG_ERROR(L"Failed to create mesh node.\n");
+        return false;
+    }
     return true;
 }
 
@@ -327,7 +407,47 @@ bool Device::CreateRootSignature(ByteBuffer& Bytecode,
         return false;
     }
 
-    OutRootSignature = std::make_unique<RootSignature>(std::move(rootSignature));
+    // Read the root parameters back from the bytecode to find the ones the renderer binds
+    ComPtr<ID3D12VersionedRootSignatureDeserializer> deserializer;
+    const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* desc;
+    if (FAILED(D3D12CreateVersionedRootSignatureDeserializer(
+            Bytecode.GetBuffer(), Bytecode.GetSize(), IID_PPV_ARGS(&deserializer))) ||
+        FAILED(deserializer->GetRootSignatureDescAtVersion(D3D_ROOT_SIGNATURE_VERSION_1_1,
+                                                           &desc))) {
+        LOG_ERROR(L"Failed to read the root parameters of the root signature.\n");
+        return false;
+    }
+
+    RootParameterSlots slots;
+    for (uint32_t i = 0; i < desc->Desc_1_1.NumParameters; ++i) {
+        const D3D12_ROOT_PARAMETER1& parameter = desc->Desc_1_1.pParameters[i];
+        switch (parameter.ParameterType) {
+            case D3D12_ROOT_PARAMETER_TYPE_SRV:
+                if (parameter.Descriptor.ShaderRegister == 0 &&
+                    parameter.Descriptor.RegisterSpace == 0) {
+                    slots.Instance = i;
+                    slots.IsInstanceRootConstants = false;
+                }
+                break;
+            case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+                if (parameter.Constants.ShaderRegister == 0 &&
+                    parameter.Constants.RegisterSpace == 0) {
+                    slots.Instance = i;
+                    slots.IsInstanceRootConstants = true;
+                }
+                break;
+            case D3D12_ROOT_PARAMETER_TYPE_CBV:
+                if (parameter.Descriptor.ShaderRegister == 1 &&
+                    parameter.Descriptor.RegisterSpace == 0) {
+                    slots.View = i;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    OutRootSignature = std::make_unique<RootSignature>(std::move(rootSignature), slots);
     return true;
 }
 
@@ -421,23 +541,96 @@ bool Device::CreateSwapChain(HWND HWnd,
 }
 
 bool Device::GetCommandList(CommandList10& OutCommandList) const {
+    // The previous blocking list has been waited on, so the allocator is free
+    if (!mCommandAllocator->Reset()) {
+        LOG_ERROR(L"Failed to reset the command allocator.\n");
+        return false;
+    }
+
     ID3D12GraphicsCommandList10* d3dCommandList;
     if (!mCommandAllocator->GetID3D12CommandList(d3dCommandList)) {
         LOG_ERROR(L"Failed to get command list from the allocator.\n");
         return false;
     }
 
-    OutCommandList = CommandList10(mCommandQueue.get(), d3dCommandList);
+    OutCommandList = CommandList10(mCommandQueue.get(), mCommandAllocator.get(), d3dCommandList,
+                                   mUploadRing.get(), GetFrameIndex());
+    return true;
+}
+
+bool Device::BeginFrame() {
+    if (!mFrameRing.BeginFrame()) {
+        LOG_ERROR(L"Failed to begin a frame.\n");
+        return false;
+    }
+
+    // The GPU is done with the commands recorded the last time the slot was used
+    if (!mFrameAllocators[GetFrameIndex()]->Reset()) {
+        LOG_ERROR(L"Failed to reset the frame command allocator.\n");
+        return false;
+    }
+
+    // Free the upload ring ranges of the completed frames, and the resources destroyed since
+    mUploadRing->Reclaim(mCommandQueue->GetCompletedFenceValue());
+    mResourceReleaser->Collect();
+
+    // Submit the uploads recorded since the last frame, and free the staging of the completed ones
+    mUploadManager->Submit();
+    mUploadManager->Collect();
+
+    // Recycle the transient descriptors of the frame slot
+    mRTVHeap->BeginFrame(GetFrameIndex());
+    return true;
+}
+
+void Device::EndFrame() {
+    uint64_t fenceValue = mCommandQueue->GetLastSignaledFenceValue();
+    mUploadRing->EndFrame(fenceValue);
+    mFrameRing.EndFrame(fenceValue);
+}
+
+bool Device::GetFrameCommandList(CommandList10& OutCommandList) const {
+    ID3D12GraphicsCommandList10* d3dCommandList;
+    if (!mFrameAllocators[GetFrameIndex()]->GetID3D12CommandList(d3dCommandList)) {
+        LOG_ERROR(L"Failed to get command list from the frame allocator.\n");
+        return false;
+    }
+
+    OutCommandList =
+        CommandList10(mCommandQueue.get(), mFrameAllocators[GetFrameIndex()].get(), d3dCommandList,
+                      mUploadRing.get(), GetFrameIndex(), false);
     return true;
 }
 
 bool Device::GetFrameCommandList(SwapChain& SwapChain, FrameCommandList10& OutCommandList) const {
     ID3D12GraphicsCommandList10* d3dCommandList;
-    if (!mCommandAllocator->GetID3D12CommandList(d3dCommandList)) {
-        LOG_ERROR(L"Failed to get command list from the allocator.\n");
+    if (!mFrameAllocators[GetFrameIndex()]->GetID3D12CommandList(d3dCommandList)) {
+        LOG_ERROR(L"Failed to get command list from the frame allocator.\n");
+        return false;
+    }
+
+    OutCommandList = FrameCommandList10(&SwapChain, mCommandQueue.get(),
+                                        mFrameAllocators[GetFrameIndex()].get(), d3dCommandList,
+                                        mUploadRing.get(), GetFrameIndex());
+    return true;
+}
+
+bool Device::GetPooledCommandList(CommandList10& OutCommandList) const {
+    CommandAllocator* allocator;
+    if (!mCommandAllocatorPool->Acquire(allocator)) {
+        LOG_ERROR(L"Failed to acquire a command allocator from the pool.\n");
+        return false;
+    }
+
+    ID3D12GraphicsCommandList10* d3dCommandList;
+    if (!allocator->GetID3D12CommandList(d3dCommandList)) {
+        LOG_ERROR(L"Failed to get command list from the pooled allocator.\n");
+        mCommandAllocatorPool->Release(allocator, 0);
         return false;
     }
 
-    OutCommandList = FrameCommandList10(&SwapChain, mCommandQueue.get(), d3dCommandList);
+    OutCommandList =
+        CommandList10(mCommandQueue.get(), allocator, d3dCommandList, mUploadRing.get(),
+                      GetFrameIndex(), false, mCommandAllocatorPool.get());
     return true;
 }
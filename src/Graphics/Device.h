@@ -1,11 +1,15 @@
 #pragma once
 
 #include <memory>
+#include <span>
+#include <vector>
 
 #include "CommandAllocator.h"
+#include "CommandAllocatorPool.h"
 #include "CommandQueue.h"
 #include "DebugLayer.h"
 #include "DescriptorHeap.h"
+#include "FrameRing.h"
 #include "IO/ByteBuffer.h"
 #include "Includes/ComIncl.h"
 #include "Includes/GraphicsIncl.h"
@@ -15,6 +19,10 @@
 #include "Mesh/Mesh.h"
 #include "Mesh/MeshInstance.h"
 #include "Resource/DeviceBuffer.h"
+#include "Resource/HeapAllocator.h"
+#include "Resource/ResourceReleaser.h"
+#include "Resource/UploadManager.h"
+#include "Resource/UploadRing.h"
 #include "RootSignature.h"
 #include "Scene/Node.h"
 #include "SwapChain.h"
@@ -25,9 +33,18 @@ constexpr D3D_FEATURE_LEVEL GRAPHICS_FEATURE_LEVEL = D3D_FEATURE_LEVEL_12_0;
 // number of RTV descriptors to allocate in the heap
 constexpr uint32_t RTV_DESCRIPTOR_COUNT{256};
 
+// number of the RTV descriptors valid for a frame only, per frame in flight; taken from the above
+constexpr uint32_t RTV_TRANSIENT_DESCRIPTOR_COUNT{16};
+
 // count is 2 to accommodate back buffer (one is presenting while the other is a back buffer)
 constexpr uint32_t SWAP_CHAIN_BUFFER_COUNT{2};
 
+// number of frames the CPU may record ahead of the GPU; per-frame resources are multiplied by it
+constexpr uint32_t FRAMES_IN_FLIGHT{2};
+
+// size of the upload ring holding the transient per-frame data of all the frames in flight
+constexpr size_t UPLOAD_RING_SIZE{32 * 1024 * 1024};
+
 // Forward declarations
 class ByteBuffer;
 class CommandList10;
@@ -118,6 +135,8 @@ class Device {
      * @param Type The type of descriptor heap (e.g., D3D12_DESCRIPTOR_HEAP_TYPE_RTV,
      * D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).
      * @param Count The number of descriptors to allocate in the heap.
+     * @param TransientCountPerFrame The number of the descriptors valid for a frame only, per
+     * frame in flight; taken from Count.
      * @param OutHeap Output parameter that will be populated with the created DescriptorHeap
      * instance on success. Unchanged on failure.
      * @return true if the DescriptorHeap was successfully created, false otherwise.
@@ -125,6 +144,7 @@ class Device {
     static bool CreateDescriptorHeap(ComPtr<ID3D12Device14>& D3DDevice,
                                      D3D12_DESCRIPTOR_HEAP_TYPE Type,
                                      uint32_t Count,
+                                     uint32_t TransientCountPerFrame,
                                      std::unique_ptr<DescriptorHeap>& OutHeap);
 
     /**
@@ -150,6 +170,7 @@ class Device {
     Device(std::unique_ptr<DebugLayer>&& DebugLayer,
            std::unique_ptr<DescriptorHeap> RtvHeap,
            std::unique_ptr<CommandQueue>&& CommandQueue,
+           std::vector<std::unique_ptr<CommandAllocator>>&& FrameAllocators,
            std::unique_ptr<CommandAllocator>&& CommandAllocator,
            ComPtr<IDXGIFactory7>&& DXGIFactory,
            ComPtr<ID3D12Device14> D3DDevice)
@@ -157,6 +178,8 @@ class Device {
 
           mCommandQueue{std::move(CommandQueue)},
           mCommandAllocator{std::move(CommandAllocator)},
+          mFrameAllocators{std::move(FrameAllocators)},
+          mFrameRing{*mCommandQueue, static_cast<uint32_t>(mFrameAllocators.size())},
 
           mRTVHeap{std::move(RtvHeap)},
           mDXGIFactory{std::move(DXGIFactory)},
@@ -164,6 +187,23 @@ class Device {
 
     ~Device() {
         LOG_INFO(L"Freeing Device.\n");
+
+        // The frames in flight still use the command allocators
+        if (!mCommandQueue->WaitForIdle()) {
+            LOG_ERROR(L"Failed to wait on command queue.\n");
+        }
+
+        // The uploads in flight still read the staging pages; release them along with the upload
+        // ring's buffer right away. The copy queue is idle afterwards, so the releaser stops
+        // waiting for it
+        if (mResourceReleaser) {
+            mResourceReleaser->SetUploadManager(nullptr);
+        }
+        mUploadManager.reset();
+        mUploadRing.reset();
+        if (mResourceReleaser) {
+            mResourceReleaser->CollectAll();
+        }
     }
 
     // Deleted copy constructor and assignment operator to prevent copying
@@ -190,14 +230,22 @@ class Device {
      * @param Resource The D3D12 resource to create the RTV for.
      * @param Desc The render target view description.
      * @param OutCpuHandle Output parameter that will be populated with the CPU descriptor handle
-     * for the created RTV.
+     * for the created RTV on success. Unchanged on failure.
+     * @return true if the RTV was successfully created, false if the RTV heap is out of room.
      */
-    void CreateRenderTargetView(ID3D12Resource2* Resource,
+    bool CreateRenderTargetView(ID3D12Resource2* Resource,
                                 D3D12_RENDER_TARGET_VIEW_DESC& Desc,
                                 D3D12_CPU_DESCRIPTOR_HANDLE& OutCpuHandle) const;
 
     /**
-     * Creates a root signature from compiled shader bytecode.
+     * Gives the descriptor of a render target view created by CreateRenderTargetView back to the
+     * RTV heap. The GPU has to be done with the view.
+     */
+    void FreeRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE CpuHandle) const;
+
+    /**
+     * Creates a root signature from compiled shader bytecode. The root parameters the renderer
+     * binds get looked up by their registers, see RootParameterSlots.
      *
      * @param Bytecode The Bytes object containing the compiled root signature bytecode.
      * @param OutRootSignature Output parameter that will be populated with the created
@@ -225,7 +273,10 @@ class Device {
 
     /**
      * Creates a buffer resource of the specified type and size. The buffer size is automatically
-     * aligned to 256 bytes as required by D3D12.
+     * aligned to 256 bytes as required by D3D12. Default and upload buffers up to
+     * HeapAllocator::kHeapBlockSize get placed in the device's heap blocks; the rest are committed
+     * resources. Small default buffers in the COMMON state get packed as ranges of a shared page
+     * buffer, see DeviceBuffer::GetResourceOffset.
      *
      * @tparam T The buffer type, must be derived from DeviceBuffer (e.g., UploadBuffer,
      * DeviceBuffer).
@@ -250,8 +301,38 @@ class Device {
         size_t BufferSize = ByteBuffer::AlignTo256Bytes(Size);
 
         ComPtr<ID3D12Resource2> d3dBuffer;
-        CD3DX12_HEAP_PROPERTIES heapProps{Type};
         CD3DX12_RESOURCE_DESC bufferDesc{CD3DX12_RESOURCE_DESC::Buffer(BufferSize)};
+
+        // Place the buffer in a heap block unless it's too large for one
+        HeapAllocator* heapAllocator = GetHeapAllocator(Type);
+        if (heapAllocator && BufferSize <= HeapAllocator::kHeapBlockSize) {
+            // Small buffers that stay in the COMMON state share a page buffer
+            const bool canPack =
+                Type == D3D12_HEAP_TYPE_DEFAULT && State == D3D12_RESOURCE_STATE_COMMON;
+            HeapAllocation allocation;
+            if (!heapAllocator->Allocate(BufferSize, canPack, allocation)) {
+                LOG_ERROR(L"Failed to allocate heap memory for the buffer.\n");
+                return false;
+            }
+
+            if (allocation.Buffer) {
+                // A range of the page, which keeps the page's name
+                d3dBuffer = allocation.Buffer;
+            } else if (FAILED(mD3DDevice->CreatePlacedResource(allocation.Heap, allocation.Offset,
+                                                               &bufferDesc, State, nullptr,
+                                                               IID_PPV_ARGS(&d3dBuffer)))) {
+                heapAllocator->Free(allocation);
+                LOG_ERROR(L"Failed to create placed buffer.\n");
+                return false;
+            } else {
+                d3dBuffer->SetName(BufferName.c_str());
+            }
+            OutBuffer = std::make_unique<T>(Type, State, BufferSize, d3dBuffer,
+                                            mResourceReleaser.get(), heapAllocator, allocation);
+            return true;
+        }
+
+        CD3DX12_HEAP_PROPERTIES heapProps{Type};
         if (FAILED(mD3DDevice->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE,
                                                        &bufferDesc, State, nullptr,
                                                        IID_PPV_ARGS(&d3dBuffer)))) {
@@ -259,13 +340,28 @@ class Device {
             return false;
         }
         d3dBuffer->SetName(BufferName.c_str());
-        OutBuffer = std::make_unique<T>(Type, State, BufferSize, d3dBuffer);
+        OutBuffer =
+            std::make_unique<T>(Type, State, BufferSize, d3dBuffer, mResourceReleaser.get());
+        return true;
+    }
+
+    /**
+     * Reports the memory statistics of the heap blocks of the given type.
+     * @return true if the stats were populated, false if the heap type isn't suballocated.
+     */
+    bool GetHeapStats(D3D12_HEAP_TYPE Type, HeapStats& OutStats) const {
+        const HeapAllocator* heapAllocator = GetHeapAllocator(Type);
+        if (!heapAllocator) {
+            return false;
+        }
+        heapAllocator->GetStats(OutStats);
         return true;
     }
 
     /**
-     * Creates a mesh from vertex data. The vertex data is uploaded to the GPU via an upload buffer
-     * and copied to a default heap vertex buffer.
+     * Creates a mesh from vertex data. The vertex data is staged and copied to a default heap
+     * vertex buffer on the copy queue without blocking; the mesh carries the ticket the draws
+     * using it have to wait on, see WaitForUpload.
      *
      * @param VertexCount The number of vertices in the mesh.
      * @param VertexStrideInBytes The size of a single vertex in bytes.
@@ -280,8 +376,22 @@ class Device {
                     std::unique_ptr<Mesh>& OutMesh);
 
     /**
-     * Creates a mesh instance that combines a mesh with a material for rendering. The instance
-     * includes CPU and GPU buffers for per-instance constant data.
+     * Creates meshes in bulk, e.g. when loading a scene. The vertex data of all the meshes is
+     * packed into one staging allocation and copied in one batch, so the meshes share a single
+     * upload ticket.
+     *
+     * @param Meshes The vertex data of the meshes to create.
+     * @param OutMeshes Output parameter the created meshes get appended to, in the order of
+     * Meshes, on success. Unchanged on failure.
+     * @return true if all the meshes were successfully created, false otherwise, e.g. if a mesh
+     * has no vertices or its vertex buffer would exceed 4 GB.
+     */
+    bool CreateMeshes(std::span<const MeshData> Meshes,
+                      std::vector<std::unique_ptr<Mesh>>& OutMeshes);
+
+    /**
+     * Creates a mesh instance that combines a mesh with a material for rendering. The per-instance
+     * constant data gets uploaded through the upload ring on draw, so no buffers are created.
      *
      * @param Model The shared mesh to use for this instance.
      * @param Mesh Output parameter that will be populated with the created MeshInstance
@@ -293,7 +403,8 @@ class Device {
     bool CreateMeshNode(MaterialId MaterialId, Mesh& Model, std::unique_ptr<Node>& OutNode);
 
     /**
-     * Retrieves a command list from the device's command allocator for recording graphics commands.
+     * Retrieves a blocking command list from the device's immediate command allocator for one-off
+     * work like resource uploads. The command queue is waited on when the list goes out of scope.
      *
      * @param OutCommandList Output parameter that will be populated with the CommandList10 instance
      * on success. Unchanged on failure.
@@ -301,9 +412,39 @@ class Device {
      */
     bool GetCommandList(CommandList10& OutCommandList) const;
 
+    /**
+     * Begins a frame: waits until the GPU is done with the frame slot's previous use and resets
+     * the slot's command allocator. Must be paired with EndFrame.
+     *
+     * @return true if the frame slot is ready for recording, false otherwise.
+     */
+    bool BeginFrame();
+
+    /**
+     * Ends the frame, so that the frame slot gets reused once the work submitted so far completes.
+     */
+    void EndFrame();
+
+    /**
+     * Returns the slot of the current frame in [0, FRAMES_IN_FLIGHT).
+     */
+    uint32_t GetFrameIndex() const {
+        return mFrameRing.GetFrameIndex();
+    }
+
+    /**
+     * Retrieves a command list recording into the current frame slot, e.g. for the scene update.
+     * The list gets executed without waiting when it goes out of scope.
+     *
+     * @param OutCommandList Output parameter that will be populated with the CommandList10 instance
+     * on success. Unchanged on failure.
+     * @return true if the command list was successfully retrieved, false otherwise.
+     */
+    bool GetFrameCommandList(CommandList10& OutCommandList) const;
+
     /**
      * Retrieves a frame command list associated with a swap chain for recording per-frame rendering
-     * commands.
+     * commands into the current frame slot.
      *
      * @param SwapChain The swap chain to associate with the command list.
      * @param OutCommandList Output parameter that will be populated with the FrameCommandList10
@@ -312,6 +453,25 @@ class Device {
      */
     bool GetFrameCommandList(SwapChain& SwapChain, FrameCommandList10& OutCommandList) const;
 
+    /**
+     * Retrieves a command list recording into an allocator of its own taken from the pool, so
+     * several threads may record at once. The list records the per-frame data into the current
+     * frame slot and gets executed without waiting when it goes out of scope or on Submit.
+     *
+     * @param OutCommandList Output parameter that will be populated with the CommandList10 instance
+     * on success. Unchanged on failure.
+     * @return true if the command list was successfully retrieved, false otherwise.
+     */
+    bool GetPooledCommandList(CommandList10& OutCommandList) const;
+
+    /**
+     * Makes the direct queue wait on the GPU for the upload of the ticket; returns right away if
+     * the upload has completed.
+     */
+    bool WaitForUpload(UploadTicket Ticket) const {
+        return mUploadManager->WaitOnQueue(*mCommandQueue, Ticket);
+    }
+
     /**
      * Disables the Alt+Enter keyboard shortcut that toggles fullscreen mode for the specified
      * window.
@@ -324,14 +484,52 @@ class Device {
     }
 
    private:
+    /**
+     * Returns the allocator the buffers of the heap type get placed with, nullptr if they are
+     * committed.
+     */
+    HeapAllocator* GetHeapAllocator(D3D12_HEAP_TYPE Type) const {
+        switch (Type) {
+            case D3D12_HEAP_TYPE_DEFAULT:
+                return mDefaultHeapAllocator.get();
+            case D3D12_HEAP_TYPE_UPLOAD:
+                return mUploadHeapAllocator.get();
+            default:
+                return nullptr;
+        }
+    }
+
     // IMPORTANT! Keep the DebugLayer at the very top to ensure it is destroyed the last.
     // It reports on LIVE DX objects before the context is destroyed.
     std::unique_ptr<DebugLayer> mDebugLayer;
 
     std::unique_ptr<DescriptorHeap> mRTVHeap;
     std::unique_ptr<CommandQueue> mCommandQueue;
+    // Allocator of the blocking command lists
     std::unique_ptr<CommandAllocator> mCommandAllocator;
 
+    // Frames in flight; an allocator per frame slot
+    std::vector<std::unique_ptr<CommandAllocator>> mFrameAllocators;
+    FrameRing<CommandQueue> mFrameRing;
+
+    // Allocators of the command lists recorded in parallel
+    std::unique_ptr<CommandAllocatorPool> mCommandAllocatorPool;
+
+    // Heap blocks the buffers get placed in; created right after the device as they need it. Kept
+    // above the upload ring so they outlive its buffer
+    std::unique_ptr<HeapAllocator> mDefaultHeapAllocator;
+    std::unique_ptr<HeapAllocator> mUploadHeapAllocator;
+
+    // Destroyed buffers waiting for the GPU; kept between the heap allocators it frees the ranges
+    // to and the upload ring whose buffer it releases
+    std::unique_ptr<ResourceReleaser> mResourceReleaser;
+
+    // Mesh uploads on a copy queue of their own; its staging pages go through the releaser
+    std::unique_ptr<UploadManager> mUploadManager;
+
+    // Transient per-frame data; created right after the device as it needs it to create the buffer
+    std::unique_ptr<UploadRing> mUploadRing;
+
     ComPtr<IDXGIFactory7> mDXGIFactory;
     ComPtr<ID3D12Device14> mD3DDevice;
 };
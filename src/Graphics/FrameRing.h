@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Logging/Logging.h"
+
+/**
+ * Tracks the frames in flight. Every frame slot remembers the fence value of the last submission
+ * made while it was current, so the CPU only waits for the GPU when it's about to reuse the slot's
+ * resources (command allocator, upload regions), i.e. FrameCount frames later.
+ *
+ * Example with 2 frame slots:
+ *
+ *   CPU: | frame 0 | frame 1 | wait(0) frame 2 | wait(1) frame 3 |
+ *   GPU:           | frame 0 | frame 1         | frame 2         |
+ *
+ * The queue is a template parameter so the frame loop can be driven by a stand-in queue whose
+ * fence completes asynchronously. The queue has to provide:
+ *   bool WaitForFenceValue(uint64_t FenceValue);
+ *
+ * @tparam T The command queue type the frames get submitted to.
+ */
+template <typename T>
+class FrameRing {
+   public:
+    FrameRing(T& Queue, uint32_t FrameCount)
+        : mQueue(&Queue), mFrameFenceValues(FrameCount, 0) {}
+
+    // Prohibit copying
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    /**
+     * Waits until the GPU is done with the work submitted the last time the current frame slot
+     * was used, so the slot's resources can be reused.
+     * @return true if the slot is free, false if waiting on the queue failed.
+     */
+    bool BeginFrame() {
+        if (!mQueue->WaitForFenceValue(mFrameFenceValues[mFrameIndex])) {
+            LOG_ERROR(L"Failed to wait for the frame slot %u.\n", mFrameIndex);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Records the fence value of the frame's last submission and moves on to the next slot.
+     * @param FenceValue The fence value the queue signals once the frame's work is complete.
+     */
+    void EndFrame(uint64_t FenceValue) {
+        mFrameFenceValues[mFrameIndex] = FenceValue;
+        mFrameIndex = (mFrameIndex + 1) % GetFrameCount();
+        ++mFrameNumber;
+    }
+
+    /**
+     * Returns the slot of the current frame in [0, GetFrameCount()).
+     */
+    uint32_t GetFrameIndex() const {
+        return mFrameIndex;
+    }
+
+    uint32_t GetFrameCount() const {
+        return static_cast<uint32_t>(mFrameFenceValues.size());
+    }
+
+    /**
+     * Returns the number of frames ended so far.
+     */
+    uint64_t GetFrameNumber() const {
+        return mFrameNumber;
+    }
+
+    uint64_t GetFrameFenceValue(uint32_t FrameIndex) const {
+        return mFrameFenceValues[FrameIndex];
+    }
+
+   private:
+    // Not-owning
+    T* mQueue;
+
+    // The fence value to wait for before reusing the slot, per slot
+    std::vector<uint64_t> mFrameFenceValues;
+    uint32_t mFrameIndex{0};
+    uint64_t mFrameNumber{0};
+};
@@ -3,8 +3,12 @@
 #include "MaterialRegistry.h"
 
 bool Material::Create(std::unique_ptr<PipelineState>&& PipelineState,
+                      ID3D12RootSignature* RootSignature,
+                      const RootParameterSlots& RootParameterSlots,
+                      InstanceBinding InstanceBinding,
                       std::shared_ptr<Material>& OutMaterial) {
-    auto material = std::make_shared<Material>(std::move(PipelineState));
+    auto material = std::make_shared<Material>(std::move(PipelineState), RootSignature,
+                                               RootParameterSlots, InstanceBinding);
     MaterialRegistry::RegisterMaterial(material);
 
     OutMaterial = material;
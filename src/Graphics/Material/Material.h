@@ -2,6 +2,7 @@
 
 #include <memory>
 
+#include "Graphics/RootSignature.h"
 #include "Includes/GraphicsIncl.h"
 #include "PipelineState.h"
 
@@ -12,6 +13,18 @@ using MaterialId = uint32_t;
 // The materialId from which materials get registered
 constexpr MaterialId kMaterialFirstId = 100;
 
+/**
+ * How the draws of a material pass the per-instance MeshConstantBuffer to the vertex shader, if the
+ * material's root signature declares it; see RootParameterSlots.
+ */
+enum class InstanceBinding : uint8_t {
+    // The constants of all the instances of a draw in a root SRV, indexed by SV_InstanceID
+    kStructuredBuffer,
+    // The constants of a single instance as 32-bit root constants; a draw per instance, but no
+    // per-instance data to upload
+    kRootConstants,
+};
+
 /**
  * Material class that owns the rendering pipeline state (PSO).
  * Multiple mesh instances can share the same material.
@@ -19,12 +32,21 @@ constexpr MaterialId kMaterialFirstId = 100;
 class Material {
    public:
     static bool Create(std::unique_ptr<PipelineState>&& PipelineState,
+                       ID3D12RootSignature* RootSignature,
+                       const RootParameterSlots& RootParameterSlots,
+                       InstanceBinding InstanceBinding,
                        std::shared_ptr<Material>& OutMaterial);
 
     static bool GetMaterial(MaterialId MaterialId, std::shared_ptr<Material>& OutMaterial);
 
-    Material(std::unique_ptr<PipelineState>&& PipelineState)
-        : mPipelineState(std::move(PipelineState)) {}
+    Material(std::unique_ptr<PipelineState>&& PipelineState,
+             ID3D12RootSignature* RootSignature,
+             const RootParameterSlots& RootParameterSlots,
+             InstanceBinding InstanceBinding)
+        : mPipelineState(std::move(PipelineState)),
+          mD3DRootSignature(RootSignature),
+          mRootParameterSlots(RootParameterSlots),
+          mInstanceBinding(InstanceBinding) {}
 
     ~Material() = default;
 
@@ -41,6 +63,26 @@ class Material {
         return mPipelineState ? mPipelineState->GetD3DPipelineState() : nullptr;
     }
 
+    /**
+     * Returns the root signature the pipeline state was created with; the draws of the material
+     * get recorded with it bound.
+     */
+    ID3D12RootSignature* GetD3DRootSignature() const {
+        return mD3DRootSignature;
+    }
+
+    /**
+     * Returns the root parameters of the material's root signature the instance and the view data
+     * get bound to.
+     */
+    const RootParameterSlots& GetRootParameterSlots() const {
+        return mRootParameterSlots;
+    }
+
+    InstanceBinding GetInstanceBinding() const {
+        return mInstanceBinding;
+    }
+
     MaterialId GetMaterialId() const {
         return mMaterialId;
     }
@@ -49,5 +91,10 @@ class Material {
     friend class MaterialRegistry;
 
     std::unique_ptr<PipelineState> mPipelineState;
+
+    // Not-owning; the root signature has to outlive the material
+    ID3D12RootSignature* mD3DRootSignature;
+    RootParameterSlots mRootParameterSlots;
+    InstanceBinding mInstanceBinding;
     MaterialId mMaterialId{0};
 };
@@ -19,9 +19,18 @@ D3D12_INPUT_ELEMENT_DESC PositionOnly[] = {
 bool MaterialBuilder::CreateMaterial(Device& Device,
                                      RootSignature& RootSignature,
                                      std::shared_ptr<Material>& OutMaterial) {
+    // The instance binding has to match the instance root parameter, if there's one
+    const RootParameterSlots& slots = RootSignature.GetRootParameterSlots();
+    if (slots.HasInstance() &&
+        slots.IsInstanceRootConstants != (mInstanceBinding == InstanceBinding::kRootConstants)) {
+        LOG_ERROR(L"Failed to create material as the instance binding mismatches parameter %u.\n",
+                  slots.Instance);
+        return false;
+    }
+
     // Create Pipeline State object
 
-    // RootSignature gets set in the Renderer.
+    // RootSignature gets set in the Renderer, switching to the material's one if they differ.
     mPSODesc.pRootSignature = RootSignature.GetD3DRootSignature();
 
     // Input-assembler
@@ -138,7 +147,8 @@ bool MaterialBuilder::CreateMaterial(Device& Device,
         return false;
     }
 
-    if (!Material::Create(std::move(pPipelineState), OutMaterial)) {
+    if (!Material::Create(std::move(pPipelineState), RootSignature.GetD3DRootSignature(), slots,
+                          mInstanceBinding, OutMaterial)) {
         LOG_ERROR(L"Failed to create material object.\n");
         return false;
     }
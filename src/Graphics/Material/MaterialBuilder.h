@@ -5,10 +5,10 @@
 #include <memory>
 
 #include "IO/ByteBuffer.h"
+#include "Material.h"
 
 // Forward declarations
 class Device;
-class Material;
 class RootSignature;
 
 /**
@@ -26,11 +26,15 @@ class MaterialBuilder {
 
     // Allow moving
     MaterialBuilder(MaterialBuilder&& other) noexcept
-        : mPSODesc(std::exchange(other.mPSODesc, {})) {}
+        : mPSODesc(std::exchange(other.mPSODesc, {})),
+          mInstanceBinding(
+              std::exchange(other.mInstanceBinding, InstanceBinding::kStructuredBuffer)) {}
 
     MaterialBuilder& operator=(MaterialBuilder&& other) noexcept {
         if (this != &other) {
             mPSODesc = std::exchange(other.mPSODesc, {});
+            mInstanceBinding =
+                std::exchange(other.mInstanceBinding, InstanceBinding::kStructuredBuffer);
         }
         return *this;
     }
@@ -65,10 +69,21 @@ class MaterialBuilder {
         return *this;
     }
 
+    /**
+     * Selects how the draws of the material pass the per-instance constants; the root signature
+     * and the vertex shader have to match it, CreateMaterial fails otherwise. Defaults to
+     * InstanceBinding::kStructuredBuffer.
+     */
+    MaterialBuilder& SetInstanceBinding(InstanceBinding Binding) {
+        mInstanceBinding = Binding;
+        return *this;
+    }
+
     bool CreateMaterial(Device& Device,
                         RootSignature& RootSignature,
                         std::shared_ptr<Material>& OutMaterial);
 
    private:
     D3D12_GRAPHICS_PIPELINE_STATE_DESC mPSODesc;
+    InstanceBinding mInstanceBinding{InstanceBinding::kStructuredBuffer};
 };
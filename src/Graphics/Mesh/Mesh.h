@@ -1,29 +1,71 @@
 #pragma once
 #include <utility>
+#include <vector>
 
 #include "Graphics/Resource/DeviceBuffer.h"
+#include "Graphics/Resource/UploadTicket.h"
 #include "Includes/GraphicsIncl.h"
+#include "Math/Bounds.h"
+#include "MeshIdPool.h"
+
+/**
+ * The vertex data a mesh gets created from.
+ */
+struct MeshData {
+    uint32_t VertexCount;
+    uint32_t VertexStrideInBytes;
+    const void* VertexData;
+    // Keeps a CPU copy of the positions to rasterize into the OcclusionBuffer; meant for the few
+    // large meshes hiding a lot, e.g. buildings and terrain
+    bool IsOccluder{false};
+};
 
 class Mesh {
    public:
-    Mesh(uint32_t VertexCount, uint32_t VertexStrideInBytes, DeviceBuffer&& VertexBuffer)
-        : mVertexCount(VertexCount),
+    Mesh(uint32_t VertexCount,
+         uint32_t VertexStrideInBytes,
+         DeviceBuffer&& VertexBuffer,
+         const AABB& Bounds,
+         UploadTicket UploadTicket = 0,
+         std::vector<float>&& OccluderPositions = {})
+        : mBounds(Bounds),
+          mOccluderPositions(std::move(OccluderPositions)),
+          mVertexCount(VertexCount),
           mVertexStrideInBytes(VertexStrideInBytes),
-          mVertexBuffer(std::move(VertexBuffer)) {}
+          mVertexBuffer(std::move(VertexBuffer)),
+          mMeshId(GetIdPool().Acquire()),
+          mUploadTicket(UploadTicket) {}
+
+    ~Mesh() {
+        if (mMeshId != MeshIdPool::kInvalidMeshId) {
+            GetIdPool().Release(mMeshId);
+        }
+    }
 
     Mesh(const Mesh&) = delete;
     Mesh& operator=(const Mesh&) = delete;
 
     Mesh(Mesh&& other) noexcept
-        : mVertexCount(std::exchange(other.mVertexCount, 0)),
+        : mBounds(other.mBounds),
+          mOccluderPositions(std::move(other.mOccluderPositions)),
+          mVertexCount(std::exchange(other.mVertexCount, 0)),
           mVertexStrideInBytes(std::exchange(other.mVertexStrideInBytes, 0)),
-          mVertexBuffer(std::move(other.mVertexBuffer)) {}
+          mVertexBuffer(std::move(other.mVertexBuffer)),
+          mMeshId(std::exchange(other.mMeshId, MeshIdPool::kInvalidMeshId)),
+          mUploadTicket(std::exchange(other.mUploadTicket, 0)) {}
 
     Mesh& operator=(Mesh&& other) noexcept {
         if (this != &other) {
+            mBounds = other.mBounds;
+            mOccluderPositions = std::move(other.mOccluderPositions);
             mVertexCount = std::exchange(other.mVertexCount, 0);
             mVertexStrideInBytes = std::exchange(other.mVertexStrideInBytes, 0);
             mVertexBuffer = std::move(other.mVertexBuffer);
+            if (mMeshId != MeshIdPool::kInvalidMeshId) {
+                GetIdPool().Release(mMeshId);
+            }
+            mMeshId = std::exchange(other.mMeshId, MeshIdPool::kInvalidMeshId);
+            mUploadTicket = std::exchange(other.mUploadTicket, 0);
         }
         return *this;
     }
@@ -44,8 +86,52 @@ class Mesh {
         return mVertexCount;
     }
 
+    /**
+     * Returns the box enclosing the vertex positions in the local space of the mesh.
+     */
+    const AABB& GetBounds() const {
+        return mBounds;
+    }
+
+    bool IsOccluder() const {
+        return !mOccluderPositions.empty();
+    }
+
+    /**
+     * Returns the positions of the triangle list of an occluder, three floats per vertex; empty
+     * for the other meshes.
+     */
+    const std::vector<float>& GetOccluderPositions() const {
+        return mOccluderPositions;
+    }
+
+    /**
+     * Returns the id the render queue sorts the mesh by, so the instances of the same mesh end up
+     * next to each other. Unique among the live meshes; a destroyed mesh's id gets reused.
+     */
+    MeshId GetMeshId() const {
+        return mMeshId;
+    }
+
+    /**
+     * Returns the ticket of the vertex data upload, 0 if there's none to wait for.
+     */
+    UploadTicket GetUploadTicket() const {
+        return mUploadTicket;
+    }
+
    private:
+    // Using the function-local static pattern the same way MaterialRegistry numbers materials
+    static MeshIdPool& GetIdPool() {
+        static MeshIdPool sIdPool;
+        return sIdPool;
+    }
+
+    AABB mBounds;
+    std::vector<float> mOccluderPositions;
     DeviceBuffer mVertexBuffer;
     uint32_t mVertexStrideInBytes;
     uint32_t mVertexCount;
+    MeshId mMeshId;
+    UploadTicket mUploadTicket;
 };
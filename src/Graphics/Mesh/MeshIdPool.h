@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+using MeshId = uint32_t;
+
+/**
+ * Hands out the ids the render queue sorts the meshes by. The ids are dense from 0 and get
+ * recycled once their meshes are destroyed, so they fit the 16 bits RenderingKey keeps for them as
+ * long as fewer than 65536 meshes are alive at once, however many get created over time.
+ *
+ * The freed ids get reused last in, first out. Thread-safe, as the meshes get created on any
+ * thread.
+ */
+class MeshIdPool {
+   public:
+    static constexpr MeshId kInvalidMeshId = std::numeric_limits<MeshId>::max();
+
+    MeshIdPool() = default;
+
+    // Prohibit copying
+    MeshIdPool(const MeshIdPool&) = delete;
+    MeshIdPool& operator=(const MeshIdPool&) = delete;
+
+    MeshId Acquire() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ++mLiveCount;
+        if (mFreeIds.empty()) {
+            return mNextId++;
+        }
+
+        const MeshId id = mFreeIds.back();
+        mFreeIds.pop_back();
+        return id;
+    }
+
+    void Release(MeshId Id) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        --mLiveCount;
+        mFreeIds.push_back(Id);
+    }
+
+    /**
+     * Returns the number of the ids in use.
+     */
+    uint32_t GetLiveCount() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mLiveCount;
+    }
+
+    /**
+     * Returns one past the largest id handed out so far.
+     */
+    MeshId GetIdRange() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mNextId;
+    }
+
+   private:
+    mutable std::mutex mMutex;
+    std::vector<MeshId> mFreeIds;
+    MeshId mNextId{0};
+    uint32_t mLiveCount{0};
+};
@@ -1,21 +1,20 @@
 #include "MeshInstance.h"
 
-void MeshInstance::Update(CommandList10& Cmdl, Matrix4& WorldTransform) {
-    // Write the transform to the upload buffer
-    BufferRange bufferRange = mUploadConstantBuffer->Map();
-    MeshConstantBuffer* cb = static_cast<MeshConstantBuffer*>(bufferRange.GetPtr());
-    cb->World = WorldTransform;
+SlabAllocator<MeshInstance>& MeshInstance::GetBlocks() {
+    static SlabAllocator<MeshInstance> blocks;
+    return blocks;
+}
+
+void* MeshInstance::operator new(size_t Size) {
+    return GetBlocks().Allocate();
+}
 
-    // Update Device constant buffer with the data from the upload one
-    Cmdl.TransitionResource(*mMeshConstantBuffer, D3D12_RESOURCE_STATE_COPY_DEST);
-    Cmdl.CopyBufferRegion(*mUploadConstantBuffer, 0, *mMeshConstantBuffer,
-                          mUploadConstantBuffer->GetBufferSize());
-    Cmdl.TransitionResource(*mMeshConstantBuffer, D3D12_RESOURCE_STATE_GENERIC_READ);
+void MeshInstance::operator delete(void* Memory) {
+    if (Memory) {
+        GetBlocks().Free(Memory);
+    }
 }
 
-void MeshInstance::Draw(const CommandList10& Cmdl) const {
-    // Set up vertex buffer view
-    Cmdl.SetConstantBuffer(0, *mMeshConstantBuffer);
-    Cmdl.SetVertexBuffer(0, *mMesh);
-    Cmdl.DrawInstanced(mMesh->GetVertexCount(), 0);
-}
\ No newline at end of file
+void MeshInstance::Update(const Matrix4& WorldTransform) {
+    mConstants.World = WorldTransform;
+}
@@ -1,23 +1,23 @@
 #pragma once
+#include <cstddef>
 #include <memory>
+#include <utility>
 
-#include "Graphics/CommandList10.h"
-#include "Graphics/Resource/UploadBuffer.h"
 #include "Math/Matrix.h"
+#include "Memory/SlabAllocator.h"
 #include "Mesh.h"
 
+/**
+ * Per-instance data; an element of the structured buffer the instanced draws read by
+ * SV_InstanceID.
+ */
 struct MeshConstantBuffer {
     Matrix4 World;
 };
 
 class MeshInstance {
    public:
-    MeshInstance(Mesh& Mesh,
-                 std::unique_ptr<UploadBuffer>&& UploadBuffer,
-                 std::unique_ptr<DeviceBuffer>&& DeviceBuffer)
-        : mUploadConstantBuffer{std::move(UploadBuffer)},
-          mMeshConstantBuffer{std::move(DeviceBuffer)},
-          mMesh(&Mesh) {}
+    explicit MeshInstance(Mesh& Mesh) : mMesh(&Mesh) {}
 
     // Prohibit copying
     MeshInstance(const MeshInstance&) = delete;
@@ -25,32 +25,40 @@ class MeshInstance {
 
     // Allow moving
     MeshInstance(MeshInstance&& other) noexcept
-        : mUploadConstantBuffer(std::exchange(other.mUploadConstantBuffer, nullptr)),
-          mMeshConstantBuffer(std::exchange(other.mMeshConstantBuffer, nullptr)),
-          mMesh(std::exchange(other.mMesh, nullptr)) {}
+        : mConstants(other.mConstants), mMesh(std::exchange(other.mMesh, nullptr)) {}
 
     MeshInstance& operator=(MeshInstance&& other) noexcept {
         if (this != &other) {
-            mUploadConstantBuffer = std::exchange(other.mUploadConstantBuffer, nullptr);
-            mMeshConstantBuffer = std::exchange(other.mMeshConstantBuffer, nullptr);
+            mConstants = other.mConstants;
             mMesh = std::exchange(other.mMesh, nullptr);
         }
         return *this;
     }
 
-    void Update(CommandList10& Cmdl, Matrix4& WorldTransform);
-    void Draw(const CommandList10& Cmdl) const;
+    /**
+     * The instances get allocated from slabs of fixed-size blocks, the same way as the nodes
+     * owning them.
+     */
+    static void* operator new(size_t Size);
+    static void operator delete(void* Memory);
 
-    Mesh* GetMesh() const {
-        return mMesh;
+    /**
+     * Updates the CPU copy of the constants. They get uploaded by the draw of the instance batch.
+     */
+    void Update(const Matrix4& WorldTransform);
+
+    const MeshConstantBuffer& GetConstants() const {
+        return mConstants;
     }
 
-    D3D12_GPU_VIRTUAL_ADDRESS GetConstantBuffer() const {
-        return mMeshConstantBuffer->GetDeviceVirtualAddress();
+    Mesh* GetMesh() const {
+        return mMesh;
     }
 
    private:
-    std::unique_ptr<UploadBuffer> mUploadConstantBuffer;
-    std::unique_ptr<DeviceBuffer> mMeshConstantBuffer;
+    // The slabs operator new allocates from
+    static SlabAllocator<MeshInstance>& GetBlocks();
+
+    MeshConstantBuffer mConstants{};
     Mesh* mMesh;
 };
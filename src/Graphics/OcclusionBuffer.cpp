@@ -0,0 +1,284 @@
+#include "OcclusionBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "Logging/Logging.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#include <emmintrin.h>
+#define HAS_SSE2 1
+#endif
+
+// The clip space w below which a point counts as on or behind the eye
+constexpr float kMinClipW = 1e-5f;
+
+bool OcclusionBuffer::Create(uint32_t Width,
+                             uint32_t Height,
+                             std::unique_ptr<OcclusionBuffer>& OutBuffer) {
+    if (Width == 0 || Height == 0 || Width % kTileSize != 0 || Height % kTileSize != 0) {
+        LOG_ERROR(L"The occlusion buffer size %u x %u isn't a multiple of the tile size %u.\n",
+                  Width, Height, kTileSize);
+        return false;
+    }
+
+    OutBuffer = std::make_unique<OcclusionBuffer>(Width, Height);
+    return true;
+}
+
+OcclusionBuffer::OcclusionBuffer(uint32_t Width, uint32_t Height)
+    : mWidth(Width),
+      mHeight(Height),
+      mTileCountX(Width / kTileSize),
+      mTileCountY(Height / kTileSize),
+      mDepth(static_cast<size_t>(Width) * Height, 1.f),
+      mTileMaxDepth(static_cast<size_t>(mTileCountX) * mTileCountY, 1.f),
+      mViewProjection{1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f,
+                      0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f} {}
+
+void OcclusionBuffer::Clear(const float* ViewProjection) {
+    std::copy_n(ViewProjection, 16, mViewProjection);
+    std::fill(mDepth.begin(), mDepth.end(), 1.f);
+    std::fill(mTileMaxDepth.begin(), mTileMaxDepth.end(), 1.f);
+
+    mRasterizedTriangleCount = 0;
+    mTestedCount = 0;
+    mCulledCount = 0;
+}
+
+void OcclusionBuffer::RasterizeOccluder(const float* World,
+                                        const void* Positions,
+                                        uint32_t VertexCount,
+                                        uint32_t StrideInBytes) {
+    // The world and the view-projection transforms combined, row vectors: p * World * ViewProj
+    float worldViewProjection[16];
+    for (uint32_t row = 0; row < 4; ++row) {
+        for (uint32_t column = 0; column < 4; ++column) {
+            float sum = 0.f;
+            for (uint32_t k = 0; k < 4; ++k) {
+                sum += World[row * 4 + k] * mViewProjection[k * 4 + column];
+            }
+            worldViewProjection[row * 4 + column] = sum;
+        }
+    }
+
+    const float halfWidth = 0.5f * static_cast<float>(mWidth);
+    const float halfHeight = 0.5f * static_cast<float>(mHeight);
+
+    const std::byte* vertex = static_cast<const std::byte*>(Positions);
+    for (uint32_t triangle = 0; triangle + 3 <= VertexCount; triangle += 3) {
+        // To pixel coordinates, y down, and the depth
+        float screen[3][3];
+        bool isBehindNearPlane = false;
+        for (uint32_t corner = 0; corner < 3; ++corner, vertex += StrideInBytes) {
+            const float* position = reinterpret_cast<const float*>(vertex);
+            float clip[4];
+            Transform(worldViewProjection, position[0], position[1], position[2], clip);
+            if (clip[3] < kMinClipW || clip[2] < 0.f) {
+                isBehindNearPlane = true;
+                continue;
+            }
+
+            const float inverseW = 1.f / clip[3];
+            screen[corner][0] = (clip[0] * inverseW + 1.f) * halfWidth;
+            screen[corner][1] = (1.f - clip[1] * inverseW) * halfHeight;
+            screen[corner][2] = clip[2] * inverseW;
+        }
+
+        if (!isBehindNearPlane) {
+            RasterizeTriangle(screen[0], screen[1], screen[2]);
+        }
+    }
+}
+
+void OcclusionBuffer::RasterizeTriangle(const float* V0, const float* V1, const float* V2) {
+    // Wind counterclockwise in pixel coordinates, so the inside is where the edges are positive
+    float area = (V1[0] - V0[0]) * (V2[1] - V0[1]) - (V1[1] - V0[1]) * (V2[0] - V0[0]);
+    if (area == 0.f || !std::isfinite(area)) {
+        return;
+    }
+    if (area < 0.f) {
+        std::swap(V1, V2);
+        area = -area;
+    }
+
+    // The pixels whose centers the bounding box of the triangle covers; the rows start on a
+    // multiple of four for the SIMD loop
+    const float minX = std::min({V0[0], V1[0], V2[0]});
+    const float maxX = std::max({V0[0], V1[0], V2[0]});
+    const float minY = std::min({V0[1], V1[1], V2[1]});
+    const float maxY = std::max({V0[1], V1[1], V2[1]});
+    const int32_t beginX = ToPixelIndex(std::floor(minX - 0.5f) + 1.f, mWidth) & ~3;
+    const int32_t endX = ToPixelIndex(std::floor(maxX - 0.5f) + 1.f, mWidth);
+    const int32_t beginY = ToPixelIndex(std::floor(minY - 0.5f) + 1.f, mHeight);
+    const int32_t endY = ToPixelIndex(std::floor(maxY - 0.5f) + 1.f, mHeight);
+    if (beginX >= endX || beginY >= endY) {
+        return;
+    }
+
+    ++mRasterizedTriangleCount;
+
+    // Edge functions E(x, y) = A * x + B * y + C, positive inside; the edge i faces vertex i
+    const float* vertices[3] = {V0, V1, V2};
+    float edgeA[3];
+    float edgeB[3];
+    float edgeC[3];
+    for (uint32_t edge = 0; edge < 3; ++edge) {
+        const float* from = vertices[(edge + 1) % 3];
+        const float* to = vertices[(edge + 2) % 3];
+        edgeA[edge] = from[1] - to[1];
+        edgeB[edge] = to[0] - from[0];
+        edgeC[edge] = from[0] * to[1] - from[1] * to[0];
+    }
+
+    // The depth is linear in the pixel coordinates: z = z0 + dz/dx * (x - x0) + dz/dy * (y - y0)
+    const float inverseArea = 1.f / area;
+    const float depthDx = (edgeA[1] * (V1[2] - V0[2]) + edgeA[2] * (V2[2] - V0[2])) * inverseArea;
+    const float depthDy = (edgeB[1] * (V1[2] - V0[2]) + edgeB[2] * (V2[2] - V0[2])) * inverseArea;
+    const float depthC = V0[2] - depthDx * V0[0] - depthDy * V0[1];
+
+    for (int32_t y = beginY; y < endY; ++y) {
+        const float centerY = static_cast<float>(y) + 0.5f;
+        float* row = mDepth.data() + static_cast<size_t>(y) * mWidth;
+
+        int32_t x = beginX;
+#ifdef HAS_SSE2
+        const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+        for (; x + 4 <= endX; x += 4) {
+            const __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (uint32_t edge = 0; edge < 3; ++edge) {
+                const __m128 value =
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[edge]), centerX),
+                               _mm_set1_ps(edgeB[edge] * centerY + edgeC[edge]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(value, zero));
+            }
+            if (_mm_movemask_ps(inside) == 0) {
+                continue;
+            }
+
+            const __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthDx), centerX),
+                                            _mm_set1_ps(depthDy * centerY + depthC));
+            const __m128 current = _mm_loadu_ps(row + x);
+            const __m128 nearest = _mm_min_ps(current, depth);
+            _mm_storeu_ps(row + x,
+                          _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+        }
+#endif
+        // The rest of the row, or all of it without SSE2
+        for (; x < endX; ++x) {
+            const float centerX = static_cast<float>(x) + 0.5f;
+            bool isInside = true;
+            for (uint32_t edge = 0; edge < 3; ++edge) {
+                isInside &= edgeA[edge] * centerX + (edgeB[edge] * centerY + edgeC[edge]) >= 0.f;
+            }
+            if (isInside) {
+                const float depth = depthDx * centerX + (depthDy * centerY + depthC);
+                row[x] = std::min(row[x], depth);
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::BuildHierarchy() {
+    for (uint32_t tileY = 0; tileY < mTileCountY; ++tileY) {
+        for (uint32_t tileX = 0; tileX < mTileCountX; ++tileX) {
+            float maxDepth = 0.f;
+            for (uint32_t y = tileY * kTileSize; y < (tileY + 1) * kTileSize; ++y) {
+                const float* row = mDepth.data() + static_cast<size_t>(y) * mWidth;
+                for (uint32_t x = tileX * kTileSize; x < (tileX + 1) * kTileSize; ++x) {
+                    maxDepth = std::max(maxDepth, row[x]);
+                }
+            }
+            mTileMaxDepth[static_cast<size_t>(tileY) * mTileCountX + tileX] = maxDepth;
+        }
+    }
+}
+
+bool OcclusionBuffer::IsVisible(const float* Min, const float* Max) {
+    ++mTestedCount;
+
+    // The screen-space bounds of the corners and their nearest depth
+    float minX = INFINITY;
+    float maxX = -INFINITY;
+    float minY = INFINITY;
+    float maxY = -INFINITY;
+    float minDepth = INFINITY;
+    for (uint32_t corner = 0; corner < 8; ++corner) {
+        float clip[4];
+        Transform(mViewProjection, (corner & 1) ? Max[0] : Min[0], (corner & 2) ? Max[1] : Min[1],
+                  (corner & 4) ? Max[2] : Min[2], clip);
+        if (clip[3] < kMinClipW || clip[2] < 0.f) {
+            // Crosses the near plane
+            return true;
+        }
+
+        const float inverseW = 1.f / clip[3];
+        minX = std::min(minX, clip[0] * inverseW);
+        maxX = std::max(maxX, clip[0] * inverseW);
+        minY = std::min(minY, clip[1] * inverseW);
+        maxY = std::max(maxY, clip[1] * inverseW);
+        minDepth = std::min(minDepth, clip[2] * inverseW);
+    }
+
+    // The pixels the bounds touch; y goes down
+    const float halfWidth = 0.5f * static_cast<float>(mWidth);
+    const float halfHeight = 0.5f * static_cast<float>(mHeight);
+    const int32_t beginX = ToPixelIndex(std::floor((minX + 1.f) * halfWidth), mWidth);
+    const int32_t endX = ToPixelIndex(std::floor((maxX + 1.f) * halfWidth) + 1.f, mWidth);
+    const int32_t beginY = ToPixelIndex(std::floor((1.f - maxY) * halfHeight), mHeight);
+    const int32_t endY = ToPixelIndex(std::floor((1.f - minY) * halfHeight) + 1.f, mHeight);
+    if (beginX >= endX || beginY >= endY) {
+        ++mCulledCount;
+        return false;
+    }
+
+    const uint32_t beginTileX = static_cast<uint32_t>(beginX) / kTileSize;
+    const uint32_t endTileX = (static_cast<uint32_t>(endX) + kTileSize - 1) / kTileSize;
+    const uint32_t beginTileY = static_cast<uint32_t>(beginY) / kTileSize;
+    const uint32_t endTileY = (static_cast<uint32_t>(endY) + kTileSize - 1) / kTileSize;
+    for (uint32_t tileY = beginTileY; tileY < endTileY; ++tileY) {
+        for (uint32_t tileX = beginTileX; tileX < endTileX; ++tileX) {
+            // The whole tile is in front of the box
+            if (mTileMaxDepth[static_cast<size_t>(tileY) * mTileCountX + tileX] < minDepth) {
+                continue;
+            }
+
+            const uint32_t pixelBeginY = std::max<uint32_t>(tileY * kTileSize, beginY);
+            const uint32_t pixelEndY = std::min<uint32_t>((tileY + 1) * kTileSize, endY);
+            const uint32_t pixelBeginX = std::max<uint32_t>(tileX * kTileSize, beginX);
+            const uint32_t pixelEndX = std::min<uint32_t>((tileX + 1) * kTileSize, endX);
+            for (uint32_t y = pixelBeginY; y < pixelEndY; ++y) {
+                const float* row = mDepth.data() + static_cast<size_t>(y) * mWidth;
+                for (uint32_t x = pixelBeginX; x < pixelEndX; ++x) {
+                    if (row[x] >= minDepth) {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    ++mCulledCount;
+    return false;
+}
+
+void OcclusionBuffer::Transform(const float* Matrix, float X, float Y, float Z, float* OutClip) {
+    for (uint32_t column = 0; column < 4; ++column) {
+        OutClip[column] = X * Matrix[column] + Y * Matrix[4 + column] + Z * Matrix[8 + column] +
+                          Matrix[12 + column];
+    }
+}
+
+int32_t OcclusionBuffer::ToPixelIndex(float Pixel, uint32_t Size) {
+    // Written so that NaN fails the first comparison
+    if (!(Pixel > 0.f)) {
+        return 0;
+    }
+    if (Pixel >= static_cast<float>(Size)) {
+        return static_cast<int32_t>(Size);
+    }
+    return static_cast<int32_t>(Pixel);
+}
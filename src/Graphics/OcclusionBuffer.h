@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * A low-resolution depth buffer the occluders get rasterized into on the CPU, to reject the
+ * objects hidden behind them before they get drawn. Plain floats in, no graphics API, so it runs
+ * anywhere.
+ *
+ * The depth follows the D3D conventions, 0 at the near plane and 1 at the far plane. On top of the
+ * depth per pixel, the buffer keeps the farthest depth per kTileSize x kTileSize tile:
+ *
+ *   pixels: | .2 .2 .9 1. |      tiles: | .9 |  1. |
+ *           | .2 .2 .9 1. |             |    |     |
+ *
+ * An object gets tested against the tiles its screen-space bounds touch first. It's hidden behind
+ * a tile whose farthest depth is nearer than the object's nearest one, so most tests end at the
+ * tiles; only the tiles partially in front of the object get their pixels tested.
+ *
+ * The occluders are sampled at the pixel centers, four pixels at a time with SSE2 where it's
+ * available. The matrices are 16 floats, row-major, in the row vector convention of Matrix4.
+ */
+class OcclusionBuffer {
+   public:
+    // The size of the square tile the farthest depth is kept for
+    static constexpr uint32_t kTileSize = 8;
+
+    /**
+     * @param Width The width in pixels; a multiple of kTileSize.
+     * @param Height The height in pixels; a multiple of kTileSize.
+     * @param OutBuffer Output parameter that will be populated with the buffer on success.
+     * @return true if the buffer was created, false if the size is invalid.
+     */
+    static bool Create(uint32_t Width,
+                       uint32_t Height,
+                       std::unique_ptr<OcclusionBuffer>& OutBuffer);
+
+    OcclusionBuffer(uint32_t Width, uint32_t Height);
+
+    // Prohibit copying
+    OcclusionBuffer(const OcclusionBuffer&) = delete;
+    OcclusionBuffer& operator=(const OcclusionBuffer&) = delete;
+
+    // Allow moving
+    OcclusionBuffer(OcclusionBuffer&&) noexcept = default;
+    OcclusionBuffer& operator=(OcclusionBuffer&&) noexcept = default;
+
+    /**
+     * Starts a view: clears the depth to the far plane and resets the counters.
+     * @param ViewProjection The view-projection matrix of the view.
+     */
+    void Clear(const float* ViewProjection);
+
+    /**
+     * Rasterizes the triangle list of an occluder. The triangles crossing the near plane get
+     * skipped, which only makes the culling less effective.
+     * @param World The world matrix of the occluder.
+     * @param Positions The first vertex position; three floats.
+     * @param VertexCount The number of vertices; three per triangle.
+     * @param StrideInBytes The distance between two positions.
+     */
+    void RasterizeOccluder(const float* World,
+                           const void* Positions,
+                           uint32_t VertexCount,
+                           uint32_t StrideInBytes);
+
+    /**
+     * Updates the farthest depth of the tiles once the occluders are rasterized.
+     */
+    void BuildHierarchy();
+
+    /**
+     * Tests the world-space box against the depth. Conservative: the boxes crossing the near plane
+     * are always visible.
+     * @param Min The min corner of the box; three floats.
+     * @param Max The max corner of the box; three floats.
+     * @return false if the box is hidden behind the occluders or off the screen, true otherwise.
+     */
+    bool IsVisible(const float* Min, const float* Max);
+
+    uint32_t GetWidth() const {
+        return mWidth;
+    }
+
+    uint32_t GetHeight() const {
+        return mHeight;
+    }
+
+    /**
+     * Returns the depth of the pixel, e.g. to inspect the buffer in a test.
+     */
+    float GetDepth(uint32_t X, uint32_t Y) const {
+        return mDepth[static_cast<size_t>(Y) * mWidth + X];
+    }
+
+    /** The number of occluder triangles rasterized since the last Clear. */
+    uint32_t GetRasterizedTriangleCount() const {
+        return mRasterizedTriangleCount;
+    }
+
+    /** The number of boxes tested since the last Clear. */
+    uint32_t GetTestedCount() const {
+        return mTestedCount;
+    }
+
+    /** The number of boxes found hidden since the last Clear. */
+    uint32_t GetCulledCount() const {
+        return mCulledCount;
+    }
+
+   private:
+    /**
+     * Rasterizes the triangle given in pixel coordinates and depth, keeping the nearest depth per
+     * pixel.
+     */
+    void RasterizeTriangle(const float* V0, const float* V1, const float* V2);
+
+    /**
+     * Transforms the point (X, Y, Z, 1) by the matrix.
+     */
+    static void Transform(const float* Matrix, float X, float Y, float Z, float* OutClip);
+
+    /**
+     * Converts the pixel coordinate, rounded down already, to a pixel index clamped to [0, Size].
+     * The clamping is done in floats, so the huge, the infinite and the NaN coordinates of the
+     * degenerate projections can't overflow the integer conversion; NaN maps to 0.
+     */
+    static int32_t ToPixelIndex(float Pixel, uint32_t Size);
+
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mTileCountX;
+    uint32_t mTileCountY;
+
+    // Row by row
+    std::vector<float> mDepth;
+    // The farthest depth per tile, row by row
+    std::vector<float> mTileMaxDepth;
+
+    float mViewProjection[16];
+
+    uint32_t mRasterizedTriangleCount{0};
+    uint32_t mTestedCount{0};
+    uint32_t mCulledCount{0};
+};
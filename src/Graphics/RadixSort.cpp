@@ -0,0 +1,144 @@
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <array>
+
+#include "Threading/WorkerPool.h"
+
+// Below the size comparison sorting beats the histogram passes
+constexpr size_t kRadixSortMinSize = 256;
+
+void RadixSort(std::vector<RenderingKey>& Keys, std::vector<RenderingKey>& Scratch) {
+    const size_t count = Keys.size();
+    if (count < kRadixSortMinSize) {
+        std::sort(Keys.begin(), Keys.end());
+        return;
+    }
+
+    // Build the histograms of all the 8 bytes with a single read of the keys, and collect the bits
+    // that differ between the keys
+    std::array<std::array<uint32_t, 256>, 8> histograms{};
+    const uint64_t firstKey = Keys[0].value;
+    uint64_t differingBits = 0;
+    for (const RenderingKey& key : Keys) {
+        differingBits |= key.value ^ firstKey;
+        for (uint32_t byte = 0; byte < 8; ++byte) {
+            ++histograms[byte][(key.value >> (byte * 8)) & 0xFF];
+        }
+    }
+
+    Scratch.resize(count);
+    RenderingKey* src = Keys.data();
+    RenderingKey* dst = Scratch.data();
+
+    for (uint32_t byte = 0; byte < 8; ++byte) {
+        const uint32_t shift = byte * 8;
+
+        // All keys share this byte; the pass would keep the order as is
+        if (((differingBits >> shift) & 0xFF) == 0) {
+            continue;
+        }
+
+        // Turn the counts into the starting offsets of each bucket
+        std::array<uint32_t, 256>& offsets = histograms[byte];
+        uint32_t offset = 0;
+        for (uint32_t& bucket : offsets) {
+            uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        // Stable scatter into the buckets
+        for (size_t i = 0; i < count; ++i) {
+            dst[offsets[(src[i].value >> shift) & 0xFF]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    // An odd number of passes leaves the sorted keys in the scratch buffer
+    if (src != Keys.data()) {
+        Keys.swap(Scratch);
+    }
+}
+
+void RadixSort(std::vector<RenderingKey>& Keys,
+               std::vector<RenderingKey>& Scratch,
+               WorkerPool& Pool) {
+    const size_t count = Keys.size();
+    if (count <= kRadixSortGrainSize || Pool.GetThreadCount() == 1) {
+        RadixSort(Keys, Scratch);
+        return;
+    }
+
+    const uint32_t taskCount =
+        static_cast<uint32_t>((count + kRadixSortGrainSize - 1) / kRadixSortGrainSize);
+    auto taskBegin = [](uint32_t TaskIndex) {
+        return static_cast<size_t>(TaskIndex) * kRadixSortGrainSize;
+    };
+    auto taskEnd = [count](uint32_t TaskIndex) {
+        return std::min(count, (static_cast<size_t>(TaskIndex) + 1) * kRadixSortGrainSize);
+    };
+
+    // Collect the bits that differ between the keys; each task ORs into its own entry
+    std::vector<uint64_t> taskDifferingBits(taskCount, 0);
+    const uint64_t firstKey = Keys[0].value;
+    Pool.ParallelFor(taskCount, [&](uint32_t TaskIndex) {
+        uint64_t differingBits = 0;
+        for (size_t i = taskBegin(TaskIndex); i < taskEnd(TaskIndex); ++i) {
+            differingBits |= Keys[i].value ^ firstKey;
+        }
+        taskDifferingBits[TaskIndex] = differingBits;
+    });
+
+    uint64_t differingBits = 0;
+    for (uint64_t taskBits : taskDifferingBits) {
+        differingBits |= taskBits;
+    }
+
+    Scratch.resize(count);
+    RenderingKey* src = Keys.data();
+    RenderingKey* dst = Scratch.data();
+
+    // Bucket counts per task, turned into the task's scatter offsets in place
+    std::vector<std::array<uint32_t, 256>> taskOffsets(taskCount);
+
+    for (uint32_t byte = 0; byte < 8; ++byte) {
+        const uint32_t shift = byte * 8;
+
+        // All keys share this byte; the pass would keep the order as is
+        if (((differingBits >> shift) & 0xFF) == 0) {
+            continue;
+        }
+
+        // The chunks change between the passes, so they get re-counted every pass
+        Pool.ParallelFor(taskCount, [&](uint32_t TaskIndex) {
+            std::array<uint32_t, 256>& counts = taskOffsets[TaskIndex];
+            counts.fill(0);
+            for (size_t i = taskBegin(TaskIndex); i < taskEnd(TaskIndex); ++i) {
+                ++counts[(src[i].value >> shift) & 0xFF];
+            }
+        });
+
+        // Within a bucket the keys of the earlier chunks go first, which keeps the sort stable
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < 256; ++bucket) {
+            for (std::array<uint32_t, 256>& offsets : taskOffsets) {
+                uint32_t bucketCount = offsets[bucket];
+                offsets[bucket] = offset;
+                offset += bucketCount;
+            }
+        }
+
+        Pool.ParallelFor(taskCount, [&](uint32_t TaskIndex) {
+            std::array<uint32_t, 256>& offsets = taskOffsets[TaskIndex];
+            for (size_t i = taskBegin(TaskIndex); i < taskEnd(TaskIndex); ++i) {
+                dst[offsets[(src[i].value >> shift) & 0xFF]++] = src[i];
+            }
+        });
+        std::swap(src, dst);
+    }
+
+    if (src != Keys.data()) {
+        Keys.swap(Scratch);
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RenderingKey.h"
+
+class WorkerPool;
+
+// The number of keys a parallel task of the RadixSort sorts at most; fewer keys get sorted serially
+constexpr uint32_t kRadixSortGrainSize = 16384;
+
+/**
+ * Sorts the keys in ascending order with an LSD radix sort over bytes. The byte passes where all
+ * the keys hold the same value are skipped, so only the key bits in use cost a pass.
+ *
+ * @param Keys The keys to sort.
+ * @param Scratch A buffer reused between the passes; resized to the size of Keys.
+ */
+void RadixSort(std::vector<RenderingKey>& Keys, std::vector<RenderingKey>& Scratch);
+
+/**
+ * Same as RadixSort() but spreads every pass over the pool. Each task counts the buckets of its
+ * own chunk of keys and scatters the chunk into its own bucket offsets, so the sort stays stable
+ * and the result is identical.
+ */
+void RadixSort(std::vector<RenderingKey>& Keys,
+               std::vector<RenderingKey>& Scratch,
+               WorkerPool& Pool);
@@ -0,0 +1,190 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "Logging/Logging.h"
+#include "RadixSort.h"
+#include "Scene/Node.h"
+#include "Threading/WorkerPool.h"
+
+RenderQueue::~RenderQueue() {
+    Detach();
+}
+
+void RenderQueue::Attach(Node& Root) {
+    if (mRoot == &Root) {
+        return;
+    }
+
+    Detach();
+    Root.SetRenderQueue(this);
+    mRoot = &Root;
+}
+
+void RenderQueue::Detach() {
+    if (!mRoot) {
+        return;
+    }
+
+    Node* root = std::exchange(mRoot, nullptr);
+    root->SetRenderQueue(nullptr);
+}
+
+uint32_t RenderQueue::Add(NodeHandle Owner,
+                          MaterialId MaterialId,
+                          DrawPass Pass,
+                          MeshInstance* MeshInstance) {
+    uint32_t objectId;
+    if (!mFreeObjectIds.empty()) {
+        objectId = mFreeObjectIds.back();
+        mFreeObjectIds.pop_back();
+    } else {
+        // The object id has to fit into RenderingKey::mObjectId
+        if (mObjects.size() >= kInvalidObjectId) {
+            LOG_ERROR(L"Failed to add a rendering object as the render queue is full.\n");
+            return kInvalidObjectId;
+        }
+        objectId = static_cast<uint32_t>(mObjects.size());
+        mObjects.emplace_back();
+    }
+
+    RenderingKey rKey = MakeKey(objectId, MaterialId, Pass, MeshInstance);
+    mObjects[objectId] = RenderingObject(Owner, MeshInstance, rKey);
+    mInsertedKeys.push_back(rKey);
+    mPendingObjectIds.push_back(objectId);
+    return objectId;
+}
+
+void RenderQueue::Remove(uint32_t ObjectId) {
+    mErasedKeys.push_back(mObjects[ObjectId].mKey);
+    mObjects[ObjectId] = RenderingObject();
+    mFreeObjectIds.push_back(ObjectId);
+    mRemovedObjectIds.push_back(ObjectId);
+}
+
+void RenderQueue::Update(uint32_t ObjectId,
+                         MaterialId MaterialId,
+                         DrawPass Pass,
+                         MeshInstance* MeshInstance) {
+    RenderingObject& object = mObjects[ObjectId];
+
+    RenderingKey rKey = MakeKey(ObjectId, MaterialId, Pass, MeshInstance);
+    if (rKey != object.mKey) {
+        mErasedKeys.push_back(object.mKey);
+        mInsertedKeys.push_back(rKey);
+        object.mKey = rKey;
+    }
+
+    if (object.mMeshInstance != MeshInstance) {
+        object.mMeshInstance = MeshInstance;
+
+        // Listed once however many times the mesh changes before the changes get consumed
+        if (!object.mIsUploadPending) {
+            object.mIsUploadPending = true;
+            mPendingObjectIds.push_back(ObjectId);
+        }
+    }
+}
+
+void RenderQueue::Flush() {
+    if (mInsertedKeys.empty() && mErasedKeys.empty()) {
+        return;
+    }
+
+    if (mInsertedKeys.size() + mErasedKeys.size() <= kInPlaceMaxChanges) {
+        for (const RenderingKey& key : mErasedKeys) {
+            // A key added since the last flush isn't in the sorted keys yet
+            auto inserted = std::find(mInsertedKeys.begin(), mInsertedKeys.end(), key);
+            if (inserted != mInsertedKeys.end()) {
+                *inserted = mInsertedKeys.back();
+                mInsertedKeys.pop_back();
+                continue;
+            }
+
+            auto it = std::lower_bound(mKeys.begin(), mKeys.end(), key);
+            if (it != mKeys.end() && *it == key) {
+                mKeys.erase(it);
+            }
+        }
+
+        for (const RenderingKey& key : mInsertedKeys) {
+            mKeys.insert(std::upper_bound(mKeys.begin(), mKeys.end(), key), key);
+        }
+    } else {
+        RadixSort(mInsertedKeys, mScratchKeys);
+        RadixSort(mErasedKeys, mScratchKeys);
+        MergeChanges();
+    }
+
+    mInsertedKeys.clear();
+    mErasedKeys.clear();
+}
+
+void RenderQueue::Flush(WorkerPool& Pool) {
+    const size_t changeCount = mInsertedKeys.size() + mErasedKeys.size();
+    if (changeCount <= kParallelGrainSize || Pool.GetThreadCount() == 1) {
+        Flush();
+        return;
+    }
+
+    // Rebuilding costs a pass over all the objects, so it pays off once the changes touch a
+    // sizable part of them
+    if (changeCount * 4 > mObjects.size()) {
+        RebuildKeys(Pool);
+    } else {
+        RadixSort(mInsertedKeys, mScratchKeys, Pool);
+        RadixSort(mErasedKeys, mScratchKeys, Pool);
+        MergeChanges();
+    }
+
+    mInsertedKeys.clear();
+    mErasedKeys.clear();
+}
+
+void RenderQueue::MergeChanges() {
+    // Merge the new keys in and drop the erased ones in two linear passes. The keys are compared
+    // as multisets, so an erased key that never got flushed cancels its insertion.
+    mScratchKeys.clear();
+    mScratchKeys.reserve(mKeys.size() + mInsertedKeys.size());
+    std::merge(mKeys.begin(), mKeys.end(), mInsertedKeys.begin(), mInsertedKeys.end(),
+               std::back_inserter(mScratchKeys));
+
+    mKeys.clear();
+    std::set_difference(mScratchKeys.begin(), mScratchKeys.end(), mErasedKeys.begin(),
+                        mErasedKeys.end(), std::back_inserter(mKeys));
+}
+
+void RenderQueue::RebuildKeys(WorkerPool& Pool) {
+    const uint32_t objectCount = GetObjectCount();
+    const uint32_t taskCount = (objectCount + kParallelGrainSize - 1) / kParallelGrainSize;
+
+    // Every task gathers the keys of its chunk of objects into its own buffer
+    mTaskKeys.resize(taskCount);
+    Pool.ParallelFor(taskCount, [this, objectCount](uint32_t TaskIndex) {
+        std::vector<RenderingKey>& taskKeys = mTaskKeys[TaskIndex];
+        taskKeys.clear();
+
+        const uint32_t end = std::min(objectCount, (TaskIndex + 1) * kParallelGrainSize);
+        for (uint32_t objectId = TaskIndex * kParallelGrainSize; objectId < end; ++objectId) {
+            if (mObjects[objectId].IsValid()) {
+                taskKeys.push_back(mObjects[objectId].mKey);
+            }
+        }
+    });
+
+    // Concatenate the buffers at their prefix-sum offsets
+    mTaskKeyOffsets.resize(taskCount);
+    size_t keyCount = 0;
+    for (uint32_t i = 0; i < taskCount; ++i) {
+        mTaskKeyOffsets[i] = keyCount;
+        keyCount += mTaskKeys[i].size();
+    }
+
+    mKeys.resize(keyCount);
+    Pool.ParallelFor(taskCount, [this](uint32_t TaskIndex) {
+        std::ranges::copy(mTaskKeys[TaskIndex], mKeys.begin() + mTaskKeyOffsets[TaskIndex]);
+    });
+
+    RadixSort(mKeys, mScratchKeys, Pool);
+}
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Material/Material.h"
+#include "Mesh/MeshInstance.h"
+#include "RenderingKey.h"
+#include "Scene/NodeRegistry.h"
+
+class Node;
+class WorkerPool;
+
+enum DrawPass {
+    kOpaque,
+};
+
+/**
+ * Scene Node representation optimized for rendering
+ */
+class RenderingObject {
+   public:
+    RenderingObject() = default;
+    RenderingObject(NodeHandle Owner, MeshInstance* Mesh, RenderingKey Key)
+        : mOwner(Owner), mMeshInstance(Mesh), mKey(Key), mIsUploadPending(true) {}
+    ~RenderingObject() = default;
+
+    RenderingObject(const RenderingObject&) = delete;
+    RenderingObject& operator=(const RenderingObject&) = delete;
+
+    RenderingObject(RenderingObject&& other) noexcept
+        : mOwner(std::exchange(other.mOwner, NodeRegistry::kInvalidHandle)),
+          mMeshInstance(std::exchange(other.mMeshInstance, nullptr)),
+          mKey(other.mKey),
+          mIsUploadPending(std::exchange(other.mIsUploadPending, false)) {}
+
+    RenderingObject& operator=(RenderingObject&& other) noexcept {
+        if (this != &other) {
+            mOwner = std::exchange(other.mOwner, NodeRegistry::kInvalidHandle);
+            mMeshInstance = std::exchange(other.mMeshInstance, nullptr);
+            mKey = other.mKey;
+            mIsUploadPending = std::exchange(other.mIsUploadPending, false);
+        }
+        return *this;
+    }
+
+    /**
+     * Free object slots have no owner.
+     */
+    bool IsValid() const {
+        return mOwner != NodeRegistry::kInvalidHandle;
+    }
+
+    /**
+     * Returns the owner node, nullptr for the free object slots.
+     */
+    Node* GetOwner() const {
+        return NodeRegistry::Resolve(mOwner);
+    }
+
+    NodeHandle GetOwnerHandle() const {
+        return mOwner;
+    }
+
+    MeshInstance* GetMeshInstance() const {
+        return mMeshInstance;
+    }
+
+    /**
+     * Returns the key of the object; the sorted keys of the queue catch up with it on Flush.
+     */
+    RenderingKey GetKey() const {
+        return mKey;
+    }
+
+    /**
+     * Checks whether the mesh constants need refreshing regardless of the world transform being
+     * updated, i.e. the object is new or got a new MeshInstance.
+     */
+    bool IsUploadPending() const {
+        return mIsUploadPending;
+    }
+
+    void SetUploadPending(bool IsUploadPending) {
+        mIsUploadPending = IsUploadPending;
+    }
+
+   private:
+    friend class RenderQueue;
+
+    // The owner node by handle, so it stays bound when the node gets moved. The MeshInstance is
+    // owned by the node, which refreshes the pointer whenever it changes
+    NodeHandle mOwner{NodeRegistry::kInvalidHandle};
+    MeshInstance* mMeshInstance{nullptr};
+
+    // The key the object is currently queued with
+    RenderingKey mKey{};
+
+    bool mIsUploadPending{false};
+};
+
+/**
+ * Persistent rendering queue. Keeps the RenderingKeys sorted in a flat vector and the
+ * RenderingObjects they refer to by mObjectId.
+ *
+ * Nodes of the attached scene register themselves once they have both a mesh and a material and
+ * deregister when they lose either or get destroyed. Material and pass changes patch the key of the
+ * registered object. All the changes get buffered and applied to the sorted keys by Flush, so a
+ * frame without changes costs nothing, and a frame with a few changes costs a binary search per
+ * change instead of a rebuild over the whole scene.
+ */
+class RenderQueue {
+   public:
+    static constexpr uint32_t kInvalidObjectId = (1u << 24) - 1;
+
+    // Change sets up to this size get patched into the keys one by one; larger ones get sorted
+    // and merged with the keys in one linear pass
+    static constexpr size_t kInPlaceMaxChanges = 64;
+
+    // The number of keys or objects a parallel task processes at most; smaller work gets done
+    // serially
+    static constexpr uint32_t kParallelGrainSize = 16384;
+
+    RenderQueue() = default;
+    ~RenderQueue();
+
+    // Prohibit copying and moving as the scene nodes hold a pointer to the queue
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+    RenderQueue(RenderQueue&&) = delete;
+    RenderQueue& operator=(RenderQueue&&) = delete;
+
+    /**
+     * Attaches the scene to the queue, detaching the previous one. All the renderable nodes of the
+     * scene get registered, and so do the nodes added to it later on.
+     */
+    void Attach(Node& Root);
+
+    /**
+     * Detaches the scene, deregistering all of its nodes.
+     */
+    void Detach();
+
+    Node* GetRoot() const {
+        return mRoot;
+    }
+
+    /**
+     * Re-binds the scene root pointer, e.g. when the root node is moved or destroyed.
+     */
+    void SetRoot(Node* Root) {
+        mRoot = Root;
+    }
+
+    /**
+     * Registers a rendering object. The key gets into the sorted order on the next Flush.
+     * @return The object id, or kInvalidObjectId if the queue is out of ids.
+     */
+    uint32_t Add(NodeHandle Owner,
+                 MaterialId MaterialId,
+                 DrawPass Pass,
+                 MeshInstance* MeshInstance);
+
+    /**
+     * Deregisters the rendering object. The id gets reused by the following Add calls.
+     */
+    void Remove(uint32_t ObjectId);
+
+    /**
+     * Re-keys the rendering object and sets its MeshInstance.
+     */
+    void Update(uint32_t ObjectId,
+                MaterialId MaterialId,
+                DrawPass Pass,
+                MeshInstance* MeshInstance);
+
+    /**
+     * Applies the changes made since the last call to the sorted keys.
+     */
+    void Flush();
+
+    /**
+     * Same as Flush() but spreads large change sets over the pool. When the changes touch a large
+     * part of the queue, e.g. a new scene got attached, the keys get rebuilt from the rendering
+     * objects instead: every task gathers the keys of its chunk of objects into its own buffer,
+     * the buffers get concatenated at their prefix-sum offsets and sorted with the parallel
+     * RadixSort. The object ids are the object slots, so they stay consistent regardless of
+     * which task emits the keys.
+     */
+    void Flush(WorkerPool& Pool);
+
+    const std::vector<RenderingKey>& GetKeys() const {
+        return mKeys;
+    }
+
+    const RenderingObject& GetObject(uint32_t ObjectId) const {
+        return mObjects[ObjectId];
+    }
+
+    RenderingObject& GetObject(uint32_t ObjectId) {
+        return mObjects[ObjectId];
+    }
+
+    /**
+     * Returns the objects added or given a new MeshInstance since the last ClearObjectChanges
+     * call, i.e. the ones that got IsUploadPending set. An id may have been removed since.
+     */
+    const std::vector<uint32_t>& GetPendingObjectIds() const {
+        return mPendingObjectIds;
+    }
+
+    /**
+     * Returns the objects removed since the last ClearObjectChanges call. An id may have been
+     * reused by an Add since.
+     */
+    const std::vector<uint32_t>& GetRemovedObjectIds() const {
+        return mRemovedObjectIds;
+    }
+
+    /**
+     * Forgets the object changes once they have been consumed, e.g. by the renderer every frame.
+     */
+    void ClearObjectChanges() {
+        mPendingObjectIds.clear();
+        mRemovedObjectIds.clear();
+    }
+
+    /**
+     * Returns the number of object slots, including the free ones.
+     */
+    uint32_t GetObjectCount() const {
+        return static_cast<uint32_t>(mObjects.size());
+    }
+
+    size_t GetSize() const {
+        return mKeys.size();
+    }
+
+   private:
+    static RenderingKey MakeKey(uint32_t ObjectId,
+                                MaterialId MaterialId,
+                                DrawPass Pass,
+                                const MeshInstance* MeshInstance) {
+        RenderingKey rKey;
+        rKey.value = ObjectId;
+        // Setting the most significant bits. The mesh ids are recycled, so they fit the 16 bits
+        // while fewer than 65536 meshes are alive. Past that they wrap around and the colliding
+        // meshes share a batch key: their instances interleave in the sort, which fragments the
+        // runs into more draws. The draws stay correct as the renderer compares the meshes.
+        rKey.mMeshId = MeshInstance->GetMesh()->GetMeshId();
+        rKey.mMaterialId = MaterialId;
+        rKey.mPass = Pass;
+        return rKey;
+    }
+
+    /**
+     * Merges the sorted pending changes into the keys with two linear passes.
+     */
+    void MergeChanges();
+
+    /**
+     * Rebuilds the sorted keys from all the valid rendering objects on the pool.
+     */
+    void RebuildKeys(WorkerPool& Pool);
+
+    // Sorted keys as of the last Flush
+    std::vector<RenderingKey> mKeys;
+    std::vector<RenderingKey> mScratchKeys;
+
+    // Changes waiting for the next Flush
+    std::vector<RenderingKey> mInsertedKeys;
+    std::vector<RenderingKey> mErasedKeys;
+
+    std::vector<RenderingObject> mObjects;
+    std::vector<uint32_t> mFreeObjectIds;
+
+    // Object changes waiting for the consumer, so it doesn't have to scan all the objects
+    std::vector<uint32_t> mPendingObjectIds;
+    std::vector<uint32_t> mRemovedObjectIds;
+
+    // Reused per-task key buffers and their offsets of the parallel rebuild
+    std::vector<std::vector<RenderingKey>> mTaskKeys;
+    std::vector<size_t> mTaskKeyOffsets;
+
+    // Not-owning pointer to the attached scene
+    Node* mRoot{nullptr};
+};
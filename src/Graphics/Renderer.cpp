@@ -1,154 +1,451 @@
 #include "Renderer.h"
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+
+#include "Command/D3D12CommandBackend.h"
 #include "CommandList10.h"
+#include "Device.h"
 #include "Material/Material.h"
+#include "RadixSort.h"
 #include "RootSignature.h"
+#include "Scene/TransformStore.h"
 
-// Internal visitor implementation - not part of public API
-class RenderObjectBuilder : public NodeVisitor {
-   public:
-    RenderObjectBuilder(CommandList10& Cmdl,
-                        std::set<RenderingKey>& RenderingOrder,
-                        std::vector<RenderingObject>& RenderingObjects)
-        : Cmdl(Cmdl), mRenderingOrder(RenderingOrder), mRenderingObjects(RenderingObjects) {}
-
-    void Visit(Node* node) override;
-
-   private:
-    CommandList10& Cmdl;
-    std::set<RenderingKey>& mRenderingOrder;
-    std::vector<RenderingObject>& mRenderingObjects;
-};
-
-void RenderObjectBuilder::Visit(Node* node) {
-    // Skip all materialIds prior to kMaterialFirstId
-    if (node->GetMaterialId() < kMaterialFirstId) {
-        return;
+// Renderer class
+bool Renderer::Create(RootSignature& RootSignature, std::unique_ptr<Renderer>& OutRenderer) {
+    std::unique_ptr<WorkerPool> workerPool;
+    if (!WorkerPool::Create(workerPool)) {
+        LOG_ERROR(L"Failed to create the Renderer worker pool.\n");
+        return false;
     }
 
-    // Skip the node if no mesh
-    if (!node->GetMeshInstance()) {
+    std::unique_ptr<OcclusionBuffer> occlusionBuffer;
+    if (!OcclusionBuffer::Create(kOcclusionBufferWidth, kOcclusionBufferHeight, occlusionBuffer)) {
+        LOG_ERROR(L"Failed to create the Renderer occlusion buffer.\n");
+        return false;
+    }
+
+    OutRenderer = std::make_unique<Renderer>(RootSignature, std::move(workerPool),
+                                             std::make_unique<RenderQueue>(),
+                                             std::move(occlusionBuffer));
+    OutRenderer->SetClearColorRGBA(0.4f, 0.6f, 0.9f, 1.0f);
+    return true;
+}
+
+bool Renderer::Update(float DeltaTime) {
+    if (mRenderQueue->GetRoot()) {
+        // Compute world transformation for the changed Nodes with linear passes over the flat store
+        TransformStore& transformStore = TransformStore::Get();
+        transformStore.UpdateWorldTransforms(*mWorkerPool);
+
+        // Apply the scene changes to the sorted rendering keys
+        mRenderQueue->Flush(*mWorkerPool);
+
+        // Reject whole subtrees by their bounds for all the views in one pass
+        mFrustums.clear();
+        for (View& view : mViews) {
+            mFrustums.emplace_back(view.GetCamera().GetViewProjection());
+            view.GetKeys().clear();
+        }
+        transformStore.Cull(mFrustums, mSlotVisibility, mVisibleSlots);
+
+        // Hand the keys of the visible objects out to the views seeing them and sort them per
+        // view, so the cost follows what the views see rather than the size of the scene
+        for (uint32_t slot : mVisibleSlots) {
+            const Node* node = transformStore.GetOwner(slot);
+            if (!node) {
+                continue;
+            }
+
+            // The node may have no object or belong to the scene of another queue
+            const uint32_t objectId = node->GetRenderObjectId();
+            if (objectId >= mRenderQueue->GetObjectCount() ||
+                mRenderQueue->GetObject(objectId).GetOwnerHandle() != node->GetHandle()) {
+                continue;
+            }
+
+            const RenderingKey key = mRenderQueue->GetObject(objectId).GetKey();
+            for (uint32_t views = mSlotVisibility[slot]; views != 0; views &= views - 1) {
+                mViews[std::countr_zero(views)].GetKeys().push_back(key);
+            }
+        }
+        for (View& view : mViews) {
+            RadixSort(view.GetKeys(), mScratchKeys, *mWorkerPool);
+        }
+
+        // Drop what the occluders hide from the views asking for it
+        mOcclusionStats = {};
+        for (View& view : mViews) {
+            if (view.IsOcclusionCulling()) {
+                CullOccluded(view);
+            }
+        }
+
+        // Refresh the mesh constants and the spatial index of what changed since the last Update
+        // only, so a static scene costs nothing here. The removed objects leave the index first,
+        // as their ids may have been reused by the added ones
+        for (uint32_t objectId : mRenderQueue->GetRemovedObjectIds()) {
+            if (!mRenderQueue->GetObject(objectId).IsValid()) {
+                mSpatialIndex.Remove(objectId);
+            }
+        }
+
+        // The objects of the nodes whose world transforms got recomputed
+        for (uint32_t slot : transformStore.GetUpdatedSlots()) {
+            const Node* node = transformStore.GetOwner(slot);
+            if (!node) {
+                continue;
+            }
+
+            // The node may be unregistered or belong to the scene of another queue
+            const uint32_t objectId = node->GetRenderObjectId();
+            if (objectId < mRenderQueue->GetObjectCount() &&
+                mRenderQueue->GetObject(objectId).GetOwnerHandle() == node->GetHandle()) {
+                RefreshObject(objectId, *node);
+            }
+        }
+
+        // The new objects and the ones with a new mesh whose transforms stayed the same
+        for (uint32_t objectId : mRenderQueue->GetPendingObjectIds()) {
+            const RenderingObject& object = mRenderQueue->GetObject(objectId);
+            if (object.IsValid() && object.IsUploadPending()) {
+                RefreshObject(objectId, *object.GetOwner());
+            }
+        }
+
+        // Refit the moved objects, rebuild the degraded subtrees
+        mSpatialIndex.Update();
+    }
+
+    // Consumed, or of no use without a scene
+    mRenderQueue->ClearObjectChanges();
+    return true;
+}
+
+void Renderer::RefreshObject(uint32_t ObjectId, const Node& Owner) {
+    RenderingObject& object = mRenderQueue->GetObject(ObjectId);
+    if (object.IsUploadPending()) {
+        // The first draw of the mesh has to wait for its vertex data
+        mUploadTicket =
+            std::max(mUploadTicket, object.GetMeshInstance()->GetMesh()->GetUploadTicket());
+        object.SetUploadPending(false);
+    }
+
+    object.GetMeshInstance()->Update(Owner.GetWorldTransform());
+    mSpatialIndex.SetBounds(ObjectId,
+                            TransformStore::Get().GetWorldBounds(Owner.GetTransformIndex()));
+}
+
+void Renderer::CullOccluded(View& View) {
+    DirectX::XMFLOAT4X4 viewProjection;
+    DirectX::XMStoreFloat4x4(&viewProjection, View.GetCamera().GetViewProjection());
+    mOcclusionBuffer->Clear(&viewProjection.m[0][0]);
+
+    // The occluders the view sees; the ones out of the view hide nothing in it
+    std::vector<RenderingKey>& keys = View.GetKeys();
+    for (const RenderingKey& key : keys) {
+        const RenderingObject& object = mRenderQueue->GetObject(key.mObjectId);
+        const Mesh& mesh = *object.GetMeshInstance()->GetMesh();
+        if (!mesh.IsOccluder()) {
+            continue;
+        }
+
+        DirectX::XMFLOAT4X4 world;
+        DirectX::XMStoreFloat4x4(&world, object.GetOwner()->GetWorldTransform());
+        const std::vector<float>& positions = mesh.GetOccluderPositions();
+        mOcclusionBuffer->RasterizeOccluder(&world.m[0][0], positions.data(),
+                                            static_cast<uint32_t>(positions.size() / 3),
+                                            3 * sizeof(float));
+    }
+
+    mOcclusionStats.OccluderTriangleCount += mOcclusionBuffer->GetRasterizedTriangleCount();
+    if (mOcclusionBuffer->GetRasterizedTriangleCount() == 0) {
         return;
     }
+    mOcclusionBuffer->BuildHierarchy();
 
-    // 2. Update Mesh constant buffers
-    node->GetMeshInstance()->Update(Cmdl, node->GetWorldTransform());
+    // The occluders stay, they'd hide themselves
+    const TransformStore& transformStore = TransformStore::Get();
+    std::erase_if(keys, [&](const RenderingKey& Key) {
+        const RenderingObject& object = mRenderQueue->GetObject(Key.mObjectId);
+        if (object.GetMeshInstance()->GetMesh()->IsOccluder()) {
+            return false;
+        }
 
-    // 3. Build a RenderingKey
-    RenderingKey rKey;
-    // Sets mObjectId to the next index by mRenderingObjects.size(); mMaterialId and
-    // mPass are set below.
-    rKey.value = mRenderingObjects.size();  // NOTE: The size of rendering OBJECTS vector.
-    // Setting the most significant bits
-    rKey.mMaterialId = node->GetMaterialId();
-    rKey.mPass = DrawPass::kOpaque;
-    mRenderingOrder.insert(rKey);
+        const AABB& bounds = transformStore.GetWorldBounds(object.GetOwner()->GetTransformIndex());
+        DirectX::XMFLOAT3 min;
+        DirectX::XMFLOAT3 max;
+        DirectX::XMStoreFloat3(&min, bounds.GetMin());
+        DirectX::XMStoreFloat3(&max, bounds.GetMax());
+        return !mOcclusionBuffer->IsVisible(&min.x, &max.x);
+    });
 
-    // 4. Build RenderingObject
-    RenderingObject rObject(node->GetMeshInstance());
-    mRenderingObjects.push_back(std::move(rObject));
+    mOcclusionStats.TestedCount += mOcclusionBuffer->GetTestedCount();
+    mOcclusionStats.CulledCount += mOcclusionBuffer->GetCulledCount();
 }
 
-// Internal visitor implementation - not part of public API
-class WorldTransformVisitor : public NodeVisitor {
-   public:
-    void Visit(Node* node) override;
-};
-
-void WorldTransformVisitor::Visit(Node* node) {
-    // Get accumulated parents' world transformation
-    // and multiply it by current node's local one
-    auto WorldTransform = node->GetParent() ? node->GetParent()->GetWorldTransform() : Matrix4();
-    node->SetWorldTransform(WorldTransform * node->GetTransform());
+bool Renderer::Draw(FrameCommandList10& Cmdl) {
+    mCommandStream.Reset();
+    if (!Record(mCommandStream)) {
+        return false;
+    }
+
+    // The command list gets closed and executed automatically on exiting the scope
+    D3D12CommandBackend backend(Cmdl);
+    return backend.Submit(mCommandStream);
 }
 
-// Renderer class
-WorldTransformVisitor Renderer::sWorldTransformVisitor{};
+bool Renderer::Draw(const Device& Device, FrameCommandList10& Cmdl) {
+    // The wait goes into the direct queue ahead of the lists below, so the CPU doesn't block
+    if (mUploadTicket != 0) {
+        if (!Device.WaitForUpload(mUploadTicket)) {
+            LOG_ERROR(L"Failed to wait for the mesh uploads.\n");
+            return false;
+        }
+        mUploadTicket = 0;
+    }
 
-bool Renderer::Create(RootSignature& RootSignature, std::unique_ptr<Renderer>& OutRenderer) {
-    OutRenderer = std::make_unique<Renderer>(RootSignature);
-    OutRenderer->SetClearColorRGBA(0.4f, 0.6f, 0.9f, 1.0f);
-    return true;
+    const size_t keyCount = GetKeyCount();
+    const uint32_t chunkCount = static_cast<uint32_t>(
+        std::min<size_t>(mWorkerPool->GetThreadCount(), keyCount / kMinKeysPerChunk));
+    if (!mRenderQueue->GetRoot() || chunkCount < 2) {
+        return Draw(Cmdl);
+    }
+
+    // Take the lists up front on this thread; each chunk records into its own allocator
+    std::vector<CommandList10> lists(chunkCount);
+    for (CommandList10& list : lists) {
+        if (!Device.GetPooledCommandList(list)) {
+            LOG_ERROR(L"Failed to get a command list for a chunk of the frame.\n");
+            return false;
+        }
+    }
+
+    if (mChunkStreams.size() < chunkCount) {
+        mChunkStreams.resize(chunkCount);
+    }
+
+    ColorBuffer& renderTarget = Cmdl.GetRenderTarget();
+    std::atomic<bool> isDrawn{true};
+    mWorkerPool->ParallelFor(chunkCount, [&](uint32_t Chunk) {
+        CommandStream& stream = mChunkStreams[Chunk];
+        stream.Reset();
+
+        // The first chunk gets executed first, so it clears the render target
+        if (Chunk == 0) {
+            stream.ClearRenderTarget(mClearColorRGBA);
+        }
+
+        const size_t begin = keyCount * Chunk / chunkCount;
+        const size_t end = keyCount * (Chunk + 1) / chunkCount;
+        if (!RecordRange(stream, begin, end)) {
+            isDrawn = false;
+            return;
+        }
+
+        // The list tracks the state of the render target on its own, so the chunks don't race
+        CommandList10& list = lists[Chunk];
+        list.TransitionResource(renderTarget, D3D12_RESOURCE_STATE_RENDER_TARGET);
+        list.SetRenderTarget(renderTarget);
+
+        D3D12CommandBackend backend(list, renderTarget);
+        if (!backend.Submit(stream)) {
+            isDrawn = false;
+        }
+    });
+
+    // Submit in the key order; the frame command list ending the frame follows on exiting the
+    // caller's scope
+    for (CommandList10& list : lists) {
+        if (!list.Submit()) {
+            isDrawn = false;
+        }
+    }
+
+    return isDrawn;
 }
 
-bool Renderer::Update(CommandList10& Cmdl, float DeltaTime) {
-    if (mScene) {
-        // Clear rendering caches
-        mRenderingOrder.clear();
-        mRenderingObjects.clear();
+bool Renderer::Record(CommandStream& Stream) const {
+    if (mRenderQueue->GetRoot()) {
+        // The FIRST thing is to CLEAR the render target
+        Stream.ClearRenderTarget(mClearColorRGBA);
 
-        RenderObjectBuilder renderObjectBuilder(Cmdl, mRenderingOrder, mRenderingObjects);
-        Node::TraverseDepthFirst(mScene,
-                                 // Compute world transformation for each Node
-                                 sWorldTransformVisitor,
-                                 // Create rendering objects from the Node
-                                 renderObjectBuilder);
+        return RecordRange(Stream, 0, GetKeyCount());
     }
 
     return true;
 }
 
-bool Renderer::Draw(FrameCommandList10& Cmdl) const {
-    if (mScene) {
-        // The FIRST thing is to CLEAR the render target
-        Cmdl.ClearRenderTarget(mClearColorRGBA);
+bool Renderer::RecordRange(CommandStream& Stream, size_t Begin, size_t End) const {
+    // The views' keys follow each other in the view order
+    size_t viewBegin = 0;
+    for (const View& view : mViews) {
+        const size_t viewEnd = viewBegin + view.GetKeys().size();
+        const size_t begin = std::max(Begin, viewBegin);
+        const size_t end = std::min(End, viewEnd);
+        if (begin < end && !RecordKeys(Stream, view, begin - viewBegin, end - viewBegin)) {
+            return false;
+        }
+        viewBegin = viewEnd;
+    }
 
-        Cmdl->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        Cmdl->SetGraphicsRootSignature(mRootSignature->GetD3DRootSignature());
+    return true;
+}
 
-        // Set viewport and scissor rect
-        Cmdl->RSSetViewports(1, &mViewport);
-        Cmdl->RSSetScissorRects(1, &mScissorRect);
+bool Renderer::RecordKeys(CommandStream& Stream, const View& View, size_t Begin, size_t End) const {
+    Stream.SetPrimitiveTopology(PrimitiveTopology::kTriangleList);
 
-        DrawPass currentPass{};
-        MaterialId currentMaterialId{0};
-        std::shared_ptr<Material> currentMaterial;
+    ID3D12RootSignature* currentRootSignature = mRootSignature->GetD3DRootSignature();
+    const RootParameterSlots* currentSlots = &mRootSignature->GetRootParameterSlots();
+    Stream.SetRootSignature(currentRootSignature);
 
-        for (const RenderingKey& key : mRenderingOrder) {
-            // DrawPass switch
-            if (currentPass != key.mPass) {
-                currentPass = static_cast<DrawPass>(key.mPass);
+    // Set viewport and scissor rect
+    Stream.SetViewport(View.GetViewport());
+    Stream.SetScissorRect(View.GetScissorRect());
 
-                // Update the context if needed
-            }
+    // The view constants go into the stream data; a root signature switch drops the binding, so
+    // it gets bound again after every switch to a root signature declaring it
+    uint32_t viewDataOffset;
+    ViewConstantBuffer* viewConstants = static_cast<ViewConstantBuffer*>(
+        Stream.AllocateData(sizeof(ViewConstantBuffer), CommandStream::kDataPlacementAlignment,
+                            viewDataOffset));
+    viewConstants->ViewProjection = View.GetCamera().GetViewProjection();
+    if (currentSlots->HasView()) {
+        Stream.SetRootConstantBufferData(currentSlots->View, viewDataOffset);
+    }
 
-            // Material switch
-            if (currentMaterialId != key.mMaterialId) {
-                currentMaterialId = key.mMaterialId;
+    DrawPass currentPass{};
+    MaterialId currentMaterialId{0};
+    std::shared_ptr<Material> currentMaterial;
 
-                // Next material
-                if (!Material::GetMaterial(currentMaterialId, currentMaterial)) {
-                    LOG_ERROR(L"Failed to draw a frame as material with materialId=%u is missing",
-                              currentMaterialId);
-                    return false;
-                }
+    const std::vector<RenderingKey>& keys = View.GetKeys();
+    for (size_t runBegin = Begin; runBegin < End;) {
+        const RenderingKey& key = keys[runBegin];
+
+        // DrawPass switch
+        if (currentPass != key.mPass) {
+            currentPass = static_cast<DrawPass>(key.mPass);
+
+            // Update the context if needed
+        }
+
+        // Material switch
+        if (currentMaterialId != key.mMaterialId) {
+            currentMaterialId = key.mMaterialId;
 
-                Cmdl->SetPipelineState(currentMaterial->GetD3DPipelineState());
+            // Next material
+            if (!Material::GetMaterial(currentMaterialId, currentMaterial)) {
+                LOG_ERROR(L"Failed to draw a frame as material with materialId=%u is missing",
+                          currentMaterialId);
+                return false;
             }
 
-            // Issue Draw commands
-            mRenderingObjects[key.mObjectId].Draw(Cmdl);
+            // The materials with the other instance binding come with their own root signature
+            ID3D12RootSignature* rootSignature = currentMaterial->GetD3DRootSignature();
+            if (rootSignature && rootSignature != currentRootSignature) {
+                currentRootSignature = rootSignature;
+                currentSlots = &currentMaterial->GetRootParameterSlots();
+                Stream.SetRootSignature(currentRootSignature);
+                if (currentSlots->HasView()) {
+                    Stream.SetRootConstantBufferData(currentSlots->View, viewDataOffset);
+                }
+            }
+
+            Stream.SetPipelineState(currentMaterial->GetD3DPipelineState());
+        }
+
+        // The keys of the same material and mesh are adjacent; gather the run of them. The mesh
+        // pointers get compared too as the mesh ids in the keys may wrap around
+        const Mesh* mesh = mRenderQueue->GetObject(key.mObjectId).GetMeshInstance()->GetMesh();
+        size_t runEnd = runBegin + 1;
+        while (runEnd < End && runEnd - runBegin < kMaxInstancesPerDraw &&
+               keys[runEnd].GetBatch() == key.GetBatch() &&
+               mRenderQueue->GetObject(keys[runEnd].mObjectId).GetMeshInstance()->GetMesh() ==
+                   mesh) {
+            ++runEnd;
         }
+
+        // Issue Draw commands
+        DrawInstances(Stream, currentMaterial->GetInstanceBinding(), currentSlots->Instance, *mesh,
+                      keys.data() + runBegin, keys.data() + runEnd);
+        runBegin = runEnd;
     }
 
-    // The command list gets closed and executed automatically on exiting the scope
     return true;
 }
 
+void Renderer::DrawInstances(CommandStream& Stream,
+                             InstanceBinding Binding,
+                             uint32_t InstanceRootParameter,
+                             const Mesh& Mesh,
+                             const RenderingKey* Begin,
+                             const RenderingKey* End) const {
+    Stream.SetVertexBuffer(0, Mesh.GetVertexBuffer(),
+                           static_cast<uint32_t>(Mesh.GetVertexBufferSize()),
+                           Mesh.GetStrideInBytes());
+
+    const uint32_t instanceCount = static_cast<uint32_t>(End - Begin);
+
+    // The shaders read no per-instance data, so there's nothing to bind
+    if (InstanceRootParameter == RootParameterSlots::kNoRootParameter) {
+        Stream.DrawInstanced(Mesh.GetVertexCount(), instanceCount, 0, 0);
+        return;
+    }
+
+    if (Binding == InstanceBinding::kRootConstants) {
+        // The constants go straight from the CPU copy into the command list
+        static_assert(sizeof(MeshConstantBuffer) <=
+                      SetRoot32BitConstantsCommand::kMaxConstantCount * sizeof(uint32_t));
+        for (const RenderingKey* key = Begin; key != End; ++key) {
+            const MeshConstantBuffer& constants =
+                mRenderQueue->GetObject(key->mObjectId).GetMeshInstance()->GetConstants();
+            Stream.SetRoot32BitConstants(InstanceRootParameter,
+                                         sizeof(MeshConstantBuffer) / sizeof(uint32_t), &constants);
+            Stream.DrawInstanced(Mesh.GetVertexCount(), 1, 0, 0);
+        }
+        return;
+    }
+
+    // Pack the instances in the order of SV_InstanceID; the backend uploads the data of the whole
+    // stream at once
+    uint32_t dataOffset;
+    MeshConstantBuffer* instances = static_cast<MeshConstantBuffer*>(Stream.AllocateData(
+        instanceCount * sizeof(MeshConstantBuffer), alignof(MeshConstantBuffer), dataOffset));
+    for (const RenderingKey* key = Begin; key != End; ++key) {
+        *instances++ = mRenderQueue->GetObject(key->mObjectId).GetMeshInstance()->GetConstants();
+    }
+
+    Stream.SetRootShaderResourceData(InstanceRootParameter, dataOffset);
+    Stream.DrawInstanced(Mesh.GetVertexCount(), instanceCount, 0, 0);
+}
+
 void Renderer::Resize(uint32_t Width, uint32_t Height) {
-    // Viewport: Maps normalized device coordinates (-1 to 1) to pixel coordinates
-    // Typically matches the full render target size
-    mViewport.TopLeftX = 0.0f;
-    mViewport.TopLeftY = 0.0f;
-    mViewport.Width = static_cast<float>(Width);
-    mViewport.Height = static_cast<float>(Height);
-    mViewport.MinDepth = 0.0f;  // Near plane (closest to camera)
-    mViewport.MaxDepth = 1.0f;  // Far plane (farthest from camera)
-
-    // Scissor Rect: Clips pixels outside this rectangle (in pixel coordinates)
-    // Typically matches the viewport, but can be smaller for UI overlays, etc.
-    mScissorRect.left = 0;
-    mScissorRect.top = 0;
-    mScissorRect.right = static_cast<LONG>(Width);
-    mScissorRect.bottom = static_cast<LONG>(Height);
+    mWidth = Width;
+    mHeight = Height;
+
+    // Each view maps its normalized rectangle onto the render target
+    for (View& view : mViews) {
+        view.Resize(Width, Height);
+    }
+}
+
+bool Renderer::AddView(View&& View, uint32_t& OutViewIndex) {
+    if (mViews.size() >= kMaxViewCount) {
+        LOG_ERROR(L"Failed to add a view as there are %u views already.\n", kMaxViewCount);
+        return false;
+    }
+
+    View.Resize(mWidth, mHeight);
+    OutViewIndex = static_cast<uint32_t>(mViews.size());
+    mViews.push_back(std::move(View));
+    return true;
+}
+
+size_t Renderer::GetKeyCount() const {
+    size_t keyCount = 0;
+    for (const View& view : mViews) {
+        keyCount += view.GetKeys().size();
+    }
+    return keyCount;
 }
@@ -1,84 +1,71 @@
 #pragma once
 
 #include <memory>
-#include <set>
 #include <utility>
+#include <vector>
 
+#include "Command/CommandStream.h"
 #include "CommandList10.h"
 #include "Includes/GraphicsIncl.h"
 #include "Logging/Logging.h"
+#include "Material/Material.h"
+#include "Math/Frustum.h"
 #include "Mesh/MeshInstance.h"
+#include "OcclusionBuffer.h"
+#include "RenderQueue.h"
+#include "Scene/Bvh.h"
 #include "Scene/Node.h"
+#include "Threading/WorkerPool.h"
+#include "View.h"
 
 // Forward declarations
 class Device;
 class RootSignature;
-class WorldTransformVisitor;
-
-enum DrawPass {
-    kOpaque,
-};
 
 /**
- * Scene Node representation optimized for rendering
+ * High-level renderer class. Manages the views and the clear color.
+ * Coordinates rendering of mesh instances.
  */
-class RenderingObject {
+class Renderer {
    public:
-    RenderingObject() = default;
-    RenderingObject(MeshInstance* mesh) : mMeshInstance(mesh) {}
-    ~RenderingObject() = default;
-
-    RenderingObject(const RenderingObject&) = delete;
-    RenderingObject& operator=(const RenderingObject&) = delete;
-
-    RenderingObject(RenderingObject&& other) noexcept
-        : mMeshInstance(std::exchange(other.mMeshInstance, nullptr)) {}
+    /**
+     * What the occlusion culling did in the last Update, summed over the views.
+     */
+    struct OcclusionStats {
+        uint32_t OccluderTriangleCount{0};
+        uint32_t TestedCount{0};
+        uint32_t CulledCount{0};
+    };
 
-    RenderingObject& operator=(RenderingObject&& other) noexcept {
-        if (this != &other) {
-            mMeshInstance = std::exchange(other.mMeshInstance, nullptr);
-        }
-        return *this;
-    }
+    // The most instances drawn by a single instanced draw; longer runs get split
+    static constexpr uint32_t kMaxInstancesPerDraw = 65536;
 
-    void Draw(FrameCommandList10& Cmdl) const {
-        mMeshInstance->Draw(Cmdl);
-    }
+    // The fewest keys worth recording on a thread of their own
+    static constexpr uint32_t kMinKeysPerChunk = 1024;
 
-   private:
-    // Not-owning pointer; Onership belongs to the scene Node
-    MeshInstance* mMeshInstance;
-};
+    // The views get culled in a single pass with a bit of the visibility mask each
+    static constexpr uint32_t kMaxViewCount = TransformStore::kMaxCullViewCount;
 
-struct RenderingKey {
-    union {
-        uint64_t value;
-        struct {
-            uint64_t mObjectId : 28;    // bits 0-27 (LSB - least significant bits)
-            uint64_t mMaterialId : 32;  // bits 28-59
-            uint64_t mPass : 4;         // bits 60-63 (MSB - most significant bits)
-        };
-    };
+    // The view covering the whole render target the renderer starts with
+    static constexpr uint32_t kMainViewIndex = 0;
 
-    bool operator<(const RenderingKey& Other) const {
-        return value < Other.value;
-    }
-};
+    // The size of the occlusion buffer the occluders get rasterized into, whatever the view size
+    static constexpr uint32_t kOcclusionBufferWidth = 256;
+    static constexpr uint32_t kOcclusionBufferHeight = 144;
 
-/**
- * High-level renderer class. Manages viewport, scissor rect, and clear color.
- * Coordinates rendering of mesh instances.
- */
-class Renderer {
-   public:
     static bool Create(RootSignature& RootSignature, std::unique_ptr<Renderer>& OutRenderer);
 
-    Renderer(RootSignature& RootSignature)
+    Renderer(RootSignature& RootSignature,
+             std::unique_ptr<WorkerPool>&& WorkerPool,
+             std::unique_ptr<RenderQueue>&& RenderQueue,
+             std::unique_ptr<OcclusionBuffer>&& OcclusionBuffer)
         : mRootSignature(&RootSignature),
-          mClearColorRGBA{0.f, 0.f, 0.f, 1.f},
-          mScene(nullptr),
-          mScissorRect(),
-          mViewport() {}
+          mWorkerPool(std::move(WorkerPool)),
+          mRenderQueue(std::move(RenderQueue)),
+          mOcclusionBuffer(std::move(OcclusionBuffer)),
+          mClearColorRGBA{0.f, 0.f, 0.f, 1.f} {
+        mViews.emplace_back();
+    }
 
     ~Renderer() {
         LOG_INFO(L"Freeing Renderer.\n");
@@ -90,23 +77,43 @@ class Renderer {
 
     // Allow moving
     Renderer(Renderer&& Other) noexcept
-        : mRenderingObjects(std::exchange(Other.mRenderingObjects, {})),
-          mRenderingOrder(std::exchange(Other.mRenderingOrder, {})),
-          mRootSignature(std::exchange(Other.mRootSignature, nullptr)),
-          mScene(std::exchange(Other.mScene, nullptr)),
-          mScissorRect(Other.mScissorRect),
-          mViewport(Other.mViewport) {
+        : mRootSignature(std::exchange(Other.mRootSignature, nullptr)),
+          mWorkerPool(std::exchange(Other.mWorkerPool, nullptr)),
+          mRenderQueue(std::exchange(Other.mRenderQueue, nullptr)),
+          mOcclusionBuffer(std::exchange(Other.mOcclusionBuffer, nullptr)),
+          mCommandStream(std::move(Other.mCommandStream)),
+          mChunkStreams(std::move(Other.mChunkStreams)),
+          mViews(std::move(Other.mViews)),
+          mFrustums(std::move(Other.mFrustums)),
+          mSlotVisibility(std::move(Other.mSlotVisibility)),
+          mVisibleSlots(std::move(Other.mVisibleSlots)),
+          mScratchKeys(std::move(Other.mScratchKeys)),
+          mSpatialIndex(std::move(Other.mSpatialIndex)),
+          mOcclusionStats(Other.mOcclusionStats),
+          mUploadTicket(std::exchange(Other.mUploadTicket, 0)),
+          mWidth(Other.mWidth),
+          mHeight(Other.mHeight) {
         std::ranges::copy(Other.mClearColorRGBA, mClearColorRGBA);
     }
 
     Renderer& operator=(Renderer&& Other) noexcept {
         if (this != &Other) {
-            mRenderingObjects = std::exchange(Other.mRenderingObjects, {});
-            mRenderingOrder = std::exchange(Other.mRenderingOrder, {});
             mRootSignature = std::exchange(Other.mRootSignature, nullptr);
-            mScene = std::exchange(Other.mScene, nullptr);
-            mScissorRect = Other.mScissorRect;
-            mViewport = Other.mViewport;
+            mWorkerPool = std::exchange(Other.mWorkerPool, nullptr);
+            mRenderQueue = std::exchange(Other.mRenderQueue, nullptr);
+            mOcclusionBuffer = std::exchange(Other.mOcclusionBuffer, nullptr);
+            mCommandStream = std::move(Other.mCommandStream);
+            mChunkStreams = std::move(Other.mChunkStreams);
+            mViews = std::move(Other.mViews);
+            mFrustums = std::move(Other.mFrustums);
+            mSlotVisibility = std::move(Other.mSlotVisibility);
+            mVisibleSlots = std::move(Other.mVisibleSlots);
+            mScratchKeys = std::move(Other.mScratchKeys);
+            mSpatialIndex = std::move(Other.mSpatialIndex);
+            mOcclusionStats = Other.mOcclusionStats;
+            mUploadTicket = std::exchange(Other.mUploadTicket, 0);
+            mWidth = Other.mWidth;
+            mHeight = Other.mHeight;
             std::ranges::copy(Other.mClearColorRGBA, mClearColorRGBA);
         }
         return *this;
@@ -115,22 +122,90 @@ class Renderer {
     // Instance members
 
     /**
-     * Draws a frame.
+     * Draws a frame: records it into the command stream and translates the stream into the
+     * command list. The meshes have to be uploaded, see Draw(Device, Cmdl).
      * @param Cmdl Frame command list to record draw commands into.
      * @return true if the frame was successfully drawn, false otherwise.
      */
-    bool Draw(FrameCommandList10& Cmdl) const;
+    bool Draw(FrameCommandList10& Cmdl);
+
+    /**
+     * Draws a frame recording it on the worker pool: the sorted keys get split into chunks, each
+     * recorded into a command list of its own and submitted in order ahead of the frame command
+     * list, which only ends the frame. Falls back to Draw(Cmdl) for the scenes too small to split.
+     * The direct queue first waits on the GPU for the uploads of the meshes drawn for the first
+     * time.
+     * @param Device The device to take the pooled command lists from and wait for the uploads on.
+     * @param Cmdl Frame command list ending the frame; submitted after the chunks.
+     * @return true if the frame was successfully drawn, false otherwise.
+     */
+    bool Draw(const Device& Device, FrameCommandList10& Cmdl);
+
+    /**
+     * Records the draw commands of a frame without touching the graphics API, e.g. to replay them
+     * with the NullCommandBackend.
+     * @param Stream The stream to append the commands to.
+     * @return true if the frame was successfully recorded, false otherwise.
+     */
+    bool Record(CommandStream& Stream) const;
 
     /**
-     * Main loop tick function.
-     * @param Cmdl Command list to record update commands into.
+     * Main loop tick function. Propagates the transforms, applies the scene changes to the render
+     * queue, culls the scene for all the views in one pass and distributes the sorted keys into
+     * the views that see them; only those get drawn. The views with the occlusion culling enabled
+     * then drop the keys of the objects hidden behind their occluders. Records nothing on the GPU.
      * @param DeltaTime Time elapsed since last tick in seconds.
      * @return True if the renderer should continue running, false to exit.
      */
-    bool Update(CommandList10& Cmdl, float DeltaTime);
+    bool Update(float DeltaTime);
 
+    /**
+     * Resizes the views to the render target size.
+     */
     void Resize(uint32_t Width, uint32_t Height);
 
+    /**
+     * Adds a view drawn after the existing ones, e.g. the other half of a split screen.
+     * @param View The view; its rectangle gets mapped onto the current render target size.
+     * @param OutViewIndex Output parameter that will be populated with the index of the view.
+     * @return true if the view was added, false if there are kMaxViewCount views already.
+     */
+    bool AddView(View&& View, uint32_t& OutViewIndex);
+
+    /**
+     * Returns the view, e.g. to move its camera. kMainViewIndex is there from the start.
+     */
+    View& GetView(uint32_t ViewIndex) {
+        return mViews[ViewIndex];
+    }
+
+    uint32_t GetViewCount() const {
+        return static_cast<uint32_t>(mViews.size());
+    }
+
+    /**
+     * Returns the spatial index over the world bounds of the rendering objects as of the last
+     * Update, e.g. for picking. The ids it returns are the rendering object ids, see
+     * GetObjectOwner.
+     */
+    const Bvh& GetSpatialIndex() const {
+        return mSpatialIndex;
+    }
+
+    /**
+     * Returns what the occlusion culling did in the last Update.
+     */
+    const OcclusionStats& GetOcclusionStats() const {
+        return mOcclusionStats;
+    }
+
+    /**
+     * Returns the node of the rendering object, nullptr if the object is gone.
+     */
+    Node* GetObjectOwner(uint32_t ObjectId) const {
+        return mRenderQueue->GetObject(ObjectId).GetOwner();
+    }
+
     // Getters/Setters
     void SetClearColorRGBA(float R, float G, float B, float A) {
         mClearColorRGBA[0] = R;
@@ -139,22 +214,94 @@ class Renderer {
         mClearColorRGBA[3] = A;
     }
 
+    /**
+     * Attaches the scene to the render queue. The scene stays attached until it gets replaced,
+     * its root node gets destroyed or the renderer goes away.
+     */
     void SetScene(Node& Scene) {
-        mScene = &Scene;
+        mRenderQueue->Attach(Scene);
     }
 
    private:
-    static WorldTransformVisitor sWorldTransformVisitor;
+    /**
+     * Records the range [Begin, End) of the keys of all the views one after another, e.g. a chunk
+     * of the frame.
+     */
+    bool RecordRange(CommandStream& Stream, size_t Begin, size_t End) const;
+
+    /**
+     * Records the draws of the view's keys [Begin, End) along with the pipeline state and the view
+     * constants they need, so that the range can be recorded on its own.
+     */
+    bool RecordKeys(CommandStream& Stream, const View& View, size_t Begin, size_t End) const;
+
+    /**
+     * Rasterizes the occluders among the view's keys into the occlusion buffer and drops the keys
+     * of the other objects whose world bounds are hidden behind them.
+     */
+    void CullOccluded(View& View);
+
+    /**
+     * Refreshes the mesh constants and the spatial index entry of the rendering object from the
+     * world transform and bounds of its node.
+     */
+    void RefreshObject(uint32_t ObjectId, const Node& Owner);
+
+    /**
+     * Returns the number of the keys of all the views.
+     */
+    size_t GetKeyCount() const;
+
+    /**
+     * Draws the run of keys [Begin, End) sharing the material and the mesh. With
+     * InstanceBinding::kStructuredBuffer, it's one instanced draw: the constants of the instances
+     * get packed into a structured buffer in the stream data, bound at InstanceRootParameter and
+     * indexed by SV_InstanceID. With InstanceBinding::kRootConstants, it's a draw per instance with
+     * its constants set as root constants at InstanceRootParameter. Without an instance root
+     * parameter, it's one instanced draw with no per-instance data.
+     */
+    void DrawInstances(CommandStream& Stream,
+                       InstanceBinding Binding,
+                       uint32_t InstanceRootParameter,
+                       const Mesh& Mesh,
+                       const RenderingKey* Begin,
+                       const RenderingKey* End) const;
 
     RootSignature* mRootSignature;
 
-    // Rendering cache
-    std::set<RenderingKey> mRenderingOrder{};
-    std::vector<RenderingObject> mRenderingObjects{};
+    // Owned
+    std::unique_ptr<WorkerPool> mWorkerPool;
+
+    // Owned; kept on the heap as the scene nodes point to it
+    std::unique_ptr<RenderQueue> mRenderQueue;
+
+    // Owned; shared by the views one after another
+    std::unique_ptr<OcclusionBuffer> mOcclusionBuffer;
+
+    // Reused every frame so the recording doesn't allocate
+    CommandStream mCommandStream;
+    std::vector<CommandStream> mChunkStreams;
+
+    // Drawn in order; kMainViewIndex first
+    std::vector<View> mViews;
+    // The frustum per view and the mask of the views seeing the slot per TransformStore slot
+    std::vector<Frustum> mFrustums;
+    std::vector<uint32_t> mSlotVisibility;
+    // The slots visible in any view, and the scratch space of sorting the keys of the views
+    std::vector<uint32_t> mVisibleSlots;
+    std::vector<RenderingKey> mScratchKeys;
+
+    // Kept in sync with the rendering objects by Update
+    Bvh mSpatialIndex;
+
+    OcclusionStats mOcclusionStats;
+
+    // The latest upload the meshes drawn for the first time since the last Draw wait for
+    UploadTicket mUploadTicket{0};
 
     float mClearColorRGBA[4];
-    Node* mScene;
 
-    D3D12_VIEWPORT mViewport;
-    RECT mScissorRect;
+    // The render target size
+    uint32_t mWidth{0};
+    uint32_t mHeight{0};
 };
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * The sort order puts the objects of the same pass, material and mesh next to each other, so each
+ * run of them gets drawn with a single instanced draw.
+ */
+struct RenderingKey {
+    union {
+        uint64_t value;
+        struct {
+            uint64_t mObjectId : 24;    // bits 0-23 (LSB - least significant bits)
+            uint64_t mMeshId : 16;      // bits 24-39
+            uint64_t mMaterialId : 20;  // bits 40-59
+            uint64_t mPass : 4;         // bits 60-63 (MSB - most significant bits)
+        };
+    };
+
+    /**
+     * Returns the pass, material and mesh bits; the keys with equal batches can be drawn together.
+     */
+    uint64_t GetBatch() const {
+        return value >> 24;
+    }
+
+    bool operator<(const RenderingKey& Other) const {
+        return value < Other.value;
+    }
+
+    bool operator==(const RenderingKey& Other) const {
+        return value == Other.value;
+    }
+};
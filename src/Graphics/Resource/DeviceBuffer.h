@@ -1,16 +1,45 @@
 ﻿#pragma once
 
+#include "HeapAllocator.h"
 #include "Resource.h"
+#include "ResourceReleaser.h"
+#include "UploadTicket.h"
 
 class DeviceBuffer : public Resource {
    public:
     DeviceBuffer(D3D12_HEAP_TYPE Type,
                  D3D12_RESOURCE_STATES State,
                  size_t _265byteAlignedBufferSize,
-                 Microsoft::WRL::ComPtr<ID3D12Resource2> pResource)
-        : Resource(State, std::move(pResource)), mType(Type), mSize(_265byteAlignedBufferSize) {}
+                 Microsoft::WRL::ComPtr<ID3D12Resource2> pResource,
+                 ResourceReleaser* Releaser = nullptr)
+        : Resource(State, std::move(pResource)),
+          mType(Type),
+          mSize(_265byteAlignedBufferSize),
+          mReleaser(Releaser) {}
 
-    virtual ~DeviceBuffer() = default;
+    /**
+     * A buffer placed in a heap of the HeapAllocator, or packed into one of its page buffers; the
+     * heap range gets freed with the buffer.
+     */
+    DeviceBuffer(D3D12_HEAP_TYPE Type,
+                 D3D12_RESOURCE_STATES State,
+                 size_t _265byteAlignedBufferSize,
+                 Microsoft::WRL::ComPtr<ID3D12Resource2> pResource,
+                 ResourceReleaser* Releaser,
+                 HeapAllocator* HeapAllocator,
+                 const HeapAllocation& HeapAllocation)
+        : Resource(State,
+                   std::move(pResource),
+                   HeapAllocation.Buffer ? HeapAllocation.Offset : 0),
+          mType(Type),
+          mSize(_265byteAlignedBufferSize),
+          mReleaser(Releaser),
+          mHeapAllocator(HeapAllocator),
+          mHeapAllocation(HeapAllocation) {}
+
+    virtual ~DeviceBuffer() {
+        ReleaseResource();
+    }
 
     // Prohibit copying
     DeviceBuffer(const DeviceBuffer& other) = delete;
@@ -20,14 +49,24 @@ class DeviceBuffer : public Resource {
     DeviceBuffer(DeviceBuffer&& other) noexcept
         : Resource(std::move(other)),
           mType(std::exchange(other.mType, D3D12_HEAP_TYPE_DEFAULT)),
-          mSize(std::exchange(other.mSize, 0)) {}
+          mSize(std::exchange(other.mSize, 0)),
+          mReleaser(std::exchange(other.mReleaser, nullptr)),
+          mHeapAllocator(std::exchange(other.mHeapAllocator, nullptr)),
+          mHeapAllocation(std::exchange(other.mHeapAllocation, {})),
+          mUploadTicket(std::exchange(other.mUploadTicket, 0)) {}
 
     // Move assignment operator
     DeviceBuffer& operator=(DeviceBuffer&& other) noexcept {
         if (this != &other) {
+            ReleaseResource();
+
             // Handle only the derived class's own members
             mType = std::exchange(other.mType, D3D12_HEAP_TYPE_DEFAULT);
             mSize = std::exchange(other.mSize, 0);
+            mReleaser = std::exchange(other.mReleaser, nullptr);
+            mHeapAllocator = std::exchange(other.mHeapAllocator, nullptr);
+            mHeapAllocation = std::exchange(other.mHeapAllocation, {});
+            mUploadTicket = std::exchange(other.mUploadTicket, 0);
 
             // Call parent's move assignment operator to handle inherited members
             Resource::operator=(std::move(other));
@@ -40,7 +79,52 @@ class DeviceBuffer : public Resource {
         return mSize;
     }
 
+    /**
+     * Returns the offset of the buffer into its resource; non-zero for a buffer packed into a page
+     * buffer, which GetResource() returns.
+     */
+    uint64_t GetResourceOffset() const {
+        return mHeapAllocation.Buffer ? mHeapAllocation.Offset : 0;
+    }
+
+    /**
+     * Returns the ticket of the last upload into the buffer, 0 if there's none. The buffer's
+     * release waits for it on top of the direct queue.
+     */
+    UploadTicket GetUploadTicket() const {
+        return mUploadTicket;
+    }
+
+    void SetUploadTicket(UploadTicket Ticket) {
+        mUploadTicket = Ticket;
+    }
+
    protected:
+    /**
+     * Hands the resource and its heap range over to the releaser, so they outlive the GPU work
+     * using them. Without a releaser, they get released right away.
+     */
+    void ReleaseResource() {
+        if (mReleaser && mD3DResource) {
+            mReleaser->Release(std::move(mD3DResource), mHeapAllocator, mHeapAllocation,
+                               mUploadTicket);
+        } else if (mHeapAllocator) {
+            // The placed resource has to go before its memory gets reused
+            mD3DResource.Reset();
+            mHeapAllocator->Free(mHeapAllocation);
+        }
+        mHeapAllocator = nullptr;
+    }
+
     D3D12_HEAP_TYPE mType;
     size_t mSize;
+
+    // Not-owning; nullptr if the resource gets released right away
+    ResourceReleaser* mReleaser{nullptr};
+
+    // Not-owning; nullptr for the committed buffers
+    HeapAllocator* mHeapAllocator{nullptr};
+    HeapAllocation mHeapAllocation;
+
+    UploadTicket mUploadTicket{0};
 };
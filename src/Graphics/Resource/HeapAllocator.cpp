@@ -0,0 +1,88 @@
+#include "HeapAllocator.h"
+
+#include "Logging/Logging.h"
+
+using Suballocator = HeapSuballocator<HeapAllocator>;
+
+static_assert(Suballocator::kPlacementAlignment == D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+static_assert(Suballocator::kPackedAlignment == D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+bool HeapAllocator::Allocate(uint64_t Size, bool CanPack, HeapAllocation& OutAllocation) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    HeapRange range;
+    if (!mSuballocator.Allocate(Size, CanPack, range)) {
+        LOG_ERROR(L"Failed to allocate %llu bytes of heap memory.\n", Size);
+        return false;
+    }
+
+    OutAllocation = {};
+    if (range.IsPacked()) {
+        OutAllocation.Buffer = mPages[range.PageIndex].Get();
+    } else {
+        OutAllocation.Heap = mHeaps[range.BlockIndex].Get();
+    }
+    OutAllocation.Offset = range.Range.Offset;
+    OutAllocation.Range = range;
+    return true;
+}
+
+void HeapAllocator::Free(const HeapAllocation& Allocation) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSuballocator.Free(Allocation.Range);
+}
+
+void HeapAllocator::GetStats(HeapStats& OutStats) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSuballocator.GetStats(OutStats);
+}
+
+bool HeapAllocator::CreateBlock(uint32_t BlockIndex) {
+    D3D12_HEAP_DESC heapDesc{};
+    heapDesc.SizeInBytes = kHeapBlockSize;
+    heapDesc.Properties = CD3DX12_HEAP_PROPERTIES{mType};
+    heapDesc.Alignment = Suballocator::kPlacementAlignment;
+    // Resource heap tier 1 hardware can't mix buffers with textures in a heap
+    heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+
+    Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+    if (FAILED(mD3DDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap)))) {
+        LOG_ERROR(L"Failed to create a heap block of %llu bytes.\n", kHeapBlockSize);
+        return false;
+    }
+    heap->SetName(L"BufferHeapBlock");
+
+    if (BlockIndex == mHeaps.size()) {
+        mHeaps.emplace_back();
+    }
+    mHeaps[BlockIndex] = std::move(heap);
+    return true;
+}
+
+void HeapAllocator::ReleaseBlock(uint32_t BlockIndex) {
+    mHeaps[BlockIndex].Reset();
+}
+
+bool HeapAllocator::CreatePage(uint32_t PageIndex, uint32_t BlockIndex, uint64_t Offset) {
+    // The packed buffers stay in the COMMON state, the page decays back to it after every use
+    const CD3DX12_RESOURCE_DESC desc{CD3DX12_RESOURCE_DESC::Buffer(Suballocator::kPageSize)};
+    Microsoft::WRL::ComPtr<ID3D12Resource2> page;
+    if (FAILED(mD3DDevice->CreatePlacedResource(mHeaps[BlockIndex].Get(), Offset, &desc,
+                                                D3D12_RESOURCE_STATE_COMMON, nullptr,
+                                                IID_PPV_ARGS(&page)))) {
+        LOG_ERROR(L"Failed to create a packed buffer page of %llu bytes.\n",
+                  Suballocator::kPageSize);
+        return false;
+    }
+    page->SetName(L"PackedBufferPage");
+
+    if (PageIndex == mPages.size()) {
+        mPages.emplace_back();
+    }
+    mPages[PageIndex] = std::move(page);
+    return true;
+}
+
+void HeapAllocator::ReleasePage(uint32_t PageIndex) {
+    mPages[PageIndex].Reset();
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Includes/ComIncl.h"
+#include "Includes/GraphicsIncl.h"
+#include "Memory/HeapSuballocator.h"
+
+/**
+ * The memory of a buffer: a range of an ID3D12Heap to place the buffer at, or a range of a shared
+ * buffer resource for a packed buffer.
+ */
+struct HeapAllocation {
+    // The heap to place the buffer in; nullptr for a packed buffer
+    ID3D12Heap* Heap{nullptr};
+    // The resource a packed buffer is a range of; nullptr for a placed buffer
+    ID3D12Resource2* Buffer{nullptr};
+    // The offset into the heap, or into the resource of a packed buffer
+    uint64_t Offset{0};
+    HeapRange Range;
+};
+
+/**
+ * Suballocates the buffers of one heap type out of large ID3D12Heap blocks, so creating a buffer
+ * costs a CreatePlacedResource call instead of an OS-level allocation per CreateCommittedResource.
+ * The HeapSuballocator does the bookkeeping; the allocator creates the heap blocks and the page
+ * buffers it asks for.
+ *
+ * Buffers get placed at D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT (64KB) boundaries as D3D12
+ * requires for the placed buffers. The small ones that stay in the COMMON state get packed as
+ * ranges of shared page buffers instead, so they don't take 64KB each; they rely on the implicit
+ * state promotion and decay of the buffers, which are per range on every queue.
+ */
+class HeapAllocator {
+   public:
+    // The size of a heap block; larger buffers don't get placed
+    static constexpr uint64_t kHeapBlockSize = HeapSuballocator<HeapAllocator>::kBlockSize;
+
+    HeapAllocator(ID3D12Device14* D3DDevice, D3D12_HEAP_TYPE Type)
+        : mD3DDevice(D3DDevice), mType(Type), mSuballocator(*this) {}
+
+    ~HeapAllocator() = default;
+
+    // Prohibit copying and moving as the buffers hold a pointer to their allocator
+    HeapAllocator(const HeapAllocator&) = delete;
+    HeapAllocator& operator=(const HeapAllocator&) = delete;
+    HeapAllocator(HeapAllocator&&) = delete;
+    HeapAllocator& operator=(HeapAllocator&&) = delete;
+
+    /**
+     * Allocates the memory of a buffer.
+     *
+     * @param Size The size of the buffer in bytes; up to kHeapBlockSize.
+     * @param CanPack Whether the buffer can share its resource with other buffers, see
+     * HeapSuballocator::Allocate.
+     * @param OutAllocation Output parameter that will be populated with the range on success.
+     * Unchanged on failure.
+     * @return true if the range was allocated, false if a new heap block or page failed to be
+     * created.
+     */
+    bool Allocate(uint64_t Size, bool CanPack, HeapAllocation& OutAllocation);
+
+    /**
+     * Frees the range. The buffer placed at it has to be released already.
+     */
+    void Free(const HeapAllocation& Allocation);
+
+    D3D12_HEAP_TYPE GetType() const {
+        return mType;
+    }
+
+    void GetStats(HeapStats& OutStats) const;
+
+   private:
+    friend class HeapSuballocator<HeapAllocator>;
+
+    // The backend of the HeapSuballocator
+    bool CreateBlock(uint32_t BlockIndex);
+    void ReleaseBlock(uint32_t BlockIndex);
+    bool CreatePage(uint32_t PageIndex, uint32_t BlockIndex, uint64_t Offset);
+    void ReleasePage(uint32_t PageIndex);
+
+    // Not-owning
+    ID3D12Device14* mD3DDevice;
+    D3D12_HEAP_TYPE mType;
+
+    // Buffers get created and released from any thread
+    mutable std::mutex mMutex;
+
+    HeapSuballocator<HeapAllocator> mSuballocator;
+
+    // By the block and page indices of the suballocator; the released ones stay as empty entries
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Heap>> mHeaps;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource2>> mPages;
+};
@@ -0,0 +1,75 @@
+#include "NullUploadBackend.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Logging/Logging.h"
+
+bool NullUploadBackend::CreateStagingBuffer(size_t Size,
+                                            StagingBuffer& OutBuffer,
+                                            std::byte*& OutMappedPtr) {
+    if (mIsStagingFailing) {
+        return false;
+    }
+
+    StagingBuffer buffer = std::make_shared<std::vector<std::byte>>(Size);
+    mStagingBuffers.push_back(buffer);
+    OutMappedPtr = buffer->data();
+    OutBuffer = std::move(buffer);
+    return true;
+}
+
+bool NullUploadBackend::OpenBatch() {
+    if (mIsBatchFailing) {
+        return false;
+    }
+    if (mIsBatchOpen) {
+        LOG_ERROR(L"The previous upload batch hasn't been submitted.\n");
+        return false;
+    }
+
+    mIsBatchOpen = true;
+    return true;
+}
+
+void NullUploadBackend::RecordCopy(const StagingBuffer& From,
+                                   size_t FromOffset,
+                                   NullUploadBuffer& To,
+                                   size_t Size) {
+    if (!mIsBatchOpen) {
+        LOG_ERROR(L"Failed to record a copy outside of an upload batch.\n");
+        return;
+    }
+    mBatchCopies.push_back({From, FromOffset, &To, Size});
+}
+
+bool NullUploadBackend::SubmitBatch() {
+    if (!mIsBatchOpen) {
+        LOG_ERROR(L"Failed to submit an upload batch that isn't open.\n");
+        return false;
+    }
+
+    bool isValid = true;
+    for (const Copy& copy : mBatchCopies) {
+        if (copy.FromOffset + copy.Size > copy.From->size() || copy.Size > copy.To->Data.size()) {
+            LOG_ERROR(L"The copy of %zu bytes exceeds its buffers.\n", copy.Size);
+            isValid = false;
+            continue;
+        }
+        std::memcpy(copy.To->Data.data(), copy.From->data() + copy.FromOffset, copy.Size);
+        ++mCopyCount;
+        mCopiedSize += copy.Size;
+    }
+    mBatchCopies.clear();
+    mIsBatchOpen = false;
+
+    ++mBatchCount;
+    ++mSignaledValue;
+    return isValid;
+}
+
+size_t NullUploadBackend::GetLiveStagingBufferCount() const {
+    return std::count_if(
+        mStagingBuffers.begin(), mStagingBuffers.end(),
+        [](const std::weak_ptr<std::vector<std::byte>>& Buffer) { return !Buffer.expired(); });
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "UploadTicket.h"
+
+/**
+ * A destination buffer of the NullUploadBackend, in plain memory.
+ */
+struct NullUploadBuffer {
+    explicit NullUploadBuffer(size_t Size) : Data(Size) {}
+
+    void SetUploadTicket(UploadTicket Ticket) {
+        this->Ticket = Ticket;
+    }
+
+    std::vector<std::byte> Data;
+    UploadTicket Ticket{0};
+};
+
+/**
+ * An UploadBatcher backend without a GPU. The staging buffers are plain memory and the recorded
+ * copies get executed when their batch is submitted, so the uploads can be checked and profiled on
+ * a headless machine. Counts the staging buffers, the batches and the copies.
+ *
+ * The fence signals a value per submitted batch; the batches complete on Complete, the way a
+ * copy queue would catch up.
+ */
+class NullUploadBackend {
+   public:
+    using StagingBuffer = std::shared_ptr<std::vector<std::byte>>;
+    using Destination = NullUploadBuffer;
+
+    NullUploadBackend() = default;
+
+    // Prohibit copying
+    NullUploadBackend(const NullUploadBackend&) = delete;
+    NullUploadBackend& operator=(const NullUploadBackend&) = delete;
+
+    bool CreateStagingBuffer(size_t Size, StagingBuffer& OutBuffer, std::byte*& OutMappedPtr);
+    bool OpenBatch();
+    void RecordCopy(const StagingBuffer& From,
+                    size_t FromOffset,
+                    NullUploadBuffer& To,
+                    size_t Size);
+    bool SubmitBatch();
+
+    uint64_t GetNextFenceValue() const {
+        return mSignaledValue + 1;
+    }
+
+    uint64_t GetCompletedFenceValue() const {
+        return mCompletedValue;
+    }
+
+    /**
+     * Completes the submitted batches up to the fence value.
+     */
+    void Complete(uint64_t FenceValue) {
+        mCompletedValue = FenceValue < mSignaledValue ? FenceValue : mSignaledValue;
+    }
+
+    /**
+     * Makes the staging buffers and the batches fail to be created, e.g. to test the error paths.
+     */
+    void SetFailures(bool IsStagingFailing, bool IsBatchFailing) {
+        mIsStagingFailing = IsStagingFailing;
+        mIsBatchFailing = IsBatchFailing;
+    }
+
+    size_t GetStagingBufferCount() const {
+        return mStagingBuffers.size();
+    }
+
+    /**
+     * Returns the number of the staging buffers the batcher still holds.
+     */
+    size_t GetLiveStagingBufferCount() const;
+
+    size_t GetBatchCount() const {
+        return mBatchCount;
+    }
+
+    size_t GetCopyCount() const {
+        return mCopyCount;
+    }
+
+    size_t GetCopiedSize() const {
+        return mCopiedSize;
+    }
+
+   private:
+    struct Copy {
+        StagingBuffer From;
+        size_t FromOffset;
+        NullUploadBuffer* To;
+        size_t Size;
+    };
+
+    // Tracked without keeping them alive
+    std::vector<std::weak_ptr<std::vector<std::byte>>> mStagingBuffers;
+
+    // The copies of the open batch
+    std::vector<Copy> mBatchCopies;
+    bool mIsBatchOpen{false};
+
+    uint64_t mSignaledValue{0};
+    uint64_t mCompletedValue{0};
+
+    size_t mBatchCount{0};
+    size_t mCopyCount{0};
+    size_t mCopiedSize{0};
+
+    bool mIsStagingFailing{false};
+    bool mIsBatchFailing{false};
+};
@@ -1,5 +1,8 @@
 ﻿#pragma once
 
+#include <memory>
+
+#include "Graphics/ResourceStateTracker.h"
 #include "Includes/ComIncl.h"
 #include "Includes/GraphicsIncl.h"
 
@@ -7,9 +10,15 @@ class Resource {
     friend class CommandList10;
 
    public:
-    Resource(D3D12_RESOURCE_STATES State, Microsoft::WRL::ComPtr<ID3D12Resource2>&& pD3DResource)
-        : mState(State),
-          mDeviceVirtualAddress(pD3DResource->GetGPUVirtualAddress()),
+    /**
+     * @param Offset The offset of a buffer into the resource it is a range of.
+     */
+    Resource(D3D12_RESOURCE_STATES State,
+             Microsoft::WRL::ComPtr<ID3D12Resource2>&& pD3DResource,
+             uint64_t Offset = 0)
+        : mState(std::make_unique<ResourceState>(
+              ResourceState{pD3DResource.Get(), static_cast<uint32_t>(State)})),
+          mDeviceVirtualAddress(pD3DResource->GetGPUVirtualAddress() + Offset),
           mD3DResource{std::move(pD3DResource)} {}
 
     virtual ~Resource() = default;
@@ -20,14 +29,14 @@ class Resource {
 
     // Allow moving
     Resource(Resource&& other) noexcept
-        : mState(std::exchange(other.mState, D3D12_RESOURCE_STATES_NULL)),
+        : mState(std::exchange(other.mState, nullptr)),
           mDeviceVirtualAddress(
               std::exchange(other.mDeviceVirtualAddress, D3D12_GPU_VIRTUAL_ADDRESS_NULL)),
           mD3DResource{std::exchange(other.mD3DResource, nullptr)} {}
 
     Resource& operator=(Resource&& other) noexcept {
         if (this != &other) {
-            mState = std::exchange(other.mState, D3D12_RESOURCE_STATES_NULL);
+            mState = std::exchange(other.mState, nullptr);
             mDeviceVirtualAddress =
                 std::exchange(other.mDeviceVirtualAddress, D3D12_GPU_VIRTUAL_ADDRESS_NULL);
             mD3DResource = std::exchange(other.mD3DResource, nullptr);
@@ -43,17 +52,22 @@ class Resource {
         return mD3DResource.Get();
     }
 
+    /**
+     * Returns the state of the resource as of the last submission; the command lists being
+     * recorded track their own.
+     */
     D3D12_RESOURCE_STATES GetCurrentState() const {
-        return mState;
+        return static_cast<D3D12_RESOURCE_STATES>(mState->State);
     }
 
-    void SetCurrentState(D3D12_RESOURCE_STATES NewState) {
-        mState = NewState;
+    ResourceState& GetState() const {
+        return *mState;
     }
 
    protected:
-    // The resource usage state
-    D3D12_RESOURCE_STATES mState;
+    // The resource usage state shared by the command lists; on the heap so that the command lists
+    // tracking it keep a valid address when the resource gets moved
+    std::unique_ptr<ResourceState> mState;
     D3D12_GPU_VIRTUAL_ADDRESS mDeviceVirtualAddress;
     Microsoft::WRL::ComPtr<ID3D12Resource2> mD3DResource;
 };
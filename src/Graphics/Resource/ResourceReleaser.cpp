@@ -0,0 +1,40 @@
+#include "ResourceReleaser.h"
+
+#include <limits>
+
+#include "Logging/Logging.h"
+#include "UploadManager.h"
+
+void ResourceReleaser::Release(Microsoft::WRL::ComPtr<ID3D12Resource2>&& Resource,
+                               HeapAllocator* HeapAllocator,
+                               const HeapAllocation& HeapAllocation,
+                               UploadTicket UploadTicket) {
+    const uint64_t fenceValue = mCommandQueue->GetNextFenceValue();
+    ReleasedResource resource(std::move(Resource), HeapAllocator, HeapAllocation);
+    if (UploadTicket == 0 || !mUploadManager || mUploadManager->IsComplete(UploadTicket)) {
+        mQueue.Enqueue(fenceValue, std::move(resource));
+        return;
+    }
+
+    // The copy may still sit in the open batch, which would hold the resource until the next
+    // Submit
+    if (!mUploadManager->Submit(UploadTicket)) {
+        LOG_ERROR(L"Failed to submit the upload batch of a released resource.\n");
+    }
+    mCopyStage.Enqueue(UploadTicket, {fenceValue, std::move(resource)});
+}
+
+size_t ResourceReleaser::Collect() {
+    // Without the upload manager the copy queue is idle
+    const UploadTicket completedTicket = mUploadManager ? mUploadManager->GetCompletedTicket()
+                                                        : std::numeric_limits<UploadTicket>::max();
+
+    // The resources whose copies have completed go on to wait for the queue
+    mCopyStage.Take(completedTicket, mCopiedResources);
+    for (PendingCopy& copied : mCopiedResources) {
+        mQueue.Enqueue(copied.FenceValue, std::move(copied.Resource));
+    }
+    mCopiedResources.clear();
+
+    return mQueue.Release(mCommandQueue->GetCompletedFenceValue());
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Graphics/CommandQueue.h"
+#include "Graphics/DeferredReleaseQueue.h"
+#include "HeapAllocator.h"
+#include "Includes/ComIncl.h"
+#include "Includes/GraphicsIncl.h"
+#include "UploadTicket.h"
+
+// Forward declarations
+class UploadManager;
+
+/**
+ * A resource parked in the ResourceReleaser along with the heap range it's placed at. Destroying
+ * it releases the resource and then frees the range.
+ */
+class ReleasedResource {
+   public:
+    ReleasedResource(Microsoft::WRL::ComPtr<ID3D12Resource2>&& Resource,
+                     HeapAllocator* HeapAllocator,
+                     const HeapAllocation& HeapAllocation)
+        : mResource(std::move(Resource)),
+          mHeapAllocator(HeapAllocator),
+          mHeapAllocation(HeapAllocation) {}
+
+    ~ReleasedResource() {
+        mResource.Reset();
+        if (mHeapAllocator) {
+            mHeapAllocator->Free(mHeapAllocation);
+        }
+    }
+
+    // Prohibit copying
+    ReleasedResource(const ReleasedResource&) = delete;
+    ReleasedResource& operator=(const ReleasedResource&) = delete;
+
+    // Allow moving
+    ReleasedResource(ReleasedResource&& other) noexcept
+        : mResource(std::exchange(other.mResource, nullptr)),
+          mHeapAllocator(std::exchange(other.mHeapAllocator, nullptr)),
+          mHeapAllocation(std::exchange(other.mHeapAllocation, {})) {}
+
+    ReleasedResource& operator=(ReleasedResource&& other) noexcept {
+        if (this != &other) {
+            mResource = std::exchange(other.mResource, nullptr);
+            mHeapAllocator = std::exchange(other.mHeapAllocator, nullptr);
+            mHeapAllocation = std::exchange(other.mHeapAllocation, {});
+        }
+        return *this;
+    }
+
+   private:
+    Microsoft::WRL::ComPtr<ID3D12Resource2> mResource;
+
+    // Not-owning; nullptr for the committed resources
+    HeapAllocator* mHeapAllocator;
+    HeapAllocation mHeapAllocation;
+};
+
+/**
+ * Defers the release of the destroyed buffers until the GPU is done with them, so scene content
+ * can be torn down at runtime without waiting for the queue to go idle.
+ *
+ * A released resource is parked until the fence value of the queue's next submission completes.
+ * That covers all the work submitted so far and the command list being recorded, as long as the
+ * latter is the next one to be executed.
+ *
+ * The buffers written by the copy queue of the UploadManager may still have their copy pending on
+ * another timeline. Those wait for their upload ticket first and only then for the fence value of
+ * the queue, so the heap range isn't reused under a running copy:
+ *
+ *   Release(A, ticket 8) at fence 5 -> copy stage until ticket 8, then direct stage until fence 5
+ */
+class ResourceReleaser {
+   public:
+    explicit ResourceReleaser(CommandQueue& CommandQueue) : mCommandQueue(&CommandQueue) {}
+
+    // Prohibit copying and moving as the buffers hold a pointer to the releaser
+    ResourceReleaser(const ResourceReleaser&) = delete;
+    ResourceReleaser& operator=(const ResourceReleaser&) = delete;
+    ResourceReleaser(ResourceReleaser&&) = delete;
+    ResourceReleaser& operator=(ResourceReleaser&&) = delete;
+
+    /**
+     * Sets the upload manager whose copies write the buffers; nullptr once it's gone, as its copy
+     * queue is idle by then.
+     */
+    void SetUploadManager(UploadManager* UploadManager) {
+        mUploadManager = UploadManager;
+    }
+
+    /**
+     * Parks the resource and its heap range until the GPU is done with them.
+     * @param UploadTicket The ticket of the last upload into the resource, 0 if there's none. The
+     * batch of a pending ticket gets submitted, so that the resource doesn't wait for it forever.
+     */
+    void Release(Microsoft::WRL::ComPtr<ID3D12Resource2>&& Resource,
+                 HeapAllocator* HeapAllocator,
+                 const HeapAllocation& HeapAllocation,
+                 UploadTicket UploadTicket = 0);
+
+    /**
+     * Releases the resources the GPU is done with; called once per frame.
+     * @return The number of resources released.
+     */
+    size_t Collect();
+
+    /**
+     * Releases all the parked resources; the queues have to be idle.
+     * @return The number of resources released.
+     */
+    size_t CollectAll() {
+        return mCopyStage.ReleaseAll() + mQueue.ReleaseAll();
+    }
+
+    size_t GetPendingCount() const {
+        return mCopyStage.GetSize() + mQueue.GetSize();
+    }
+
+   private:
+    // A resource waiting for its copy, along with the fence value it waits for next
+    struct PendingCopy {
+        uint64_t FenceValue;
+        ReleasedResource Resource;
+    };
+
+    // Not-owning
+    CommandQueue* mCommandQueue;
+    UploadManager* mUploadManager{nullptr};
+
+    // By the upload ticket, then by the fence value of the queue
+    DeferredReleaseQueue<PendingCopy> mCopyStage;
+    DeferredReleaseQueue<ReleasedResource> mQueue;
+
+    // Reused by Collect
+    std::vector<PendingCopy> mCopiedResources;
+};
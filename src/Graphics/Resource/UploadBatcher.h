@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "Graphics/DeferredReleaseQueue.h"
+#include "Memory/StreamingCopy.h"
+#include "UploadTicket.h"
+
+/**
+ * The data to copy into a buffer, at offset 0.
+ */
+template <typename D>
+struct BasicUploadRequest {
+    // Gets the ticket of the upload recorded, see DeviceBuffer::GetUploadTicket
+    D* Destination;
+    const void* Data;
+    size_t Size;
+};
+
+/**
+ * The staging and batching of the uploads, with no graphics API. The uploads get staged in
+ * persistently mapped pages and their copies recorded into one open batch, submitted on Submit or
+ * once the batch grows large. Every upload returns the ticket of its batch: the fence value the
+ * batch signals.
+ *
+ * The backend T owns the copy queue:
+ *   using StagingBuffer = ...;  // a movable, persistently mapped upload buffer
+ *   using Destination = ...;    // a buffer with SetUploadTicket(UploadTicket)
+ *   bool CreateStagingBuffer(size_t Size, StagingBuffer& OutBuffer, std::byte*& OutMappedPtr);
+ *   bool OpenBatch();
+ *   void RecordCopy(const StagingBuffer& From, size_t FromOffset, Destination& To, size_t Size);
+ *   bool SubmitBatch();  // signals GetNextFenceValue()
+ *   uint64_t GetNextFenceValue() const;
+ *   uint64_t GetCompletedFenceValue() const;
+ * Only the batcher submits to the queue. Thread-safe.
+ */
+template <typename T>
+class UploadBatcher {
+   public:
+    using Request = BasicUploadRequest<typename T::Destination>;
+
+    // The size of the staging pages; larger uploads get a page of their own
+    static constexpr size_t kStagingPageSize = 4 * 1024 * 1024;
+
+    // The staged size a batch gets submitted at without waiting for Submit
+    static constexpr size_t kMaxBatchSize = 64 * 1024 * 1024;
+
+    // The alignment of the uploads within a staging page
+    static constexpr size_t kStagingAlignment = 16;
+
+    explicit UploadBatcher(T& Backend) : mBackend(&Backend) {}
+
+    // Prohibit copying
+    UploadBatcher(const UploadBatcher&) = delete;
+    UploadBatcher& operator=(const UploadBatcher&) = delete;
+
+    /**
+     * Stages the data of all the requests in one staging allocation and records their copies into
+     * the open batch, so they complete together under one ticket.
+     *
+     * @param Requests The uploads.
+     * @param OutTicket Output parameter that will be populated with the ticket of the batch on
+     * success, 0 if there's no data to upload. Unchanged on failure.
+     * @return true if the uploads were recorded, false otherwise.
+     */
+    bool UploadBatch(std::span<const Request> Requests, UploadTicket& OutTicket);
+
+    /**
+     * Submits the open batch, if any.
+     */
+    bool Submit() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return SubmitLocked();
+    }
+
+    /**
+     * Submits the batch of the ticket if it's still open.
+     */
+    bool Submit(UploadTicket Ticket) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mBatchSize > 0 && Ticket >= mBackend->GetNextFenceValue()) {
+            return SubmitLocked();
+        }
+        return true;
+    }
+
+    /**
+     * Releases the staging pages of the completed batches.
+     */
+    void Collect() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRetiredPages.Release(mBackend->GetCompletedFenceValue());
+    }
+
+    /**
+     * Releases the staging pages of all the submitted batches; the queue has to be idle.
+     */
+    void ReleaseAll() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRetiredPages.ReleaseAll();
+    }
+
+    /** The number of batches submitted so far. */
+    uint64_t GetSubmitCount() const {
+        return mSubmitCount;
+    }
+
+    /** The number of staging pages created so far. */
+    uint64_t GetStagingPageCount() const {
+        return mStagingPageCount;
+    }
+
+   private:
+    struct StagingPage {
+        typename T::StagingBuffer Buffer;
+        std::byte* MappedPtr{nullptr};
+        size_t Size{0};
+        size_t UsedSize{0};
+    };
+
+    static size_t AlignStaging(size_t Size) {
+        return (Size + kStagingAlignment - 1) & ~(kStagingAlignment - 1);
+    }
+
+    bool AllocateStaging(size_t Size, StagingPage*& OutPage, size_t& OutOffset);
+    bool SubmitLocked();
+
+    // Not-owning
+    T* mBackend;
+
+    // Guards the open batch
+    std::mutex mMutex;
+    std::vector<StagingPage> mBatchPages;
+    size_t mBatchSize{0};
+
+    uint64_t mSubmitCount{0};
+    uint64_t mStagingPageCount{0};
+
+    // The pages of the submitted batches until the queue is done with them
+    DeferredReleaseQueue<StagingPage> mRetiredPages;
+};
+
+template <typename T>
+bool UploadBatcher<T>::UploadBatch(std::span<const Request> Requests, UploadTicket& OutTicket) {
+    // Pack the uploads back to back into one staging allocation
+    size_t stagingSize = 0;
+    for (const Request& request : Requests) {
+        stagingSize += AlignStaging(request.Size);
+    }
+
+    if (stagingSize == 0) {
+        // Nothing to wait for
+        OutTicket = 0;
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    StagingPage* page;
+    size_t offset;
+    if (!AllocateStaging(stagingSize, page, offset)) {
+        return false;
+    }
+
+    // Open the batch with its first upload
+    if (mBatchSize == 0 && !mBackend->OpenBatch()) {
+        return false;
+    }
+
+    for (const Request& request : Requests) {
+        if (request.Size == 0) {
+            continue;
+        }
+
+        StreamingCopy(page->MappedPtr + offset, request.Data, request.Size);
+        mBackend->RecordCopy(page->Buffer, offset, *request.Destination, request.Size);
+        offset += AlignStaging(request.Size);
+    }
+    mBatchSize += stagingSize;
+
+    // Only the batcher submits to the queue, so the open batch signals the next value
+    OutTicket = mBackend->GetNextFenceValue();
+    for (const Request& request : Requests) {
+        if (request.Size != 0) {
+            request.Destination->SetUploadTicket(OutTicket);
+        }
+    }
+
+    if (mBatchSize >= kMaxBatchSize) {
+        return SubmitLocked();
+    }
+    return true;
+}
+
+template <typename T>
+bool UploadBatcher<T>::AllocateStaging(size_t Size, StagingPage*& OutPage, size_t& OutOffset) {
+    if (!mBatchPages.empty()) {
+        StagingPage& page = mBatchPages.back();
+        const size_t offset = AlignStaging(page.UsedSize);
+        if (offset + Size <= page.Size) {
+            page.UsedSize = offset + Size;
+            OutPage = &page;
+            OutOffset = offset;
+            return true;
+        }
+    }
+
+    StagingPage page;
+    page.Size = std::max(Size, kStagingPageSize);
+    if (!mBackend->CreateStagingBuffer(page.Size, page.Buffer, page.MappedPtr)) {
+        return false;
+    }
+    page.UsedSize = Size;
+    ++mStagingPageCount;
+
+    OutPage = &mBatchPages.emplace_back(std::move(page));
+    OutOffset = 0;
+    return true;
+}
+
+template <typename T>
+bool UploadBatcher<T>::SubmitLocked() {
+    if (mBatchSize == 0) {
+        return true;
+    }
+
+    const uint64_t fenceValue = mBackend->GetNextFenceValue();
+    const bool isSubmitted = mBackend->SubmitBatch();
+    ++mSubmitCount;
+
+    // The pages get released once the queue is done reading them
+    for (StagingPage& page : mBatchPages) {
+        mRetiredPages.Enqueue(fenceValue, std::move(page));
+    }
+    mBatchPages.clear();
+    mBatchSize = 0;
+    return isSubmitted;
+}
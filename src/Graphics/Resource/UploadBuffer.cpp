@@ -1,10 +1,36 @@
 ﻿#include "UploadBuffer.h"
 
-#include <cstring>
+#include <cstddef>
 
 #include "Logging/Logging.h"
+#include "Memory/StreamingCopy.h"
+
+bool UploadBuffer::MapPersistent() {
+    if (mMappedPtr) {
+        return true;
+    }
+
+    // The CPU doesn't read the buffer back
+    const D3D12_RANGE readRange = CD3DX12_RANGE(0, 0);
+    if (FAILED(GetResource()->Map(0, &readRange, &mMappedPtr))) {
+        LOG_ERROR(L"Failed to map the upload buffer.\n");
+        mMappedPtr = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void UploadBuffer::Unmap() {
+    if (mMappedPtr) {
+        GetResource()->Unmap(0, nullptr);
+        mMappedPtr = nullptr;
+    }
+}
 
 BufferRange UploadBuffer::Map(size_t Offset, size_t Size) {
+    if (mMappedPtr) {
+        return BufferRange{static_cast<std::byte*>(mMappedPtr) + Offset, Size};
+    }
     return BufferRange{Offset, Size, this};
 }
 
@@ -17,12 +43,28 @@ bool UploadBuffer::UploadBytes(size_t Size, const void* data) {
     return bufferRange.UploadBytes(Size, data);
 }
 
+bool UploadBuffer::WriteBytes(size_t Offset, const void* Data, size_t Size) {
+    if (!mMappedPtr) {
+        LOG_ERROR(L"Upload buffer is not persistently mapped.\n");
+        return false;
+    }
+
+    if (Offset + Size > mSize) {
+        LOG_ERROR(L"Data of %zu bytes at offset %zu exceeds upload buffer size (%zu).\n", Size,
+                  Offset, mSize);
+        return false;
+    }
+
+    StreamingCopy(static_cast<std::byte*>(mMappedPtr) + Offset, Data, Size);
+    return true;
+}
+
 bool BufferRange::UploadBytes(size_t size, const void* data) const {
     if (size > mSize) {
         LOG_ERROR(L"Data size (%zu) exceeds upload buffer size (%zu).\n", size, mSize);
         return false;
     }
 
-    memcpy(mPtr, data, size);
+    StreamingCopy(mPtr, data, size);
     return true;
 }
\ No newline at end of file
@@ -8,7 +8,8 @@
 class BufferRange;
 
 /**
- * UploadBuffer CPU bound buffer class. Can map a region of the buffer for writing.
+ * UploadBuffer CPU bound buffer class. Can map a region of the buffer for writing, or stay mapped
+ * for its whole lifetime, which upload heaps allow, so the writes skip the Map/Unmap calls.
  */
 class UploadBuffer : public DeviceBuffer {
     friend BufferRange;
@@ -17,25 +18,86 @@ class UploadBuffer : public DeviceBuffer {
     UploadBuffer(D3D12_HEAP_TYPE Type,
                  D3D12_RESOURCE_STATES State,
                  size_t _265byteAlignedBufferSize,
-                 Microsoft::WRL::ComPtr<ID3D12Resource2> pResource)
-        : DeviceBuffer(Type, State, _265byteAlignedBufferSize, std::move(pResource)) {}
+                 Microsoft::WRL::ComPtr<ID3D12Resource2> pResource,
+                 ResourceReleaser* Releaser = nullptr)
+        : DeviceBuffer(Type, State, _265byteAlignedBufferSize, std::move(pResource), Releaser) {}
+
+    UploadBuffer(D3D12_HEAP_TYPE Type,
+                 D3D12_RESOURCE_STATES State,
+                 size_t _265byteAlignedBufferSize,
+                 Microsoft::WRL::ComPtr<ID3D12Resource2> pResource,
+                 ResourceReleaser* Releaser,
+                 HeapAllocator* HeapAllocator,
+                 const HeapAllocation& HeapAllocation)
+        : DeviceBuffer(Type,
+                       State,
+                       _265byteAlignedBufferSize,
+                       std::move(pResource),
+                       Releaser,
+                       HeapAllocator,
+                       HeapAllocation) {}
 
     // Prohibit copying
     UploadBuffer(UploadBuffer& other) = delete;
     UploadBuffer& operator=(UploadBuffer& other) = delete;
 
+    ~UploadBuffer() override {
+        Unmap();
+    }
+
     // Allow moving
-    UploadBuffer(UploadBuffer&& other) = default;
-    UploadBuffer& operator=(UploadBuffer&& other) = default;
+    UploadBuffer(UploadBuffer&& other) noexcept
+        : DeviceBuffer(std::move(other)), mMappedPtr(std::exchange(other.mMappedPtr, nullptr)) {}
+
+    UploadBuffer& operator=(UploadBuffer&& other) noexcept {
+        if (this != &other) {
+            Unmap();
+
+            // Handle only the derived class's own members
+            mMappedPtr = std::exchange(other.mMappedPtr, nullptr);
+
+            // Call parent's move assignment operator to handle inherited members
+            DeviceBuffer::operator=(std::move(other));
+        }
+        return *this;
+    }
+
+    /**
+     * Maps the whole buffer until it's destroyed. Does nothing if it's mapped already.
+     * @return true if the buffer is mapped, false otherwise.
+     */
+    bool MapPersistent();
+
+    /**
+     * Returns the CPU address of the persistently mapped buffer, stable for its lifetime; nullptr
+     * unless MapPersistent has been called.
+     */
+    void* GetMappedPtr() const {
+        return mMappedPtr;
+    }
 
     /**
      * Maps a range of the buffer and returns a BufferRange object that will unmap it when it goes
-     * out of scope.
+     * out of scope. A persistently mapped buffer hands out its mapped range without calling into
+     * the driver.
      */
     BufferRange Map(size_t Offset, size_t Size);
     BufferRange Map();
 
     bool UploadBytes(size_t Size, const void* data);
+
+    /**
+     * Writes the data into the persistently mapped buffer with streaming stores, see
+     * StreamingCopy.
+     * @return true if the data was written, false if the buffer isn't mapped or is too small.
+     */
+    bool WriteBytes(size_t Offset, const void* Data, size_t Size);
+
+   private:
+    void Unmap();
+
+    // Persistently mapped memory; nullptr if unmapped
+    void* mMappedPtr{nullptr};
 };
 
 /**
@@ -50,6 +112,11 @@ class BufferRange {
         Buffer->GetResource()->Map(0, &mD3DRange, &mPtr);
     }
 
+    /**
+     * A range of memory mapped by someone else, e.g. a persistently mapped buffer; not unmapped.
+     */
+    BufferRange(void* Ptr, size_t Size) : mSize(Size), mD3DRange{}, mPtr(Ptr) {}
+
     ~BufferRange() {
         if (mBuffer) {
             mBuffer->GetResource()->Unmap(0, &mD3DRange);
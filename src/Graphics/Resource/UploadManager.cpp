@@ -0,0 +1,108 @@
+#include "UploadManager.h"
+
+#include <cstddef>
+
+#include "Graphics/Device.h"
+#include "Logging/Logging.h"
+
+bool D3D12UploadBackend::CreateStagingBuffer(size_t Size,
+                                             StagingBuffer& OutBuffer,
+                                             std::byte*& OutMappedPtr) {
+    std::unique_ptr<UploadBuffer> buffer;
+    if (!mDevice->CreateBuffer(L"UploadStagingPage", D3D12_HEAP_TYPE_UPLOAD,
+                               D3D12_RESOURCE_STATE_GENERIC_READ, Size, buffer)) {
+        return false;
+    }
+
+    if (!buffer->MapPersistent()) {
+        return false;
+    }
+
+    OutMappedPtr = static_cast<std::byte*>(buffer->GetMappedPtr());
+    OutBuffer = std::move(buffer);
+    return true;
+}
+
+bool D3D12UploadBackend::OpenBatch() {
+    CommandAllocator* allocator;
+    if (!mAllocatorPool->Acquire(allocator)) {
+        LOG_ERROR(L"Failed to acquire a copy command allocator.\n");
+        return false;
+    }
+
+    ID3D12GraphicsCommandList10* d3dCommandList;
+    if (!allocator->GetID3D12CommandList(d3dCommandList)) {
+        LOG_ERROR(L"Failed to get a copy command list.\n");
+        mAllocatorPool->Release(allocator, 0);
+        return false;
+    }
+
+    mBatchList = CommandList10(mCopyQueue.get(), allocator, d3dCommandList, nullptr, 0, false,
+                               mAllocatorPool.get());
+    return true;
+}
+
+bool D3D12UploadBackend::SubmitBatch() {
+    if (!mBatchList.Submit()) {
+        LOG_ERROR(L"Failed to submit the upload batch.\n");
+        return false;
+    }
+    return true;
+}
+
+bool UploadManager::Create(Device& Device,
+                           ComPtr<ID3D12Device14>& D3DDevice,
+                           std::unique_ptr<UploadManager>& OutManager) {
+    std::unique_ptr<CommandQueue> copyQueue;
+    if (!Device::CreateCommandQueue(D3DDevice, D3D12_COMMAND_LIST_TYPE_COPY,
+                                    D3D12_COMMAND_QUEUE_PRIORITY_NORMAL,
+                                    D3D12_COMMAND_QUEUE_FLAG_NONE, D3D12_FENCE_FLAG_NONE,
+                                    copyQueue)) {
+        LOG_ERROR(L"Failed to create the copy Command Queue.\n");
+        return false;
+    }
+
+    auto allocatorPool =
+        std::make_unique<CommandAllocatorPool>(D3DDevice, *copyQueue, D3D12_COMMAND_LIST_TYPE_COPY);
+
+    OutManager =
+        std::make_unique<UploadManager>(Device, std::move(copyQueue), std::move(allocatorPool));
+    return true;
+}
+
+UploadManager::~UploadManager() {
+    // The staging pages have to outlive the copies reading them
+    Submit();
+    if (!mBackend.GetCopyQueue().WaitForIdle()) {
+        LOG_ERROR(L"Failed to wait on the copy queue.\n");
+    }
+    mBatcher.ReleaseAll();
+}
+
+bool UploadManager::UploadBatch(std::span<const UploadRequest> Requests,
+                                UploadTicket& OutTicket) {
+    if (!mBatcher.UploadBatch(Requests, OutTicket)) {
+        LOG_ERROR(L"Failed to record the upload of %zu buffers.\n", Requests.size());
+        return false;
+    }
+    return true;
+}
+
+bool UploadManager::Submit() {
+    return mBatcher.Submit();
+}
+
+bool UploadManager::Submit(UploadTicket Ticket) {
+    return mBatcher.Submit(Ticket);
+}
+
+bool UploadManager::WaitOnQueue(CommandQueue& Queue, UploadTicket Ticket) {
+    if (!Submit(Ticket)) {
+        return false;
+    }
+
+    if (IsComplete(Ticket)) {
+        return true;
+    }
+    return Queue.WaitForQueue(mBackend.GetCopyQueue(), Ticket);
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+
+#include "Graphics/CommandAllocatorPool.h"
+#include "Graphics/CommandList10.h"
+#include "Graphics/CommandQueue.h"
+#include "Includes/ComIncl.h"
+#include "Includes/GraphicsIncl.h"
+#include "UploadBatcher.h"
+#include "UploadBuffer.h"
+#include "UploadTicket.h"
+
+// Forward declarations
+class Device;
+
+/**
+ * The data to copy into a buffer, at offset 0.
+ */
+using UploadRequest = BasicUploadRequest<DeviceBuffer>;
+
+/**
+ * The copy queue the UploadBatcher of the UploadManager records and submits the batches to.
+ */
+class D3D12UploadBackend {
+   public:
+    using StagingBuffer = std::unique_ptr<UploadBuffer>;
+    using Destination = DeviceBuffer;
+
+    D3D12UploadBackend(Device& Device,
+                       std::unique_ptr<CommandQueue>&& CopyQueue,
+                       std::unique_ptr<CommandAllocatorPool>&& AllocatorPool)
+        : mDevice(&Device),
+          mCopyQueue(std::move(CopyQueue)),
+          mAllocatorPool(std::move(AllocatorPool)) {}
+
+    // Prohibit copying and moving as the command lists hold a pointer to the pool
+    D3D12UploadBackend(const D3D12UploadBackend&) = delete;
+    D3D12UploadBackend& operator=(const D3D12UploadBackend&) = delete;
+    D3D12UploadBackend(D3D12UploadBackend&&) = delete;
+    D3D12UploadBackend& operator=(D3D12UploadBackend&&) = delete;
+
+    bool CreateStagingBuffer(size_t Size, StagingBuffer& OutBuffer, std::byte*& OutMappedPtr);
+
+    /**
+     * Opens the copy command list of the next batch.
+     */
+    bool OpenBatch();
+
+    void RecordCopy(const StagingBuffer& From,
+                    size_t FromOffset,
+                    DeviceBuffer& To,
+                    size_t Size) const {
+        mBatchList.CopyBufferRegion(*From, FromOffset, To, Size);
+    }
+
+    bool SubmitBatch();
+
+    uint64_t GetNextFenceValue() const {
+        return mCopyQueue->GetNextFenceValue();
+    }
+
+    uint64_t GetCompletedFenceValue() const {
+        return mCopyQueue->GetCompletedFenceValue();
+    }
+
+    CommandQueue& GetCopyQueue() const {
+        return *mCopyQueue;
+    }
+
+   private:
+    // Not-owning
+    Device* mDevice;
+
+    std::unique_ptr<CommandQueue> mCopyQueue;
+    std::unique_ptr<CommandAllocatorPool> mAllocatorPool;
+    CommandList10 mBatchList;
+};
+
+/**
+ * Uploads buffer data through a queue of the COPY type, so creating resources never stalls the
+ * direct queue or the CPU.
+ *
+ * The uploads get staged in persistently mapped upload pages and batched into one copy command
+ * list, submitted on Submit, e.g. once per frame, or when the batch grows large; see
+ * UploadBatcher. Every upload returns the ticket of its batch; the direct queue waits on it on the
+ * GPU before the first draw using the data:
+ *
+ *   Upload(A) -> 7, Upload(B) -> 7, Submit(), Upload(C) -> 8, WaitOnQueue(Direct, 7)
+ *
+ * The destination buffers have to be in the COMMON state: the copy queue promotes them to
+ * COPY_DEST, and they decay back to COMMON once the batch completes.
+ */
+class UploadManager {
+    // Alias for Microsoft::WRL::ComPtr
+    template <typename T>
+    using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+   public:
+    /**
+     * Creates the upload manager along with its copy queue.
+     *
+     * @param Device The device creating the staging pages.
+     * @param D3DDevice The D3D12 device to create the copy queue and the command lists with.
+     * @param OutManager Output parameter that will be populated with the created UploadManager
+     * instance on success. Unchanged on failure.
+     * @return true if the UploadManager was successfully created, false otherwise.
+     */
+    static bool Create(Device& Device,
+                       ComPtr<ID3D12Device14>& D3DDevice,
+                       std::unique_ptr<UploadManager>& OutManager);
+
+    UploadManager(Device& Device,
+                  std::unique_ptr<CommandQueue>&& CopyQueue,
+                  std::unique_ptr<CommandAllocatorPool>&& AllocatorPool)
+        : mBackend(Device, std::move(CopyQueue), std::move(AllocatorPool)), mBatcher(mBackend) {}
+
+    ~UploadManager();
+
+    // Prohibit copying and moving as the batcher holds a pointer to the backend
+    UploadManager(const UploadManager&) = delete;
+    UploadManager& operator=(const UploadManager&) = delete;
+    UploadManager(UploadManager&&) = delete;
+    UploadManager& operator=(UploadManager&&) = delete;
+
+    /**
+     * Stages the data and records its copy into the destination buffer into the open batch. The
+     * data may be released right after the call.
+     *
+     * @param Destination The buffer to copy the data to, at offset 0; in the COMMON state.
+     * @param Data The data to upload.
+     * @param Size The size of the data in bytes.
+     * @param OutTicket Output parameter that will be populated with the ticket of the batch on
+     * success. Unchanged on failure.
+     * @return true if the upload was recorded, false otherwise.
+     */
+    bool Upload(DeviceBuffer& Destination,
+                const void* Data,
+                size_t Size,
+                UploadTicket& OutTicket) {
+        const UploadRequest request{&Destination, Data, Size};
+        return UploadBatch({&request, 1}, OutTicket);
+    }
+
+    /**
+     * Stages the data of all the requests in one staging allocation and records their copies into
+     * the open batch, so they complete together under one ticket.
+     *
+     * @param Requests The uploads; the destinations have to be in the COMMON state.
+     * @param OutTicket Output parameter that will be populated with the ticket of the batch on
+     * success. Unchanged on failure.
+     * @return true if the uploads were recorded, false otherwise.
+     */
+    bool UploadBatch(std::span<const UploadRequest> Requests, UploadTicket& OutTicket);
+
+    /**
+     * Submits the open batch, if any, to the copy queue.
+     */
+    bool Submit();
+
+    /**
+     * Submits the batch of the ticket if it's still open.
+     */
+    bool Submit(UploadTicket Ticket);
+
+    /**
+     * Makes the queue wait on the GPU for the batch of the ticket, submitting the batch if it's
+     * still open. Does nothing if the batch has completed already.
+     */
+    bool WaitOnQueue(CommandQueue& Queue, UploadTicket Ticket);
+
+    bool IsComplete(UploadTicket Ticket) const {
+        return Ticket <= GetCompletedTicket();
+    }
+
+    /**
+     * Returns the latest ticket whose batch has completed; all the earlier ones have too.
+     */
+    UploadTicket GetCompletedTicket() const {
+        return mBackend.GetCompletedFenceValue();
+    }
+
+    /**
+     * Releases the staging pages of the completed batches; called once per frame.
+     */
+    void Collect() {
+        mBatcher.Collect();
+    }
+
+    /** The number of batches submitted to the copy queue so far. */
+    uint64_t GetSubmitCount() const {
+        return mBatcher.GetSubmitCount();
+    }
+
+    /** The number of staging pages created so far. */
+    uint64_t GetStagingPageCount() const {
+        return mBatcher.GetStagingPageCount();
+    }
+
+   private:
+    D3D12UploadBackend mBackend;
+    UploadBatcher<D3D12UploadBackend> mBatcher;
+};
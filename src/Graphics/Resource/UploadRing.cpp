@@ -0,0 +1,24 @@
+#include "UploadRing.h"
+
+#include <cstddef>
+
+#include "Logging/Logging.h"
+
+bool UploadRing::Allocate(size_t Size, size_t Alignment, UploadAllocation& OutAllocation) {
+    size_t offset;
+    bool isAllocated;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        isAllocated = mAllocator.Allocate(Size, Alignment, offset);
+    }
+
+    if (!isAllocated) {
+        LOG_ERROR(L"Upload ring of %zu bytes is out of space for %zu bytes.\n",
+                  mAllocator.GetCapacity(), Size);
+        return false;
+    }
+
+    OutAllocation.CpuPtr = static_cast<std::byte*>(mBuffer->GetMappedPtr()) + offset;
+    OutAllocation.GpuAddress = mBuffer->GetDeviceVirtualAddress() + offset;
+    return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "Memory/RingAllocator.h"
+#include "UploadBuffer.h"
+
+/**
+ * A suballocated range of the UploadRing. The CPU writes through CpuPtr; the GPU reads from
+ * GpuAddress.
+ */
+struct UploadAllocation {
+    void* CpuPtr{nullptr};
+    D3D12_GPU_VIRTUAL_ADDRESS GpuAddress{0};
+};
+
+/**
+ * One large persistently mapped upload buffer handing out transient per-frame ranges, e.g.
+ * constant buffer data bound to draws right at its ring address. The ranges get reclaimed once the
+ * GPU has completed the frame they were allocated in, so no per-resource copies or barriers are
+ * needed. Command lists recorded in parallel may allocate from it concurrently.
+ */
+class UploadRing {
+   public:
+    /**
+     * @param Buffer The buffer to suballocate; has to be persistently mapped, see
+     * UploadBuffer::MapPersistent.
+     */
+    explicit UploadRing(std::unique_ptr<UploadBuffer>&& Buffer)
+        : mBuffer(std::move(Buffer)), mAllocator(mBuffer->GetBufferSize()) {}
+
+    ~UploadRing() = default;
+
+    // Prohibit copying and moving as the command lists hold a pointer to the ring
+    UploadRing(const UploadRing&) = delete;
+    UploadRing& operator=(const UploadRing&) = delete;
+    UploadRing(UploadRing&&) = delete;
+    UploadRing& operator=(UploadRing&&) = delete;
+
+    /**
+     * Allocates a range for the current frame.
+     *
+     * @param Size The size of the range in bytes.
+     * @param Alignment The alignment of the range; a power of two, e.g.
+     * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT for constant buffers.
+     * @param OutAllocation Output parameter that will be populated with the range on success.
+     * Unchanged on failure.
+     * @return true if the range was allocated, false if the ring is full.
+     */
+    bool Allocate(size_t Size, size_t Alignment, UploadAllocation& OutAllocation);
+
+    /**
+     * Closes the current frame; see RingAllocator::EndFrame.
+     */
+    void EndFrame(uint64_t FenceValue) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mAllocator.EndFrame(FenceValue);
+    }
+
+    /**
+     * Frees the frames up to the completed fence value; see RingAllocator::Reclaim.
+     */
+    void Reclaim(uint64_t CompletedFenceValue) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mAllocator.Reclaim(CompletedFenceValue);
+    }
+
+   private:
+    // Owned; stays mapped until it's released
+    std::unique_ptr<UploadBuffer> mBuffer;
+
+    std::mutex mMutex;
+    RingAllocator mAllocator;
+};
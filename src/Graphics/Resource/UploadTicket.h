@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Identifies a batch of uploads on the copy queue: the fence value the copy queue signals once the
+ * batch completes. 0 stands for no pending upload.
+ */
+using UploadTicket = uint64_t;
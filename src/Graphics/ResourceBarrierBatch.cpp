@@ -0,0 +1,27 @@
+#include "ResourceBarrierBatch.h"
+
+void ResourceBarrierBatch::Transition(ID3D12Resource* Resource,
+                                      uint32_t StateBefore,
+                                      uint32_t StateAfter) {
+    ++mRequestedCount;
+
+    // A batch holds a handful of transitions between two draws, so a linear search does
+    for (auto it = mPending.begin(); it != mPending.end(); ++it) {
+        if (it->Resource != Resource) {
+            continue;
+        }
+
+        // Fold the new transition into the pending one
+        ++mRemovedCount;
+        it->StateAfter = StateAfter;
+
+        // Back to where it started, so there's nothing to transition at all
+        if (it->StateBefore == it->StateAfter) {
+            ++mRemovedCount;
+            mPending.erase(it);
+        }
+        return;
+    }
+
+    mPending.push_back({Resource, StateBefore, StateAfter});
+}
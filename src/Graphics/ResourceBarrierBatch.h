@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Forward declarations; the batch only passes the resources through
+struct ID3D12Resource;
+
+/**
+ * A pending transition of all the subresources of a resource. The states are
+ * D3D12_RESOURCE_STATES values.
+ */
+struct BarrierTransition {
+    ID3D12Resource* Resource;
+    uint32_t StateBefore;
+    uint32_t StateAfter;
+};
+
+/**
+ * Accumulates the transition barriers of a command list so they get submitted in one
+ * ResourceBarrier call right before the work that depends on them.
+ *
+ * Transitions of a resource that's already pending get collapsed into one, as nothing in between
+ * could have used the intermediate state:
+ *
+ *   A: COPY_DEST -> GENERIC_READ, A: GENERIC_READ -> COPY_DEST   =>  nothing
+ *   B: PRESENT -> RENDER_TARGET, B: RENDER_TARGET -> COPY_SOURCE =>  B: PRESENT -> COPY_SOURCE
+ */
+class ResourceBarrierBatch {
+   public:
+    ResourceBarrierBatch() = default;
+
+    // Prohibit copying
+    ResourceBarrierBatch(const ResourceBarrierBatch&) = delete;
+    ResourceBarrierBatch& operator=(const ResourceBarrierBatch&) = delete;
+
+    // Allow moving
+    ResourceBarrierBatch(ResourceBarrierBatch&&) noexcept = default;
+    ResourceBarrierBatch& operator=(ResourceBarrierBatch&&) noexcept = default;
+
+    /**
+     * Adds a transition, collapsing it with the pending transition of the resource if there's one.
+     */
+    void Transition(ID3D12Resource* Resource, uint32_t StateBefore, uint32_t StateAfter);
+
+    /**
+     * Submits the pending transitions to the target in one call and clears them.
+     *
+     * @tparam T Anything with ResourceBarriers(const BarrierTransition*, uint32_t Count), e.g. a
+     * command list, or a recorder in a test.
+     */
+    template <typename T>
+    void Flush(T& Target) {
+        if (mPending.empty()) {
+            return;
+        }
+
+        Target.ResourceBarriers(mPending.data(), static_cast<uint32_t>(mPending.size()));
+        mFlushedCount += mPending.size();
+        ++mFlushCount;
+        mPending.clear();
+    }
+
+    bool IsEmpty() const {
+        return mPending.empty();
+    }
+
+    uint32_t GetPendingCount() const {
+        return static_cast<uint32_t>(mPending.size());
+    }
+
+    /** The number of transitions requested so far. */
+    uint64_t GetRequestedCount() const {
+        return mRequestedCount;
+    }
+
+    /** The number of barriers submitted so far. */
+    uint64_t GetFlushedCount() const {
+        return mFlushedCount;
+    }
+
+    /** The number of ResourceBarrier calls so far. */
+    uint64_t GetFlushCount() const {
+        return mFlushCount;
+    }
+
+    /** The number of requested transitions collapsed away so far. */
+    uint64_t GetRemovedCount() const {
+        return mRemovedCount;
+    }
+
+   private:
+    std::vector<BarrierTransition> mPending;
+
+    uint64_t mRequestedCount{0};
+    uint64_t mFlushedCount{0};
+    uint64_t mFlushCount{0};
+    uint64_t mRemovedCount{0};
+};
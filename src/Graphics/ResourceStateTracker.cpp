@@ -0,0 +1,27 @@
+#include "ResourceStateTracker.h"
+
+void ResourceStateTracker::Transition(ResourceState& State,
+                                      uint32_t StateAfter,
+                                      ResourceBarrierBatch& Barriers) {
+    auto [it, isFirstUse] = mIndices.try_emplace(&State, static_cast<uint32_t>(mEntries.size()));
+    if (isFirstUse) {
+        mEntries.push_back({&State, StateAfter, StateAfter});
+        return;
+    }
+
+    Entry& entry = mEntries[it->second];
+    if (entry.LastState != StateAfter) {
+        Barriers.Transition(State.Resource, entry.LastState, StateAfter);
+        entry.LastState = StateAfter;
+    }
+}
+
+void ResourceStateTracker::Resolve(std::vector<BarrierTransition>& OutFixups) {
+    for (const Entry& entry : mEntries) {
+        if (entry.State->State != entry.FirstState) {
+            OutFixups.push_back({entry.State->Resource, entry.State->State, entry.FirstState});
+        }
+        entry.State->State = entry.LastState;
+    }
+    Reset();
+}
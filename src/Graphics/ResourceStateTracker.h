@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ResourceBarrierBatch.h"
+
+/**
+ * The state of a resource as of the last submission to the queue, shared by all the command
+ * lists. The state is a D3D12_RESOURCE_STATES value. Only the submission, under the queue lock,
+ * reads or writes it, so the command lists may record concurrently.
+ */
+struct ResourceState {
+    ID3D12Resource* Resource;
+    uint32_t State;
+};
+
+/**
+ * Tracks the resource states local to a command list while it records, without touching the
+ * shared states.
+ *
+ * The first transition of a resource in the list can't know the state the resource will be in by
+ * the time the list executes, so it's left pending: the list records only the transitions that
+ * follow it. At submission, Resolve compares the state each resource needs with its shared state,
+ * emits the fix-up barriers to run right before the list, and publishes the states the list leaves
+ * the resources in:
+ *
+ *   list 1: A -> RENDER_TARGET (pending), A: RENDER_TARGET -> PRESENT
+ *   list 2: A -> COPY_SOURCE (pending)
+ *   submit 1: fix-up A: PRESENT -> RENDER_TARGET, shared A = PRESENT
+ *   submit 2: fix-up A: PRESENT -> COPY_SOURCE, shared A = COPY_SOURCE
+ *
+ * The lists have to be resolved in the order they execute, and the resources have to outlive the
+ * submission of the lists using them.
+ */
+class ResourceStateTracker {
+   public:
+    ResourceStateTracker() = default;
+
+    // Prohibit copying
+    ResourceStateTracker(const ResourceStateTracker&) = delete;
+    ResourceStateTracker& operator=(const ResourceStateTracker&) = delete;
+
+    // Allow moving
+    ResourceStateTracker(ResourceStateTracker&&) noexcept = default;
+    ResourceStateTracker& operator=(ResourceStateTracker&&) noexcept = default;
+
+    /**
+     * Transitions the resource within the list. The first transition of the resource is left
+     * pending for Resolve, the following ones go into the barrier batch.
+     * @param State The shared state of the resource; only its address is used here.
+     * @param StateAfter The state to transition to.
+     * @param Barriers The barrier batch of the list.
+     */
+    void Transition(ResourceState& State, uint32_t StateAfter, ResourceBarrierBatch& Barriers);
+
+    /**
+     * Resolves the pending transitions against the shared states and publishes the states the
+     * list leaves the resources in. Clears the tracker.
+     * @param OutFixups Output parameter the fix-up barriers get appended to.
+     */
+    void Resolve(std::vector<BarrierTransition>& OutFixups);
+
+    void Reset() {
+        mIndices.clear();
+        mEntries.clear();
+    }
+
+    bool IsEmpty() const {
+        return mEntries.empty();
+    }
+
+    uint32_t GetResourceCount() const {
+        return static_cast<uint32_t>(mEntries.size());
+    }
+
+   private:
+    struct Entry {
+        ResourceState* State;
+        // The state the list needs the resource in when it starts executing
+        uint32_t FirstState;
+        // The state the list has transitioned the resource to so far
+        uint32_t LastState;
+    };
+
+    // Entry per resource in the order of the first use
+    std::unordered_map<ResourceState*, uint32_t> mIndices;
+    std::vector<Entry> mEntries;
+};
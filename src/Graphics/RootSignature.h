@@ -1,14 +1,41 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
 #include <utility>
 
 #include "Includes/ComIncl.h"
 #include "Includes/GraphicsIncl.h"
 
+/**
+ * The root parameters of a root signature the renderer binds its data to, found by their shader
+ * registers. A root signature declares only the ones its shaders read, and the renderer binds only
+ * the ones it declares.
+ */
+struct RootParameterSlots {
+    static constexpr uint32_t kNoRootParameter = std::numeric_limits<uint32_t>::max();
+
+    // The per-instance MeshConstantBuffer: a root SRV at t0 or 32-bit root constants at b0
+    uint32_t Instance{kNoRootParameter};
+    bool IsInstanceRootConstants{false};
+
+    // The per-view ViewConstantBuffer: a root CBV at b1
+    uint32_t View{kNoRootParameter};
+
+    bool HasInstance() const {
+        return Instance != kNoRootParameter;
+    }
+
+    bool HasView() const {
+        return View != kNoRootParameter;
+    }
+};
+
 class RootSignature {
    public:
-    RootSignature(Microsoft::WRL::ComPtr<ID3D12RootSignature> RootSignature)
-        : mD3DRootSignature(std::move(RootSignature)) {}
+    RootSignature(Microsoft::WRL::ComPtr<ID3D12RootSignature> RootSignature,
+                  const RootParameterSlots& Slots)
+        : mD3DRootSignature(std::move(RootSignature)), mSlots(Slots) {}
 
     // Prohibit copying
     RootSignature(const RootSignature& other) = delete;
@@ -16,11 +43,13 @@ class RootSignature {
 
     // Allow moving
     RootSignature(RootSignature&& other) noexcept
-        : mD3DRootSignature(std::exchange(other.mD3DRootSignature, nullptr)) {}
+        : mD3DRootSignature(std::exchange(other.mD3DRootSignature, nullptr)),
+          mSlots(std::exchange(other.mSlots, {})) {}
 
     RootSignature& operator=(RootSignature&& other) noexcept {
         if (this != &other) {
             mD3DRootSignature = std::exchange(other.mD3DRootSignature, nullptr);
+            mSlots = std::exchange(other.mSlots, {});
         }
         return *this;
     }
@@ -29,6 +58,14 @@ class RootSignature {
         return mD3DRootSignature ? mD3DRootSignature.Get() : nullptr;
     }
 
+    /**
+     * Returns the root parameters the renderer binds its data to.
+     */
+    const RootParameterSlots& GetRootParameterSlots() const {
+        return mSlots;
+    }
+
    private:
     Microsoft::WRL::ComPtr<ID3D12RootSignature> mD3DRootSignature;
+    RootParameterSlots mSlots;
 };
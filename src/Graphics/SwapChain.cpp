@@ -20,7 +20,10 @@ bool SwapChain::BuffersReadTo(std::vector<std::unique_ptr<ColorBuffer>>& OutVect
         desc.Texture2D.PlaneSlice = 0;
 
         D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle;
-        mDevice->CreateRenderTargetView(resource.Get(), desc, rtvHandle);
+        if (!mDevice->CreateRenderTargetView(resource.Get(), desc, rtvHandle)) {
+            LOG_ERROR(L"Failed to create the RTV of IDXGISwapChain buffer %d.\n", i);
+            return false;
+        }
 
         OutVector[i] = std::make_unique<ColorBuffer>(rtvHandle, std::move(resource));
     }
@@ -67,8 +70,12 @@ bool SwapChain::FlushAll() {
     }
 
     LOG_INFO(L"Releasing swap chain buffers.\n");
-    // Release references to the buffers but keep the vector size intact.
+    // Release references to the buffers but keep the vector size intact. Their RTVs go back to the
+    // heap, so resizing over and over reuses the same descriptors.
     for (uint32_t i = 0; i < mBackBufferCount; ++i) {
+        if (mBackBuffers[i]) {
+            mDevice->FreeRenderTargetView(mBackBuffers[i]->GetRTV());
+        }
         mBackBuffers[i] = nullptr;
     }
     return true;
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Command/CommandStream.h"
+#include "Math/Matrix.h"
+#include "RenderQueue.h"
+#include "Scene/Camera.h"
+
+/**
+ * Per-view data; the constant buffer the vertex shaders read the view-projection transform from.
+ */
+struct ViewConstantBuffer {
+    Matrix4 ViewProjection;
+};
+
+/**
+ * A view of the scene: a camera rendering into a rectangle of the render target, e.g. one half of
+ * a split screen. The rectangle is normalized to the render target size, so it follows resizes.
+ *
+ * The renderer culls the scene for all the views at once and collects the sorted keys of the
+ * objects each view sees into the view.
+ */
+class View {
+   public:
+    View() = default;
+
+    /**
+     * @param Camera The camera to render with.
+     * @param Left The left edge of the view in the render target, 0 to 1.
+     * @param Top The top edge of the view in the render target, 0 to 1.
+     * @param Width The width of the view relative to the render target width.
+     * @param Height The height of the view relative to the render target height.
+     */
+    View(const Camera& Camera, float Left, float Top, float Width, float Height)
+        : mCamera(Camera), mLeft(Left), mTop(Top), mWidth(Width), mHeight(Height) {}
+
+    // Prohibit copying
+    View(const View&) = delete;
+    View& operator=(const View&) = delete;
+
+    // Allow moving
+    View(View&&) noexcept = default;
+    View& operator=(View&&) noexcept = default;
+
+    Camera& GetCamera() {
+        return mCamera;
+    }
+
+    const Camera& GetCamera() const {
+        return mCamera;
+    }
+
+    /**
+     * Moves the view within the render target; the arguments are the same as the constructor's.
+     */
+    void SetRect(float Left, float Top, float Width, float Height) {
+        mLeft = Left;
+        mTop = Top;
+        mWidth = Width;
+        mHeight = Height;
+        Resize(mTargetWidth, mTargetHeight);
+    }
+
+    /**
+     * Maps the normalized rectangle onto the render target of the given size and updates the
+     * aspect ratio of the camera.
+     */
+    void Resize(uint32_t Width, uint32_t Height) {
+        mTargetWidth = Width;
+        mTargetHeight = Height;
+
+        mViewport.TopLeftX = mLeft * static_cast<float>(Width);
+        mViewport.TopLeftY = mTop * static_cast<float>(Height);
+        mViewport.Width = mWidth * static_cast<float>(Width);
+        mViewport.Height = mHeight * static_cast<float>(Height);
+        mViewport.MinDepth = 0.0f;
+        mViewport.MaxDepth = 1.0f;
+
+        mScissorRect.Left = static_cast<int32_t>(mViewport.TopLeftX);
+        mScissorRect.Top = static_cast<int32_t>(mViewport.TopLeftY);
+        mScissorRect.Right = static_cast<int32_t>(mViewport.TopLeftX + mViewport.Width);
+        mScissorRect.Bottom = static_cast<int32_t>(mViewport.TopLeftY + mViewport.Height);
+
+        if (mViewport.Height > 0.f) {
+            mCamera.SetAspectRatio(mViewport.Width / mViewport.Height);
+        }
+    }
+
+    const Viewport& GetViewport() const {
+        return mViewport;
+    }
+
+    const ScissorRect& GetScissorRect() const {
+        return mScissorRect;
+    }
+
+    /**
+     * Enables testing the objects the view sees against the depth of the occluders in it; see
+     * MeshData::IsOccluder. Pays off in the views looking at dense scenes, e.g. a street.
+     */
+    void SetOcclusionCulling(bool IsOcclusionCulling) {
+        mIsOcclusionCulling = IsOcclusionCulling;
+    }
+
+    bool IsOcclusionCulling() const {
+        return mIsOcclusionCulling;
+    }
+
+    /**
+     * The sorted keys of the objects visible in the view as of the last Renderer::Update.
+     */
+    std::vector<RenderingKey>& GetKeys() {
+        return mKeys;
+    }
+
+    const std::vector<RenderingKey>& GetKeys() const {
+        return mKeys;
+    }
+
+   private:
+    Camera mCamera;
+
+    // The normalized rectangle
+    float mLeft{0.f};
+    float mTop{0.f};
+    float mWidth{1.f};
+    float mHeight{1.f};
+
+    // The render target size
+    uint32_t mTargetWidth{0};
+    uint32_t mTargetHeight{0};
+
+    Viewport mViewport;
+    ScissorRect mScissorRect;
+
+    bool mIsOcclusionCulling{false};
+
+    std::vector<RenderingKey> mKeys;
+};
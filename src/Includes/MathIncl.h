@@ -2,8 +2,16 @@
 
 #include <DirectXMath.h>
 
+#if defined(_MSC_VER)
 // We want to inline small hot functions like matrix/vector operations
 #define INLINE __forceinline
 
 // MSVC specific
-#define ALIGN(arg) __declspec(align(arg))
\ No newline at end of file
+#define ALIGN(arg) __declspec(align(arg))
+#else
+// The other compilers, e.g. building the tests on Linux
+#define INLINE inline __attribute__((always_inline))
+
+// The SIMD members already carry their alignment, so the classes get it without the attribute
+#define ALIGN(arg)
+#endif
\ No newline at end of file
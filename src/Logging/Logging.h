@@ -3,11 +3,14 @@
 //
 #pragma once
 
+#ifdef _WIN32
 #include <Windows.h>  // required for OutputDebugString
+#endif
 
 #include <cstdio>  // required for swprintf_s
+#include <cwchar>  // required for fwprintf
 
-#ifdef _DEBUG
+#if defined(_DEBUG) && defined(_WIN32)
 // Buffer size for logging macros
 #define LOGGING_BUFFER_SIZE 512
 
@@ -19,6 +22,10 @@
         swprintf_s(buffer, _countof(buffer), L"%-70s - " msg, fileLine, ##__VA_ARGS__); \
         OutputDebugString(buffer);                                                      \
     } while (0)
+#elif defined(_DEBUG)
+// Headless builds, e.g. replaying command streams with the null backend, log to stderr
+#define LOG_PRINT(file, line, msg, ...) \
+    fwprintf(stderr, L"%s:%d - " msg, file, line, ##__VA_ARGS__)
 #else
 #define LOG_PRINT(file, line, msg, ...) ((void)0)
 #endif
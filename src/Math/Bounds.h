@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+
+#include "Includes/MathIncl.h"
+#include "Matrix.h"
+#include "Vector.h"
+
+/**
+ * Axis-aligned bounding box kept as the min and max corners. A default constructed box is empty:
+ * merging anything into it yields the other box, and no frustum contains it.
+ */
+// XMVECTOR requires 16byte alignment
+ALIGN(16)
+class AABB {
+   public:
+    using XMVECTOR = DirectX::XMVECTOR;
+    using XMMATRIX = DirectX::XMMATRIX;
+
+    INLINE AABB()
+        : mMin(DirectX::XMVectorReplicate(FLT_MAX)), mMax(DirectX::XMVectorReplicate(-FLT_MAX)) {}
+
+    INLINE AABB(Vector3 Min, Vector3 Max) : mMin(Min), mMax(Max) {}
+
+    /**
+     * Computes the box of the points, e.g. of the vertex positions.
+     * @param Points The first point; three floats.
+     * @param Count The number of points.
+     * @param StrideInBytes The distance between two points; at least three floats.
+     */
+    static AABB FromPoints(const void* Points, uint32_t Count, uint32_t StrideInBytes) {
+        AABB box;
+        const std::byte* point = static_cast<const std::byte*>(Points);
+        for (uint32_t i = 0; i < Count; ++i, point += StrideInBytes) {
+            const XMVECTOR position =
+                DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(point));
+            box.mMin = DirectX::XMVectorMin(box.mMin, position);
+            box.mMax = DirectX::XMVectorMax(box.mMax, position);
+        }
+        return box;
+    }
+
+    INLINE bool IsEmpty() const {
+        // Any of the min coordinates past the max one
+        return !DirectX::XMVector3LessOrEqual(mMin, mMax);
+    }
+
+    INLINE XMVECTOR GetMin() const {
+        return mMin;
+    }
+
+    INLINE XMVECTOR GetMax() const {
+        return mMax;
+    }
+
+    INLINE XMVECTOR GetCenter() const {
+        return DirectX::XMVectorScale(DirectX::XMVectorAdd(mMin, mMax), 0.5f);
+    }
+
+    INLINE XMVECTOR GetExtents() const {
+        return DirectX::XMVectorScale(DirectX::XMVectorSubtract(mMax, mMin), 0.5f);
+    }
+
+    /**
+     * Returns the box enclosing both boxes.
+     */
+    INLINE AABB Merge(const AABB& Other) const {
+        return AABB(DirectX::XMVectorMin(mMin, Other.mMin), DirectX::XMVectorMax(mMax, Other.mMax));
+    }
+
+    /**
+     * Returns the box enclosing this box transformed by the matrix: the center gets transformed,
+     * the extents get projected onto the axes by the absolute values of the matrix rows.
+     */
+    INLINE AABB Transform(const Matrix4& Transform) const {
+        if (IsEmpty()) {
+            return *this;
+        }
+
+        const XMMATRIX matrix = Transform;
+        const XMVECTOR center = DirectX::XMVector3Transform(GetCenter(), matrix);
+        const XMVECTOR extents = GetExtents();
+
+        XMVECTOR newExtents = DirectX::XMVectorMultiply(DirectX::XMVectorSplatX(extents),
+                                                        DirectX::XMVectorAbs(matrix.r[0]));
+        newExtents = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorSplatY(extents),
+                                                  DirectX::XMVectorAbs(matrix.r[1]), newExtents);
+        newExtents = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorSplatZ(extents),
+                                                  DirectX::XMVectorAbs(matrix.r[2]), newExtents);
+
+        return AABB(DirectX::XMVectorSubtract(center, newExtents),
+                    DirectX::XMVectorAdd(center, newExtents));
+    }
+
+   private:
+    XMVECTOR mMin;
+    XMVECTOR mMax;
+};
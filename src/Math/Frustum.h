@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Bounds.h"
+#include "Includes/MathIncl.h"
+#include "Matrix.h"
+
+/**
+ * The six planes of a view frustum, extracted from a view-projection matrix in the D3D clip space
+ * conventions (0 <= z <= w). Transformed by a matrix M, a point p is inside when p * M lands in the
+ * clip volume, so the identity matrix yields the clip volume itself.
+ *
+ * The planes are kept as structure-of-arrays, four planes to a register, so a box gets tested
+ * against four planes with a handful of SIMD instructions:
+ *
+ *   X: | left.x | right.x | bottom.x | top.x |   | near.x | far.x | near.x | far.x |
+ *   Y: | left.y | ...
+ *
+ * The second group repeats the near and far planes to fill the register.
+ */
+// XMVECTOR requires 16byte alignment
+ALIGN(16)
+class Frustum {
+   public:
+    using XMVECTOR = DirectX::XMVECTOR;
+
+    enum class Containment : uint8_t {
+        kOutside,
+        kIntersects,
+        kInside,
+    };
+
+    INLINE Frustum() : Frustum(Matrix4()) {}
+
+    explicit Frustum(const Matrix4& ViewProjection) {
+        DirectX::XMFLOAT4X4 m;
+        DirectX::XMStoreFloat4x4(&m, ViewProjection);
+
+        // The plane coefficients of a clip space bound combine the matrix columns (Gribb/Hartmann)
+        const auto column = [&m](uint32_t Column) {
+            return DirectX::XMVectorSet(m.m[0][Column], m.m[1][Column], m.m[2][Column],
+                                        m.m[3][Column]);
+        };
+        const XMVECTOR x = column(0);
+        const XMVECTOR y = column(1);
+        const XMVECTOR z = column(2);
+        const XMVECTOR w = column(3);
+
+        const XMVECTOR planes[8] = {
+            DirectX::XMVectorAdd(w, x),       // Left
+            DirectX::XMVectorSubtract(w, x),  // Right
+            DirectX::XMVectorAdd(w, y),       // Bottom
+            DirectX::XMVectorSubtract(w, y),  // Top
+            z,                                // Near
+            DirectX::XMVectorSubtract(w, z),  // Far
+            z,                                // Near, again
+            DirectX::XMVectorSubtract(w, z),  // Far, again
+        };
+
+        // Transpose into the structure-of-arrays layout
+        for (uint32_t group = 0; group < kGroupCount; ++group) {
+            const DirectX::XMMATRIX transposed = DirectX::XMMatrixTranspose(
+                DirectX::XMMATRIX(planes[group * 4 + 0], planes[group * 4 + 1],
+                                  planes[group * 4 + 2], planes[group * 4 + 3]));
+            mPlaneX[group] = transposed.r[0];
+            mPlaneY[group] = transposed.r[1];
+            mPlaneZ[group] = transposed.r[2];
+            mPlaneW[group] = transposed.r[3];
+        }
+    }
+
+    /**
+     * Tests the box against the planes. The box is outside if it's fully behind any of the planes,
+     * inside if it's fully in front of all of them; conservative for the boxes close to the
+     * frustum edges, which may get reported as intersecting while they are outside.
+     */
+    INLINE Containment Test(const AABB& Box) const {
+        if (Box.IsEmpty()) {
+            return Containment::kOutside;
+        }
+
+        const XMVECTOR center = Box.GetCenter();
+        const XMVECTOR extents = Box.GetExtents();
+        const XMVECTOR centerX = DirectX::XMVectorSplatX(center);
+        const XMVECTOR centerY = DirectX::XMVectorSplatY(center);
+        const XMVECTOR centerZ = DirectX::XMVectorSplatZ(center);
+        const XMVECTOR extentsX = DirectX::XMVectorSplatX(extents);
+        const XMVECTOR extentsY = DirectX::XMVectorSplatY(extents);
+        const XMVECTOR extentsZ = DirectX::XMVectorSplatZ(extents);
+        const XMVECTOR zero = DirectX::XMVectorZero();
+
+        bool isInside = true;
+        for (uint32_t group = 0; group < kGroupCount; ++group) {
+            // The signed distances of the center to the four planes
+            XMVECTOR distance =
+                DirectX::XMVectorMultiplyAdd(centerX, mPlaneX[group], mPlaneW[group]);
+            distance = DirectX::XMVectorMultiplyAdd(centerY, mPlaneY[group], distance);
+            distance = DirectX::XMVectorMultiplyAdd(centerZ, mPlaneZ[group], distance);
+
+            // The extents projected onto the plane normals
+            const XMVECTOR normalX = DirectX::XMVectorAbs(mPlaneX[group]);
+            const XMVECTOR normalY = DirectX::XMVectorAbs(mPlaneY[group]);
+            const XMVECTOR normalZ = DirectX::XMVectorAbs(mPlaneZ[group]);
+            XMVECTOR radius = DirectX::XMVectorMultiply(extentsX, normalX);
+            radius = DirectX::XMVectorMultiplyAdd(extentsY, normalY, radius);
+            radius = DirectX::XMVectorMultiplyAdd(extentsZ, normalZ, radius);
+
+            // Fully behind any of the planes
+            const XMVECTOR farthest = DirectX::XMVectorAdd(distance, radius);
+            if (!DirectX::XMVector4GreaterOrEqual(farthest, zero)) {
+                return Containment::kOutside;
+            }
+
+            // Straddling any of the planes
+            const XMVECTOR nearest = DirectX::XMVectorSubtract(distance, radius);
+            if (!DirectX::XMVector4GreaterOrEqual(nearest, zero)) {
+                isInside = false;
+            }
+        }
+
+        return isInside ? Containment::kInside : Containment::kIntersects;
+    }
+
+   private:
+    static constexpr uint32_t kGroupCount = 2;
+
+    XMVECTOR mPlaneX[kGroupCount];
+    XMVECTOR mPlaneY[kGroupCount];
+    XMVECTOR mPlaneZ[kGroupCount];
+    XMVECTOR mPlaneW[kGroupCount];
+};
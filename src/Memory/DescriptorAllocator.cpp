@@ -0,0 +1,41 @@
+#include "DescriptorAllocator.h"
+
+DescriptorAllocator::DescriptorAllocator(uint32_t Count,
+                                         uint32_t TransientCountPerFrame,
+                                         uint32_t FrameCount)
+    : mCount(Count),
+      mAllocator(Count - TransientCountPerFrame * FrameCount),
+      mRangeBlocks(Count - TransientCountPerFrame * FrameCount, TlsfAllocator::kInvalidBlock),
+      mTransientCountPerFrame(TransientCountPerFrame) {}
+
+bool DescriptorAllocator::Allocate(uint32_t Count, uint32_t& OutIndex) {
+    TlsfAllocation range;
+    if (!mAllocator.Allocate(Count, 1, range)) {
+        return false;
+    }
+
+    OutIndex = static_cast<uint32_t>(range.Offset);
+    mRangeBlocks[OutIndex] = range.BlockIndex;
+    return true;
+}
+
+void DescriptorAllocator::Free(uint32_t Index) {
+    // The allocator only needs the block to free it
+    TlsfAllocation range;
+    range.Offset = Index;
+    range.BlockIndex = mRangeBlocks[Index];
+    mRangeBlocks[Index] = TlsfAllocator::kInvalidBlock;
+
+    mAllocator.Free(range);
+}
+
+bool DescriptorAllocator::AllocateTransient(uint32_t Count, uint32_t& OutIndex) {
+    if (Count > mTransientCountPerFrame - mTransientUsedCount) {
+        return false;
+    }
+
+    // The slices follow the persistent part in the frame slot order
+    OutIndex = GetPersistentCount() + mFrameIndex * mTransientCountPerFrame + mTransientUsedCount;
+    mTransientUsedCount += Count;
+    return true;
+}
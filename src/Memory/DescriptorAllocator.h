@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "TlsfAllocator.h"
+
+/**
+ * Index bookkeeping of a descriptor heap; knows nothing about the descriptors themselves.
+ *
+ * The heap gets split into a persistent part and a transient part:
+ *
+ *   | persistent: TLSF ranges, freed one by one | frame 0 slice | frame 1 slice | ...
+ *
+ * The persistent descriptors, e.g. render target views, get allocated as contiguous ranges by a
+ * TlsfAllocator and freed by their first index, both in O(1). The transient descriptors live for a
+ * frame only: they get bumped out of the slice of the current frame, and the whole slice gets
+ * recycled at once when the frame slot comes around again.
+ */
+class DescriptorAllocator {
+   public:
+    /**
+     * @param Count The number of descriptors in the heap.
+     * @param TransientCountPerFrame The number of transient descriptors per frame slot, taken from
+     * the end of the heap.
+     * @param FrameCount The number of frame slots.
+     */
+    DescriptorAllocator(uint32_t Count, uint32_t TransientCountPerFrame, uint32_t FrameCount);
+
+    // Prohibit copying
+    DescriptorAllocator(const DescriptorAllocator&) = delete;
+    DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+    /**
+     * Allocates a contiguous range of persistent descriptors.
+     * @param Count The number of descriptors.
+     * @param OutIndex Output parameter that will be populated with the first index of the range on
+     * success. Unchanged on failure.
+     * @return true if the range was allocated, false if the persistent part is out of room.
+     */
+    bool Allocate(uint32_t Count, uint32_t& OutIndex);
+
+    /**
+     * Frees the range of persistent descriptors starting at the index.
+     */
+    void Free(uint32_t Index);
+
+    /**
+     * Allocates a contiguous range of transient descriptors valid until the frame slot is reused.
+     * @return true if the range was allocated, false if the slice of the frame is out of room.
+     */
+    bool AllocateTransient(uint32_t Count, uint32_t& OutIndex);
+
+    /**
+     * Recycles the transient descriptors of the frame slot, the GPU has to be done with them.
+     */
+    void BeginFrame(uint32_t FrameIndex) {
+        mFrameIndex = FrameIndex;
+        mTransientUsedCount = 0;
+    }
+
+    uint32_t GetCount() const {
+        return mCount;
+    }
+
+    uint32_t GetPersistentCount() const {
+        return static_cast<uint32_t>(mAllocator.GetCapacity());
+    }
+
+    uint32_t GetPersistentUsedCount() const {
+        return static_cast<uint32_t>(mAllocator.GetUsedSize());
+    }
+
+    uint32_t GetTransientUsedCount() const {
+        return mTransientUsedCount;
+    }
+
+   private:
+    uint32_t mCount;
+    TlsfAllocator mAllocator;
+
+    // TLSF block per first index of the allocated ranges, so the ranges get freed by their index
+    std::vector<uint32_t> mRangeBlocks;
+
+    uint32_t mTransientCountPerFrame;
+    uint32_t mFrameIndex{0};
+    uint32_t mTransientUsedCount{0};
+};
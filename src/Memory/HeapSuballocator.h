@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "TlsfAllocator.h"
+
+/**
+ * A range handed out by the HeapSuballocator: a range of a heap block to place a buffer at, or a
+ * range of a page buffer a small buffer is packed into.
+ */
+struct HeapRange {
+    static constexpr uint32_t kNoPage = std::numeric_limits<uint32_t>::max();
+
+    uint32_t BlockIndex{0};
+    // The page the range is packed into; kNoPage for the placed ranges
+    uint32_t PageIndex{kNoPage};
+    // The range of the heap block, or of the page for the packed ranges
+    TlsfAllocation Range;
+    // The requested size; the range is rounded up to the alignment
+    uint64_t Size{0};
+
+    bool IsPacked() const {
+        return PageIndex != kNoPage;
+    }
+};
+
+/**
+ * Memory statistics of a HeapSuballocator.
+ */
+struct HeapStats {
+    uint32_t HeapCount{0};
+    uint32_t PageCount{0};
+    // The placed and the packed buffers; the pages don't count
+    uint32_t AllocationCount{0};
+    uint32_t PackedCount{0};
+    uint32_t FreeBlockCount{0};
+    // Total size of the heaps
+    uint64_t ReservedSize{0};
+    // The heap memory taken by the placed buffers and the pages
+    uint64_t UsedSize{0};
+    // Requested buffer sizes
+    uint64_t RequestedSize{0};
+    // The free room of the pages, left for more packed buffers
+    uint64_t PageFreeSize{0};
+    // Lost to rounding the buffers up to their alignment: UsedSize - RequestedSize - PageFreeSize
+    uint64_t WastedSize{0};
+    uint64_t LargestFreeSize{0};
+
+    /**
+     * The part of the reserved memory used by the buffers.
+     */
+    float GetUtilization() const {
+        return ReservedSize == 0 ? 0.f
+                                 : static_cast<float>(RequestedSize) /
+                                       static_cast<float>(ReservedSize);
+    }
+
+    /**
+     * The part of the free memory unusable for an allocation of the whole free size, in [0, 1].
+     */
+    float GetFragmentation() const {
+        const uint64_t freeSize = ReservedSize - UsedSize;
+        return freeSize == 0 ? 0.f
+                             : 1.f - static_cast<float>(LargestFreeSize) /
+                                         static_cast<float>(freeSize);
+    }
+};
+
+/**
+ * Bookkeeping of the buffer memory of one heap type, with no graphics API. The memory is reserved
+ * in large heap blocks, each managed by a TlsfAllocator; a new block gets created once none of the
+ * existing ones has the room, and the empty blocks but the last one get released.
+ *
+ * Placed buffers start at kPlacementAlignment (64KB) boundaries, as D3D12 requires, which would
+ * waste most of the memory of the small buffers. Those that allow it get packed into pages
+ * instead: kPageSize ranges of the heap blocks, each backing a single buffer the small buffers are
+ * ranges of, at kPackedAlignment.
+ *
+ * The backend T creates and releases the memory the bookkeeping describes:
+ *   bool CreateBlock(uint32_t BlockIndex);
+ *   void ReleaseBlock(uint32_t BlockIndex);
+ *   bool CreatePage(uint32_t PageIndex, uint32_t BlockIndex, uint64_t Offset);
+ *   void ReleasePage(uint32_t PageIndex);
+ * The indices of the released blocks and pages get reused. Not thread-safe.
+ */
+template <typename T>
+class HeapSuballocator {
+   public:
+    // The size of a heap block; larger buffers don't fit
+    static constexpr uint64_t kBlockSize = 64ull * 1024 * 1024;
+
+    // D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT
+    static constexpr uint64_t kPlacementAlignment = 64 * 1024;
+
+    static constexpr uint64_t kPageSize = 1024 * 1024;
+
+    // The buffers this small would waste at least half of their placed range
+    static constexpr uint64_t kMaxPackedSize = kPlacementAlignment / 2;
+
+    // D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, so that any packed buffer can be a CBV
+    static constexpr uint64_t kPackedAlignment = 256;
+
+    explicit HeapSuballocator(T& Backend) : mBackend(&Backend) {}
+
+    // Prohibit copying
+    HeapSuballocator(const HeapSuballocator&) = delete;
+    HeapSuballocator& operator=(const HeapSuballocator&) = delete;
+
+    /**
+     * Allocates a range for a buffer.
+     *
+     * @param Size The size of the buffer in bytes; up to kBlockSize.
+     * @param CanPack Whether the buffer can be a range of a page, i.e. shares its resource with
+     * other buffers. Only the buffers up to kMaxPackedSize get packed.
+     * @param OutRange Output parameter that will be populated with the range on success. Unchanged
+     * on failure.
+     * @return true if the range was allocated, false if the backend failed to create a block or a
+     * page.
+     */
+    bool Allocate(uint64_t Size, bool CanPack, HeapRange& OutRange);
+
+    /**
+     * Frees the range. The buffer using it has to be released already.
+     */
+    void Free(const HeapRange& Range);
+
+    void GetStats(HeapStats& OutStats) const;
+
+   private:
+    struct Block {
+        // nullptr once the block is released
+        std::unique_ptr<TlsfAllocator> Allocator;
+    };
+
+    struct Page {
+        // nullptr once the page is released
+        std::unique_ptr<TlsfAllocator> Allocator;
+        uint32_t BlockIndex{0};
+        TlsfAllocation Range;
+    };
+
+    bool AllocatePlaced(uint64_t Size, uint32_t& OutBlockIndex, TlsfAllocation& OutRange);
+    void FreePlaced(uint32_t BlockIndex, const TlsfAllocation& Range);
+    bool AllocatePacked(uint64_t Size, uint32_t& OutPageIndex, TlsfAllocation& OutRange);
+
+    /**
+     * Returns the index of the first released entry, or of a new one.
+     */
+    template <typename E>
+    static uint32_t FindFreeEntry(std::vector<E>& Entries) {
+        auto entry = std::find_if(Entries.begin(), Entries.end(),
+                                  [](const E& Entry) { return Entry.Allocator == nullptr; });
+        if (entry == Entries.end()) {
+            entry = Entries.emplace(Entries.end());
+        }
+        return static_cast<uint32_t>(entry - Entries.begin());
+    }
+
+    template <typename E>
+    static size_t CountLive(const std::vector<E>& Entries) {
+        return std::count_if(Entries.begin(), Entries.end(),
+                             [](const E& Entry) { return Entry.Allocator != nullptr; });
+    }
+
+    // Not-owning
+    T* mBackend;
+
+    std::vector<Block> mBlocks;
+    std::vector<Page> mPages;
+    uint64_t mRequestedSize{0};
+};
+
+template <typename T>
+bool HeapSuballocator<T>::Allocate(uint64_t Size, bool CanPack, HeapRange& OutRange) {
+    HeapRange range;
+    range.Size = Size;
+    if (CanPack && Size <= kMaxPackedSize) {
+        if (!AllocatePacked(Size, range.PageIndex, range.Range)) {
+            return false;
+        }
+        range.BlockIndex = mPages[range.PageIndex].BlockIndex;
+    } else if (!AllocatePlaced(Size, range.BlockIndex, range.Range)) {
+        return false;
+    }
+
+    mRequestedSize += Size;
+    OutRange = range;
+    return true;
+}
+
+template <typename T>
+void HeapSuballocator<T>::Free(const HeapRange& Range) {
+    mRequestedSize -= Range.Size;
+    if (!Range.IsPacked()) {
+        FreePlaced(Range.BlockIndex, Range.Range);
+        return;
+    }
+
+    Page& page = mPages[Range.PageIndex];
+    page.Allocator->Free(Range.Range);
+
+    // Same as the blocks, the last page stays for the next small buffer
+    if (page.Allocator->IsEmpty() && CountLive(mPages) > 1) {
+        mBackend->ReleasePage(Range.PageIndex);
+        page.Allocator.reset();
+        FreePlaced(page.BlockIndex, page.Range);
+    }
+}
+
+template <typename T>
+void HeapSuballocator<T>::GetStats(HeapStats& OutStats) const {
+    OutStats = {};
+    for (const Block& block : mBlocks) {
+        if (block.Allocator == nullptr) {
+            continue;
+        }
+        ++OutStats.HeapCount;
+        OutStats.AllocationCount += block.Allocator->GetAllocationCount();
+        OutStats.FreeBlockCount += block.Allocator->GetFreeBlockCount();
+        OutStats.ReservedSize += block.Allocator->GetCapacity();
+        OutStats.UsedSize += block.Allocator->GetUsedSize();
+        OutStats.LargestFreeSize =
+            std::max(OutStats.LargestFreeSize, block.Allocator->GetLargestFreeSize());
+    }
+    for (const Page& page : mPages) {
+        if (page.Allocator == nullptr) {
+            continue;
+        }
+        ++OutStats.PageCount;
+        OutStats.PackedCount += page.Allocator->GetAllocationCount();
+        OutStats.PageFreeSize += page.Allocator->GetFreeSize();
+    }
+
+    // The pages are block allocations of their own, the buffers packed into them are not
+    OutStats.AllocationCount += OutStats.PackedCount - OutStats.PageCount;
+    OutStats.RequestedSize = mRequestedSize;
+    OutStats.WastedSize = OutStats.UsedSize - OutStats.RequestedSize - OutStats.PageFreeSize;
+}
+
+template <typename T>
+bool HeapSuballocator<T>::AllocatePlaced(uint64_t Size,
+                                         uint32_t& OutBlockIndex,
+                                         TlsfAllocation& OutRange) {
+    const uint64_t alignedSize = (Size + kPlacementAlignment - 1) & ~(kPlacementAlignment - 1);
+
+    // First fit over the blocks; there are only a few of them
+    for (uint32_t index = 0; index < mBlocks.size(); ++index) {
+        const Block& block = mBlocks[index];
+        if (block.Allocator != nullptr &&
+            block.Allocator->Allocate(alignedSize, kPlacementAlignment, OutRange)) {
+            OutBlockIndex = index;
+            return true;
+        }
+    }
+
+    if (alignedSize > kBlockSize) {
+        return false;
+    }
+    const uint32_t index = FindFreeEntry(mBlocks);
+    if (!mBackend->CreateBlock(index)) {
+        return false;
+    }
+    mBlocks[index].Allocator = std::make_unique<TlsfAllocator>(kBlockSize);
+    mBlocks[index].Allocator->Allocate(alignedSize, kPlacementAlignment, OutRange);
+    OutBlockIndex = index;
+    return true;
+}
+
+template <typename T>
+void HeapSuballocator<T>::FreePlaced(uint32_t BlockIndex, const TlsfAllocation& Range) {
+    Block& block = mBlocks[BlockIndex];
+    block.Allocator->Free(Range);
+
+    // Give the memory of an empty block back unless it's the last one, so a buffer created and
+    // released over and over doesn't recreate the heap every time
+    if (block.Allocator->IsEmpty() && CountLive(mBlocks) > 1) {
+        mBackend->ReleaseBlock(BlockIndex);
+        block.Allocator.reset();
+    }
+}
+
+template <typename T>
+bool HeapSuballocator<T>::AllocatePacked(uint64_t Size,
+                                         uint32_t& OutPageIndex,
+                                         TlsfAllocation& OutRange) {
+    const uint64_t alignedSize = (Size + kPackedAlignment - 1) & ~(kPackedAlignment - 1);
+
+    for (uint32_t index = 0; index < mPages.size(); ++index) {
+        const Page& page = mPages[index];
+        if (page.Allocator != nullptr &&
+            page.Allocator->Allocate(alignedSize, kPackedAlignment, OutRange)) {
+            OutPageIndex = index;
+            return true;
+        }
+    }
+
+    uint32_t blockIndex = 0;
+    TlsfAllocation pageRange;
+    if (!AllocatePlaced(kPageSize, blockIndex, pageRange)) {
+        return false;
+    }
+
+    const uint32_t index = FindFreeEntry(mPages);
+    if (!mBackend->CreatePage(index, blockIndex, pageRange.Offset)) {
+        FreePlaced(blockIndex, pageRange);
+        return false;
+    }
+
+    Page& page = mPages[index];
+    page.Allocator = std::make_unique<TlsfAllocator>(kPageSize);
+    page.BlockIndex = blockIndex;
+    page.Range = pageRange;
+    page.Allocator->Allocate(alignedSize, kPackedAlignment, OutRange);
+    OutPageIndex = index;
+    return true;
+}
@@ -0,0 +1,51 @@
+#include "RingAllocator.h"
+
+bool RingAllocator::Allocate(size_t Size, size_t Alignment, size_t& OutOffset) {
+    // An empty ring starts over from the beginning to get the most contiguous space
+    if (mUsedSize == 0 && mFrames.empty()) {
+        mHead = 0;
+        mTail = 0;
+    }
+
+    const size_t offset = (mHead + Alignment - 1) & ~(Alignment - 1);
+
+    size_t consumed;
+    if (mHead >= mTail && mUsedSize < mCapacity) {
+        // The free space is [head, capacity) followed by [0, tail)
+        if (offset + Size <= mCapacity) {
+            consumed = offset + Size - mHead;
+            OutOffset = offset;
+        } else if (Size <= mTail) {
+            // Wrap around; the end of the ring stays unused until this frame gets reclaimed
+            consumed = mCapacity - mHead + Size;
+            OutOffset = 0;
+        } else {
+            return false;
+        }
+    } else {
+        // The free space is [head, tail)
+        if (offset + Size > mTail) {
+            return false;
+        }
+        consumed = offset + Size - mHead;
+        OutOffset = offset;
+    }
+
+    mHead = OutOffset + Size;
+    mUsedSize += consumed;
+    mFrameSize += consumed;
+    return true;
+}
+
+void RingAllocator::EndFrame(uint64_t FenceValue) {
+    mFrames.push_back({FenceValue, mHead, mFrameSize});
+    mFrameSize = 0;
+}
+
+void RingAllocator::Reclaim(uint64_t CompletedFenceValue) {
+    while (!mFrames.empty() && mFrames.front().FenceValue <= CompletedFenceValue) {
+        mTail = mFrames.front().End;
+        mUsedSize -= mFrames.front().Size;
+        mFrames.pop_front();
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+/**
+ * CPU bookkeeping of a ring of memory suballocated linearly frame by frame. Knows nothing about
+ * the memory itself, it only hands out offsets into [0, Capacity).
+ *
+ * The allocations made between two EndFrame calls form a frame tagged with a fence value. Reclaim
+ * frees the oldest frames whose fence values have been completed:
+ *
+ *   |   free   | frame 1 | frame 2 | frame 3 (current) |   free   |
+ *              ^ tail                                  ^ head
+ *
+ * An allocation that doesn't fit before the end of the ring wraps around to offset 0, wasting the
+ * rest of the ring until its frame gets reclaimed.
+ */
+class RingAllocator {
+   public:
+    explicit RingAllocator(size_t Capacity) : mCapacity(Capacity) {}
+
+    // Prohibit copying
+    RingAllocator(const RingAllocator&) = delete;
+    RingAllocator& operator=(const RingAllocator&) = delete;
+
+    /**
+     * Allocates a range of the ring for the current frame.
+     *
+     * @param Size The size of the range in bytes.
+     * @param Alignment The alignment of the range offset; a power of two.
+     * @param OutOffset Output parameter that will be populated with the offset of the range on
+     * success. Unchanged on failure.
+     * @return true if the range was allocated, false if the ring is full.
+     */
+    bool Allocate(size_t Size, size_t Alignment, size_t& OutOffset);
+
+    /**
+     * Closes the current frame. Its allocations get freed by the Reclaim call with the fence value
+     * completed.
+     * @param FenceValue The fence value signaled after the frame's last use of the allocations.
+     */
+    void EndFrame(uint64_t FenceValue);
+
+    /**
+     * Frees the frames up to the completed fence value.
+     */
+    void Reclaim(uint64_t CompletedFenceValue);
+
+    size_t GetCapacity() const {
+        return mCapacity;
+    }
+
+    /**
+     * Returns the number of bytes in use, including the alignment padding and the wasted ring
+     * ends.
+     */
+    size_t GetUsedSize() const {
+        return mUsedSize;
+    }
+
+   private:
+    // The end of a closed frame in the ring
+    struct FrameMark {
+        uint64_t FenceValue;
+        size_t End;
+        size_t Size;
+    };
+
+    size_t mCapacity;
+    size_t mHead{0};
+    size_t mTail{0};
+    size_t mUsedSize{0};
+
+    // Bytes allocated by the current frame
+    size_t mFrameSize{0};
+    std::deque<FrameMark> mFrames;
+};
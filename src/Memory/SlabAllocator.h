@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+/**
+ * Allocator of fixed-size blocks, each the size and the alignment of T, carved out of slabs of
+ * SlabSize blocks. Backs the class operator new of the objects created and destroyed en masse, so
+ * they don't fragment the heap.
+ *
+ * The free blocks form an intrusive LIFO list threaded through the blocks themselves, so Allocate
+ * and Free are O(1) and the last freed block, still hot in the cache, is the next one handed out.
+ * A freed block is always reused: the number of slabs follows the peak number of the live blocks,
+ * however many get allocated and freed over time. The slabs get freed with the allocator only.
+ *
+ * Unlike a SlotPool, the blocks carry no generation, as nothing refers to them by a handle. Not
+ * thread-safe.
+ */
+template <typename T, uint32_t SlabSize = 1024>
+class SlabAllocator {
+   public:
+    static_assert(SlabSize > 0, "The slab size must not be zero.");
+
+    SlabAllocator() = default;
+    ~SlabAllocator() = default;
+
+    // Prohibit copying and moving as the blocks handed out point into the slabs
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+    SlabAllocator(SlabAllocator&&) = delete;
+    SlabAllocator& operator=(SlabAllocator&&) = delete;
+
+    /**
+     * Returns an uninitialized block for a T. Adds a slab if no block is free.
+     * @throws std::bad_alloc if a new slab can't be allocated.
+     */
+    void* Allocate() {
+        if (!mFreeHead) {
+            mSlabs.push_back(std::make_unique<Block[]>(SlabSize));
+
+            // Thread the new blocks in order, so they get handed out by increasing address
+            Block* slab = mSlabs.back().get();
+            for (uint32_t i = SlabSize; i-- > 0;) {
+                slab[i].NextFree = mFreeHead;
+                mFreeHead = &slab[i];
+            }
+        }
+
+        Block* block = mFreeHead;
+        mFreeHead = block->NextFree;
+        ++mBlockCount;
+        return block->Storage;
+    }
+
+    /**
+     * Returns the block to the free list; it has to come from Allocate of this allocator.
+     */
+    void Free(void* Memory) {
+        // The storage is the first member of the block
+        Block* block = static_cast<Block*>(Memory);
+        block->NextFree = mFreeHead;
+        mFreeHead = block;
+        --mBlockCount;
+    }
+
+    /**
+     * Returns the number of the blocks handed out and not freed yet.
+     */
+    size_t GetBlockCount() const {
+        return mBlockCount;
+    }
+
+    /**
+     * Returns the number of the blocks of all the slabs, free or not.
+     */
+    size_t GetCapacity() const {
+        return mSlabs.size() * SlabSize;
+    }
+
+   private:
+    union Block {
+        alignas(T) std::byte Storage[sizeof(T)];
+        // The next free block while the block is free
+        Block* NextFree;
+    };
+
+    std::vector<std::unique_ptr<Block[]>> mSlabs;
+
+    // The head of the free block list; nullptr if it's empty
+    Block* mFreeHead{nullptr};
+    size_t mBlockCount{0};
+};
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * A generational handle to an item of a SlotPool: the slot index in the low kIndexBits bits and
+ * the generation of the slot in the rest.
+ */
+using SlotHandle = uint32_t;
+
+/**
+ * Pool of items in fixed-size slots, addressed by generational handles. The slots live in slabs
+ * of SlabSize that never move or get freed before the pool, so the items keep their addresses and
+ * creating or destroying one doesn't touch the heap once the slabs are in place.
+ *
+ * Every slot counts the items it held. A handle carries the count of its item, so the handles of
+ * the destroyed items fail IsValid without being tracked:
+ *
+ *   slot 3, generation 5:  | item A |  handle (5 << kIndexBits) | 3 resolves to A
+ *   A destroyed, B created: | item B |  the same handle fails, B is (6 << kIndexBits) | 3
+ *
+ * A slot gets retired once its generation wraps around instead of being reused, so a stale handle
+ * never resolves to another item.
+ *
+ * Create and Destroy are O(1): the free slots form a LIFO list, so the last freed slot, still hot
+ * in the cache, is the next one used. The items are iterated in the slot order, which creating and
+ * destroying other items doesn't change. Not thread-safe.
+ */
+template <typename T, uint32_t SlabSize = 1024>
+class SlotPool {
+   public:
+    static constexpr uint32_t kIndexBits = 20;
+    static constexpr uint32_t kIndexMask = (1u << kIndexBits) - 1;
+    static constexpr uint32_t kGenerationMask = (1u << (32 - kIndexBits)) - 1;
+
+    static constexpr SlotHandle kInvalidHandle = std::numeric_limits<SlotHandle>::max();
+
+    // The index kIndexMask is left out, so that no valid handle equals kInvalidHandle
+    static constexpr uint32_t kMaxSlotCount = kIndexMask;
+
+    static_assert(SlabSize > 0 && (SlabSize & (SlabSize - 1)) == 0,
+                  "The slab size must be a power of two.");
+
+    SlotPool() = default;
+
+    ~SlotPool() {
+        Release();
+    }
+
+    // Prohibit copying
+    SlotPool(const SlotPool&) = delete;
+    SlotPool& operator=(const SlotPool&) = delete;
+
+    // Allow moving
+    SlotPool(SlotPool&& Other) noexcept
+        : mSlabs(std::move(Other.mSlabs)),
+          mSlotCount(std::exchange(Other.mSlotCount, 0)),
+          mItemCount(std::exchange(Other.mItemCount, 0)),
+          mFreeHead(std::exchange(Other.mFreeHead, kIndexMask)) {}
+
+    SlotPool& operator=(SlotPool&& Other) noexcept {
+        if (this != &Other) {
+            Release();
+            mSlabs = std::move(Other.mSlabs);
+            mSlotCount = std::exchange(Other.mSlotCount, 0);
+            mItemCount = std::exchange(Other.mItemCount, 0);
+            mFreeHead = std::exchange(Other.mFreeHead, kIndexMask);
+        }
+        return *this;
+    }
+
+    /**
+     * Constructs an item in a free slot.
+     * @param Arguments The arguments of the item constructor.
+     * @return The handle of the item, or kInvalidHandle if all the kMaxSlotCount slots are taken.
+     */
+    template <typename... Args>
+    SlotHandle Create(Args&&... Arguments) {
+        uint32_t index;
+        if (mFreeHead != kIndexMask) {
+            index = mFreeHead;
+            mFreeHead = GetSlot(index).NextFree;
+        } else {
+            if (mSlotCount >= kMaxSlotCount) {
+                return kInvalidHandle;
+            }
+
+            index = mSlotCount++;
+            if (index % SlabSize == 0) {
+                mSlabs.push_back(std::make_unique<Slot[]>(SlabSize));
+            }
+        }
+
+        Slot& slot = GetSlot(index);
+        new (slot.Storage) T(std::forward<Args>(Arguments)...);
+        slot.IsLive = true;
+        ++mItemCount;
+        return MakeHandle(index, slot.Generation);
+    }
+
+    /**
+     * Destroys the item; its handle and the copies of it go stale.
+     * @return true if the item was destroyed, false if the handle is already stale.
+     */
+    bool Destroy(SlotHandle Handle) {
+        if (!IsValid(Handle)) {
+            return false;
+        }
+
+        const uint32_t index = Handle & kIndexMask;
+        Slot& slot = GetSlot(index);
+        GetItem(slot)->~T();
+        slot.IsLive = false;
+        --mItemCount;
+
+        // Retire the slot once the generation wraps around
+        slot.Generation = (slot.Generation + 1) & kGenerationMask;
+        if (slot.Generation != 0) {
+            slot.NextFree = mFreeHead;
+            mFreeHead = index;
+        }
+        return true;
+    }
+
+    bool IsValid(SlotHandle Handle) const {
+        const uint32_t index = Handle & kIndexMask;
+        if (index >= mSlotCount) {
+            return false;
+        }
+
+        const Slot& slot = GetSlot(index);
+        return slot.IsLive && slot.Generation == Handle >> kIndexBits;
+    }
+
+    /**
+     * Returns the item, or nullptr if the handle is stale.
+     */
+    T* Get(SlotHandle Handle) {
+        return IsValid(Handle) ? GetItem(GetSlot(Handle & kIndexMask)) : nullptr;
+    }
+
+    const T* Get(SlotHandle Handle) const {
+        return IsValid(Handle) ? GetItem(GetSlot(Handle & kIndexMask)) : nullptr;
+    }
+
+    /**
+     * Calls Function(SlotHandle, T&) for every item in the slot order. The function must not
+     * create or destroy items.
+     */
+    template <typename Fn>
+    void ForEach(Fn&& Function) {
+        for (uint32_t index = 0; index < mSlotCount; ++index) {
+            Slot& slot = GetSlot(index);
+            if (slot.IsLive) {
+                Function(MakeHandle(index, slot.Generation), *GetItem(slot));
+            }
+        }
+    }
+
+    /**
+     * Returns the number of the items.
+     */
+    uint32_t GetCount() const {
+        return mItemCount;
+    }
+
+    /**
+     * Returns the number of the slots ever used, including the free and retired ones.
+     */
+    uint32_t GetSlotCount() const {
+        return mSlotCount;
+    }
+
+   private:
+    struct Slot {
+        alignas(T) std::byte Storage[sizeof(T)];
+        // The next free slot while the slot is free
+        uint32_t NextFree;
+        uint32_t Generation;
+        bool IsLive;
+    };
+
+    static SlotHandle MakeHandle(uint32_t Index, uint32_t Generation) {
+        return (Generation << kIndexBits) | Index;
+    }
+
+    static T* GetItem(Slot& Slot) {
+        return std::launder(reinterpret_cast<T*>(Slot.Storage));
+    }
+
+    static const T* GetItem(const Slot& Slot) {
+        return std::launder(reinterpret_cast<const T*>(Slot.Storage));
+    }
+
+    Slot& GetSlot(uint32_t Index) {
+        return mSlabs[Index / SlabSize][Index % SlabSize];
+    }
+
+    const Slot& GetSlot(uint32_t Index) const {
+        return mSlabs[Index / SlabSize][Index % SlabSize];
+    }
+
+    /**
+     * Destroys all the items and frees the slabs.
+     */
+    void Release() {
+        for (uint32_t index = 0; index < mSlotCount; ++index) {
+            Slot& slot = GetSlot(index);
+            if (slot.IsLive) {
+                GetItem(slot)->~T();
+            }
+        }
+
+        mSlabs.clear();
+        mSlotCount = 0;
+        mItemCount = 0;
+        mFreeHead = kIndexMask;
+    }
+
+    std::vector<std::unique_ptr<Slot[]>> mSlabs;
+    uint32_t mSlotCount{0};
+    uint32_t mItemCount{0};
+
+    // The head of the free slot list; kIndexMask if it's empty
+    uint32_t mFreeHead{kIndexMask};
+};
@@ -0,0 +1,56 @@
+#include "StreamingCopy.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#include <emmintrin.h>
+#define HAS_STREAMING_STORES 1
+#endif
+
+void StreamingCopy(void* Destination, const void* Source, size_t Size) {
+#ifdef HAS_STREAMING_STORES
+    constexpr size_t kStoreSize = sizeof(__m128i);
+    auto* destination = static_cast<std::byte*>(Destination);
+    auto* source = static_cast<const std::byte*>(Source);
+
+    // The streaming stores need the destination aligned; the head up to it gets copied as is
+    const size_t misalignment = reinterpret_cast<uintptr_t>(destination) % kStoreSize;
+    const size_t headSize = std::min(Size, misalignment ? kStoreSize - misalignment : 0);
+    memcpy(destination, source, headSize);
+    destination += headSize;
+    source += headSize;
+    Size -= headSize;
+
+    // 64 bytes at a time fill a whole write-combining line
+    for (; Size >= 4 * kStoreSize; Size -= 4 * kStoreSize) {
+        const __m128i* from = reinterpret_cast<const __m128i*>(source);
+        __m128i* to = reinterpret_cast<__m128i*>(destination);
+        const __m128i a = _mm_loadu_si128(from + 0);
+        const __m128i b = _mm_loadu_si128(from + 1);
+        const __m128i c = _mm_loadu_si128(from + 2);
+        const __m128i d = _mm_loadu_si128(from + 3);
+        _mm_stream_si128(to + 0, a);
+        _mm_stream_si128(to + 1, b);
+        _mm_stream_si128(to + 2, c);
+        _mm_stream_si128(to + 3, d);
+        destination += 4 * kStoreSize;
+        source += 4 * kStoreSize;
+    }
+
+    for (; Size >= kStoreSize; Size -= kStoreSize) {
+        _mm_stream_si128(reinterpret_cast<__m128i*>(destination),
+                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)));
+        destination += kStoreSize;
+        source += kStoreSize;
+    }
+
+    memcpy(destination, source, Size);
+
+    // Order the streaming stores before anything the CPU does next, e.g. executing the list
+    _mm_sfence();
+#else
+    memcpy(Destination, Source, Size);
+#endif
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Copies the bytes into write-combined memory, e.g. a mapped upload heap, with non-temporal
+ * streaming stores. The stores bypass the cache and fill whole write-combining lines, while the
+ * destination never gets read back. Falls back to memcpy where the streaming stores aren't
+ * available.
+ *
+ * The stores are fenced before returning, so the data is visible to the GPU once the command list
+ * reading it gets executed.
+ */
+void StreamingCopy(void* Destination, const void* Source, size_t Size);
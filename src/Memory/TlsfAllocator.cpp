@@ -0,0 +1,235 @@
+#include "TlsfAllocator.h"
+
+#include <algorithm>
+#include <bit>
+
+TlsfAllocator::TlsfAllocator(uint64_t Capacity) : mCapacity(Capacity) {
+    for (auto& lists : mFreeLists) {
+        std::fill(std::begin(lists), std::end(lists), kInvalidBlock);
+    }
+
+    // The whole capacity starts as one free block
+    if (Capacity > 0) {
+        const uint32_t index = NewBlock();
+        mBlocks[index] = {0, Capacity, kInvalidBlock, kInvalidBlock, kInvalidBlock, kInvalidBlock,
+                          true};
+        InsertFreeBlock(index);
+    }
+}
+
+bool TlsfAllocator::Allocate(uint64_t Size, uint64_t Alignment, TlsfAllocation& OutAllocation) {
+    if (Size == 0 || Size > GetFreeSize()) {
+        return false;
+    }
+
+    // The blocks are mostly aligned already as the allocations usually share the alignment, so
+    // look for a block of the exact size first, and for one with the room to align only then
+    uint32_t index = FindFreeBlock(Size);
+    if (index != kInvalidBlock && (mBlocks[index].Offset & (Alignment - 1)) != 0) {
+        const uint64_t padding = Alignment - (mBlocks[index].Offset & (Alignment - 1));
+        if (mBlocks[index].Size < Size + padding) {
+            index = kInvalidBlock;
+        }
+    }
+    if (index == kInvalidBlock && Alignment > 1) {
+        if (Size > mCapacity - (Alignment - 1)) {
+            return false;
+        }
+        index = FindFreeBlock(Size + Alignment - 1);
+    }
+    if (index == kInvalidBlock) {
+        return false;
+    }
+
+    RemoveFreeBlock(index);
+
+    // Give the padding in front of the aligned offset back as a free block
+    const uint64_t misalignment = mBlocks[index].Offset & (Alignment - 1);
+    if (misalignment != 0) {
+        const uint32_t aligned = SplitBlock(index, Alignment - misalignment);
+        InsertFreeBlock(index);
+        index = aligned;
+    }
+
+    // Give the tail back as a free block
+    if (mBlocks[index].Size > Size) {
+        InsertFreeBlock(SplitBlock(index, Size));
+    }
+
+    Block& block = mBlocks[index];
+    block.IsFree = false;
+    mUsedSize += block.Size;
+    ++mAllocationCount;
+
+    OutAllocation.Offset = block.Offset;
+    OutAllocation.Size = block.Size;
+    OutAllocation.BlockIndex = index;
+    return true;
+}
+
+void TlsfAllocator::Free(const TlsfAllocation& Allocation) {
+    uint32_t index = Allocation.BlockIndex;
+    mUsedSize -= mBlocks[index].Size;
+    --mAllocationCount;
+
+    // Coalesce with the free neighbors, so the free blocks never border each other
+    const uint32_t next = mBlocks[index].NextPhysical;
+    if (next != kInvalidBlock && mBlocks[next].IsFree) {
+        RemoveFreeBlock(next);
+        MergeNext(index);
+    }
+
+    const uint32_t prev = mBlocks[index].PrevPhysical;
+    if (prev != kInvalidBlock && mBlocks[prev].IsFree) {
+        RemoveFreeBlock(prev);
+        MergeNext(prev);
+        index = prev;
+    }
+
+    InsertFreeBlock(index);
+}
+
+uint64_t TlsfAllocator::GetLargestFreeSize() const {
+    if (mFirstLevelBitmap == 0) {
+        return 0;
+    }
+
+    // The largest block is in the highest non-empty list; the list holds a range of sizes
+    const uint32_t firstLevel = 63 - std::countl_zero(mFirstLevelBitmap);
+    const uint32_t secondLevel = 31 - std::countl_zero(mSecondLevelBitmaps[firstLevel]);
+
+    uint64_t largest = 0;
+    for (uint32_t index = mFreeLists[firstLevel][secondLevel]; index != kInvalidBlock;
+         index = mBlocks[index].NextFree) {
+        largest = std::max(largest, mBlocks[index].Size);
+    }
+    return largest;
+}
+
+void TlsfAllocator::MapSize(uint64_t Size, uint32_t& OutFirstLevel, uint32_t& OutSecondLevel) {
+    if (Size < kSecondLevelCount) {
+        // The small sizes get a list each
+        OutFirstLevel = 0;
+        OutSecondLevel = static_cast<uint32_t>(Size);
+        return;
+    }
+
+    const uint32_t msb = static_cast<uint32_t>(std::bit_width(Size)) - 1;
+    OutFirstLevel = msb - kSecondLevelBits + 1;
+    OutSecondLevel = static_cast<uint32_t>(Size >> (msb - kSecondLevelBits)) - kSecondLevelCount;
+}
+
+uint32_t TlsfAllocator::FindFreeBlock(uint64_t Size) const {
+    // Round the size up to the next list, so any block of that list fits
+    if (Size >= kSecondLevelCount) {
+        const uint32_t msb = static_cast<uint32_t>(std::bit_width(Size)) - 1;
+        Size += (1ull << (msb - kSecondLevelBits)) - 1;
+    }
+
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    MapSize(Size, firstLevel, secondLevel);
+    if (firstLevel >= kFirstLevelCount) {
+        return kInvalidBlock;
+    }
+
+    // A non-empty list at the first level, or the smallest one at the higher first levels
+    uint32_t secondLevelMap = mSecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+    if (secondLevelMap == 0) {
+        const uint64_t firstLevelMap =
+            firstLevel + 1 < 64 ? mFirstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+        if (firstLevelMap == 0) {
+            return kInvalidBlock;
+        }
+        firstLevel = static_cast<uint32_t>(std::countr_zero(firstLevelMap));
+        secondLevelMap = mSecondLevelBitmaps[firstLevel];
+    }
+
+    secondLevel = static_cast<uint32_t>(std::countr_zero(secondLevelMap));
+    return mFreeLists[firstLevel][secondLevel];
+}
+
+void TlsfAllocator::InsertFreeBlock(uint32_t Index) {
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    MapSize(mBlocks[Index].Size, firstLevel, secondLevel);
+
+    Block& block = mBlocks[Index];
+    const uint32_t head = mFreeLists[firstLevel][secondLevel];
+    block.IsFree = true;
+    block.PrevFree = kInvalidBlock;
+    block.NextFree = head;
+    if (head != kInvalidBlock) {
+        mBlocks[head].PrevFree = Index;
+    }
+    mFreeLists[firstLevel][secondLevel] = Index;
+
+    mFirstLevelBitmap |= 1ull << firstLevel;
+    mSecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+    ++mFreeBlockCount;
+}
+
+void TlsfAllocator::RemoveFreeBlock(uint32_t Index) {
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    MapSize(mBlocks[Index].Size, firstLevel, secondLevel);
+
+    const Block& block = mBlocks[Index];
+    if (block.PrevFree != kInvalidBlock) {
+        mBlocks[block.PrevFree].NextFree = block.NextFree;
+    } else {
+        mFreeLists[firstLevel][secondLevel] = block.NextFree;
+    }
+    if (block.NextFree != kInvalidBlock) {
+        mBlocks[block.NextFree].PrevFree = block.PrevFree;
+    }
+
+    if (mFreeLists[firstLevel][secondLevel] == kInvalidBlock) {
+        mSecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+        if (mSecondLevelBitmaps[firstLevel] == 0) {
+            mFirstLevelBitmap &= ~(1ull << firstLevel);
+        }
+    }
+
+    mBlocks[Index].IsFree = false;
+    --mFreeBlockCount;
+}
+
+uint32_t TlsfAllocator::SplitBlock(uint32_t Index, uint64_t Size) {
+    // May reallocate the blocks, so no references are held across it
+    const uint32_t tail = NewBlock();
+
+    Block& block = mBlocks[Index];
+    mBlocks[tail] = {block.Offset + Size, block.Size - Size, Index, block.NextPhysical,
+                     kInvalidBlock, kInvalidBlock, false};
+    if (block.NextPhysical != kInvalidBlock) {
+        mBlocks[block.NextPhysical].PrevPhysical = tail;
+    }
+    block.NextPhysical = tail;
+    block.Size = Size;
+    return tail;
+}
+
+void TlsfAllocator::MergeNext(uint32_t Index) {
+    Block& block = mBlocks[Index];
+    const uint32_t next = block.NextPhysical;
+
+    block.Size += mBlocks[next].Size;
+    block.NextPhysical = mBlocks[next].NextPhysical;
+    if (block.NextPhysical != kInvalidBlock) {
+        mBlocks[block.NextPhysical].PrevPhysical = Index;
+    }
+
+    mUnusedBlocks.push_back(next);
+}
+
+uint32_t TlsfAllocator::NewBlock() {
+    if (!mUnusedBlocks.empty()) {
+        const uint32_t index = mUnusedBlocks.back();
+        mUnusedBlocks.pop_back();
+        return index;
+    }
+
+    mBlocks.emplace_back();
+    return static_cast<uint32_t>(mBlocks.size() - 1);
+}
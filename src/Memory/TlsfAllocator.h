@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * A range handed out by the TlsfAllocator. The block index identifies it on Free.
+ */
+struct TlsfAllocation {
+    uint64_t Offset{0};
+    uint64_t Size{0};
+    uint32_t BlockIndex{std::numeric_limits<uint32_t>::max()};
+};
+
+/**
+ * Two-Level Segregated Fit allocator. Pure CPU bookkeeping of the ranges of [0, Capacity); it knows
+ * nothing about the memory itself, so it can back any kind of memory, e.g. GPU heaps or descriptor
+ * heaps.
+ *
+ * The free blocks are kept in lists segregated by size: the first level splits the sizes into
+ * powers of two, the second level splits every power of two into kSecondLevelCount linear ranges.
+ * Two levels of bitmaps track the non-empty lists, so both Allocate and Free are O(1): a couple of
+ * bit scans to find a list with a large enough block, and merging with the physical neighbors on
+ * Free.
+ *
+ * Example with kSecondLevelCount = 4; sizes 64..127 are split into 64..79, 80..95, 96..111,
+ * 112..127. A request for 70 gets rounded up to the next range, 80, so that any block found in the
+ * 80..95 list or above fits without searching the list.
+ */
+class TlsfAllocator {
+   public:
+    static constexpr uint32_t kInvalidBlock = std::numeric_limits<uint32_t>::max();
+
+    static constexpr uint32_t kSecondLevelBits = 5;
+    static constexpr uint32_t kSecondLevelCount = 1u << kSecondLevelBits;
+    static constexpr uint32_t kFirstLevelCount = 64 - kSecondLevelBits + 1;
+
+    explicit TlsfAllocator(uint64_t Capacity);
+
+    // Prohibit copying
+    TlsfAllocator(const TlsfAllocator&) = delete;
+    TlsfAllocator& operator=(const TlsfAllocator&) = delete;
+
+    // Allow moving
+    TlsfAllocator(TlsfAllocator&&) noexcept = default;
+    TlsfAllocator& operator=(TlsfAllocator&&) noexcept = default;
+
+    /**
+     * Allocates a range.
+     *
+     * @param Size The size of the range; greater than zero.
+     * @param Alignment The alignment of the range offset; a power of two.
+     * @param OutAllocation Output parameter that will be populated with the range on success.
+     * Unchanged on failure.
+     * @return true if the range was allocated, false if no free block is large enough.
+     */
+    bool Allocate(uint64_t Size, uint64_t Alignment, TlsfAllocation& OutAllocation);
+
+    /**
+     * Frees the range, merging it with the free neighbor ranges.
+     */
+    void Free(const TlsfAllocation& Allocation);
+
+    uint64_t GetCapacity() const {
+        return mCapacity;
+    }
+
+    uint64_t GetUsedSize() const {
+        return mUsedSize;
+    }
+
+    uint64_t GetFreeSize() const {
+        return mCapacity - mUsedSize;
+    }
+
+    uint32_t GetAllocationCount() const {
+        return mAllocationCount;
+    }
+
+    uint32_t GetFreeBlockCount() const {
+        return mFreeBlockCount;
+    }
+
+    bool IsEmpty() const {
+        return mAllocationCount == 0;
+    }
+
+    /**
+     * Returns the size of the largest free block. Allocations slightly smaller than it may still
+     * fail, as the requests get rounded up to the next list.
+     */
+    uint64_t GetLargestFreeSize() const;
+
+    /**
+     * Returns the part of the free space unusable for an allocation of the whole free size, in
+     * [0, 1]: 0 when all the free space is one block, close to 1 when it's scattered in small
+     * blocks.
+     */
+    float GetFragmentation() const {
+        const uint64_t freeSize = GetFreeSize();
+        return freeSize == 0 ? 0.f
+                             : 1.f - static_cast<float>(GetLargestFreeSize()) /
+                                         static_cast<float>(freeSize);
+    }
+
+   private:
+    struct Block {
+        uint64_t Offset;
+        uint64_t Size;
+
+        // Neighbor blocks in the address order
+        uint32_t PrevPhysical;
+        uint32_t NextPhysical;
+
+        // Neighbor blocks in the free list; only valid for the free blocks
+        uint32_t PrevFree;
+        uint32_t NextFree;
+
+        bool IsFree;
+    };
+
+    /**
+     * Returns the list indices of the blocks of the given size.
+     */
+    static void MapSize(uint64_t Size, uint32_t& OutFirstLevel, uint32_t& OutSecondLevel);
+
+    /**
+     * Finds a free block at least the size of Size; kInvalidBlock if there's none.
+     */
+    uint32_t FindFreeBlock(uint64_t Size) const;
+
+    void InsertFreeBlock(uint32_t Index);
+    void RemoveFreeBlock(uint32_t Index);
+
+    /**
+     * Splits the block at Offset + Size, returns the index of the tail block.
+     */
+    uint32_t SplitBlock(uint32_t Index, uint64_t Size);
+
+    /**
+     * Merges the next physical block into the block and retires it.
+     */
+    void MergeNext(uint32_t Index);
+
+    uint32_t NewBlock();
+
+    uint64_t mCapacity;
+    uint64_t mUsedSize{0};
+    uint32_t mAllocationCount{0};
+    uint32_t mFreeBlockCount{0};
+
+    // Bit per first level with a non-empty list, and per second level of every first level
+    uint64_t mFirstLevelBitmap{0};
+    uint32_t mSecondLevelBitmaps[kFirstLevelCount]{};
+    uint32_t mFreeLists[kFirstLevelCount][kSecondLevelCount];
+
+    std::vector<Block> mBlocks;
+    std::vector<uint32_t> mUnusedBlocks;
+};
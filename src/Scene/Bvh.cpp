@@ -0,0 +1,826 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+
+// The cost of visiting a node relative to testing an item
+constexpr float kTraversalCost = 1.f;
+
+// A box every merge overwrites
+constexpr float kEmptyMin = FLT_MAX;
+constexpr float kEmptyMax = -FLT_MAX;
+
+// The refit flags of the nodes changed by the refit
+constexpr uint8_t kChangedNode = 1;
+constexpr uint8_t kDegradedNode = 2;
+
+void Bvh::SetBounds(uint32_t Id, const AABB& Bounds) {
+    if (Bounds.IsEmpty()) {
+        Remove(Id);
+        return;
+    }
+
+    if (Contains(Id)) {
+        const uint32_t position = mItemPositions[Id];
+        mItems[position].Bounds = ToBox(Bounds);
+
+        // The items waiting for the insertion have no leaf yet
+        if (mItemLeaves[position] != kInvalidIndex) {
+            QueueRefit(mItemLeaves[position]);
+        }
+        return;
+    }
+
+    if (Id >= mItemPositions.size()) {
+        mItemPositions.resize(static_cast<size_t>(Id) + 1, kInvalidIndex);
+    }
+    const uint32_t position = static_cast<uint32_t>(mItems.size());
+    mItemPositions[Id] = position;
+    mItems.push_back({ToBox(Bounds), Id});
+    mItemLeaves.push_back(kInvalidIndex);
+    mPendingItems.push_back(position);
+}
+
+void Bvh::Remove(uint32_t Id) {
+    if (!Contains(Id)) {
+        return;
+    }
+
+    const uint32_t position = mItemPositions[Id];
+    mItemPositions[Id] = kInvalidIndex;
+
+    // Not inserted yet; Update skips it
+    const uint32_t leaf = mItemLeaves[position];
+    if (leaf == kInvalidIndex) {
+        KillItem(position);
+        return;
+    }
+
+    // Fill the hole with the last item of the leaf, so its items stay contiguous
+    const uint32_t last = mNodes[leaf].Offset + GetNodeItemCount(mNodes[leaf]) - 1;
+    if (position != last) {
+        mItems[position] = mItems[last];
+        mItemPositions[mItems[position].Id] = position;
+    }
+    KillItem(last);
+
+    for (uint32_t node = leaf; node != kInvalidIndex; node = mParents[node]) {
+        --mNodes[node].ItemCount;
+    }
+
+    if (GetNodeItemCount(mNodes[leaf]) > 0) {
+        QueueRefit(leaf);
+    } else {
+        RemoveLeaf(leaf);
+    }
+}
+
+void Bvh::Update() {
+    size_t pendingCount = 0;
+    for (uint32_t position : mPendingItems) {
+        pendingCount += IsAlive(position) ? 1 : 0;
+    }
+
+    // A new scene or a large part of one goes faster and comes out better with a single build
+    if (pendingCount > 0 && (mNodes.empty() || pendingCount * kBulkInsertRatio > GetItemCount())) {
+        Build();
+        return;
+    }
+
+    for (uint32_t position : mPendingItems) {
+        if (IsAlive(position)) {
+            InsertItem(position);
+        }
+    }
+    mPendingItems.clear();
+
+    if (!mRefitNodes.empty()) {
+        Refit();
+    }
+
+    if (mDeadItemCount > GetItemCount()) {
+        CompactItems();
+    }
+}
+
+void Bvh::Build() {
+    std::erase_if(mItems, [](const Item& Item) { return Item.Id == kInvalidIndex; });
+    const uint32_t itemCount = static_cast<uint32_t>(mItems.size());
+    mItemLeaves.assign(itemCount, kInvalidIndex);
+    mDeadItemCount = 0;
+    mPendingItems.clear();
+
+    mNodes.clear();
+    mParents.clear();
+    mBuildAreas.clear();
+    mIsRefitQueued.clear();
+    mFreeNodePairs.clear();
+    mRefitNodes.clear();
+
+    if (itemCount > 0) {
+        const size_t nodeCount = 2 * static_cast<size_t>(itemCount) - 1;
+        mNodes.reserve(nodeCount);
+        mParents.reserve(nodeCount);
+        mBuildAreas.reserve(nodeCount);
+        mIsRefitQueued.reserve(nodeCount);
+
+        // The root comes alone, the rest in pairs
+        mNodes.emplace_back();
+        mParents.push_back(kInvalidIndex);
+        mBuildAreas.push_back(0.f);
+        mIsRefitQueued.push_back(false);
+        BuildSubtree(0, 0, itemCount, kInvalidIndex);
+    }
+
+    ++mBuildCount;
+}
+
+void Bvh::BuildSubtree(uint32_t NodeIndex, uint32_t Begin, uint32_t End, uint32_t Parent) {
+    struct BuildTask {
+        uint32_t NodeIndex;
+        uint32_t Begin;
+        uint32_t End;
+        uint32_t Parent;
+    };
+
+    // Depth-first with an explicit stack, so a lopsided split can't overflow the call stack
+    std::vector<BuildTask> tasks;
+    tasks.push_back({NodeIndex, Begin, End, Parent});
+    while (!tasks.empty()) {
+        const BuildTask task = tasks.back();
+        tasks.pop_back();
+
+        Box bounds = {{kEmptyMin, kEmptyMin, kEmptyMin}, {kEmptyMax, kEmptyMax, kEmptyMax}};
+        Box centroidBounds = bounds;
+        for (uint32_t i = task.Begin; i < task.End; ++i) {
+            const Box& itemBounds = mItems[i].Bounds;
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                const float centroid = 0.5f * (itemBounds.Min[axis] + itemBounds.Max[axis]);
+                bounds.Min[axis] = std::min(bounds.Min[axis], itemBounds.Min[axis]);
+                bounds.Max[axis] = std::max(bounds.Max[axis], itemBounds.Max[axis]);
+                centroidBounds.Min[axis] = std::min(centroidBounds.Min[axis], centroid);
+                centroidBounds.Max[axis] = std::max(centroidBounds.Max[axis], centroid);
+            }
+        }
+
+        const uint32_t middle = Split(task.Begin, task.End, bounds, centroidBounds);
+
+        // Allocated before taking the node, as it may grow the nodes
+        const uint32_t children = middle == task.Begin ? kInvalidIndex : AllocateNodePair();
+
+        BvhNode& node = mNodes[task.NodeIndex];
+        std::copy_n(bounds.Min, 3, node.Min);
+        std::copy_n(bounds.Max, 3, node.Max);
+        mParents[task.NodeIndex] = task.Parent;
+        mBuildAreas[task.NodeIndex] = GetSurfaceArea(bounds);
+
+        if (children == kInvalidIndex) {
+            node.ItemCount = (task.End - task.Begin) | kLeafFlag;
+            node.Offset = task.Begin;
+            for (uint32_t i = task.Begin; i < task.End; ++i) {
+                mItemLeaves[i] = task.NodeIndex;
+                mItemPositions[mItems[i].Id] = i;
+            }
+            continue;
+        }
+
+        node.ItemCount = task.End - task.Begin;
+        node.Offset = children;
+
+        tasks.push_back({children + 1, middle, task.End, task.NodeIndex});
+        tasks.push_back({children, task.Begin, middle, task.NodeIndex});
+    }
+}
+
+void Bvh::RebuildSubtree(uint32_t NodeIndex) {
+    // Free the nodes below and find where the items of the subtree are
+    uint32_t begin = kInvalidIndex;
+    uint32_t end = 0;
+    const uint32_t itemCount = GetNodeItemCount(mNodes[NodeIndex]);
+
+    std::vector<uint32_t> stack;
+    std::vector<uint32_t> leaves;
+    stack.push_back(NodeIndex);
+    while (!stack.empty()) {
+        const uint32_t nodeIndex = stack.back();
+        stack.pop_back();
+
+        const BvhNode& node = mNodes[nodeIndex];
+        if (IsLeaf(node)) {
+            begin = std::min(begin, node.Offset);
+            end = std::max(end, node.Offset + GetNodeItemCount(node));
+            leaves.push_back(nodeIndex);
+            continue;
+        }
+
+        // The freed nodes keep their contents until they get reused by the build below
+        stack.push_back(node.Offset);
+        stack.push_back(node.Offset + 1);
+        FreeNodePair(node.Offset);
+    }
+
+    // The insertions and the removals have scattered the items; gather them at the end
+    if (end - begin != itemCount) {
+        begin = static_cast<uint32_t>(mItems.size());
+        for (uint32_t leaf : leaves) {
+            const uint32_t first = mNodes[leaf].Offset;
+            const uint32_t last = first + GetNodeItemCount(mNodes[leaf]);
+            for (uint32_t i = first; i < last; ++i) {
+                const Item item = mItems[i];
+                mItems.push_back(item);
+                mItemLeaves.push_back(kInvalidIndex);
+                KillItem(i);
+            }
+        }
+        end = static_cast<uint32_t>(mItems.size());
+    }
+
+    BuildSubtree(NodeIndex, begin, end, mParents[NodeIndex]);
+}
+
+void Bvh::InsertItem(uint32_t Position) {
+    const Box& bounds = mItems[Position].Bounds;
+
+    // Descend into the child growing the least
+    uint32_t leaf = 0;
+    while (!IsLeaf(mNodes[leaf])) {
+        ++mNodes[leaf].ItemCount;
+
+        const uint32_t children = mNodes[leaf].Offset;
+        float growths[2];
+        for (uint32_t c = 0; c < 2; ++c) {
+            const Box childBounds = GetNodeBounds(mNodes[children + c]);
+            growths[c] =
+                GetSurfaceArea(Merge(childBounds, bounds)) - GetSurfaceArea(childBounds);
+        }
+        leaf = growths[0] <= growths[1] ? children : children + 1;
+    }
+
+    // The leaf moves into the first child and the item into the second one
+    const uint32_t children = AllocateNodePair();
+    MoveNode(leaf, children);
+    mParents[children] = leaf;
+    BuildSubtree(children + 1, Position, Position + 1, leaf);
+
+    BvhNode& node = mNodes[leaf];
+    const Box mergedBounds = Merge(GetNodeBounds(mNodes[children]), bounds);
+    node.ItemCount = GetNodeItemCount(mNodes[children]) + 1;
+    node.Offset = children;
+    mBuildAreas[leaf] = GetSurfaceArea(mergedBounds);
+
+    // Refitting the new parent refits the ancestors the item grows
+    QueueRefit(leaf);
+}
+
+void Bvh::RemoveLeaf(uint32_t NodeIndex) {
+    const uint32_t parent = mParents[NodeIndex];
+    if (parent == kInvalidIndex) {
+        // The last item is gone
+        mNodes.clear();
+        mParents.clear();
+        mBuildAreas.clear();
+        mIsRefitQueued.clear();
+        mFreeNodePairs.clear();
+        mRefitNodes.clear();
+        return;
+    }
+
+    // The sibling takes the place of the parent; it holds all the items of the parent now
+    const uint32_t children = mNodes[parent].Offset;
+    const uint32_t sibling = NodeIndex == children ? children + 1 : children;
+    MoveNode(sibling, parent);
+    FreeNodePair(children);
+
+    // The parent has the bounds of the sibling already; its ancestors may shrink
+    if (mParents[parent] != kInvalidIndex) {
+        QueueRefit(mParents[parent]);
+    }
+}
+
+void Bvh::Refit() {
+    for (uint32_t node : mRefitNodes) {
+        mIsRefitQueued[node] = false;
+    }
+
+    // Refit bottom-up from every queued node. The ancestors whose bounds stay the same cut the
+    // walk short, as nothing above them changes either
+    mChangedNodes.clear();
+    for (uint32_t start : mRefitNodes) {
+        // Freed since it got queued
+        if (start != 0 && mParents[start] == kInvalidIndex) {
+            continue;
+        }
+
+        for (uint32_t node = start; node != kInvalidIndex && RefitNode(node);
+             node = mParents[node]) {
+            if (!mIsRefitQueued[node]) {
+                mIsRefitQueued[node] = kChangedNode;
+                mChangedNodes.push_back(node);
+            }
+        }
+    }
+    mRefitNodes.clear();
+    ++mRefitCount;
+
+    // Rebuild the degraded subtrees, the topmost ones only; a rebuild covers everything below it
+    for (uint32_t node : mChangedNodes) {
+        if (!IsLeaf(mNodes[node]) &&
+            GetSurfaceArea(GetNodeBounds(mNodes[node])) > kMaxAreaGrowth * mBuildAreas[node]) {
+            mIsRefitQueued[node] = kDegradedNode;
+        }
+    }
+
+    mRebuildNodes.clear();
+    for (uint32_t node : mChangedNodes) {
+        if (mIsRefitQueued[node] != kDegradedNode) {
+            continue;
+        }
+
+        uint32_t ancestor = mParents[node];
+        while (ancestor != kInvalidIndex && mIsRefitQueued[ancestor] != kDegradedNode) {
+            ancestor = mParents[ancestor];
+        }
+        if (ancestor == kInvalidIndex) {
+            mRebuildNodes.push_back(node);
+        }
+    }
+
+    for (uint32_t node : mChangedNodes) {
+        mIsRefitQueued[node] = false;
+    }
+
+    for (uint32_t node : mRebuildNodes) {
+        RebuildSubtree(node);
+        ++mSubtreeRebuildCount;
+    }
+}
+
+void Bvh::CompactItems() {
+    // Copy the items leaf by leaf, depth-first, so the subtrees come out contiguous again
+    std::vector<Item> items;
+    std::vector<uint32_t> itemLeaves;
+    items.reserve(GetItemCount());
+    itemLeaves.reserve(GetItemCount());
+
+    std::vector<uint32_t> stack;
+    if (!mNodes.empty()) {
+        stack.push_back(0);
+    }
+    while (!stack.empty()) {
+        const uint32_t nodeIndex = stack.back();
+        stack.pop_back();
+
+        BvhNode& node = mNodes[nodeIndex];
+        if (!IsLeaf(node)) {
+            stack.push_back(node.Offset + 1);
+            stack.push_back(node.Offset);
+            continue;
+        }
+
+        const uint32_t end = node.Offset + GetNodeItemCount(node);
+        const uint32_t offset = static_cast<uint32_t>(items.size());
+        for (uint32_t i = node.Offset; i < end; ++i) {
+            mItemPositions[mItems[i].Id] = static_cast<uint32_t>(items.size());
+            items.push_back(mItems[i]);
+            itemLeaves.push_back(nodeIndex);
+        }
+        node.Offset = offset;
+    }
+
+    mItems = std::move(items);
+    mItemLeaves = std::move(itemLeaves);
+    mDeadItemCount = 0;
+}
+
+void Bvh::MoveNode(uint32_t From, uint32_t To) {
+    const BvhNode& node = mNodes[From];
+    if (IsLeaf(node)) {
+        const uint32_t end = node.Offset + GetNodeItemCount(node);
+        for (uint32_t i = node.Offset; i < end; ++i) {
+            mItemLeaves[i] = To;
+        }
+    } else {
+        mParents[node.Offset] = To;
+        mParents[node.Offset + 1] = To;
+    }
+
+    mNodes[To] = node;
+    mBuildAreas[To] = mBuildAreas[From];
+    if (mIsRefitQueued[From]) {
+        QueueRefit(To);
+    }
+}
+
+uint32_t Bvh::AllocateNodePair() {
+    if (!mFreeNodePairs.empty()) {
+        const uint32_t nodeIndex = mFreeNodePairs.back();
+        mFreeNodePairs.pop_back();
+        return nodeIndex;
+    }
+
+    const uint32_t nodeIndex = static_cast<uint32_t>(mNodes.size());
+    mNodes.resize(mNodes.size() + 2);
+    mParents.resize(mNodes.size(), kInvalidIndex);
+    mBuildAreas.resize(mNodes.size(), 0.f);
+    mIsRefitQueued.resize(mNodes.size(), false);
+    return nodeIndex;
+}
+
+void Bvh::FreeNodePair(uint32_t NodeIndex) {
+    for (uint32_t node = NodeIndex; node < NodeIndex + 2; ++node) {
+        mParents[node] = kInvalidIndex;
+        mIsRefitQueued[node] = false;
+    }
+    mFreeNodePairs.push_back(NodeIndex);
+}
+
+void Bvh::QueueRefit(uint32_t NodeIndex) {
+    if (!mIsRefitQueued[NodeIndex]) {
+        mIsRefitQueued[NodeIndex] = true;
+        mRefitNodes.push_back(NodeIndex);
+    }
+}
+
+void Bvh::KillItem(uint32_t Position) {
+    mItems[Position].Id = kInvalidIndex;
+    mItemLeaves[Position] = kInvalidIndex;
+    ++mDeadItemCount;
+}
+
+uint32_t Bvh::Split(uint32_t Begin, uint32_t End, const Box& Bounds, const Box& CentroidBounds) {
+    const uint32_t count = End - Begin;
+    if (count == 1) {
+        return Begin;
+    }
+
+    struct Bin {
+        Box Bounds;
+        uint32_t Count;
+    };
+
+    const auto getBin = [&CentroidBounds](const Box& ItemBounds, uint32_t Axis) {
+        const float centroid = 0.5f * (ItemBounds.Min[Axis] + ItemBounds.Max[Axis]);
+        const float extent = CentroidBounds.Max[Axis] - CentroidBounds.Min[Axis];
+        const float bin = (centroid - CentroidBounds.Min[Axis]) / extent * kBinCount;
+        return std::min(static_cast<uint32_t>(bin), kBinCount - 1);
+    };
+
+    // The SAH costs scaled by the parent area, so degenerate flat boxes compare as well
+    const float parentArea = GetSurfaceArea(Bounds);
+    const float leafCost = static_cast<float>(count) * parentArea;
+    float bestCost = FLT_MAX;
+    uint32_t bestAxis = 3;
+    uint32_t bestBin = 0;
+
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        if (CentroidBounds.Max[axis] <= CentroidBounds.Min[axis]) {
+            continue;
+        }
+
+        Bin bins[kBinCount];
+        for (Bin& bin : bins) {
+            bin = {{{kEmptyMin, kEmptyMin, kEmptyMin}, {kEmptyMax, kEmptyMax, kEmptyMax}}, 0};
+        }
+        for (uint32_t i = Begin; i < End; ++i) {
+            Bin& bin = bins[getBin(mItems[i].Bounds, axis)];
+            for (uint32_t a = 0; a < 3; ++a) {
+                bin.Bounds.Min[a] = std::min(bin.Bounds.Min[a], mItems[i].Bounds.Min[a]);
+                bin.Bounds.Max[a] = std::max(bin.Bounds.Max[a], mItems[i].Bounds.Max[a]);
+            }
+            ++bin.Count;
+        }
+
+        // Sweep from the right to get the cost of the right side of every split
+        float rightCosts[kBinCount];
+        Box rightBounds = bins[kBinCount - 1].Bounds;
+        uint32_t rightCount = 0;
+        for (uint32_t b = kBinCount - 1; b > 0; --b) {
+            for (uint32_t a = 0; a < 3; ++a) {
+                rightBounds.Min[a] = std::min(rightBounds.Min[a], bins[b].Bounds.Min[a]);
+                rightBounds.Max[a] = std::max(rightBounds.Max[a], bins[b].Bounds.Max[a]);
+            }
+            rightCount += bins[b].Count;
+            rightCosts[b] = rightCount > 0 ? GetSurfaceArea(rightBounds) * rightCount : FLT_MAX;
+        }
+
+        // Then from the left, splitting before the bin b
+        Box leftBounds = bins[0].Bounds;
+        uint32_t leftCount = 0;
+        for (uint32_t b = 1; b < kBinCount; ++b) {
+            for (uint32_t a = 0; a < 3; ++a) {
+                leftBounds.Min[a] = std::min(leftBounds.Min[a], bins[b - 1].Bounds.Min[a]);
+                leftBounds.Max[a] = std::max(leftBounds.Max[a], bins[b - 1].Bounds.Max[a]);
+            }
+            leftCount += bins[b - 1].Count;
+            if (leftCount == 0 || leftCount == count) {
+                continue;
+            }
+
+            const float cost = kTraversalCost * parentArea +
+                               GetSurfaceArea(leftBounds) * leftCount + rightCosts[b];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b;
+            }
+        }
+    }
+
+    // All the centroids coincide; split in the middle if the range is too large for a leaf
+    if (bestAxis == 3) {
+        return count <= kMaxLeafSize ? Begin : Begin + count / 2;
+    }
+
+    if (count <= kMaxLeafSize && leafCost <= bestCost) {
+        return Begin;
+    }
+
+    const auto middle =
+        std::partition(mItems.begin() + Begin, mItems.begin() + End,
+                       [&](const Item& Item) { return getBin(Item.Bounds, bestAxis) < bestBin; });
+    return static_cast<uint32_t>(middle - mItems.begin());
+}
+
+bool Bvh::RefitNode(uint32_t NodeIndex) {
+    BvhNode& node = mNodes[NodeIndex];
+    Box bounds = {{kEmptyMin, kEmptyMin, kEmptyMin}, {kEmptyMax, kEmptyMax, kEmptyMax}};
+
+    if (IsLeaf(node)) {
+        const uint32_t end = node.Offset + GetNodeItemCount(node);
+        for (uint32_t i = node.Offset; i < end; ++i) {
+            bounds = Merge(bounds, mItems[i].Bounds);
+        }
+    } else {
+        bounds = Merge(GetNodeBounds(mNodes[node.Offset]), GetNodeBounds(mNodes[node.Offset + 1]));
+    }
+
+    if (std::equal(bounds.Min, bounds.Min + 3, node.Min) &&
+        std::equal(bounds.Max, bounds.Max + 3, node.Max)) {
+        return false;
+    }
+
+    std::copy_n(bounds.Min, 3, node.Min);
+    std::copy_n(bounds.Max, 3, node.Max);
+    return true;
+}
+
+void Bvh::CollectIds(uint32_t NodeIndex, std::vector<uint32_t>& OutIds) const {
+    std::vector<uint32_t> stack;
+    stack.push_back(NodeIndex);
+    while (!stack.empty()) {
+        const BvhNode& node = mNodes[stack.back()];
+        stack.pop_back();
+
+        if (!IsLeaf(node)) {
+            stack.push_back(node.Offset + 1);
+            stack.push_back(node.Offset);
+            continue;
+        }
+
+        const uint32_t end = node.Offset + GetNodeItemCount(node);
+        for (uint32_t i = node.Offset; i < end; ++i) {
+            OutIds.push_back(mItems[i].Id);
+        }
+    }
+}
+
+void Bvh::Query(const Frustum& ViewFrustum, std::vector<uint32_t>& OutIds) const {
+    for (uint32_t position : mPendingItems) {
+        const Item& item = mItems[position];
+        if (IsAlive(position) && ViewFrustum.Test(ToAABB(item.Bounds.Min, item.Bounds.Max)) !=
+                                     Frustum::Containment::kOutside) {
+            OutIds.push_back(item.Id);
+        }
+    }
+
+    if (mNodes.empty()) {
+        return;
+    }
+
+    std::vector<uint32_t> stack;
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const uint32_t nodeIndex = stack.back();
+        stack.pop_back();
+
+        const BvhNode& node = mNodes[nodeIndex];
+        const Frustum::Containment containment = ViewFrustum.Test(ToAABB(node.Min, node.Max));
+        if (containment == Frustum::Containment::kOutside) {
+            continue;
+        }
+
+        // A subtree inside of the frustum takes all of its items without testing them
+        if (containment == Frustum::Containment::kInside) {
+            CollectIds(nodeIndex, OutIds);
+            continue;
+        }
+
+        if (IsLeaf(node)) {
+            const uint32_t end = node.Offset + GetNodeItemCount(node);
+            for (uint32_t i = node.Offset; i < end; ++i) {
+                const Item& item = mItems[i];
+                if (ViewFrustum.Test(ToAABB(item.Bounds.Min, item.Bounds.Max)) !=
+                    Frustum::Containment::kOutside) {
+                    OutIds.push_back(item.Id);
+                }
+            }
+            continue;
+        }
+
+        stack.push_back(node.Offset + 1);
+        stack.push_back(node.Offset);
+    }
+}
+
+void Bvh::Query(const AABB& Bounds, std::vector<uint32_t>& OutIds) const {
+    if (Bounds.IsEmpty()) {
+        return;
+    }
+
+    const Box box = ToBox(Bounds);
+    for (uint32_t position : mPendingItems) {
+        const Item& item = mItems[position];
+        if (IsAlive(position) && Overlaps(box, item.Bounds.Min, item.Bounds.Max)) {
+            OutIds.push_back(item.Id);
+        }
+    }
+
+    if (mNodes.empty()) {
+        return;
+    }
+
+    std::vector<uint32_t> stack;
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const BvhNode& node = mNodes[stack.back()];
+        stack.pop_back();
+
+        if (!Overlaps(box, node.Min, node.Max)) {
+            continue;
+        }
+
+        if (IsLeaf(node)) {
+            const uint32_t end = node.Offset + GetNodeItemCount(node);
+            for (uint32_t i = node.Offset; i < end; ++i) {
+                if (Overlaps(box, mItems[i].Bounds.Min, mItems[i].Bounds.Max)) {
+                    OutIds.push_back(mItems[i].Id);
+                }
+            }
+            continue;
+        }
+
+        stack.push_back(node.Offset + 1);
+        stack.push_back(node.Offset);
+    }
+}
+
+bool Bvh::Raycast(Vector3 Origin,
+                  Vector3 Direction,
+                  float MaxDistance,
+                  uint32_t& OutId,
+                  float& OutDistance) const {
+    DirectX::XMFLOAT3 origin;
+    DirectX::XMFLOAT3 direction;
+    DirectX::XMStoreFloat3(&origin, Origin);
+    DirectX::XMStoreFloat3(&direction, Direction);
+    const float rayOrigin[3] = {origin.x, origin.y, origin.z};
+    const float inverseDirection[3] = {1.f / direction.x, 1.f / direction.y, 1.f / direction.z};
+
+    uint32_t hitId = kInvalidIndex;
+    float hitDistance = MaxDistance;
+
+    const auto testItem = [&](const Item& Item) {
+        float distance;
+        if (IntersectRay(Item.Bounds.Min, Item.Bounds.Max, rayOrigin, inverseDirection,
+                         hitDistance, distance) &&
+            distance < hitDistance) {
+            hitId = Item.Id;
+            hitDistance = distance;
+        }
+    };
+
+    for (uint32_t position : mPendingItems) {
+        if (IsAlive(position)) {
+            testItem(mItems[position]);
+        }
+    }
+
+    if (!mNodes.empty()) {
+        // The entry distance of a node travels with it, so the nodes behind the closest hit so
+        // far get skipped without another test
+        struct StackEntry {
+            uint32_t NodeIndex;
+            float Distance;
+        };
+
+        std::vector<StackEntry> stack;
+        float rootDistance;
+        if (IntersectRay(mNodes[0].Min, mNodes[0].Max, rayOrigin, inverseDirection, hitDistance,
+                         rootDistance)) {
+            stack.push_back({0, rootDistance});
+        }
+
+        while (!stack.empty()) {
+            const StackEntry entry = stack.back();
+            stack.pop_back();
+            if (entry.Distance > hitDistance) {
+                continue;
+            }
+
+            const BvhNode& node = mNodes[entry.NodeIndex];
+            if (IsLeaf(node)) {
+                const uint32_t end = node.Offset + GetNodeItemCount(node);
+                for (uint32_t i = node.Offset; i < end; ++i) {
+                    testItem(mItems[i]);
+                }
+                continue;
+            }
+
+            // Visit the nearer child first by pushing it last
+            const uint32_t children[2] = {node.Offset, node.Offset + 1};
+            float distances[2];
+            bool isHit[2];
+            for (uint32_t c = 0; c < 2; ++c) {
+                const BvhNode& child = mNodes[children[c]];
+                isHit[c] = IntersectRay(child.Min, child.Max, rayOrigin, inverseDirection,
+                                        hitDistance, distances[c]);
+            }
+
+            const uint32_t nearer = distances[0] <= distances[1] ? 0 : 1;
+            const uint32_t farther = 1 - nearer;
+            if (isHit[farther]) {
+                stack.push_back({children[farther], distances[farther]});
+            }
+            if (isHit[nearer]) {
+                stack.push_back({children[nearer], distances[nearer]});
+            }
+        }
+    }
+
+    if (hitId == kInvalidIndex) {
+        return false;
+    }
+
+    OutId = hitId;
+    OutDistance = hitDistance;
+    return true;
+}
+
+float Bvh::GetSurfaceArea(const Box& Bounds) {
+    const float x = Bounds.Max[0] - Bounds.Min[0];
+    const float y = Bounds.Max[1] - Bounds.Min[1];
+    const float z = Bounds.Max[2] - Bounds.Min[2];
+    return 2.f * (x * y + y * z + z * x);
+}
+
+Bvh::Box Bvh::GetNodeBounds(const BvhNode& Node) {
+    return {{Node.Min[0], Node.Min[1], Node.Min[2]}, {Node.Max[0], Node.Max[1], Node.Max[2]}};
+}
+
+Bvh::Box Bvh::Merge(const Box& A, const Box& B) {
+    Box bounds;
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        bounds.Min[axis] = std::min(A.Min[axis], B.Min[axis]);
+        bounds.Max[axis] = std::max(A.Max[axis], B.Max[axis]);
+    }
+    return bounds;
+}
+
+Bvh::Box Bvh::ToBox(const AABB& Bounds) {
+    DirectX::XMFLOAT3 min;
+    DirectX::XMFLOAT3 max;
+    DirectX::XMStoreFloat3(&min, Bounds.GetMin());
+    DirectX::XMStoreFloat3(&max, Bounds.GetMax());
+    return {{min.x, min.y, min.z}, {max.x, max.y, max.z}};
+}
+
+AABB Bvh::ToAABB(const float* Min, const float* Max) {
+    return AABB(Vector3(Min[0], Min[1], Min[2]), Vector3(Max[0], Max[1], Max[2]));
+}
+
+bool Bvh::Overlaps(const Box& Bounds, const float* Min, const float* Max) {
+    return Bounds.Min[0] <= Max[0] && Min[0] <= Bounds.Max[0] && Bounds.Min[1] <= Max[1] &&
+           Min[1] <= Bounds.Max[1] && Bounds.Min[2] <= Max[2] && Min[2] <= Bounds.Max[2];
+}
+
+bool Bvh::IntersectRay(const float* Min,
+                       const float* Max,
+                       const float* Origin,
+                       const float* InverseDirection,
+                       float MaxDistance,
+                       float& OutDistance) {
+    // fmin/fmax drop the NaNs of the rays running within the plane of a slab
+    float entry = 0.f;
+    float exit = MaxDistance;
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        const float nearDistance = (Min[axis] - Origin[axis]) * InverseDirection[axis];
+        const float farDistance = (Max[axis] - Origin[axis]) * InverseDirection[axis];
+        entry = std::fmax(entry, std::fmin(nearDistance, farDistance));
+        exit = std::fmin(exit, std::fmax(nearDistance, farDistance));
+    }
+
+    OutDistance = entry;
+    return entry <= exit;
+}
@@ -0,0 +1,313 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Math/Bounds.h"
+#include "Math/Frustum.h"
+#include "Math/Vector.h"
+
+/**
+ * Bounding volume hierarchy over the world bounds of the scene objects, for the spatial queries
+ * the scene graph can't answer: picking, proximity and culling independent of the hierarchy.
+ *
+ * The nodes are 32 bytes each, stored in a flat array. The two children of an inner node are
+ * allocated as a pair, so the node refers to both by the index of the first one, and a leaf refers
+ * to the contiguous range of its items:
+ *
+ *   inner node: | bounds | item count | first child | -> nodes: | left | right |
+ *   leaf:       | bounds | item count | first item  | -> items: | 0 | 1 | ... | count - 1 |
+ *
+ * The pairs freed by the removals and the rebuilds get reused, so any subtree can be changed or
+ * rebuilt without touching the rest.
+ *
+ * The hierarchy stays in sync with the scene without being rebuilt every frame. Changed bounds
+ * only get refitted: the leaves holding them and their ancestors get their bounds recomputed
+ * bottom-up, up to the first ancestor whose bounds stay the same. A new item gets paired with the
+ * leaf whose surface area it grows the least, and a removed item leaves its leaf; an emptied leaf
+ * gets replaced by its sibling. Either way only the ancestors get refitted. That keeps the
+ * hierarchy valid but degrades it, so the subtrees whose surface area grows past kMaxAreaGrowth
+ * times their area at build time get rebuilt with the SAH. Only adding more than one in
+ * kBulkInsertRatio of the items at once, e.g. a new scene, builds the whole hierarchy anew.
+ */
+class Bvh {
+   public:
+    static constexpr uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+
+    // The most items a leaf holds; larger ranges always get split
+    static constexpr uint32_t kMaxLeafSize = 4;
+
+    // The number of centroid bins the SAH evaluates per axis
+    static constexpr uint32_t kBinCount = 16;
+
+    // The surface area growth of a refitted subtree that gets it rebuilt
+    static constexpr float kMaxAreaGrowth = 2.f;
+
+    // Adding more than one in this many of the items in a single Update builds the whole hierarchy
+    // instead of inserting them one by one
+    static constexpr uint32_t kBulkInsertRatio = 4;
+
+    Bvh() = default;
+    ~Bvh() = default;
+
+    // Prohibit copying
+    Bvh(const Bvh&) = delete;
+    Bvh& operator=(const Bvh&) = delete;
+
+    // Allow moving
+    Bvh(Bvh&&) noexcept = default;
+    Bvh& operator=(Bvh&&) noexcept = default;
+
+    /**
+     * Adds the item or updates its bounds. A new item gets inserted on the next Update, an
+     * existing one gets its leaf refitted. An item with empty bounds gets removed.
+     * @param Id The id of the item, e.g. a RenderQueue object id; the ids are expected to be dense.
+     * @param Bounds The world bounds of the item.
+     */
+    void SetBounds(uint32_t Id, const AABB& Bounds);
+
+    /**
+     * Removes the item from its leaf right away; the ancestors get refitted on the next Update.
+     */
+    void Remove(uint32_t Id);
+
+    bool Contains(uint32_t Id) const {
+        return Id < mItemPositions.size() && mItemPositions[Id] != kInvalidIndex;
+    }
+
+    /**
+     * Applies the changes since the last call: inserts the added items, refits the changed leaves
+     * and their ancestors and rebuilds the degraded subtrees. Builds the whole hierarchy instead
+     * if the items added outnumber the rest, see kBulkInsertRatio.
+     *
+     * The queries see the removals right away. The added items get tested one by one until they
+     * are inserted, and the changed bounds get tested against the ancestors as of the last refit.
+     */
+    void Update();
+
+    /**
+     * Collects the ids of the items whose bounds intersect the frustum.
+     * @param OutIds Output parameter the ids get appended to.
+     */
+    void Query(const Frustum& ViewFrustum, std::vector<uint32_t>& OutIds) const;
+
+    /**
+     * Collects the ids of the items whose bounds intersect the box, e.g. for proximity queries.
+     * @param OutIds Output parameter the ids get appended to.
+     */
+    void Query(const AABB& Bounds, std::vector<uint32_t>& OutIds) const;
+
+    /**
+     * Finds the item whose bounds the ray hits first, e.g. for picking.
+     * @param Origin The origin of the ray.
+     * @param Direction The direction of the ray; doesn't need to be normalized.
+     * @param MaxDistance The farthest hit accepted, in the units of the direction.
+     * @param OutId Output parameter that will be populated with the id of the item hit. Unchanged
+     * if there's no hit.
+     * @param OutDistance Output parameter that will be populated with the distance of the hit, in
+     * the units of the direction. Unchanged if there's no hit.
+     * @return true if the ray hits any item, false otherwise.
+     */
+    bool Raycast(Vector3 Origin,
+                 Vector3 Direction,
+                 float MaxDistance,
+                 uint32_t& OutId,
+                 float& OutDistance) const;
+
+    size_t GetItemCount() const {
+        return mItems.size() - mDeadItemCount;
+    }
+
+    /**
+     * Returns the number of the nodes in use; the freed pairs don't count.
+     */
+    size_t GetNodeCount() const {
+        return mNodes.size() - 2 * mFreeNodePairs.size();
+    }
+
+    /** The number of full builds so far. */
+    uint64_t GetBuildCount() const {
+        return mBuildCount;
+    }
+
+    /** The number of refits so far. */
+    uint64_t GetRefitCount() const {
+        return mRefitCount;
+    }
+
+    /** The number of degraded subtrees rebuilt so far. */
+    uint64_t GetSubtreeRebuildCount() const {
+        return mSubtreeRebuildCount;
+    }
+
+   private:
+    // Plain floats rather than XMVECTOR keep the node at 32 bytes
+    struct Box {
+        float Min[3];
+        float Max[3];
+    };
+
+    struct alignas(32) BvhNode {
+        float Min[3];
+        // The number of items in the subtree; kLeafFlag marks the leaves
+        uint32_t ItemCount;
+        float Max[3];
+        // The first item of a leaf, the first child of an inner node; the second one follows it
+        uint32_t Offset;
+    };
+    static_assert(sizeof(BvhNode) == 32);
+
+    static constexpr uint32_t kLeafFlag = 0x80000000u;
+
+    struct Item {
+        Box Bounds;
+        uint32_t Id;
+    };
+
+    /**
+     * Drops the removed items and builds the hierarchy over the rest anew.
+     */
+    void Build();
+
+    /**
+     * Builds the subtree over the items [Begin, End) rooted at NodeIndex, reordering the items.
+     * The other nodes of the subtree get allocated.
+     */
+    void BuildSubtree(uint32_t NodeIndex, uint32_t Begin, uint32_t End, uint32_t Parent);
+
+    /**
+     * Frees the nodes below NodeIndex and builds the subtree over its items anew. The items get
+     * gathered at the end first, unless the insertions and the removals have left them contiguous.
+     */
+    void RebuildSubtree(uint32_t NodeIndex);
+
+    /**
+     * Pairs the item with the leaf whose surface area it grows the least, descending from the
+     * root; the leaf turns into the parent of the two.
+     */
+    void InsertItem(uint32_t Position);
+
+    /**
+     * Replaces the parent of the emptied leaf with the sibling of the leaf.
+     */
+    void RemoveLeaf(uint32_t NodeIndex);
+
+    /**
+     * Refits the queued nodes and their ancestors, then rebuilds the degraded subtrees.
+     */
+    void Refit();
+
+    /**
+     * Moves the removed items out of the leaf ranges once they outnumber the rest.
+     */
+    void CompactItems();
+
+    /**
+     * Copies the node along with its build area to another slot and re-parents its children or
+     * items.
+     */
+    void MoveNode(uint32_t From, uint32_t To);
+
+    /**
+     * Returns the first node of a free pair, appending one if none is free.
+     */
+    uint32_t AllocateNodePair();
+
+    void FreeNodePair(uint32_t NodeIndex);
+
+    /**
+     * Queues the node for the refit on the next Update.
+     */
+    void QueueRefit(uint32_t NodeIndex);
+
+    /**
+     * Marks the item slot as removed; the slot gets reclaimed by the next compaction.
+     */
+    void KillItem(uint32_t Position);
+
+    /**
+     * Checks whether the item slot holds an item, i.e. it hasn't been removed.
+     */
+    bool IsAlive(uint32_t Position) const {
+        return mItems[Position].Id != kInvalidIndex;
+    }
+
+    /**
+     * Appends the ids of all the items of the subtree.
+     */
+    void CollectIds(uint32_t NodeIndex, std::vector<uint32_t>& OutIds) const;
+
+    /**
+     * Finds the SAH split of the items [Begin, End) over binned centroids and partitions them.
+     * @param Bounds The bounds of the items.
+     * @param CentroidBounds The bounds of the item centroids.
+     * @return The first item of the right half, or Begin if a leaf is cheaper than any split.
+     */
+    uint32_t Split(uint32_t Begin, uint32_t End, const Box& Bounds, const Box& CentroidBounds);
+
+    /**
+     * Recomputes the bounds of the node from its items or its children.
+     * @return true if the bounds have changed, false otherwise.
+     */
+    bool RefitNode(uint32_t NodeIndex);
+
+    static bool IsLeaf(const BvhNode& Node) {
+        return (Node.ItemCount & kLeafFlag) != 0;
+    }
+
+    static uint32_t GetNodeItemCount(const BvhNode& Node) {
+        return Node.ItemCount & ~kLeafFlag;
+    }
+
+    static float GetSurfaceArea(const Box& Bounds);
+    static Box GetNodeBounds(const BvhNode& Node);
+    static Box Merge(const Box& A, const Box& B);
+    static Box ToBox(const AABB& Bounds);
+    static AABB ToAABB(const float* Min, const float* Max);
+    static bool Overlaps(const Box& Bounds, const float* Min, const float* Max);
+
+    /**
+     * Slab test of the ray against the box.
+     * @param OutDistance Output parameter that will be populated with the entry distance on a hit.
+     */
+    static bool IntersectRay(const float* Min,
+                             const float* Max,
+                             const float* Origin,
+                             const float* InverseDirection,
+                             float MaxDistance,
+                             float& OutDistance);
+
+    // Node 0 is the root; the others come in pairs of siblings. The parent of a freed node and of
+    // the root is kInvalidIndex
+    std::vector<BvhNode> mNodes;
+    std::vector<uint32_t> mParents;
+    // The surface area of the node when it got built
+    std::vector<float> mBuildAreas;
+    // Nonzero for the nodes queued for the refit; the refit reuses it to flag the changed nodes
+    std::vector<uint8_t> mIsRefitQueued;
+    // The first nodes of the freed pairs
+    std::vector<uint32_t> mFreeNodePairs;
+
+    // The items in the ranges of their leaves, and the leaf per item slot. The slots of the
+    // removed items hold kInvalidIndex ids until the next compaction
+    std::vector<Item> mItems;
+    std::vector<uint32_t> mItemLeaves;
+    size_t mDeadItemCount{0};
+    // The position of the item by id, kInvalidIndex for the ids not in the hierarchy
+    std::vector<uint32_t> mItemPositions;
+
+    // The positions of the items added since the last Update; they have no leaf yet
+    std::vector<uint32_t> mPendingItems;
+
+    // The nodes with items changed since the last Update
+    std::vector<uint32_t> mRefitNodes;
+    // Reused lists of the nodes changed by the refit and of the subtrees to rebuild
+    std::vector<uint32_t> mChangedNodes;
+    std::vector<uint32_t> mRebuildNodes;
+
+    uint64_t mBuildCount{0};
+    uint64_t mRefitCount{0};
+    uint64_t mSubtreeRebuildCount{0};
+};
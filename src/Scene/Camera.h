@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Includes/MathIncl.h"
+#include "Math/Angle.h"
+#include "Math/Matrix.h"
+#include "Math/Vector.h"
+
+/**
+ * A camera: the view transform placing it in the world and the projection onto the D3D clip space
+ * (0 <= z <= w). A default constructed camera has identity transforms, so the world positions get
+ * output as the clip space positions.
+ *
+ * The matrices follow the row vector convention of Matrix4: a world position p lands in the clip
+ * space at p * View * Projection.
+ */
+// XMMATRIX requires 16byte alignment
+ALIGN(16)
+class Camera {
+   public:
+    enum class Projection : uint8_t {
+        kIdentity,
+        kPerspective,
+        kOrthographic,
+    };
+
+    Camera() = default;
+
+    /**
+     * Places the camera at the eye looking at the target, left-handed.
+     */
+    void SetLookAt(Vector3 Eye, Vector3 Target, Vector3 Up) {
+        mView = DirectX::XMMatrixLookAtLH(Eye, Target, Up);
+        UpdateViewProjection();
+    }
+
+    void SetView(const Matrix4& View) {
+        mView = View;
+        UpdateViewProjection();
+    }
+
+    /**
+     * Switches to a perspective projection, left-handed.
+     * @param VerticalFov The vertical field of view.
+     * @param AspectRatio The width of the view over its height.
+     */
+    void SetPerspective(Degrees VerticalFov, float AspectRatio, float NearZ, float FarZ) {
+        mProjectionType = Projection::kPerspective;
+        mVerticalFov = VerticalFov;
+        mAspectRatio = AspectRatio;
+        mNearZ = NearZ;
+        mFarZ = FarZ;
+        UpdateProjection();
+    }
+
+    /**
+     * Switches to an orthographic projection, left-handed.
+     * @param Height The height of the view volume; the width follows the aspect ratio.
+     * @param AspectRatio The width of the view over its height.
+     */
+    void SetOrthographic(float Height, float AspectRatio, float NearZ, float FarZ) {
+        mProjectionType = Projection::kOrthographic;
+        mOrthographicHeight = Height;
+        mAspectRatio = AspectRatio;
+        mNearZ = NearZ;
+        mFarZ = FarZ;
+        UpdateProjection();
+    }
+
+    /**
+     * Keeps the projection undistorted when the view gets resized. Ignored by the identity
+     * projection.
+     */
+    void SetAspectRatio(float AspectRatio) {
+        mAspectRatio = AspectRatio;
+        UpdateProjection();
+    }
+
+    Projection GetProjectionType() const {
+        return mProjectionType;
+    }
+
+    const Matrix4& GetView() const {
+        return mView;
+    }
+
+    const Matrix4& GetProjection() const {
+        return mProjection;
+    }
+
+    const Matrix4& GetViewProjection() const {
+        return mViewProjection;
+    }
+
+   private:
+    void UpdateProjection() {
+        switch (mProjectionType) {
+            case Projection::kIdentity:
+                return;
+
+            case Projection::kPerspective:
+                mProjection =
+                    DirectX::XMMatrixPerspectiveFovLH(mVerticalFov, mAspectRatio, mNearZ, mFarZ);
+                break;
+
+            case Projection::kOrthographic:
+                mProjection = DirectX::XMMatrixOrthographicLH(
+                    mOrthographicHeight * mAspectRatio, mOrthographicHeight, mNearZ, mFarZ);
+                break;
+        }
+        UpdateViewProjection();
+    }
+
+    void UpdateViewProjection() {
+        // The view transform applies first
+        mViewProjection = DirectX::XMMatrixMultiply(mView, mProjection);
+    }
+
+    Matrix4 mView;
+    Matrix4 mProjection;
+    Matrix4 mViewProjection;
+
+    Projection mProjectionType{Projection::kIdentity};
+    // Radians
+    float mVerticalFov{0.f};
+    float mOrthographicHeight{0.f};
+    float mAspectRatio{1.f};
+    float mNearZ{0.f};
+    float mFarZ{1.f};
+};
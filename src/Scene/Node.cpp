@@ -1 +1,86 @@
 #include "Node.h"
+
+#include "Logging/Logging.h"
+
+// Internal visitor implementation - not part of public API
+class RenderQueueBindVisitor : public NodeVisitor {
+   public:
+    explicit RenderQueueBindVisitor(RenderQueue* Queue) : mRenderQueue(Queue) {}
+
+    void Visit(Node* node) override;
+
+   private:
+    RenderQueue* mRenderQueue;
+};
+
+void RenderQueueBindVisitor::Visit(Node* node) {
+    if (node->mRenderQueue == mRenderQueue) {
+        return;
+    }
+
+    if (node->mRenderObjectId != RenderQueue::kInvalidObjectId) {
+        node->mRenderQueue->Remove(node->mRenderObjectId);
+        node->mRenderObjectId = RenderQueue::kInvalidObjectId;
+    }
+    node->mRenderQueue = mRenderQueue;
+    node->UpdateRenderObject();
+}
+
+NodeHandle Node::RegisterHandle(Node* Node) {
+    const NodeHandle handle = NodeRegistry::Get().Create(Node);
+    if (handle == NodeRegistry::kInvalidHandle) {
+        LOG_ERROR(L"Failed to register a node as the node registry is out of handles.\n");
+    }
+    return handle;
+}
+
+SlabAllocator<Node>& Node::GetBlocks() {
+    static SlabAllocator<Node> blocks;
+    return blocks;
+}
+
+void* Node::operator new(size_t /*Size*/) {
+    // Always sizeof(Node) as nothing derives from the node
+    return GetBlocks().Allocate();
+}
+
+void Node::operator delete(void* Memory) {
+    if (Memory) {
+        GetBlocks().Free(Memory);
+    }
+}
+
+void Node::SetRenderQueue(RenderQueue* Queue) {
+    // The node might be the root of a scene attached to the previous queue
+    if (mRenderQueue && mRenderQueue != Queue && mRenderQueue->GetRoot() == this) {
+        mRenderQueue->SetRoot(nullptr);
+    }
+
+    RenderQueueBindVisitor bindVisitor(Queue);
+    TraverseDepthFirst(this, bindVisitor);
+}
+
+void Node::UpdateRenderObject() {
+    if (!mRenderQueue) {
+        return;
+    }
+
+    // The rendering object refers to the node by its handle
+    const bool isRenderable = mMeshInstance && mMaterialId >= kMaterialFirstId &&
+                              mHandle != NodeRegistry::kInvalidHandle;
+    if (mRenderObjectId == RenderQueue::kInvalidObjectId) {
+        if (isRenderable) {
+            mRenderObjectId =
+                mRenderQueue->Add(mHandle, mMaterialId, mDrawPass, mMeshInstance.get());
+        }
+        return;
+    }
+
+    if (!isRenderable) {
+        mRenderQueue->Remove(mRenderObjectId);
+        mRenderObjectId = RenderQueue::kInvalidObjectId;
+        return;
+    }
+
+    mRenderQueue->Update(mRenderObjectId, mMaterialId, mDrawPass, mMeshInstance.get());
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <queue>
 #include <ranges>
@@ -9,7 +10,11 @@
 
 #include "Graphics/Material/Material.h"
 #include "Graphics/Mesh/MeshInstance.h"
+#include "Graphics/RenderQueue.h"
 #include "Math/Matrix.h"
+#include "Memory/SlabAllocator.h"
+#include "NodeRegistry.h"
+#include "TransformStore.h"
 
 class Node;
 
@@ -19,7 +24,7 @@ class NodeVisitor {
     virtual void Visit(Node* node) = 0;
 };
 
-class Node {
+class Node final {
    public:
     /**
      * Traverses a node tree in depth-first order, invoking the visitor's Visit method for each
@@ -55,7 +60,7 @@ class Node {
         // Walk down the tree depth-first
         while (!visitingNodes.empty()) {
             // Get the next node from the top of the stack
-            auto& node = visitingNodes.top();
+            Node* node = visitingNodes.top();
             visitingNodes.pop();
 
             // Call all visitors using C++17 fold expression
@@ -101,7 +106,7 @@ class Node {
 
         while (!visitingNodes.empty()) {
             // Get the next node from the front of the queue
-            auto& node = visitingNodes.front();
+            Node* node = visitingNodes.front();
             visitingNodes.pop();
 
             visitor.Visit(node);
@@ -114,76 +119,231 @@ class Node {
         }
     }
 
+    /**
+     * Creates a node.
+     * @return true if the node was created, false if the NodeRegistry is out of handles, in which
+     * case OutNode is unchanged.
+     */
     static bool Create(MaterialId MaterialId,
                        std::unique_ptr<MeshInstance>&& MeshInstance,
                        std::unique_ptr<Node>& OutNode) {
-        OutNode = std::make_unique<Node>(MaterialId, std::move(MeshInstance));
+        auto node = std::make_unique<Node>(MaterialId, std::move(MeshInstance));
+        if (node->mHandle == NodeRegistry::kInvalidHandle) {
+            return false;
+        }
+
+        OutNode = std::move(node);
         return true;
     }
 
+    /**
+     * The nodes constructed directly rather than by Create have to check GetHandle against
+     * NodeRegistry::kInvalidHandle; a node without a handle works but can't be referred to by one,
+     * so it never gets registered in a render queue.
+     */
     Node(MaterialId MaterialId, std::unique_ptr<MeshInstance>&& Mesh)
         : mMeshInstance(std::move(Mesh)),
-          mMaterialId(MaterialId),
-          mLocalTransform(Matrix4{}),
-          mWorldTransform(Matrix4{}) {}
+          mTransformIndex(TransformStore::Get().Allocate(this, &mTransformIndex)),
+          mHandle(RegisterHandle(this)),
+          mMaterialId(MaterialId) {
+        UpdateLocalBounds();
+    }
 
-    Node() = default;
+    Node()
+        : mTransformIndex(TransformStore::Get().Allocate(this, &mTransformIndex)),
+          mHandle(RegisterHandle(this)) {}
 
-    ~Node() = default;
+    ~Node() {
+        ReleaseRenderObject();
+
+        if (HasTransformSlot()) {
+            TransformStore::Get().Release(mTransformIndex);
+        }
+        NodeRegistry::Get().Destroy(mHandle);
+    }
+
+    /**
+     * The nodes get allocated from slabs of fixed-size blocks rather than one by one from the heap,
+     * so creating and destroying many of them doesn't fragment it. The blocks are sizeof(Node),
+     * hence the class is final. Not thread-safe, the same as the TransformStore the nodes register
+     * in.
+     */
+    static void* operator new(size_t Size);
+    static void operator delete(void* Memory);
 
     // Prohibit copying
     Node(const Node&) = delete;
     Node& operator=(const Node&) = delete;
 
-    // Move constructor
+    // Move constructor. The moved-from node owns no transform slot anymore, see HasTransformSlot
     Node(Node&& other) noexcept
-        : mMeshInstance(std::exchange(other.mMeshInstance, nullptr)),
+        : mChildren(std::exchange(other.mChildren, {})),
+          mMeshInstance(std::exchange(other.mMeshInstance, nullptr)),
+          mTransformIndex(std::exchange(other.mTransformIndex, TransformStore::kInvalidIndex)),
+          mHandle(std::exchange(other.mHandle, NodeRegistry::kInvalidHandle)),
           mMaterialId(std::exchange(other.mMaterialId, MaterialId{0})),
-          mChildren(std::exchange(other.mChildren, {})),
-          mLocalTransform(std::exchange(other.mLocalTransform, Matrix4{})),
-          mWorldTransform(std::exchange(other.mWorldTransform, Matrix4{})) {
+          mRenderQueue(std::exchange(other.mRenderQueue, nullptr)),
+          mRenderObjectId(std::exchange(other.mRenderObjectId, RenderQueue::kInvalidObjectId)),
+          mDrawPass(other.mDrawPass) {
         UpdateChildrenParent();
         other.mParent = nullptr;
+
+        // Take over the transform slot, if the other node still has one; the moved node has no
+        // parent
+        if (HasTransformSlot()) {
+            TransformStore::Get().SetOwner(mTransformIndex, this, &mTransformIndex);
+            TransformStore::Get().SetParent(mTransformIndex, TransformStore::kInvalidIndex);
+        }
+
+        // Take over the handle, which the rendering object refers to the node by, and the scene
+        // root
+        BindHandle();
+        BindRenderQueueRoot(&other);
     }
 
     // Move assignment operator
     Node& operator=(Node&& other) noexcept {
         if (this != &other) {
+            ReleaseRenderObject();
+
+            if (HasTransformSlot()) {
+                TransformStore::Get().Release(mTransformIndex);
+            }
+            NodeRegistry::Get().Destroy(mHandle);
+
             mMeshInstance = std::exchange(other.mMeshInstance, nullptr);
             mMaterialId = std::exchange(other.mMaterialId, MaterialId{0});
             mChildren = std::exchange(other.mChildren, {});
-            mLocalTransform = std::exchange(other.mLocalTransform, Matrix4{});
-            mWorldTransform = std::exchange(other.mWorldTransform, Matrix4{});
+            mTransformIndex = std::exchange(other.mTransformIndex, TransformStore::kInvalidIndex);
+            mHandle = std::exchange(other.mHandle, NodeRegistry::kInvalidHandle);
+            mRenderQueue = std::exchange(other.mRenderQueue, nullptr);
+            mRenderObjectId = std::exchange(other.mRenderObjectId, RenderQueue::kInvalidObjectId);
+            mDrawPass = other.mDrawPass;
             mParent = nullptr;
 
             UpdateChildrenParent();
             other.mParent = nullptr;
+
+            if (HasTransformSlot()) {
+                TransformStore::Get().SetOwner(mTransformIndex, this, &mTransformIndex);
+                TransformStore::Get().SetParent(mTransformIndex, TransformStore::kInvalidIndex);
+            }
+
+            BindHandle();
+            BindRenderQueueRoot(&other);
         }
         return *this;
     }
 
+    /**
+     * Returns the handle of the node, e.g. to refer to it from outside of the scene tree without
+     * dangling once it's destroyed; see NodeRegistry::Resolve.
+     */
+    NodeHandle GetHandle() const {
+        return mHandle;
+    }
+
     MeshInstance* GetMeshInstance() const {
         return mMeshInstance.get();
     }
 
+    /**
+     * Replaces the MeshInstance. A node with both a mesh and a material gets registered in the
+     * render queue of its scene; a node without a mesh gets deregistered.
+     */
+    void SetMeshInstance(std::unique_ptr<MeshInstance>&& MeshInstance) {
+        mMeshInstance = std::move(MeshInstance);
+        UpdateLocalBounds();
+        UpdateRenderObject();
+    }
+
     MaterialId GetMaterialId() const {
         return mMaterialId;
     }
 
-    Matrix4& GetTransform() {
-        return mLocalTransform;
+    /**
+     * Sets the material. Re-keys the rendering object in place; a MaterialId below
+     * kMaterialFirstId deregisters the node.
+     */
+    void SetMaterialId(MaterialId MaterialId) {
+        mMaterialId = MaterialId;
+        UpdateRenderObject();
+    }
+
+    DrawPass GetDrawPass() const {
+        return mDrawPass;
+    }
+
+    void SetDrawPass(DrawPass Pass) {
+        mDrawPass = Pass;
+        UpdateRenderObject();
+    }
+
+    /**
+     * Returns the id of the node's rendering object, or RenderQueue::kInvalidObjectId if the node
+     * isn't registered in a render queue.
+     */
+    uint32_t GetRenderObjectId() const {
+        return mRenderObjectId;
+    }
+
+    /**
+     * Binds the node and its subtree to the render queue, registering the renderable nodes.
+     * Deregisters them from the previous queue. Gets called by RenderQueue::Attach and AddChild.
+     * @param Queue The queue to bind to, or nullptr to unbind.
+     */
+    void SetRenderQueue(RenderQueue* Queue);
+
+    /**
+     * Checks whether the node owns a slot in the TransformStore. Every node does but a moved-from
+     * one, which reads as an identity transform and ignores the transform changes; it's only fit
+     * to be destroyed or assigned to.
+     */
+    bool HasTransformSlot() const {
+        return mTransformIndex != TransformStore::kInvalidIndex;
+    }
+
+    /**
+     * Returns the local transform stored in the TransformStore. The reference stays valid until
+     * the next node gets created or the store gets re-sorted, so don't hold on to it.
+     */
+    const Matrix4& GetTransform() const {
+        if (!HasTransformSlot()) {
+            return GetIdentityTransform();
+        }
+        return TransformStore::Get().GetLocalTransform(mTransformIndex);
+    }
+
+    /**
+     * Sets the local transform. The world transforms of the node and its subtree get recomputed
+     * on the next TransformStore::UpdateWorldTransforms call.
+     */
+    void SetTransform(const Matrix4& Transform) {
+        if (HasTransformSlot()) {
+            TransformStore::Get().SetLocalTransform(mTransformIndex, Transform);
+        }
     }
 
+    /**
+     * Returns the world transform computed by the last TransformStore::UpdateWorldTransforms call.
+     */
     const Matrix4& GetWorldTransform() const {
-        return mWorldTransform;
+        if (!HasTransformSlot()) {
+            return GetIdentityTransform();
+        }
+        return TransformStore::Get().GetWorldTransform(mTransformIndex);
     }
 
-    Matrix4& GetWorldTransform() {
-        return mWorldTransform;
+    /**
+     * Checks whether the world transform got recomputed by the last
+     * TransformStore::UpdateWorldTransforms call.
+     */
+    bool IsWorldTransformUpdated() const {
+        return HasTransformSlot() && TransformStore::Get().IsUpdated(mTransformIndex);
     }
 
-    void SetWorldTransform(const Matrix4& Transform) {
-        mWorldTransform = Transform;
+    uint32_t GetTransformIndex() const {
+        return mTransformIndex;
     }
 
     bool HasParent() const {
@@ -196,10 +356,89 @@ class Node {
 
     void AddChild(std::unique_ptr<Node>&& Child) {
         Child->mParent = this;
+        if (Child->HasTransformSlot()) {
+            TransformStore::Get().SetParent(Child->mTransformIndex, mTransformIndex);
+        }
+        if (Child->mRenderQueue != mRenderQueue) {
+            Child->SetRenderQueue(mRenderQueue);
+        }
         mChildren.push_back(std::move(Child));
     }
 
    private:
+    friend class RenderQueueBindVisitor;
+
+    /**
+     * Registers, re-keys or deregisters the rendering object to reflect the node's mesh, material
+     * and pass.
+     */
+    void UpdateRenderObject();
+
+    /**
+     * Hands the bounds of the node's mesh over to the TransformStore; a node without a mesh has
+     * empty bounds.
+     */
+    void UpdateLocalBounds() {
+        if (!HasTransformSlot()) {
+            return;
+        }
+        TransformStore::Get().SetLocalBounds(
+            mTransformIndex, mMeshInstance ? mMeshInstance->GetMesh()->GetBounds() : AABB{});
+    }
+
+    /**
+     * Returns the transform of the nodes without a transform slot.
+     */
+    static const Matrix4& GetIdentityTransform() {
+        static const Matrix4 identity;
+        return identity;
+    }
+
+    /**
+     * Deregisters the rendering object and unbinds the node from its render queue.
+     */
+    void ReleaseRenderObject() {
+        if (!mRenderQueue) {
+            return;
+        }
+
+        if (mRenderObjectId != RenderQueue::kInvalidObjectId) {
+            mRenderQueue->Remove(mRenderObjectId);
+            mRenderObjectId = RenderQueue::kInvalidObjectId;
+        }
+        if (mRenderQueue->GetRoot() == this) {
+            mRenderQueue->SetRoot(nullptr);
+        }
+        mRenderQueue = nullptr;
+    }
+
+    /**
+     * Creates the handle of the node in the NodeRegistry.
+     * @return The handle, or NodeRegistry::kInvalidHandle if the registry is out of handles.
+     */
+    static NodeHandle RegisterHandle(Node* Node);
+
+    /**
+     * Points the handle at this node instead of the moved one.
+     */
+    void BindHandle() {
+        if (Node** node = NodeRegistry::Get().Get(mHandle)) {
+            *node = this;
+        }
+    }
+
+    /**
+     * Points the render queue at this node instead of the moved one if it's the scene root.
+     */
+    void BindRenderQueueRoot(const Node* Moved) {
+        if (mRenderQueue && mRenderQueue->GetRoot() == Moved) {
+            mRenderQueue->SetRoot(this);
+        }
+    }
+
+    // The slabs operator new allocates from
+    static SlabAllocator<Node>& GetBlocks();
+
     void UpdateChildrenParent() {
         for (auto& child : mChildren) {
             child->mParent = this;
@@ -211,12 +450,20 @@ class Node {
     std::vector<std::unique_ptr<Node>> mChildren;
 
     // Owned components
-    Matrix4 mLocalTransform;
-    Matrix4 mWorldTransform;
     std::unique_ptr<MeshInstance> mMeshInstance;
 
+    // Handle to the local and world transforms and bounds kept in the TransformStore
+    uint32_t mTransformIndex{TransformStore::kInvalidIndex};
+
+    NodeHandle mHandle{NodeRegistry::kInvalidHandle};
+
     // Intentionally uses MaterialId instead of a Material reference to decouple Node from Material
     // and enable efficient batching by grouping nodes with the same MaterialId to minimize PSO
     // switches.
     MaterialId mMaterialId{0};
+
+    // Not-owning pointer to the render queue of the scene the node is attached to
+    RenderQueue* mRenderQueue{nullptr};
+    uint32_t mRenderObjectId{RenderQueue::kInvalidObjectId};
+    DrawPass mDrawPass{kOpaque};
 };
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Memory/SlotPool.h"
+
+class Node;
+
+/**
+ * A generational handle to a Node. It follows the node when the node gets moved and goes stale
+ * once the node is destroyed, so it's safe to hold on to where a Node pointer would dangle.
+ */
+using NodeHandle = SlotHandle;
+
+/**
+ * The table resolving the node handles. The nodes register themselves on construction, re-point
+ * their entry when moved and release it when destroyed.
+ */
+class NodeRegistry {
+   public:
+    static constexpr NodeHandle kInvalidHandle = SlotPool<Node*>::kInvalidHandle;
+
+    // Using the function-local static pattern the same way TransformStore::Get does
+    static SlotPool<Node*>& Get() {
+        static SlotPool<Node*> registry;
+        return registry;
+    }
+
+    /**
+     * Returns the node, or nullptr if it's destroyed.
+     */
+    static Node* Resolve(NodeHandle Handle) {
+        Node* const* node = Get().Get(Handle);
+        return node ? *node : nullptr;
+    }
+};
@@ -0,0 +1,412 @@
+#include "TransformStore.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "Threading/WorkerPool.h"
+
+uint32_t TransformStore::Allocate(Node* Owner, uint32_t* OwnerIndex) {
+    // A new slot is a root, so it never breaks the parent-before-child order
+    if (!mFreeSlots.empty()) {
+        uint32_t index = mFreeSlots.back();
+        mFreeSlots.pop_back();
+
+        mParents[index] = kInvalidIndex;
+        mSubtreeSizes[index] = 1;
+        mLocalTransforms[index] = Matrix4{};
+        mWorldTransforms[index] = Matrix4{};
+        mLocalBounds[index] = AABB{};
+        mWorldBounds[index] = AABB{};
+        mSubtreeBounds[index] = AABB{};
+        mDirty[index] = true;
+        mOwners[index] = Owner;
+        mOwnerIndices[index] = OwnerIndex;
+        return index;
+    }
+
+    uint32_t index = static_cast<uint32_t>(mOwners.size());
+    mParents.push_back(kInvalidIndex);
+    mSubtreeSizes.push_back(1);
+    mLocalTransforms.emplace_back();
+    mWorldTransforms.emplace_back();
+    mLocalBounds.emplace_back();
+    mWorldBounds.emplace_back();
+    mSubtreeBounds.emplace_back();
+    mDirty.push_back(true);
+    mUpdatePasses.push_back(0);
+    mBoundsPasses.push_back(0);
+    mOwners.push_back(Owner);
+    mOwnerIndices.push_back(OwnerIndex);
+    return index;
+}
+
+void TransformStore::Release(uint32_t Index) {
+    if (mParents[Index] != kInvalidIndex) {
+        mDetachedParents.push_back(mParents[Index]);
+    }
+    mParents[Index] = kInvalidIndex;
+    mOwners[Index] = nullptr;
+    mOwnerIndices[Index] = nullptr;
+    mFreeSlots.push_back(Index);
+
+    // Compact the arrays on the next update
+    mIsOrderDirty = true;
+}
+
+void TransformStore::Reorder() {
+    const uint32_t count = static_cast<uint32_t>(mOwners.size());
+
+    // Link the children of every slot in the current slot order; a slot whose parent got freed
+    // becomes a root
+    mFirstChildren.assign(count, kInvalidIndex);
+    mNextSiblings.assign(count, kInvalidIndex);
+    for (uint32_t i = count; i-- > 0;) {
+        const uint32_t parent = mParents[i];
+        if (mOwners[i] && parent != kInvalidIndex && mOwners[parent]) {
+            mNextSiblings[i] = mFirstChildren[parent];
+            mFirstChildren[parent] = i;
+        }
+    }
+
+    // Walk every tree from its root keeping the current relative order of the roots. The stack
+    // holds the next child to visit per level.
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> newIndices(count, kInvalidIndex);
+    order.reserve(count);
+    parents.reserve(count);
+    for (uint32_t root = 0; root < count; ++root) {
+        if (!mOwners[root] || (mParents[root] != kInvalidIndex && mOwners[mParents[root]])) {
+            continue;
+        }
+        if (mParents[root] != kInvalidIndex) {
+            mDirty[root] = true;
+        }
+
+        newIndices[root] = static_cast<uint32_t>(order.size());
+        order.push_back(root);
+        parents.push_back(kInvalidIndex);
+        mReorderStack.assign(1, mFirstChildren[root]);
+        while (!mReorderStack.empty()) {
+            const uint32_t slot = mReorderStack.back();
+            if (slot == kInvalidIndex) {
+                mReorderStack.pop_back();
+                continue;
+            }
+            mReorderStack.back() = mNextSiblings[slot];
+
+            // Parents are visited before their children, so the parent already has its new index
+            newIndices[slot] = static_cast<uint32_t>(order.size());
+            order.push_back(slot);
+            parents.push_back(newIndices[mParents[slot]]);
+            mReorderStack.push_back(mFirstChildren[slot]);
+        }
+    }
+
+    std::vector<Matrix4> localTransforms;
+    std::vector<Matrix4> worldTransforms;
+    std::vector<AABB> localBounds;
+    std::vector<AABB> worldBounds;
+    std::vector<AABB> subtreeBounds;
+    std::vector<uint8_t> dirty;
+    std::vector<Node*> owners;
+    std::vector<uint32_t*> ownerIndices;
+    localTransforms.reserve(order.size());
+    worldTransforms.reserve(order.size());
+    localBounds.reserve(order.size());
+    worldBounds.reserve(order.size());
+    subtreeBounds.reserve(order.size());
+    dirty.reserve(order.size());
+    owners.reserve(order.size());
+    ownerIndices.reserve(order.size());
+
+    // The slots keep their state; only the re-parented ones are dirty
+    for (uint32_t oldIndex : order) {
+        *mOwnerIndices[oldIndex] = static_cast<uint32_t>(owners.size());
+        localTransforms.push_back(mLocalTransforms[oldIndex]);
+        worldTransforms.push_back(mWorldTransforms[oldIndex]);
+        localBounds.push_back(mLocalBounds[oldIndex]);
+        worldBounds.push_back(mWorldBounds[oldIndex]);
+        subtreeBounds.push_back(mSubtreeBounds[oldIndex]);
+        dirty.push_back(mDirty[oldIndex]);
+        owners.push_back(mOwners[oldIndex]);
+        ownerIndices.push_back(mOwnerIndices[oldIndex]);
+    }
+
+    // Children follow their parents, so accumulating in reverse order yields the subtree sizes
+    std::vector<uint32_t> subtreeSizes(order.size(), 1);
+    for (size_t i = order.size(); i-- > 0;) {
+        if (parents[i] != kInvalidIndex) {
+            subtreeSizes[parents[i]] += subtreeSizes[i];
+        }
+    }
+
+    mParents = std::move(parents);
+    mSubtreeSizes = std::move(subtreeSizes);
+    mLocalTransforms = std::move(localTransforms);
+    mWorldTransforms = std::move(worldTransforms);
+    mLocalBounds = std::move(localBounds);
+    mWorldBounds = std::move(worldBounds);
+    mSubtreeBounds = std::move(subtreeBounds);
+    mDirty = std::move(dirty);
+    mOwners = std::move(owners);
+    mOwnerIndices = std::move(ownerIndices);
+    mFreeSlots.clear();
+    mUpdatePasses.assign(mOwners.size(), 0);
+    mBoundsPasses.assign(mOwners.size(), 0);
+
+    // The slots that lost a child get their subtree bounds merged by the current pass; the ones
+    // that gained a child get flagged by the recomputed child anyway
+    for (uint32_t oldIndex : mDetachedParents) {
+        if (oldIndex < newIndices.size() && newIndices[oldIndex] != kInvalidIndex) {
+            mBoundsPasses[newIndices[oldIndex]] = mUpdatePass;
+        }
+    }
+    mDetachedParents.clear();
+
+    mIsOrderDirty = false;
+}
+
+void TransformStore::UpdateSlot(uint32_t Index,
+                                size_t& DirtyRangeEnd,
+                                std::vector<uint32_t>& UpdatedSlots) {
+    if (!mDirty[Index] && Index >= DirtyRangeEnd) {
+        return;
+    }
+
+    const uint32_t parent = mParents[Index];
+    mWorldTransforms[Index] = parent == kInvalidIndex
+                                  ? mLocalTransforms[Index]
+                                  : mWorldTransforms[parent] * mLocalTransforms[Index];
+    mWorldBounds[Index] = mLocalBounds[Index].Transform(mWorldTransforms[Index]);
+
+    DirtyRangeEnd = std::max(DirtyRangeEnd, static_cast<size_t>(Index) + mSubtreeSizes[Index]);
+    mDirty[Index] = false;
+    mUpdatePasses[Index] = mUpdatePass;
+    UpdatedSlots.push_back(Index);
+}
+
+void TransformStore::UpdateRange(const SlotRange& Range, std::vector<uint32_t>& UpdatedSlots) {
+    for (uint32_t i = Range.Begin; i < Range.End; ++i) {
+        // The parent is either in this range or got updated before the parallel tasks started
+        const uint32_t parent = mParents[i];
+        const bool isParentUpdated =
+            parent != kInvalidIndex && mUpdatePasses[parent] == mUpdatePass;
+        if (!mDirty[i] && !isParentUpdated) {
+            continue;
+        }
+
+        mWorldTransforms[i] = parent == kInvalidIndex
+                                  ? mLocalTransforms[i]
+                                  : mWorldTransforms[parent] * mLocalTransforms[i];
+        mWorldBounds[i] = mLocalBounds[i].Transform(mWorldTransforms[i]);
+        mDirty[i] = false;
+        mUpdatePasses[i] = mUpdatePass;
+        UpdatedSlots.push_back(i);
+    }
+}
+
+void TransformStore::UpdateSubtreeBounds(const SlotRange& Range) {
+    for (uint32_t i = Range.End; i-- > Range.Begin;) {
+        if (mUpdatePasses[i] != mUpdatePass && mBoundsPasses[i] != mUpdatePass) {
+            continue;
+        }
+
+        MergeSubtreeBounds(i);
+
+        // The parents outside of the range belong to other tasks, they check their children
+        const uint32_t parent = mParents[i];
+        if (parent != kInvalidIndex && parent >= Range.Begin) {
+            mBoundsPasses[parent] = mUpdatePass;
+        }
+    }
+}
+
+void TransformStore::MergeSubtreeBounds(uint32_t Index) {
+    AABB bounds = mWorldBounds[Index];
+
+    // The children are the subtrees following the slot back to back
+    const uint32_t end = Index + mSubtreeSizes[Index];
+    for (uint32_t child = Index + 1; child < end; child += mSubtreeSizes[child]) {
+        bounds = bounds.Merge(mSubtreeBounds[child]);
+    }
+    mSubtreeBounds[Index] = bounds;
+}
+
+void TransformStore::UpdateWorldTransforms() {
+    // The reorder flags the slots for the current pass
+    ++mUpdatePass;
+    const bool isReordered = mIsOrderDirty;
+    if (isReordered) {
+        Reorder();
+    }
+
+    mUpdatedSlots.clear();
+
+    // Parents always precede their children, so a parent's world transform is final by the time
+    // any of its children reads it. A dirty slot invalidates its whole subtree, which is the
+    // contiguous range [i, i + mSubtreeSizes[i]).
+    size_t dirtyRangeEnd = 0;
+    const uint32_t count = static_cast<uint32_t>(mOwners.size());
+    for (uint32_t i = 0; i < count; ++i) {
+        UpdateSlot(i, dirtyRangeEnd, mUpdatedSlots);
+    }
+
+    if (!mUpdatedSlots.empty() || isReordered) {
+        UpdateSubtreeBounds({0, count});
+    }
+}
+
+void TransformStore::UpdateWorldTransforms(WorkerPool& Pool) {
+    if (mOwners.size() <= kParallelGrainSize || Pool.GetThreadCount() == 1) {
+        UpdateWorldTransforms();
+        return;
+    }
+
+    ++mUpdatePass;
+    if (mIsOrderDirty) {
+        Reorder();
+    }
+
+    mUpdatedSlots.clear();
+    mParallelRanges.clear();
+    mSerialSlots.clear();
+
+    // Update the slots too large to fit into a task serially and batch the rest into ranges. A
+    // subtree that fits gets skipped as a whole, so the serial slots are exactly the ancestors of
+    // the batched subtrees, and they come first in the slot order.
+    size_t dirtyRangeEnd = 0;
+    const uint32_t count = static_cast<uint32_t>(mOwners.size());
+    for (uint32_t i = 0; i < count;) {
+        const uint32_t subtreeSize = mSubtreeSizes[i];
+        if (subtreeSize > kParallelGrainSize) {
+            UpdateSlot(i, dirtyRangeEnd, mUpdatedSlots);
+            mSerialSlots.push_back(i);
+            ++i;
+            continue;
+        }
+
+        // Append to the previous range if the subtree follows it directly
+        if (!mParallelRanges.empty() && mParallelRanges.back().End == i &&
+            mParallelRanges.back().End - mParallelRanges.back().Begin + subtreeSize <=
+                kParallelGrainSize) {
+            mParallelRanges.back().End += subtreeSize;
+        } else {
+            mParallelRanges.push_back({i, i + subtreeSize});
+        }
+        i += subtreeSize;
+    }
+
+    // Each task collects into its own list to avoid contention; the ranges follow the serial
+    // slots and each other, so concatenating the lists keeps the slot order
+    mParallelUpdatedSlots.resize(mParallelRanges.size());
+    Pool.ParallelFor(static_cast<uint32_t>(mParallelRanges.size()), [this](uint32_t TaskIndex) {
+        const SlotRange& range = mParallelRanges[TaskIndex];
+        std::vector<uint32_t>& updatedSlots = mParallelUpdatedSlots[TaskIndex];
+        updatedSlots.clear();
+        UpdateRange(range, updatedSlots);
+        UpdateSubtreeBounds(range);
+    });
+
+    for (const std::vector<uint32_t>& updatedSlots : mParallelUpdatedSlots) {
+        mUpdatedSlots.insert(mUpdatedSlots.end(), updatedSlots.begin(), updatedSlots.end());
+    }
+
+    // The serial slots enclose the task ranges, so they get merged last, children first. Unlike
+    // within the ranges nothing flags them, so they check their children instead.
+    for (size_t i = mSerialSlots.size(); i-- > 0;) {
+        const uint32_t index = mSerialSlots[i];
+        bool isChanged =
+            mUpdatePasses[index] == mUpdatePass || mBoundsPasses[index] == mUpdatePass;
+
+        const uint32_t end = index + mSubtreeSizes[index];
+        for (uint32_t child = index + 1; child < end && !isChanged;
+             child += mSubtreeSizes[child]) {
+            isChanged = mUpdatePasses[child] == mUpdatePass || mBoundsPasses[child] == mUpdatePass;
+        }
+
+        if (isChanged) {
+            MergeSubtreeBounds(index);
+            mBoundsPasses[index] = mUpdatePass;
+        }
+    }
+}
+
+void TransformStore::Cull(std::span<const Frustum> Frustums,
+                          std::vector<uint32_t>& OutVisibility,
+                          std::vector<uint32_t>& OutVisibleSlots) {
+    const uint32_t count = static_cast<uint32_t>(mOwners.size());
+    OutVisibility.assign(count, 0);
+    OutVisibleSlots.clear();
+
+    const size_t viewCount = std::min<size_t>(Frustums.size(), kMaxCullViewCount);
+    if (viewCount == 0) {
+        return;
+    }
+    const uint32_t allViewsMask =
+        viewCount == kMaxCullViewCount ? ~0u : (1u << static_cast<uint32_t>(viewCount)) - 1;
+
+    mCullStack.clear();
+    for (uint32_t i = 0; i < count;) {
+        // Leave the subtrees that end before the slot
+        while (!mCullStack.empty() && mCullStack.back().End <= i) {
+            mCullStack.pop_back();
+        }
+
+        // The frustums the parent subtree crosses are the only ones left to test
+        const CullState parent =
+            mCullStack.empty() ? CullState{count, 0, allViewsMask} : mCullStack.back();
+
+        uint32_t subtreeInsideMask = parent.InsideMask;
+        uint32_t subtreeCrossingMask = 0;
+        for (uint32_t views = parent.CrossingMask; views != 0; views &= views - 1) {
+            const uint32_t view = static_cast<uint32_t>(std::countr_zero(views));
+            switch (Frustums[view].Test(mSubtreeBounds[i])) {
+                case Frustum::Containment::kOutside:
+                    break;
+
+                case Frustum::Containment::kInside:
+                    subtreeInsideMask |= 1u << view;
+                    break;
+
+                case Frustum::Containment::kIntersects:
+                    subtreeCrossingMask |= 1u << view;
+                    break;
+            }
+        }
+
+        // Decided for every view, accept or reject the whole subtree
+        const uint32_t end = i + mSubtreeSizes[i];
+        if (subtreeCrossingMask == 0) {
+            if (subtreeInsideMask != 0) {
+                std::fill(OutVisibility.begin() + i, OutVisibility.begin() + end,
+                          subtreeInsideMask);
+                for (uint32_t slot = i; slot < end; ++slot) {
+                    OutVisibleSlots.push_back(slot);
+                }
+            }
+            i = end;
+            continue;
+        }
+
+        // A leaf's subtree bounds are its own bounds
+        uint32_t visibilityMask = subtreeInsideMask;
+        if (mSubtreeSizes[i] == 1) {
+            visibilityMask |= subtreeCrossingMask;
+        } else {
+            for (uint32_t views = subtreeCrossingMask; views != 0; views &= views - 1) {
+                const uint32_t view = static_cast<uint32_t>(std::countr_zero(views));
+                if (Frustums[view].Test(mWorldBounds[i]) != Frustum::Containment::kOutside) {
+                    visibilityMask |= 1u << view;
+                }
+            }
+            mCullStack.push_back({end, subtreeInsideMask, subtreeCrossingMask});
+        }
+
+        OutVisibility[i] = visibilityMask;
+        if (visibilityMask != 0) {
+            OutVisibleSlots.push_back(i);
+        }
+        ++i;
+    }
+}
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "Math/Bounds.h"
+#include "Math/Frustum.h"
+#include "Math/Matrix.h"
+
+class Node;
+class WorkerPool;
+
+/**
+ * Structure-of-arrays storage for the scene transforms.
+ *
+ * Every Node owns a slot in the store and accesses its local and world matrices through it. The
+ * slots are kept in depth-first (parent before children) order, so the world transforms of the
+ * whole scene get propagated with a single linear pass over contiguous arrays instead of chasing
+ * Node pointers across the heap.
+ *
+ * Example slot layout for the tree below:
+ *
+ *           A
+ *          /|\
+ *         B C D
+ *        /|   |
+ *       E F   G
+ *
+ * Slots:    A  B  E  F  C  D  G
+ * Parents:  -  0  1  1  0  0  5
+ * Subtrees: 7  3  1  1  1  2  1
+ *
+ * Local transforms are tracked for changes. As every subtree occupies a contiguous range of slots,
+ * only the ranges below the changed slots get recomputed, so static parts of the scene cost
+ * nothing but a flag check.
+ *
+ * The subtree ranges are also independent units of work, so large scenes get their world
+ * transforms propagated on a WorkerPool with the same results as the serial pass.
+ *
+ * Every slot carries the bounds of its mesh too. The world bounds get derived along with the world
+ * transforms, and a reverse pass merges them into the bounds of the whole subtree, again touching
+ * only the changed slots and their ancestors. A frustum test of the subtree bounds then rejects or
+ * accepts whole subtrees at once.
+ */
+class TransformStore {
+   public:
+    static constexpr uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+
+    // The number of slots a parallel task processes at most; smaller scenes are updated serially
+    static constexpr uint32_t kParallelGrainSize = 4096;
+
+    // The number of frustums a single Cull call tests; a bit of the visibility mask each
+    static constexpr uint32_t kMaxCullViewCount = 32;
+
+    // Using the function-local static pattern (Meyer's Singleton) the same way MaterialRegistry
+    // does. Nodes get created before they are attached to any scene, so the store can't be owned by
+    // a scene root.
+    static TransformStore& Get() {
+        static TransformStore store;
+        return store;
+    }
+
+    TransformStore() = default;
+    ~TransformStore() = default;
+
+    // Prohibit copying
+    TransformStore(const TransformStore&) = delete;
+    TransformStore& operator=(const TransformStore&) = delete;
+
+    /**
+     * Allocates a root slot with identity transforms for the given node.
+     * @param Owner The node the slot belongs to.
+     * @param OwnerIndex The node's copy of the slot index, kept up to date when the slots get
+     * reordered.
+     * @return The index of the allocated slot.
+     */
+    uint32_t Allocate(Node* Owner, uint32_t* OwnerIndex);
+
+    /**
+     * Frees the slot. The slots get compacted on the next UpdateWorldTransforms call.
+     */
+    void Release(uint32_t Index);
+
+    /**
+     * Re-binds the slot to another node, e.g. when a node is moved.
+     */
+    void SetOwner(uint32_t Index, Node* Owner, uint32_t* OwnerIndex) {
+        mOwners[Index] = Owner;
+        mOwnerIndices[Index] = OwnerIndex;
+    }
+
+    /**
+     * Links the slot to the parent slot. Invalidates the slot order, so the slots get re-sorted on
+     * the next UpdateWorldTransforms call. Marks the slot dirty, so its subtree gets recomputed
+     * under the new parent, and the old parent gets its subtree bounds merged again.
+     * @param Index The child slot.
+     * @param ParentIndex The parent slot, or kInvalidIndex to make the slot a root.
+     */
+    void SetParent(uint32_t Index, uint32_t ParentIndex) {
+        if (mParents[Index] == ParentIndex) {
+            return;
+        }
+
+        if (mParents[Index] != kInvalidIndex) {
+            mDetachedParents.push_back(mParents[Index]);
+        }
+        mParents[Index] = ParentIndex;
+        mDirty[Index] = true;
+        mIsOrderDirty = true;
+    }
+
+    const Matrix4& GetLocalTransform(uint32_t Index) const {
+        return mLocalTransforms[Index];
+    }
+
+    /**
+     * Sets the local transform and marks the slot dirty, so its subtree gets recomputed on the
+     * next UpdateWorldTransforms call.
+     */
+    void SetLocalTransform(uint32_t Index, const Matrix4& Transform) {
+        mLocalTransforms[Index] = Transform;
+        mDirty[Index] = true;
+    }
+
+    const Matrix4& GetWorldTransform(uint32_t Index) const {
+        return mWorldTransforms[Index];
+    }
+
+    /**
+     * Sets the bounds in the local space of the slot, e.g. of its mesh, and marks the slot dirty,
+     * so the world and the subtree bounds get recomputed on the next UpdateWorldTransforms call.
+     */
+    void SetLocalBounds(uint32_t Index, const AABB& Bounds) {
+        mLocalBounds[Index] = Bounds;
+        mDirty[Index] = true;
+    }
+
+    /**
+     * Returns the local bounds transformed to the world space as of the last UpdateWorldTransforms
+     * call.
+     */
+    const AABB& GetWorldBounds(uint32_t Index) const {
+        return mWorldBounds[Index];
+    }
+
+    /**
+     * Returns the world bounds of the slot merged with the world bounds of its whole subtree as of
+     * the last UpdateWorldTransforms call.
+     */
+    const AABB& GetSubtreeBounds(uint32_t Index) const {
+        return mSubtreeBounds[Index];
+    }
+
+    /**
+     * Checks whether the world transform of the slot got recomputed by the last
+     * UpdateWorldTransforms call.
+     */
+    bool IsUpdated(uint32_t Index) const {
+        return mUpdatePasses[Index] == mUpdatePass;
+    }
+
+    /**
+     * Returns the node owning the slot, nullptr for a freed slot.
+     */
+    Node* GetOwner(uint32_t Index) const {
+        return mOwners[Index];
+    }
+
+    size_t GetSize() const {
+        return mOwners.size();
+    }
+
+    /**
+     * Returns the number of world transforms recomputed by the last UpdateWorldTransforms call.
+     */
+    size_t GetUpdatedCount() const {
+        return mUpdatedSlots.size();
+    }
+
+    /**
+     * Returns the slots whose world transforms got recomputed by the last UpdateWorldTransforms
+     * call, so the consumers of the transforms touch only what changed instead of the whole scene.
+     * Valid until the next call.
+     */
+    std::span<const uint32_t> GetUpdatedSlots() const {
+        return mUpdatedSlots;
+    }
+
+    /**
+     * Recomputes the world transforms of the dirty slots and their subtrees with one linear pass.
+     * Re-sorts the slots first if the hierarchy has changed since the last call; the slots keep
+     * their transforms and bounds, so only the re-parented subtrees get recomputed and only the
+     * ancestors that gained or lost a child get their subtree bounds merged again.
+     */
+    void UpdateWorldTransforms();
+
+    /**
+     * Same as UpdateWorldTransforms() but spreads the work over the pool.
+     *
+     * The slots with subtrees larger than kParallelGrainSize get updated serially first. The
+     * remaining subtrees only depend on those, so they get batched into contiguous ranges of up to
+     * kParallelGrainSize slots and updated in parallel. Every world transform is computed with the
+     * same operations as in the serial pass, so the results are identical.
+     */
+    void UpdateWorldTransforms(WorkerPool& Pool);
+
+    /**
+     * Tests the slots against the frustums of several views in one linear pass, so N views don't
+     * cost N walks of the scene. A subtree outside of a frustum gets rejected and a subtree inside
+     * of it gets accepted as a whole for that view; only the subtrees crossing the frustum planes
+     * get their slots tested one by one. The subtrees decided for all the views get skipped.
+     *
+     * Uses the bounds as of the last UpdateWorldTransforms call, so it has to follow it.
+     * @param Frustums The frustums to test against, up to kMaxCullViewCount.
+     * @param OutVisibility Output parameter that will be populated with a mask per slot; bit i is
+     * set if the slot may be visible in the frustum i.
+     * @param OutVisibleSlots Output parameter that will be populated with the slots visible in
+     * any of the frustums, in the slot order.
+     */
+    void Cull(std::span<const Frustum> Frustums,
+              std::vector<uint32_t>& OutVisibility,
+              std::vector<uint32_t>& OutVisibleSlots);
+
+   private:
+    // A contiguous range of whole subtrees updated by one parallel task
+    struct SlotRange {
+        uint32_t Begin;
+        uint32_t End;
+    };
+
+    // The frustums a subtree being culled is known to be inside of, and the ones it crosses
+    struct CullState {
+        uint32_t End;
+        uint32_t InsideMask;
+        uint32_t CrossingMask;
+    };
+
+    /**
+     * Recomputes the slot if it's dirty or lies within the dirty range. Extends the range by the
+     * slot's subtree and appends the slot to UpdatedSlots if it got recomputed.
+     */
+    void UpdateSlot(uint32_t Index, size_t& DirtyRangeEnd, std::vector<uint32_t>& UpdatedSlots);
+
+    /**
+     * Recomputes the dirty slots of the range and the slots whose parent got recomputed by the
+     * current pass, appending them to UpdatedSlots.
+     */
+    void UpdateRange(const SlotRange& Range, std::vector<uint32_t>& UpdatedSlots);
+
+    /**
+     * Merges the world bounds of the slots recomputed by the current pass into the subtree bounds
+     * in reverse order, so the children are done before their parents. A slot whose subtree bounds
+     * change flags its parent to be merged again, as long as the parent lies within the range.
+     */
+    void UpdateSubtreeBounds(const SlotRange& Range);
+
+    /**
+     * Recomputes the subtree bounds of the slot from its world bounds and the subtree bounds of
+     * its children.
+     */
+    void MergeSubtreeBounds(uint32_t Index);
+
+    /**
+     * Rebuilds the slot arrays in depth-first order of the slot trees and drops the freed slots.
+     * The siblings keep their relative order. Updates the slot indices held by the nodes and flags
+     * the slots that lost a child for the subtree bounds merge of the current pass.
+     */
+    void Reorder();
+
+    // Parent slot index per slot, kInvalidIndex for the roots
+    std::vector<uint32_t> mParents;
+    // Number of slots in the subtree rooted at the slot, including the slot itself
+    std::vector<uint32_t> mSubtreeSizes;
+    std::vector<Matrix4> mLocalTransforms;
+    std::vector<Matrix4> mWorldTransforms;
+
+    // Bounds per slot; the subtree bounds enclose the world bounds of the slot and its descendants
+    std::vector<AABB> mLocalBounds;
+    std::vector<AABB> mWorldBounds;
+    std::vector<AABB> mSubtreeBounds;
+
+    // Change tracking
+    std::vector<uint8_t> mDirty;
+    // The pass number that has last recomputed the slot
+    std::vector<uint32_t> mUpdatePasses;
+    // The pass number that has last flagged the subtree bounds of the slot for merging
+    std::vector<uint32_t> mBoundsPasses;
+    uint32_t mUpdatePass{0};
+    // The slots recomputed by the last pass in the slot order
+    std::vector<uint32_t> mUpdatedSlots;
+
+    // Not-owning back pointers to the nodes and their handles, which get fixed up on reorder;
+    // nullptr for free slots
+    std::vector<Node*> mOwners;
+    std::vector<uint32_t*> mOwnerIndices;
+    std::vector<uint32_t> mFreeSlots;
+
+    // The slots that lost a child since the last reorder, in the slot indices before the reorder
+    std::vector<uint32_t> mDetachedParents;
+    bool mIsOrderDirty{false};
+
+    // Reused task list of the parallel pass
+    std::vector<SlotRange> mParallelRanges;
+    std::vector<std::vector<uint32_t>> mParallelUpdatedSlots;
+    std::vector<uint32_t> mSerialSlots;
+
+    // Reused child lists and stack of the reorder
+    std::vector<uint32_t> mFirstChildren;
+    std::vector<uint32_t> mNextSiblings;
+    std::vector<uint32_t> mReorderStack;
+
+    // Reused stack of the subtrees enclosing the slot being culled
+    std::vector<CullState> mCullStack;
+};
@@ -0,0 +1,110 @@
+#include "WorkerPool.h"
+
+#include "Logging/Logging.h"
+
+bool WorkerPool::Create(uint32_t WorkerCount, std::unique_ptr<WorkerPool>& OutPool) {
+    LOG_INFO(L"Creating WorkerPool with %u worker threads.\n", WorkerCount);
+    OutPool = std::make_unique<WorkerPool>(WorkerCount);
+    return true;
+}
+
+WorkerPool::WorkerPool(uint32_t WorkerCount) {
+    mWorkers.reserve(WorkerCount);
+    for (uint32_t i = 0; i < WorkerCount; ++i) {
+        mWorkers.emplace_back(&WorkerPool::WorkerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsStopping = true;
+    }
+    mWakeCondition.notify_all();
+
+    for (std::thread& worker : mWorkers) {
+        worker.join();
+    }
+}
+
+void WorkerPool::ParallelFor(uint32_t Count, const std::function<void(uint32_t)>& Task) {
+    if (Count == 0) {
+        return;
+    }
+
+    // Nothing to spread the work over
+    if (mWorkers.empty() || Count == 1) {
+        for (uint32_t i = 0; i < Count; ++i) {
+            Task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> dispatchLock(mDispatchMutex);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTask = &Task;
+        mTaskCount = Count;
+        mNextIndex.store(0, std::memory_order_relaxed);
+        mPendingCount.store(Count, std::memory_order_relaxed);
+        ++mGeneration;
+    }
+    mWakeCondition.notify_all();
+
+    // The calling thread works on the loop too
+    RunTasks(Task, Count);
+
+    // Wait for the tasks picked up by the workers. Workers that have seen the loop must also leave
+    // it before the Task reference goes out of scope.
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDoneCondition.wait(lock, [this] {
+        return mPendingCount.load(std::memory_order_acquire) == 0 && mActiveWorkers == 0;
+    });
+    mTask = nullptr;
+    mTaskCount = 0;
+}
+
+void WorkerPool::RunTasks(const std::function<void(uint32_t)>& Task, uint32_t Count) {
+    for (;;) {
+        uint32_t index = mNextIndex.fetch_add(1, std::memory_order_relaxed);
+        if (index >= Count) {
+            return;
+        }
+
+        Task(index);
+
+        if (mPendingCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // The last task is done; the lock makes sure the waiting thread doesn't miss it
+            std::lock_guard<std::mutex> lock(mMutex);
+            mDoneCondition.notify_all();
+        }
+    }
+}
+
+void WorkerPool::WorkerLoop() {
+    uint64_t seenGeneration = 0;
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    for (;;) {
+        mWakeCondition.wait(lock, [&] {
+            return mIsStopping || (mTask && mGeneration != seenGeneration);
+        });
+        if (mIsStopping) {
+            return;
+        }
+
+        // Take a snapshot of the loop while holding the lock
+        seenGeneration = mGeneration;
+        const std::function<void(uint32_t)>* task = mTask;
+        uint32_t count = mTaskCount;
+        ++mActiveWorkers;
+
+        lock.unlock();
+        RunTasks(*task, count);
+        lock.lock();
+
+        if (--mActiveWorkers == 0) {
+            mDoneCondition.notify_all();
+        }
+    }
+}
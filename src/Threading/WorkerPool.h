@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads executing data-parallel loops. The calling thread takes part in
+ * the loop as well, so a pool of N workers runs a loop on N + 1 threads.
+ */
+class WorkerPool {
+   public:
+    /**
+     * Creates a pool with the given number of worker threads.
+     *
+     * @param WorkerCount The number of threads to spawn besides the calling one. 0 runs all the
+     * loops on the calling thread.
+     * @param OutPool Output parameter that will be populated with the created WorkerPool instance.
+     * @return true if the WorkerPool was successfully created, false otherwise.
+     */
+    static bool Create(uint32_t WorkerCount, std::unique_ptr<WorkerPool>& OutPool);
+
+    /**
+     * Creates a pool with a worker per hardware thread, minus the calling one.
+     */
+    static bool Create(std::unique_ptr<WorkerPool>& OutPool) {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        return Create(hardwareThreads > 1 ? hardwareThreads - 1 : 0, OutPool);
+    }
+
+    explicit WorkerPool(uint32_t WorkerCount);
+    ~WorkerPool();
+
+    // Prohibit copying and moving as the workers hold a pointer to the pool
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    WorkerPool(WorkerPool&&) = delete;
+    WorkerPool& operator=(WorkerPool&&) = delete;
+
+    /**
+     * Returns the number of threads a loop runs on, the calling thread included.
+     */
+    uint32_t GetThreadCount() const {
+        return static_cast<uint32_t>(mWorkers.size()) + 1;
+    }
+
+    /**
+     * Calls Task(i) for every i in [0, Count) spreading the calls over the workers and the calling
+     * thread. Returns once all the calls have completed. Loops from different threads get
+     * serialized.
+     */
+    void ParallelFor(uint32_t Count, const std::function<void(uint32_t)>& Task);
+
+   private:
+    void WorkerLoop();
+    void RunTasks(const std::function<void(uint32_t)>& Task, uint32_t Count);
+
+    std::vector<std::thread> mWorkers;
+
+    // Serializes ParallelFor calls
+    std::mutex mDispatchMutex;
+
+    // Guards the loop state below
+    std::mutex mMutex;
+    std::condition_variable mWakeCondition;
+    std::condition_variable mDoneCondition;
+    const std::function<void(uint32_t)>* mTask{nullptr};
+    uint32_t mTaskCount{0};
+    uint64_t mGeneration{0};
+    uint32_t mActiveWorkers{0};
+    bool mIsStopping{false};
+
+    std::atomic<uint32_t> mNextIndex{0};
+    std::atomic<uint32_t> mPendingCount{0};
+};
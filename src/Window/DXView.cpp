@@ -43,22 +43,22 @@ bool DXView::Update() {
 
     mLastFrameTime = currentTime;
 
-    {  // Scene update
-        CommandList10 cmdl;
-        if (!mDevice->GetCommandList(cmdl)) {
-            LOG_ERROR(L"Failed to get command list for model update.\n");
-            return false;
-        }
+    // Wait for the frame slot to be free; the previous frames keep running on the GPU meanwhile
+    if (!mDevice->BeginFrame()) {
+        LOG_ERROR(L"Failed to begin a frame.\n");
+        return false;
+    }
 
-        if (!mRenderer->Update(cmdl, deltaTime)) {
-            LOG_ERROR(L"Failed to update the scene.\n");
-            return false;
-        }
+    // Scene update
+    if (!mRenderer->Update(deltaTime)) {
+        LOG_ERROR(L"Failed to update the scene.\n");
+        return false;
     }
 
     // Skip rendering when the window is minimized
     if (mIsMinimizing) {
         // The mIsMinimizing flag gets reset in OnResize method
+        mDevice->EndFrame();
         return true;
     }
 
@@ -74,6 +74,7 @@ bool DXView::Update() {
 
         if (mWidth == mNewWidth && mHeight == mNewHeight) {
             LOG_INFO(L"Skip resizing to the same size %d x %d.\n", mWidth, mHeight);
+            mDevice->EndFrame();
             return true;
         }
 
@@ -114,7 +115,7 @@ bool DXView::Update() {
         }
 
         // Do draw
-        if (!mRenderer->Draw(cmdl)) {
+        if (!mRenderer->Draw(*mDevice, cmdl)) {
             LOG_ERROR(L"Failed to draw a frame.\n");
             return false;
         }
@@ -126,5 +127,8 @@ bool DXView::Update() {
         return false;
     }
 
+    // The frame slot gets reused once the GPU is done with the frame
+    mDevice->EndFrame();
+
     return mIsRunning;
 }
\ No newline at end of file